@@ -177,6 +177,26 @@ struct ConfigFileSetting config_file_settings[] =
 		{},
 		{}
 	},
+	/* log_format */
+	{
+		"log_format",
+		CONFIG_LOG_FORMAT,
+		{ .logformatptr = &config_file_options.log_format },
+		{ .logformatdefault = DEFAULT_LOG_FORMAT },
+		{},
+		{},
+		{}
+	},
+	/* log_buffer_size */
+	{
+		"log_buffer_size",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.log_buffer_size },
+		{ .intdefault = DEFAULT_LOG_BUFFER_SIZE, },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
 	/* ======================
 	 * standby clone settings
 	 * ======================
@@ -426,6 +446,31 @@ struct ConfigFileSetting config_file_settings[] =
 		{}
 	},
 
+	/* ===========================
+	 * parallel execution settings
+	 * ===========================
+	 */
+	/* parallel_jobs */
+	{
+		"parallel_jobs",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.parallel_jobs },
+		{ .intdefault = DEFAULT_PARALLEL_JOBS },
+		{ .intminval = 1 },
+		{},
+		{}
+	},
+	/* remote_command_timeout */
+	{
+		"remote_command_timeout",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.remote_command_timeout },
+		{ .intdefault = DEFAULT_REMOTE_COMMAND_TIMEOUT },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+
 	/* ================
 	 * repmgrd settings
 	 * ================
@@ -490,6 +535,16 @@ struct ConfigFileSetting config_file_settings[] =
 		{},
 		{}
 	},
+	/* monitor_interval_ms */
+	{
+		"monitor_interval_ms",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.monitor_interval_ms },
+		{ .intdefault = DEFAULT_MONITORING_INTERVAL_MS },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
 	/* reconnect_attempts */
 	{
 		"reconnect_attempts",
@@ -510,6 +565,26 @@ struct ConfigFileSetting config_file_settings[] =
 		{},
 		{}
 	},
+	/* reconnect_backoff */
+	{
+		"reconnect_backoff",
+		CONFIG_BOOL,
+		{ .boolptr = &config_file_options.reconnect_backoff },
+		{ .booldefault = DEFAULT_RECONNECT_BACKOFF },
+		{},
+		{},
+		{}
+	},
+	/* reconnect_initial_interval_ms */
+	{
+		"reconnect_initial_interval_ms",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.reconnect_initial_interval_ms },
+		{ .intdefault = DEFAULT_RECONNECT_INITIAL_INTERVAL_MS },
+		{ .intminval = 10 },
+		{},
+		{}
+	},
 
 	/* monitoring_history */
 	{
@@ -521,6 +596,46 @@ struct ConfigFileSetting config_file_settings[] =
 		{},
 		{}
 	},
+	/* monitoring_history_flush_interval */
+	{
+		"monitoring_history_flush_interval",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.monitoring_history_flush_interval },
+		{ .intdefault = DEFAULT_MONITORING_HISTORY_FLUSH_INTERVAL },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* monitoring_history_max_records */
+	{
+		"monitoring_history_max_records",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.monitoring_history_max_records },
+		{ .intdefault = DEFAULT_MONITORING_HISTORY_MAX_RECORDS },
+		{ .intminval = 1 },
+		{},
+		{}
+	},
+	/* metrics_listen_address */
+	{
+		"metrics_listen_address",
+		CONFIG_STRING,
+		{ .strptr = config_file_options.metrics_listen_address },
+		{ .strdefault = "" },
+		{},
+		{ .strmaxlen = sizeof(config_file_options.metrics_listen_address) },
+		{}
+	},
+	/* metrics_port */
+	{
+		"metrics_port",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.metrics_port },
+		{ .intdefault = DEFAULT_METRICS_PORT },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
 	/* degraded_monitoring_timeout */
 	{
 		"degraded_monitoring_timeout",
@@ -631,6 +746,76 @@ struct ConfigFileSetting config_file_settings[] =
 		{},
 		{}
 	},
+	/* election_prevote_timeout */
+	{
+		"election_prevote_timeout",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.election_prevote_timeout },
+		{ .intdefault = DEFAULT_ELECTION_PREVOTE_TIMEOUT },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* promotion_candidate_scoring */
+	{
+		"promotion_candidate_scoring",
+		CONFIG_BOOL,
+		{ .boolptr = &config_file_options.promotion_candidate_scoring },
+		{ .booldefault = DEFAULT_PROMOTION_CANDIDATE_SCORING },
+		{},
+		{},
+		{}
+	},
+	/* promotion_score_priority_weight */
+	{
+		"promotion_score_priority_weight",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.promotion_score_priority_weight },
+		{ .intdefault = DEFAULT_PROMOTION_SCORE_PRIORITY_WEIGHT },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* promotion_score_replay_weight */
+	{
+		"promotion_score_replay_weight",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.promotion_score_replay_weight },
+		{ .intdefault = DEFAULT_PROMOTION_SCORE_REPLAY_WEIGHT },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* promotion_score_lag_weight */
+	{
+		"promotion_score_lag_weight",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.promotion_score_lag_weight },
+		{ .intdefault = DEFAULT_PROMOTION_SCORE_LAG_WEIGHT },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* promotion_score_location_weight */
+	{
+		"promotion_score_location_weight",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.promotion_score_location_weight },
+		{ .intdefault = DEFAULT_PROMOTION_SCORE_LOCATION_WEIGHT },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* upstream_failover_strategy */
+	{
+		"upstream_failover_strategy",
+		CONFIG_UPSTREAM_FAILOVER_STRATEGY,
+		{ .upstreamfailoverptr = &config_file_options.upstream_failover_strategy },
+		{ .upstreamfailoverdefault = DEFAULT_UPSTREAM_FAILOVER_STRATEGY },
+		{},
+		{},
+		{}
+	},
 	/* child_nodes_check_interval */
 	{
 		"child_nodes_check_interval",
@@ -691,6 +876,46 @@ struct ConfigFileSetting config_file_settings[] =
 		{ .strmaxlen = sizeof(config_file_options.child_nodes_disconnect_command) },
 		{}
 	},
+	/* replication_slot_check_interval */
+	{
+		"replication_slot_check_interval",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.replication_slot_check_interval },
+		{ .intdefault = DEFAULT_REPLICATION_SLOT_CHECK_INTERVAL },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* replication_slot_retained_wal_threshold */
+	{
+		"replication_slot_retained_wal_threshold",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.replication_slot_retained_wal_threshold },
+		{ .intdefault = DEFAULT_REPLICATION_SLOT_RETAINED_WAL_THRESHOLD },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* replication_slot_retained_wal_growth_rate */
+	{
+		"replication_slot_retained_wal_growth_rate",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.replication_slot_retained_wal_growth_rate },
+		{ .intdefault = DEFAULT_REPLICATION_SLOT_RETAINED_WAL_GROWTH_RATE },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* replication_slot_inactive_drop_timeout */
+	{
+		"replication_slot_inactive_drop_timeout",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.replication_slot_inactive_drop_timeout },
+		{ .intdefault = DEFAULT_REPLICATION_SLOT_INACTIVE_DROP_TIMEOUT },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
 	/* ================
 	 * service settings
 	 * ================
@@ -803,6 +1028,36 @@ struct ConfigFileSetting config_file_settings[] =
 		{},
 		{}
 	},
+	/* event_notification_workers */
+	{
+		"event_notification_workers",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.event_notification_workers },
+		{ .intdefault = DEFAULT_EVENT_NOTIFICATION_WORKERS },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* event_notification_queue_size */
+	{
+		"event_notification_queue_size",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.event_notification_queue_size },
+		{ .intdefault = DEFAULT_EVENT_NOTIFICATION_QUEUE_SIZE },
+		{ .intminval = 1 },
+		{},
+		{}
+	},
+	/* event_notification_timeout */
+	{
+		"event_notification_timeout",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.event_notification_timeout },
+		{ .intdefault = DEFAULT_EVENT_NOTIFICATION_TIMEOUT },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
 	/* ===============
 	 * barman settings
 	 * ===============
@@ -837,6 +1092,16 @@ struct ConfigFileSetting config_file_settings[] =
 		{ .strmaxlen = sizeof(config_file_options.barman_config) },
 		{}
 	},
+	/* barman_restore_jobs */
+	{
+		"barman_restore_jobs",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.barman_restore_jobs },
+		{ .intdefault = DEFAULT_BARMAN_RESTORE_JOBS },
+		{ .intminval = 1 },
+		{},
+		{}
+	},
 	/* ==================
 	 * rsync/ssh settings
 	 * ==================
@@ -861,6 +1126,16 @@ struct ConfigFileSetting config_file_settings[] =
 		{ .strmaxlen = sizeof(config_file_options.ssh_options) },
 		{}
 	},
+	/* ssh_multiplexing */
+	{
+		"ssh_multiplexing",
+		CONFIG_BOOL,
+		{ .boolptr = &config_file_options.ssh_multiplexing },
+		{ .booldefault = DEFAULT_SSH_MULTIPLEXING },
+		{},
+		{},
+		{}
+	},
 	/* ==========================
 	 * undocumented test settings
 	 * ==========================
@@ -313,6 +313,12 @@ _parse_config(ItemList *error_list, ItemList *warning_list)
 			case CONFIG_CONNECTION_CHECK_TYPE:
 				*setting->val.checktypeptr = setting->defval.checktypedefault;
 				break;
+			case CONFIG_LOG_FORMAT:
+				*setting->val.logformatptr = setting->defval.logformatdefault;
+				break;
+			case CONFIG_UPSTREAM_FAILOVER_STRATEGY:
+				*setting->val.upstreamfailoverptr = setting->defval.upstreamfailoverdefault;
+				break;
 			case CONFIG_EVENT_NOTIFICATION_LIST:
 			case CONFIG_TABLESPACE_MAPPING:
 				/* no default for these types; lists cleared above */
@@ -558,10 +564,50 @@ parse_configuration_item(ItemList *error_list, ItemList *warning_list, const cha
 					{
 						*(ConnectionCheckType *)setting->val.checktypeptr = CHECK_QUERY;
 					}
+					else if (strcasecmp(value, "wal_receiver") == 0)
+					{
+						*(ConnectionCheckType *)setting->val.checktypeptr = CHECK_WAL_RECEIVER;
+					}
+					else
+					{
+						item_list_append_format(error_list,
+												_("value for \"%s\" must be \"ping\", \"connection\", \"query\" or \"wal_receiver\"\n"),
+												name);
+					}
+					break;
+				}
+				case CONFIG_LOG_FORMAT:
+				{
+					if (strcasecmp(value, "text") == 0)
+					{
+						*(LogFormat *)setting->val.logformatptr = LOG_FORMAT_TEXT;
+					}
+					else if (strcasecmp(value, "json") == 0)
+					{
+						*(LogFormat *)setting->val.logformatptr = LOG_FORMAT_JSON;
+					}
 					else
 					{
 						item_list_append_format(error_list,
-												_("value for \"%s\" must be \"ping\", \"connection\" or \"query\"\n"),
+												_("value for \"%s\" must be \"text\" or \"json\"\n"),
+												name);
+					}
+					break;
+				}
+				case CONFIG_UPSTREAM_FAILOVER_STRATEGY:
+				{
+					if (strcasecmp(value, "primary") == 0)
+					{
+						*(UpstreamFailoverStrategy *)setting->val.upstreamfailoverptr = UPSTREAM_FAILOVER_PRIMARY;
+					}
+					else if (strcasecmp(value, "balanced") == 0)
+					{
+						*(UpstreamFailoverStrategy *)setting->val.upstreamfailoverptr = UPSTREAM_FAILOVER_BALANCED;
+					}
+					else
+					{
+						item_list_append_format(error_list,
+												_("value for \"%s\" must be \"primary\" or \"balanced\"\n"),
 												name);
 					}
 					break;
@@ -855,25 +901,48 @@ parse_time_unit_parameter(const char *name, const char *value, char *dest, ItemL
  * - conninfo
  * - degraded_monitoring_timeout
  * - event_notification_command
+ * - event_notification_queue_size
+ * - event_notification_timeout
+ * - event_notification_workers
+ * - election_prevote_timeout
  * - event_notifications
  * - failover
  * - failover_validation_command
  * - follow_command
+ * - log_buffer_size
  * - log_facility
  * - log_file
+ * - log_format
  * - log_level
  * - log_status_interval
+ * - metrics_listen_address
+ * - metrics_port
  * - monitor_interval_secs
+ * - monitor_interval_ms
  * - monitoring_history
+ * - monitoring_history_flush_interval
+ * - monitoring_history_max_records
  * - primary_notification_timeout
  * - primary_visibility_consensus
  * - promote_command
+ * - promotion_candidate_scoring
+ * - promotion_score_lag_weight
+ * - promotion_score_location_weight
+ * - promotion_score_priority_weight
+ * - promotion_score_replay_weight
  * - reconnect_attempts
+ * - reconnect_backoff
+ * - reconnect_initial_interval_ms
  * - reconnect_interval
+ * - replication_slot_check_interval
+ * - replication_slot_inactive_drop_timeout
+ * - replication_slot_retained_wal_growth_rate
+ * - replication_slot_retained_wal_threshold
  * - repmgrd_standby_startup_timeout
  * - retry_promote_interval_secs
  * - sibling_nodes_disconnect_timeout
  * - standby_disconnect_on_failover
+ * - upstream_failover_strategy
  *
  *
  * Not publicly documented:
@@ -1104,6 +1173,33 @@ reload_config(t_server_type server_type)
 								config_file_options.event_notification_command);
 	}
 
+	/* event_notification_workers */
+	if (config_file_options.event_notification_workers != orig_config_file_options.event_notification_workers)
+	{
+		item_list_append_format(&config_changes,
+								_("\"event_notification_workers\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.event_notification_workers,
+								config_file_options.event_notification_workers);
+	}
+
+	/* event_notification_queue_size */
+	if (config_file_options.event_notification_queue_size != orig_config_file_options.event_notification_queue_size)
+	{
+		item_list_append_format(&config_changes,
+								_("\"event_notification_queue_size\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.event_notification_queue_size,
+								config_file_options.event_notification_queue_size);
+	}
+
+	/* event_notification_timeout */
+	if (config_file_options.event_notification_timeout != orig_config_file_options.event_notification_timeout)
+	{
+		item_list_append_format(&config_changes,
+								_("\"event_notification_timeout\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.event_notification_timeout,
+								config_file_options.event_notification_timeout);
+	}
+
 	/* event_notifications */
 	if (strncmp(config_file_options.event_notifications_orig, orig_config_file_options.event_notifications_orig, sizeof(config_file_options.event_notifications_orig)) != 0)
 	{
@@ -1140,6 +1236,15 @@ reload_config(t_server_type server_type)
 								config_file_options.monitor_interval_secs);
 	}
 
+	/* monitor_interval_ms */
+	if (config_file_options.monitor_interval_ms != orig_config_file_options.monitor_interval_ms)
+	{
+		item_list_append_format(&config_changes,
+								_("\"monitor_interval_ms\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.monitor_interval_ms,
+								config_file_options.monitor_interval_ms);
+	}
+
 	/* monitoring_history */
 	if (config_file_options.monitoring_history != orig_config_file_options.monitoring_history)
 	{
@@ -1149,6 +1254,42 @@ reload_config(t_server_type server_type)
 								format_bool(config_file_options.monitoring_history));
 	}
 
+	/* monitoring_history_flush_interval */
+	if (config_file_options.monitoring_history_flush_interval != orig_config_file_options.monitoring_history_flush_interval)
+	{
+		item_list_append_format(&config_changes,
+								_("\"monitoring_history_flush_interval\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.monitoring_history_flush_interval,
+								config_file_options.monitoring_history_flush_interval);
+	}
+
+	/* monitoring_history_max_records */
+	if (config_file_options.monitoring_history_max_records != orig_config_file_options.monitoring_history_max_records)
+	{
+		item_list_append_format(&config_changes,
+								_("\"monitoring_history_max_records\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.monitoring_history_max_records,
+								config_file_options.monitoring_history_max_records);
+	}
+
+	/* metrics_listen_address */
+	if (strncmp(config_file_options.metrics_listen_address, orig_config_file_options.metrics_listen_address, sizeof(config_file_options.metrics_listen_address)) != 0)
+	{
+		item_list_append_format(&config_changes,
+								_("\"metrics_listen_address\" changed from \"%s\" to \"%s\""),
+								orig_config_file_options.metrics_listen_address,
+								config_file_options.metrics_listen_address);
+	}
+
+	/* metrics_port */
+	if (config_file_options.metrics_port != orig_config_file_options.metrics_port)
+	{
+		item_list_append_format(&config_changes,
+								_("\"metrics_port\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.metrics_port,
+								config_file_options.metrics_port);
+	}
+
 	/* primary_notification_timeout */
 	if (config_file_options.primary_notification_timeout != orig_config_file_options.primary_notification_timeout)
 	{
@@ -1194,6 +1335,60 @@ reload_config(t_server_type server_type)
 								config_file_options.reconnect_interval);
 	}
 
+	/* replication_slot_check_interval */
+	if (config_file_options.replication_slot_check_interval != orig_config_file_options.replication_slot_check_interval)
+	{
+		item_list_append_format(&config_changes,
+								_("\"replication_slot_check_interval\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.replication_slot_check_interval,
+								config_file_options.replication_slot_check_interval);
+	}
+
+	/* replication_slot_retained_wal_threshold */
+	if (config_file_options.replication_slot_retained_wal_threshold != orig_config_file_options.replication_slot_retained_wal_threshold)
+	{
+		item_list_append_format(&config_changes,
+								_("\"replication_slot_retained_wal_threshold\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.replication_slot_retained_wal_threshold,
+								config_file_options.replication_slot_retained_wal_threshold);
+	}
+
+	/* replication_slot_retained_wal_growth_rate */
+	if (config_file_options.replication_slot_retained_wal_growth_rate != orig_config_file_options.replication_slot_retained_wal_growth_rate)
+	{
+		item_list_append_format(&config_changes,
+								_("\"replication_slot_retained_wal_growth_rate\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.replication_slot_retained_wal_growth_rate,
+								config_file_options.replication_slot_retained_wal_growth_rate);
+	}
+
+	/* replication_slot_inactive_drop_timeout */
+	if (config_file_options.replication_slot_inactive_drop_timeout != orig_config_file_options.replication_slot_inactive_drop_timeout)
+	{
+		item_list_append_format(&config_changes,
+								_("\"replication_slot_inactive_drop_timeout\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.replication_slot_inactive_drop_timeout,
+								config_file_options.replication_slot_inactive_drop_timeout);
+	}
+
+	/* reconnect_backoff */
+	if (config_file_options.reconnect_backoff != orig_config_file_options.reconnect_backoff)
+	{
+		item_list_append_format(&config_changes,
+								_("\"reconnect_backoff\" changed from \"%s\" to \"%s\""),
+								format_bool(orig_config_file_options.reconnect_backoff),
+								format_bool(config_file_options.reconnect_backoff));
+	}
+
+	/* reconnect_initial_interval_ms */
+	if (config_file_options.reconnect_initial_interval_ms != orig_config_file_options.reconnect_initial_interval_ms)
+	{
+		item_list_append_format(&config_changes,
+								_("\"reconnect_initial_interval_ms\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.reconnect_initial_interval_ms,
+								config_file_options.reconnect_initial_interval_ms);
+	}
+
 	/* repmgrd_standby_startup_timeout */
 	if (config_file_options.repmgrd_standby_startup_timeout != orig_config_file_options.repmgrd_standby_startup_timeout)
 	{
@@ -1212,6 +1407,69 @@ reload_config(t_server_type server_type)
 								format_bool(config_file_options.standby_disconnect_on_failover));
 	}
 
+	/* election_prevote_timeout */
+	if (config_file_options.election_prevote_timeout != orig_config_file_options.election_prevote_timeout)
+	{
+		item_list_append_format(&config_changes,
+								_("\"election_prevote_timeout\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.election_prevote_timeout,
+								config_file_options.election_prevote_timeout);
+	}
+
+	/* promotion_candidate_scoring */
+	if (config_file_options.promotion_candidate_scoring != orig_config_file_options.promotion_candidate_scoring)
+	{
+		item_list_append_format(&config_changes,
+								_("\"promotion_candidate_scoring\" changed from \"%s\" to \"%s\""),
+								format_bool(orig_config_file_options.promotion_candidate_scoring),
+								format_bool(config_file_options.promotion_candidate_scoring));
+	}
+
+	/* promotion_score_priority_weight */
+	if (config_file_options.promotion_score_priority_weight != orig_config_file_options.promotion_score_priority_weight)
+	{
+		item_list_append_format(&config_changes,
+								_("\"promotion_score_priority_weight\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.promotion_score_priority_weight,
+								config_file_options.promotion_score_priority_weight);
+	}
+
+	/* promotion_score_replay_weight */
+	if (config_file_options.promotion_score_replay_weight != orig_config_file_options.promotion_score_replay_weight)
+	{
+		item_list_append_format(&config_changes,
+								_("\"promotion_score_replay_weight\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.promotion_score_replay_weight,
+								config_file_options.promotion_score_replay_weight);
+	}
+
+	/* promotion_score_lag_weight */
+	if (config_file_options.promotion_score_lag_weight != orig_config_file_options.promotion_score_lag_weight)
+	{
+		item_list_append_format(&config_changes,
+								_("\"promotion_score_lag_weight\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.promotion_score_lag_weight,
+								config_file_options.promotion_score_lag_weight);
+	}
+
+	/* promotion_score_location_weight */
+	if (config_file_options.promotion_score_location_weight != orig_config_file_options.promotion_score_location_weight)
+	{
+		item_list_append_format(&config_changes,
+								_("\"promotion_score_location_weight\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.promotion_score_location_weight,
+								config_file_options.promotion_score_location_weight);
+	}
+
+	/* upstream_failover_strategy */
+	if (config_file_options.upstream_failover_strategy != orig_config_file_options.upstream_failover_strategy)
+	{
+		item_list_append_format(&config_changes,
+								_("\"upstream_failover_strategy\" changed from \"%s\" to \"%s\""),
+								print_upstream_failover_strategy(orig_config_file_options.upstream_failover_strategy),
+								print_upstream_failover_strategy(config_file_options.upstream_failover_strategy));
+	}
+
 	/* sibling_nodes_disconnect_timeout */
 	if (config_file_options.sibling_nodes_disconnect_timeout != orig_config_file_options.sibling_nodes_disconnect_timeout)
 	{
@@ -1252,6 +1510,15 @@ reload_config(t_server_type server_type)
 	 * Handle changes to logging configuration
 	 */
 
+	/* log_buffer_size */
+	if (config_file_options.log_buffer_size != orig_config_file_options.log_buffer_size)
+	{
+		item_list_append_format(&config_changes,
+								_("\"log_buffer_size\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.log_buffer_size,
+								config_file_options.log_buffer_size);
+	}
+
 	/* log_facility */
 	if (strncmp(config_file_options.log_facility, orig_config_file_options.log_facility, sizeof(config_file_options.log_facility)) != 0)
 	{
@@ -1270,6 +1537,14 @@ reload_config(t_server_type server_type)
 								config_file_options.log_file);
 	}
 
+	/* log_format */
+	if (config_file_options.log_format != orig_config_file_options.log_format)
+	{
+		item_list_append_format(&config_changes,
+								_("\"log_format\" changed from \"%s\" to \"%s\""),
+								print_log_format(orig_config_file_options.log_format),
+								print_log_format(config_file_options.log_format));
+	}
 
 	/* log_level */
 	if (strncmp(config_file_options.log_level, orig_config_file_options.log_level, sizeof(config_file_options.log_level)) != 0)
@@ -2092,6 +2367,40 @@ print_connection_check_type(ConnectionCheckType type)
 			return "query";
 		case CHECK_CONNECTION:
 			return "connection";
+		case CHECK_WAL_RECEIVER:
+			return "wal_receiver";
+	}
+
+	/* should never reach here */
+	return "UNKNOWN";
+}
+
+
+const char *
+print_upstream_failover_strategy(UpstreamFailoverStrategy strategy)
+{
+	switch (strategy)
+	{
+		case UPSTREAM_FAILOVER_PRIMARY:
+			return "primary";
+		case UPSTREAM_FAILOVER_BALANCED:
+			return "balanced";
+	}
+
+	/* should never reach here */
+	return "UNKNOWN";
+}
+
+
+const char *
+print_log_format(LogFormat format)
+{
+	switch (format)
+	{
+		case LOG_FORMAT_TEXT:
+			return "text";
+		case LOG_FORMAT_JSON:
+			return "json";
 	}
 
 	/* should never reach here */
@@ -47,9 +47,22 @@ typedef enum
 {
 	CHECK_PING,
 	CHECK_QUERY,
-	CHECK_CONNECTION
+	CHECK_CONNECTION,
+	CHECK_WAL_RECEIVER
 } ConnectionCheckType;
 
+typedef enum
+{
+	LOG_FORMAT_TEXT,
+	LOG_FORMAT_JSON
+} LogFormat;
+
+typedef enum
+{
+	UPSTREAM_FAILOVER_PRIMARY,
+	UPSTREAM_FAILOVER_BALANCED
+} UpstreamFailoverStrategy;
+
 typedef struct EventNotificationListCell
 {
 	struct EventNotificationListCell *next;
@@ -85,6 +98,8 @@ typedef enum
 	CONFIG_STRING,
 	CONFIG_FAILOVER_MODE,
 	CONFIG_CONNECTION_CHECK_TYPE,
+	CONFIG_LOG_FORMAT,
+	CONFIG_UPSTREAM_FAILOVER_STRATEGY,
 	CONFIG_EVENT_NOTIFICATION_LIST,
 	CONFIG_TABLESPACE_MAPPING
 } ConfigItemType;
@@ -101,6 +116,8 @@ typedef struct ConfigFileSetting
 		bool	   *boolptr;
 		failover_mode_opt *failovermodeptr;
 		ConnectionCheckType *checktypeptr;
+		LogFormat  *logformatptr;
+		UpstreamFailoverStrategy *upstreamfailoverptr;
 		EventNotificationList *notificationlistptr;
 		TablespaceList *tablespacemappingptr;
 	} val;
@@ -110,6 +127,8 @@ typedef struct ConfigFileSetting
 		bool		booldefault;
 		failover_mode_opt failovermodedefault;
 		ConnectionCheckType checktypedefault;
+		LogFormat	logformatdefault;
+		UpstreamFailoverStrategy upstreamfailoverdefault;
 	} defval;
 	union {
 		int				intminval;
@@ -145,6 +164,8 @@ typedef struct
 	char		log_facility[MAXLEN];
 	char		log_file[MAXPGPATH];
 	int			log_status_interval;
+	int			log_buffer_size;
+	LogFormat	log_format;
 
 	/* standby clone settings */
 	bool		use_replication_slots;
@@ -182,6 +203,10 @@ typedef struct
 	/* witness settings */
 	int			witness_sync_interval;
 
+	/* parallel execution settings */
+	int			parallel_jobs;
+	int			remote_command_timeout;
+
 	/* repmgrd settings */
 	failover_mode_opt failover;
 	char		location[MAXLEN];
@@ -189,9 +214,16 @@ typedef struct
 	char		promote_command[MAXLEN];
 	char		follow_command[MAXLEN];
 	int			monitor_interval_secs;
+	int			monitor_interval_ms;
 	int			reconnect_attempts;
 	int			reconnect_interval;
+	bool		reconnect_backoff;
+	int			reconnect_initial_interval_ms;
 	bool		monitoring_history;
+	int			monitoring_history_flush_interval;
+	int			monitoring_history_max_records;
+	char		metrics_listen_address[MAXLEN];
+	int			metrics_port;
 	int			degraded_monitoring_timeout;
 	int			async_query_timeout;
 	int			primary_notification_timeout;
@@ -203,12 +235,23 @@ typedef struct
 	bool		primary_visibility_consensus;
 	char		failover_validation_command[MAXPGPATH];
 	int			election_rerun_interval;
+	int			election_prevote_timeout;
+	bool		promotion_candidate_scoring;
+	int			promotion_score_priority_weight;
+	int			promotion_score_replay_weight;
+	int			promotion_score_lag_weight;
+	int			promotion_score_location_weight;
+	UpstreamFailoverStrategy upstream_failover_strategy;
 	int			child_nodes_check_interval;
 	int			child_nodes_disconnect_min_count;
 	int			child_nodes_connected_min_count;
 	bool		child_nodes_connected_include_witness;
 	int			child_nodes_disconnect_timeout;
 	char		child_nodes_disconnect_command[MAXPGPATH];
+	int			replication_slot_check_interval;
+	int			replication_slot_retained_wal_threshold;
+	int			replication_slot_retained_wal_growth_rate;
+	int			replication_slot_inactive_drop_timeout;
 
 	/* service settings */
 	char		pg_ctl_options[MAXLEN];
@@ -226,15 +269,20 @@ typedef struct
 	char		event_notification_command[MAXPGPATH];
 	char		event_notifications_orig[MAXLEN];
 	EventNotificationList event_notifications;
+	int			event_notification_workers;
+	int			event_notification_queue_size;
+	int			event_notification_timeout;
 
 	/* barman settings */
 	char		barman_host[MAXLEN];
 	char		barman_server[MAXLEN];
 	char		barman_config[MAXLEN];
+	int			barman_restore_jobs;
 
 	/* rsync/ssh settings */
 	char		rsync_options[MAXLEN];
 	char		ssh_options[MAXLEN];
+	bool		ssh_multiplexing;
 
 	/* undocumented test settings */
 	int			promote_delay;
@@ -341,6 +389,8 @@ void		exit_with_cli_errors(ItemList *error_list, const char *repmgr_command);
 
 void		print_item_list(ItemList *item_list);
 const char *print_connection_check_type(ConnectionCheckType type);
+const char *print_log_format(LogFormat format);
+const char *print_upstream_failover_strategy(UpstreamFailoverStrategy strategy);
 char 	   *print_event_notification_list(EventNotificationList *list);
 
 extern bool modify_auto_conf(const char *data_dir, KeyValueList *items);
@@ -0,0 +1,202 @@
+#!/usr/bin/env perl
+#
+# cluster-benchmark.pl
+#
+# Measure how "repmgr cluster show", "repmgr cluster matrix" and
+# "repmgr cluster crosscheck" scale with the number of nodes.
+#
+# For each node count, a scratch database is created on an existing
+# PostgreSQL server and its "repmgr.nodes" table populated with synthetic
+# node records. Reachable nodes point back at the scratch database;
+# unreachable nodes point either at a port nothing is listening on
+# ("refused", the default) or at a non-routable address ("timeout").
+#
+# "cluster matrix" and "cluster crosscheck" execute repmgr on each node via
+# SSH, so require passwordless SSH access to the server's host.
+#
+# Executed by "make benchmark-cluster"; example:
+#
+#   contrib/cluster-benchmark.pl --host localhost --port 5432 --user postgres \
+#       --nodes 10,100,500 --commands show,matrix --unreachable-pct 10
+
+use strict;
+use warnings;
+
+use File::Temp qw(tempdir);
+use Getopt::Long;
+use POSIX qw(floor);
+use Time::HiRes qw(time);
+
+my %opt = (
+    'repmgr'           => 'repmgr',
+    'psql'             => 'psql',
+    'host'             => 'localhost',
+    'port'             => 5432,
+    'user'             => $ENV{USER},
+    'dbname'           => 'repmgr_bench',
+    'nodes'            => '10,50,100,250,500',
+    'commands'         => 'show',
+    'iterations'       => 3,
+    'unreachable-pct'  => 10,
+    'unreachable-mode' => 'refused',
+    'unreachable-port' => 1,
+    'set'              => [],
+    'help'             => 0,
+);
+
+GetOptions(\%opt,
+           'repmgr=s', 'psql=s', 'host=s', 'port=i', 'user=s', 'dbname=s',
+           'nodes=s', 'commands=s', 'iterations=i',
+           'unreachable-pct=i', 'unreachable-mode=s', 'unreachable-port=i',
+           'set=s@', 'help')
+    or usage(1);
+
+usage(0) if $opt{help};
+
+my @node_counts = split(/,/, $opt{nodes});
+my @commands = split(/,/, $opt{commands});
+
+foreach my $command (@commands) {
+    if ($command !~ m/^(show|matrix|crosscheck)$/) {
+        print STDERR qq|Unknown command "$command"\n|;
+        usage(1);
+    }
+}
+
+if ($opt{'unreachable-mode'} !~ m/^(refused|timeout)$/) {
+    print STDERR qq|Unknown unreachable mode "$opt{'unreachable-mode'}"\n|;
+    usage(1);
+}
+
+my $workdir = tempdir('repmgr-cluster-bench-XXXXXX', TMPDIR => 1, CLEANUP => 1);
+my $conf = "$workdir/repmgr.conf";
+my @results = ();
+
+foreach my $node_count (@node_counts) {
+    create_cluster($node_count);
+
+    foreach my $command (@commands) {
+        my @timings = ();
+
+        for my $i (1 .. $opt{iterations}) {
+            my $start = time();
+            system("$opt{repmgr} -f $conf cluster $command >/dev/null 2>&1");
+            push @timings, time() - $start;
+        }
+
+        @timings = sort { $a <=> $b } @timings;
+
+        push @results, {
+            nodes   => $node_count,
+            command => $command,
+            min     => $timings[0],
+            median  => $timings[floor($#timings / 2)],
+            max     => $timings[-1],
+        };
+
+        printf("%5d nodes: cluster %-10s median %.3f s\n", $node_count, $command, $results[-1]->{median});
+    }
+}
+
+psql('postgres', "DROP DATABASE IF EXISTS $opt{dbname}");
+
+printf("\n%-7s %-12s %10s %10s %10s\n", 'nodes', 'command', 'min', 'median', 'max');
+
+foreach my $result (@results) {
+    printf("%-7d %-12s %10.3f %10.3f %10.3f\n",
+           $result->{nodes}, $result->{command},
+           $result->{min}, $result->{median}, $result->{max});
+}
+
+exit(0);
+
+
+sub usage {
+    my ($exit_code) = @_;
+
+    print qq|Usage: $0 [OPTIONS]
+
+  --repmgr PATH             repmgr binary (default: repmgr)
+  --psql PATH               psql binary (default: psql)
+  --host HOST               server host (default: localhost)
+  --port PORT               server port (default: 5432)
+  --user USER               superuser to connect as (default: current user)
+  --dbname NAME             scratch database to create (default: repmgr_bench)
+  --nodes LIST              comma-separated node counts (default: 10,50,100,250,500)
+  --commands LIST           any of show,matrix,crosscheck (default: show)
+  --iterations N            executions of each command per node count (default: 3)
+  --unreachable-pct N       percentage of unreachable nodes (default: 10)
+  --unreachable-mode MODE   "refused" or "timeout" (default: refused)
+  --unreachable-port PORT   port used for "refused" nodes (default: 1)
+  --set NAME=VALUE          add a setting to repmgr.conf, e.g. parallel_jobs=16
+|;
+    exit($exit_code);
+}
+
+
+sub psql {
+    my ($dbname, $sql) = @_;
+    my $fh;
+
+    open($fh, '|-', "$opt{psql} -X -q -v ON_ERROR_STOP=1 -h $opt{host} -p $opt{port} -U $opt{user} -d $dbname >/dev/null")
+        or die "unable to execute psql\n";
+    print $fh "$sql;\n";
+    close($fh) or die "query failed:\n  $sql\n";
+}
+
+
+sub node_conninfo {
+    my ($node_id) = @_;
+    my $unreachable_interval = $opt{'unreachable-pct'} > 0 ? floor(100 / $opt{'unreachable-pct'}) : 0;
+
+    # node 1 is the primary, and always reachable
+    if ($node_id > 1 && $unreachable_interval > 0 && $node_id % $unreachable_interval == 0) {
+        return "host=192.0.2.1 port=$opt{port} user=$opt{user} dbname=$opt{dbname} connect_timeout=2"
+            if $opt{'unreachable-mode'} eq 'timeout';
+
+        return "host=$opt{host} port=$opt{'unreachable-port'} user=$opt{user} dbname=$opt{dbname} connect_timeout=2";
+    }
+
+    return "host=$opt{host} port=$opt{port} user=$opt{user} dbname=$opt{dbname} connect_timeout=2";
+}
+
+
+sub create_cluster {
+    my ($node_count) = @_;
+    my $fh;
+
+    psql('postgres', "DROP DATABASE IF EXISTS $opt{dbname}");
+    psql('postgres', "CREATE DATABASE $opt{dbname}");
+    psql($opt{dbname}, "CREATE EXTENSION repmgr");
+
+    my @rows = ();
+
+    for my $node_id (1 .. $node_count) {
+        push @rows, sprintf("(%d, %s, 'node%d', '%s', '%s', 'repmgr', '%s')",
+                            $node_id,
+                            $node_id == 1 ? 'NULL' : '1',
+                            $node_id,
+                            $node_id == 1 ? 'primary' : 'standby',
+                            node_conninfo($node_id),
+                            $conf);
+    }
+
+    psql($opt{dbname},
+         "INSERT INTO repmgr.nodes (node_id, upstream_node_id, node_name, type, conninfo, repluser, config_file) VALUES "
+         . join(",\n", @rows));
+
+    open($fh, '>', $conf) or die "unable to write $conf\n";
+
+    print $fh qq|node_id=1
+node_name='node1'
+conninfo='@{[node_conninfo(1)]}'
+data_directory='$workdir/data'
+log_level=ERROR
+|;
+
+    foreach my $setting (@{$opt{set}}) {
+        print $fh "$setting\n";
+    }
+
+    close($fh);
+}
@@ -0,0 +1,790 @@
+#!/usr/bin/env perl
+#
+# failover-benchmark.pl
+#
+# Build a local repmgr cluster, inject a failure (or execute a switchover)
+# and measure how long the cluster takes to recover. Each iteration is run
+# against a freshly built cluster so results are reproducible.
+#
+# All nodes run on the local host, listening on Unix sockets in the work
+# directory. The "switchover" scenario requires passwordless SSH access
+# to localhost for the user running the script.
+#
+# Measured for each iteration (in seconds, relative to the failure being
+# injected or the switchover being started):
+#
+#   promotion       time until a standby is no longer in recovery
+#   reattach        time until all surviving standbys are streaming from a
+#                   node other than the failed primary
+#   write_downtime  longest gap between successful writes executed by a
+#                   background writer process
+#
+# plus the per-phase timings (detection, election, promote etc.) reported
+# by repmgrd in the "repmgrd_failover_promote" event.
+#
+# Example:
+#
+#   contrib/failover-benchmark.pl --standbys 3 --witness --scenario primary-kill \
+#       --iterations 5 --set monitor_interval_secs=1 --set reconnect_attempts=2
+
+use strict;
+use warnings;
+
+use File::Path qw(make_path remove_tree);
+use File::Temp qw(tempdir);
+use Getopt::Long;
+use IO::Handle;
+use POSIX qw(floor);
+use Time::HiRes qw(time sleep);
+
+my %opt = (
+    'bindir'          => undef,
+    'repmgr-bindir'   => undef,
+    'workdir'         => undef,
+    'standbys'        => 2,
+    'cascades'        => 0,
+    'witness'         => 0,
+    'scenario'        => 'primary-kill',
+    'iterations'      => 3,
+    'base-port'       => 55432,
+    'timeout'         => 120,
+    'stall-ms'        => 3000,
+    'stall-duration'  => 30,
+    'write-interval'  => 0.05,
+    'set'             => [],
+    'csv'             => undef,
+    'keep'            => 0,
+    'help'            => 0,
+);
+
+my @scenarios = qw(primary-kill partition slow-upstream switchover);
+
+GetOptions(\%opt,
+           'bindir=s', 'repmgr-bindir=s', 'workdir=s',
+           'standbys=i', 'cascades=i', 'witness!',
+           'scenario=s', 'iterations=i', 'base-port=i', 'timeout=i',
+           'stall-ms=i', 'stall-duration=i', 'write-interval=f',
+           'set=s@', 'csv=s', 'keep!', 'help')
+    or usage(1);
+
+usage(0) if $opt{help};
+
+if (!grep { $_ eq $opt{scenario} } @scenarios) {
+    print STDERR qq|Unknown scenario "$opt{scenario}"\n|;
+    usage(1);
+}
+
+if ($opt{standbys} < 1) {
+    print STDERR qq|At least one standby is required\n|;
+    exit(1);
+}
+
+if ($opt{cascades} > 0 && $opt{standbys} < 2) {
+    print STDERR qq|Cascaded standbys require at least two standbys\n|;
+    exit(1);
+}
+
+if (!defined $opt{bindir}) {
+    $opt{bindir} = `pg_config --bindir`;
+    if ($? != 0 || !defined $opt{bindir}) {
+        print STDERR qq|Unable to execute "pg_config"; please provide --bindir\n|;
+        exit(1);
+    }
+    chomp $opt{bindir};
+}
+
+$opt{'repmgr-bindir'} = $opt{bindir} unless defined $opt{'repmgr-bindir'};
+
+my $workdir = defined $opt{workdir}
+    ? $opt{workdir}
+    : tempdir('repmgr-bench-XXXXXX', TMPDIR => 1, CLEANUP => !$opt{keep});
+
+my $socket_dir = "$workdir/sockets";
+my @nodes = ();
+my $writer_pid = undef;
+my @results = ();
+
+$ENV{PGCONNECT_TIMEOUT} = 1;
+
+$SIG{INT} = $SIG{TERM} = sub {
+    teardown_cluster();
+    exit(1);
+};
+
+for my $iteration (1 .. $opt{iterations}) {
+    log_msg("iteration $iteration of $opt{iterations}: building cluster");
+    build_cluster();
+
+    my $result = run_scenario($opt{scenario});
+    $result->{iteration} = $iteration;
+    push @results, $result;
+
+    print_result($result);
+
+    teardown_cluster();
+}
+
+print_summary(\@results);
+write_csv(\@results, $opt{csv}) if defined $opt{csv};
+
+exit(0);
+
+
+sub usage {
+    my ($exit_code) = @_;
+
+    print qq|Usage: $0 [OPTIONS]
+
+Cluster options:
+  --bindir DIR            PostgreSQL binary directory (default: "pg_config --bindir")
+  --repmgr-bindir DIR     directory containing repmgr and repmgrd (default: --bindir)
+  --workdir DIR           directory for the cluster (default: temporary directory)
+  --standbys N            number of standbys attached to the primary (default: 2)
+  --cascades N            number of standbys attached to the first standby (default: 0)
+  --witness               add a witness node
+  --base-port PORT        port of the first node (default: 55432)
+  --set NAME=VALUE        add a setting to each node's repmgr.conf; may be repeated
+
+Benchmark options:
+  --scenario NAME         one of: @scenarios (default: primary-kill)
+  --iterations N          number of iterations (default: 3)
+  --timeout SECS          maximum time to wait for recovery (default: 120)
+  --stall-ms MS           slow-upstream: length of each stall (default: 3000)
+  --stall-duration SECS   slow-upstream: length of the stall phase (default: 30)
+  --write-interval SECS   interval between writes (default: 0.05)
+  --csv FILE              write per-iteration results to FILE
+  --keep                  don't remove the work directory
+|;
+    exit($exit_code);
+}
+
+
+sub log_msg {
+    my ($msg) = @_;
+    my @t = localtime();
+
+    printf("[%02d:%02d:%02d] %s\n", $t[2], $t[1], $t[0], $msg);
+}
+
+
+sub run_cmd {
+    my ($cmd, $allow_failure) = @_;
+
+    my $output = `$cmd 2>&1`;
+
+    if ($? != 0 && !$allow_failure) {
+        print STDERR qq|Command failed:\n  $cmd\n$output\n|;
+        teardown_cluster();
+        exit(1);
+    }
+
+    return $output;
+}
+
+
+sub pg_bin {
+    my ($prog) = @_;
+
+    return "$opt{bindir}/$prog";
+}
+
+
+sub repmgr_bin {
+    my ($prog) = @_;
+
+    return "$opt{'repmgr-bindir'}/$prog";
+}
+
+
+sub conninfo {
+    my ($node) = @_;
+
+    return "host=$socket_dir port=$node->{port} user=repmgr dbname=repmgr connect_timeout=2";
+}
+
+
+# Execute a query on a node; returns undef if the node could not be queried
+sub psql_value {
+    my ($node, $query) = @_;
+
+    my $output = `$opt{bindir}/psql -X -A -t -q -d "@{[conninfo($node)]}" -c "$query" 2>/dev/null`;
+
+    return undef if $? != 0;
+
+    chomp $output;
+    return $output;
+}
+
+
+# ---------------------------------------------------------------------------
+# Cluster setup
+# ---------------------------------------------------------------------------
+
+sub build_cluster {
+    my $port = $opt{'base-port'};
+    my $node_id = 1;
+
+    remove_tree("$workdir/nodes");
+    make_path("$workdir/nodes", $socket_dir);
+
+    @nodes = ();
+
+    push @nodes, new_node($node_id++, 'primary', $port++, undef);
+
+    for my $i (1 .. $opt{standbys}) {
+        push @nodes, new_node($node_id++, 'standby', $port++, 1);
+    }
+
+    for my $i (1 .. $opt{cascades}) {
+        push @nodes, new_node($node_id++, 'standby', $port++, 2);
+    }
+
+    if ($opt{witness}) {
+        push @nodes, new_node($node_id++, 'witness', $port++, undef);
+    }
+
+    foreach my $node (@nodes) {
+        write_repmgr_conf($node);
+    }
+
+    my $primary = $nodes[0];
+
+    init_node($primary);
+    start_node($primary);
+    run_cmd(pg_bin('createuser') . " -h $socket_dir -p $primary->{port} -s repmgr");
+    run_cmd(pg_bin('createdb') . " -h $socket_dir -p $primary->{port} -O repmgr repmgr");
+    run_cmd(repmgr_bin('repmgr') . " -f $primary->{conf} primary register");
+
+    foreach my $node (@nodes) {
+        next unless $node->{type} eq 'standby';
+
+        my $upstream = $nodes[$node->{upstream_id} - 1];
+        my $upstream_opt = $node->{upstream_id} == 1 ? '' : " --upstream-node-id=$node->{upstream_id}";
+
+        run_cmd(repmgr_bin('repmgr') . " -f $node->{conf} -h $socket_dir -p $upstream->{port} -U repmgr -d repmgr"
+                . " standby clone --fast-checkpoint$upstream_opt");
+        set_node_port($node);
+        start_node($node);
+        run_cmd(repmgr_bin('repmgr') . " -f $node->{conf} standby register --wait-sync=$opt{timeout}$upstream_opt");
+    }
+
+    foreach my $node (@nodes) {
+        next unless $node->{type} eq 'witness';
+
+        init_node($node);
+        start_node($node);
+        run_cmd(pg_bin('createuser') . " -h $socket_dir -p $node->{port} -s repmgr");
+        run_cmd(pg_bin('createdb') . " -h $socket_dir -p $node->{port} -O repmgr repmgr");
+        run_cmd(repmgr_bin('repmgr') . " -f $node->{conf} -h $socket_dir -p $primary->{port} -U repmgr -d repmgr witness register");
+    }
+
+    run_cmd($opt{bindir} . "/psql -X -q -d \"" . conninfo($primary) . "\""
+            . " -c \"CREATE TABLE public.benchmark_writes (id SERIAL PRIMARY KEY, ts TIMESTAMPTZ NOT NULL DEFAULT now())\"");
+
+    foreach my $node (@nodes) {
+        run_cmd(repmgr_bin('repmgrd') . " -f $node->{conf} >/dev/null");
+    }
+
+    # give each repmgrd the chance to start monitoring
+    wait_for(sub {
+        foreach my $node (@nodes) {
+            my $running = psql_value($node, 'SELECT repmgr.repmgrd_is_running()');
+            return 0 unless defined $running && $running eq 't';
+        }
+        return 1;
+    }, $opt{timeout}) or die_with_teardown("repmgrd did not start on all nodes");
+}
+
+
+sub new_node {
+    my ($node_id, $type, $port, $upstream_id) = @_;
+
+    my $name = "node$node_id";
+
+    return {
+        node_id     => $node_id,
+        name        => $name,
+        type        => $type,
+        port        => $port,
+        upstream_id => $upstream_id,
+        datadir     => "$workdir/nodes/$name/data",
+        conf        => "$workdir/nodes/$name/repmgr.conf",
+        logfile     => "$workdir/nodes/$name/postgres.log",
+    };
+}
+
+
+sub write_repmgr_conf {
+    my ($node) = @_;
+    my $dir = "$workdir/nodes/$node->{name}";
+    my $repmgr = repmgr_bin('repmgr');
+    my $fh;
+
+    make_path($dir);
+
+    open($fh, '>', $node->{conf}) or die_with_teardown("unable to write $node->{conf}");
+
+    print $fh qq|node_id=$node->{node_id}
+node_name='$node->{name}'
+conninfo='@{[conninfo($node)]}'
+data_directory='$node->{datadir}'
+pg_bindir='$opt{bindir}'
+repmgr_bindir='$opt{'repmgr-bindir'}'
+use_replication_slots=true
+log_file='$dir/repmgrd.log'
+log_level=INFO
+repmgrd_pid_file='$dir/repmgrd.pid'
+failover=automatic
+promote_command='$repmgr standby promote -f $node->{conf} --log-to-file'
+follow_command='$repmgr standby follow -f $node->{conf} --log-to-file --upstream-node-id=%n'
+monitor_interval_secs=2
+reconnect_attempts=3
+reconnect_interval=1
+|;
+
+    foreach my $setting (@{$opt{set}}) {
+        print $fh "$setting\n";
+    }
+
+    close($fh);
+}
+
+
+sub init_node {
+    my ($node) = @_;
+
+    run_cmd(pg_bin('initdb') . " -D $node->{datadir} -A trust --no-sync");
+
+    my $fh;
+    open($fh, '>>', "$node->{datadir}/postgresql.conf") or die_with_teardown("unable to write postgresql.conf");
+
+    print $fh qq|
+port = $node->{port}
+listen_addresses = ''
+unix_socket_directories = '$socket_dir'
+shared_preload_libraries = 'repmgr'
+wal_level = replica
+wal_log_hints = on
+hot_standby = on
+max_wal_senders = 20
+max_replication_slots = 20
+fsync = off
+|;
+
+    close($fh);
+}
+
+
+# Cloned standbys inherit the upstream's configuration, including its port
+sub set_node_port {
+    my ($node) = @_;
+    my $fh;
+
+    open($fh, '>>', "$node->{datadir}/postgresql.conf") or die_with_teardown("unable to write postgresql.conf");
+    print $fh "\nport = $node->{port}\n";
+    close($fh);
+}
+
+
+sub start_node {
+    my ($node) = @_;
+
+    run_cmd(pg_bin('pg_ctl') . " -D $node->{datadir} -l $node->{logfile} -w start");
+}
+
+
+sub postmaster_pid {
+    my ($node) = @_;
+    my $fh;
+
+    open($fh, '<', "$node->{datadir}/postmaster.pid") or return undef;
+    my $pid = <$fh>;
+    close($fh);
+
+    chomp $pid if defined $pid;
+    return $pid;
+}
+
+
+# The postmaster and all its child processes
+sub postgres_pids {
+    my ($node) = @_;
+    my $pm_pid = postmaster_pid($node);
+
+    return () unless defined $pm_pid;
+
+    my @pids = ($pm_pid);
+
+    foreach my $line (split(/\n/, `ps -e -o pid= -o ppid=`)) {
+        my ($pid, $ppid) = split(' ', $line);
+        push @pids, $pid if defined $ppid && $ppid == $pm_pid;
+    }
+
+    return @pids;
+}
+
+
+sub repmgrd_pid {
+    my ($node) = @_;
+    my $fh;
+
+    open($fh, '<', "$workdir/nodes/$node->{name}/repmgrd.pid") or return undef;
+    my $pid = <$fh>;
+    close($fh);
+
+    chomp $pid if defined $pid;
+    return $pid;
+}
+
+
+sub teardown_cluster {
+    stop_writer();
+
+    foreach my $node (@nodes) {
+        my $pid = repmgrd_pid($node);
+
+        if (defined $pid) {
+            kill('CONT', $pid);
+            kill('TERM', $pid);
+        }
+
+        # resume any stalled processes so the node can be shut down
+        stall_processes('CONT', postgres_pids($node));
+
+        run_cmd(pg_bin('pg_ctl') . " -D $node->{datadir} -m immediate -w stop", 1)
+            if -d $node->{datadir};
+    }
+
+    @nodes = ();
+}
+
+
+sub die_with_teardown {
+    my ($msg) = @_;
+
+    print STDERR "$msg\n";
+    teardown_cluster();
+    exit(1);
+}
+
+
+sub wait_for {
+    my ($check, $timeout) = @_;
+    my $start = time();
+
+    while (time() - $start < $timeout) {
+        return 1 if $check->();
+        sleep(0.1);
+    }
+
+    return 0;
+}
+
+
+# ---------------------------------------------------------------------------
+# Background writer
+# ---------------------------------------------------------------------------
+
+sub start_writer {
+    my $log = "$workdir/writes.log";
+
+    my @hosts = map { $socket_dir } grep { $_->{type} ne 'witness' } @nodes;
+    my @ports = map { $_->{port} } grep { $_->{type} ne 'witness' } @nodes;
+
+    my $conninfo = sprintf("host=%s port=%s user=repmgr dbname=repmgr connect_timeout=1 target_session_attrs=read-write",
+                           join(',', @hosts), join(',', @ports));
+
+    unlink($log);
+
+    $writer_pid = fork();
+
+    die_with_teardown("unable to fork writer process") unless defined $writer_pid;
+
+    if ($writer_pid == 0) {
+        my $fh;
+
+        $SIG{INT} = $SIG{TERM} = 'DEFAULT';
+
+        open($fh, '>', $log) or POSIX::_exit(1);
+        $fh->autoflush(1);
+
+        while (1) {
+            my $start = time();
+
+            system("$opt{bindir}/psql -X -q -d \"$conninfo\" -c \"INSERT INTO public.benchmark_writes DEFAULT VALUES\" >/dev/null 2>&1");
+
+            printf $fh "%.3f %d\n", $start, ($? == 0) ? 1 : 0;
+
+            my $elapsed = time() - $start;
+            sleep($opt{'write-interval'} - $elapsed) if $elapsed < $opt{'write-interval'};
+        }
+    }
+
+    # wait for the first successful write
+    wait_for(sub { (last_write_log($log) // 0) > 0 }, 10);
+}
+
+
+sub stop_writer {
+    return unless defined $writer_pid;
+
+    kill('TERM', $writer_pid);
+    waitpid($writer_pid, 0);
+    $writer_pid = undef;
+}
+
+
+sub last_write_log {
+    my ($log) = @_;
+    my $fh;
+    my $count = 0;
+
+    open($fh, '<', $log) or return undef;
+    while (<$fh>) {
+        $count++ if m|\s1$|;
+    }
+    close($fh);
+
+    return $count;
+}
+
+
+# Longest gap between successful writes started between "$since" and
+# "$until"; if no write succeeded after the last gap, it extends to "$until"
+sub write_downtime {
+    my ($since, $until) = @_;
+    my $fh;
+    my $last_success = undef;
+    my $max_gap = 0;
+
+    open($fh, '<', "$workdir/writes.log") or return undef;
+
+    while (<$fh>) {
+        my ($ts, $ok) = split;
+
+        next unless $ok;
+
+        if (defined $last_success && $ts >= $since) {
+            $max_gap = $ts - $last_success if $ts - $last_success > $max_gap;
+        }
+
+        $last_success = $ts;
+    }
+
+    close($fh);
+
+    return undef unless defined $last_success;
+
+    $max_gap = $until - $last_success if $until - $last_success > $max_gap;
+
+    return $max_gap;
+}
+
+
+# ---------------------------------------------------------------------------
+# Scenarios
+# ---------------------------------------------------------------------------
+
+sub run_scenario {
+    my ($scenario) = @_;
+    my $primary = $nodes[0];
+    my $result = { scenario => $scenario };
+    my $start;
+
+    start_writer();
+
+    if ($scenario eq 'primary-kill') {
+        log_msg("killing primary \"$primary->{name}\"");
+        $start = time();
+        stall_processes('KILL', repmgrd_pid($primary));
+        run_cmd(pg_bin('pg_ctl') . " -D $primary->{datadir} -m immediate -w stop");
+    }
+    elsif ($scenario eq 'partition') {
+        # freezing the primary and its repmgrd makes it unresponsive without
+        # closing any connections, as a network partition would
+        log_msg("partitioning primary \"$primary->{name}\"");
+        $start = time();
+        stall_processes('STOP', repmgrd_pid($primary), postgres_pids($primary));
+    }
+    elsif ($scenario eq 'slow-upstream') {
+        log_msg("stalling primary \"$primary->{name}\" for $opt{'stall-ms'} ms at a time for $opt{'stall-duration'} seconds");
+        $start = time();
+        my @pids = postgres_pids($primary);
+
+        while (time() - $start < $opt{'stall-duration'}) {
+            stall_processes('STOP', @pids);
+            sleep($opt{'stall-ms'} / 1000);
+            stall_processes('CONT', @pids);
+            sleep($opt{'stall-ms'} / 1000);
+        }
+    }
+    elsif ($scenario eq 'switchover') {
+        my $candidate = $nodes[1];
+
+        log_msg("switching over to \"$candidate->{name}\"");
+        $start = time();
+        run_cmd(repmgr_bin('repmgr') . " -f $candidate->{conf} standby switchover --siblings-follow");
+        $result->{switchover} = time() - $start;
+    }
+
+    measure_recovery($result, $start, $scenario eq 'switchover' ? undef : $primary);
+
+    stop_writer();
+    $result->{write_downtime} = write_downtime($start, time());
+
+    return $result;
+}
+
+
+sub stall_processes {
+    my ($signal, @pids) = @_;
+
+    foreach my $pid (grep { defined } @pids) {
+        kill($signal, $pid);
+    }
+}
+
+
+sub measure_recovery {
+    my ($result, $start, $failed_node) = @_;
+    my $new_primary = undef;
+
+    my @candidates = grep { $_->{type} eq 'standby' } @nodes;
+
+    # in "slow-upstream" the original primary may recover, which is the expected outcome
+    if ($opt{scenario} eq 'slow-upstream') {
+        $result->{promotion} = undef;
+        foreach my $node (@candidates) {
+            my $in_recovery = psql_value($node, 'SELECT pg_catalog.pg_is_in_recovery()');
+            if (defined $in_recovery && $in_recovery eq 'f') {
+                $result->{spurious_failover} = 1;
+                $new_primary = $node;
+            }
+        }
+        $result->{spurious_failover} //= 0;
+        return unless defined $new_primary;
+    }
+    else {
+        wait_for(sub {
+            foreach my $node (@candidates) {
+                my $in_recovery = psql_value($node, 'SELECT pg_catalog.pg_is_in_recovery()');
+                if (defined $in_recovery && $in_recovery eq 'f') {
+                    $new_primary = $node;
+                    return 1;
+                }
+            }
+            return 0;
+        }, $opt{timeout});
+
+        if (!defined $new_primary) {
+            log_msg("no standby was promoted within $opt{timeout} seconds");
+            return;
+        }
+
+        $result->{promotion} = time() - $start;
+    }
+
+    $result->{new_primary} = $new_primary->{name};
+
+    # all surviving standbys streaming from a node other than the failed primary
+    my @followers = grep { $_->{type} eq 'standby' && $_ != $new_primary } @nodes;
+    push @followers, $nodes[0] if !defined $failed_node;
+
+    my $attached = wait_for(sub {
+        foreach my $node (@followers) {
+            my $receiver = psql_value($node, "SELECT status || ' ' || conninfo FROM pg_catalog.pg_stat_wal_receiver");
+            return 0 unless defined $receiver && $receiver =~ m|^streaming |;
+            return 0 if defined $failed_node && $receiver =~ m|port=$failed_node->{port}\b|;
+        }
+        return 1;
+    }, $opt{timeout});
+
+    $result->{reattach} = $attached ? time() - $start : undef;
+
+    # phase timings as reported by repmgrd
+    my $details = psql_value($new_primary,
+                             "SELECT details FROM repmgr.events WHERE event = 'repmgrd_failover_promote' ORDER BY event_timestamp DESC LIMIT 1");
+
+    if (defined $details && $details =~ m|phase timings \(ms\): (.+)$|) {
+        foreach my $timing (split(/, /, $1)) {
+            my ($phase, $ms) = split(/=/, $timing);
+            $result->{"phase_$phase"} = $ms / 1000;
+        }
+    }
+}
+
+
+# ---------------------------------------------------------------------------
+# Reporting
+# ---------------------------------------------------------------------------
+
+sub result_columns {
+    my ($results) = @_;
+    my %seen = ();
+
+    foreach my $result (@$results) {
+        $seen{$_} = 1 foreach grep { m|^phase_| } keys %$result;
+    }
+
+    return ('promotion', 'reattach', 'write_downtime', 'switchover', 'spurious_failover', sort keys %seen);
+}
+
+
+sub format_value {
+    my ($value) = @_;
+
+    return '-' unless defined $value;
+    return sprintf('%.3f', $value);
+}
+
+
+sub print_result {
+    my ($result) = @_;
+    my @parts = ();
+
+    foreach my $column (result_columns([$result])) {
+        next unless exists $result->{$column};
+        push @parts, "$column=" . format_value($result->{$column});
+    }
+
+    push @parts, "new_primary=$result->{new_primary}" if defined $result->{new_primary};
+
+    log_msg("iteration $result->{iteration}: " . join(' ', @parts));
+}
+
+
+sub print_summary {
+    my ($results) = @_;
+
+    printf("\n%-24s %10s %10s %10s %10s\n", 'metric (seconds)', 'min', 'median', 'max', 'samples');
+
+    foreach my $column (result_columns($results)) {
+        my @values = sort { $a <=> $b } grep { defined } map { $_->{$column} } @$results;
+
+        next unless @values;
+
+        printf("%-24s %10.3f %10.3f %10.3f %10d\n",
+               $column,
+               $values[0],
+               $values[floor($#values / 2)],
+               $values[-1],
+               scalar @values);
+    }
+}
+
+
+sub write_csv {
+    my ($results, $file) = @_;
+    my @columns = ('iteration', 'scenario', result_columns($results), 'new_primary');
+    my $fh;
+
+    open($fh, '>', $file) or die "unable to write $file\n";
+
+    print $fh join(',', @columns) . "\n";
+
+    foreach my $result (@$results) {
+        print $fh join(',', map { defined $result->{$_} ? $result->{$_} : '' } @columns) . "\n";
+    }
+
+    close($fh);
+}
@@ -23,6 +23,10 @@
 #include <sys/time.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
 #include <arpa/inet.h>
 
 #include "repmgr.h"
@@ -31,6 +35,7 @@
 #include "dirutil.h"
 
 #define NODE_RECORD_PARAM_COUNT 11
+#define NODE_RECORD_INT_LEN 12
 
 
 static void log_db_error(PGconn *conn, const char *query_text, const char *fmt,...)
@@ -54,6 +59,13 @@ static RecordStatus _get_node_record(PGconn *conn, char *sqlquery, t_node_info *
 static void _populate_node_record(PGresult *res, t_node_info *node_info, int row, bool init_defaults);
 
 static void _populate_node_records(PGresult *res, NodeInfoList *node_list);
+static bool _get_node_records_hash(PGconn *conn, char *hash);
+static bool _node_records_equal(t_node_info *node_a, t_node_info *node_b);
+static bool _insert_node_records(PGconn *conn, t_node_info **nodes, int node_count);
+static void _release_node_list_entries(NodeInfoList *nodes);
+static void _init_node_tables(NodeInfoList *node_list, int count);
+static void _build_node_list_index(NodeInfoList *node_list);
+static bool _node_list_is_indexed(NodeInfoList *node_list);
 
 static bool _create_update_node_record(PGconn *conn, char *action, t_node_info *node_info);
 
@@ -61,6 +73,45 @@ static ReplSlotStatus _verify_replication_slot(PGconn *conn, char *slot_name, PQ
 
 static bool _create_event(PGconn *conn, t_configuration_options *options, int node_id, char *event, bool successful, char *details, t_event_info *event_info, bool send_notification);
 
+typedef void (*t_node_query_result_handler) (t_node_info *node_info, PGresult *res);
+
+static void _execute_node_queries_parallel(t_node_info **nodes, const char **queries, int node_count, t_node_query_result_handler handler, int timeout);
+static void _get_node_status_result(t_node_info *node_info, PGresult *res);
+static void _repmgrd_pause_result(t_node_info *node_info, PGresult *res);
+static void _get_repmgrd_status_result(t_node_info *node_info, PGresult *res);
+static void _notify_follow_primary_result(t_node_info *node_info, PGresult *res);
+
+static void _build_replication_info_query(PGconn *conn, t_server_type node_type, bool election_status, PQExpBufferData *query);
+static void _populate_replication_info(PGresult *res, bool election_status, ReplInfo *replication_info);
+static void _get_replication_info_result(t_node_info *node_info, PGresult *res);
+
+/*
+ * Cache of replication protocol results used when checking whether a node
+ * can follow another; see get_cached_system_identification() and
+ * get_cached_timeline_history().
+ */
+typedef struct SystemIdentificationCacheEntry
+{
+	int			node_id;
+	t_system_identification identification;
+	struct SystemIdentificationCacheEntry *next;
+} SystemIdentificationCacheEntry;
+
+typedef struct TimelineHistoryCacheEntry
+{
+	uint64		system_identifier;
+	TimeLineID	tli;
+	TimeLineHistoryEntry history;
+	struct TimelineHistoryCacheEntry *next;
+} TimelineHistoryCacheEntry;
+
+static SystemIdentificationCacheEntry *system_identification_cache = NULL;
+static TimelineHistoryCacheEntry *timeline_history_cache = NULL;
+
+static void _get_archive_status_dir(PGconn *conn, const char *data_directory, char *archive_status_dir);
+static int	_estimate_ready_archive_files(PGconn *conn, const char *archive_status_dir);
+static int	_count_ready_archive_files(const char *archive_status_dir);
+
 /*
  * This provides a standardized way of logging database errors. Note
  * that the provided PGconn can be a normal or a replication connection;
@@ -110,6 +161,64 @@ parse_lsn(const char *str)
 }
 
 
+/*
+ * Parse the value provided with "cluster event --before/--after", which is
+ * either a timestamp, or a "timestamp,node_id,event" key.
+ *
+ * The timestamp itself is validated by PostgreSQL when the query is executed;
+ * here we just reject anything which can't be part of a timestamp.
+ */
+bool
+parse_event_pagination_key(const char *str, t_event_pagination_key *key)
+{
+	const char *timestamp_chars = "0123456789 :.+-/abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	const char *event_chars = "_0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	const char *first_sep = strchr(str, ',');
+	const char *last_sep = strrchr(str, ',');
+	size_t		timestamp_len;
+	char	   *endptr = NULL;
+	long		node_id;
+
+	memset(key, 0, sizeof(t_event_pagination_key));
+	key->node_id = UNKNOWN_NODE_ID;
+
+	timestamp_len = (first_sep == NULL) ? strlen(str) : (size_t) (first_sep - str);
+
+	if (timestamp_len == 0 || timestamp_len >= sizeof(key->timestamp))
+		return false;
+
+	if (strspn(str, timestamp_chars) != timestamp_len)
+		return false;
+
+	memcpy(key->timestamp, str, timestamp_len);
+
+	if (first_sep == NULL)
+		return true;
+
+	/* exactly three elements are required */
+	if (first_sep == last_sep)
+		return false;
+
+	errno = 0;
+	node_id = strtol(first_sep + 1, &endptr, 10);
+
+	if (errno != 0 || endptr != last_sep || endptr == first_sep + 1
+		|| node_id < MIN_NODE_ID || node_id != (int) node_id)
+		return false;
+
+	key->node_id = (int) node_id;
+
+	if (last_sep[1] == '\0'
+		|| strlen(last_sep + 1) >= sizeof(key->event)
+		|| strspn(last_sep + 1, event_chars) != strlen(last_sep + 1))
+		return false;
+
+	strncpy(key->event, last_sep + 1, sizeof(key->event));
+
+	return true;
+}
+
+
 /* ==================== */
 /* Connection functions */
 /* ==================== */
@@ -449,465 +558,1062 @@ close_connection(PGconn **conn)
 }
 
 
-/* =============================== */
-/* conninfo manipulation functions */
-/* =============================== */
-
-
 /*
- * get_conninfo_value()
+ * establish_node_connections_parallel()
  *
- * Extract the value represented by 'keyword' in 'conninfo' and copy
- * it to the 'output' buffer.
+ * Connect to each node in the provided list, using libpq's non-blocking
+ * connection API so that connection attempts are made concurrently, with
+ * at most "max_parallel" attempts in progress at any one time. The overall
+ * time taken is therefore bounded by the slowest node(s), rather than
+ * the sum of all connection attempts.
  *
- * Returns true on success, or false on failure (conninfo string could
- * not be parsed, or provided keyword not found).
+ * Each node's "conn" field will be set to the resulting connection handle,
+ * which the caller must check with PQstatus() and close. If a connection
+ * attempt is not completed within the node's "connect_timeout" (default: 2
+ * seconds, as for _establish_db_connection()), "conn" will be set to NULL.
+ * Nodes which already have a usable connection are left as-is.
+ *
+ * NOTE: these connections are intended for status checks; unlike
+ * _establish_db_connection(), "synchronous_commit" is not set.
+ *
+ * Returns the number of nodes successfully connected to.
  */
-
-bool
-get_conninfo_value(const char *conninfo, const char *keyword, char *output)
+int
+establish_node_connections_parallel(NodeInfoList *node_list, int max_parallel)
 {
-	PQconninfoOption *conninfo_options = NULL;
-	PQconninfoOption *conninfo_option = NULL;
+	NodeInfoListCell *cell = NULL;
+	NodeInfoListCell **pending = NULL;
+	instr_time *start_times = NULL;
+	int		   *timeouts = NULL;
+	PostgresPollingStatusType *poll_statuses = NULL;
+	struct pollfd *pollfds = NULL;
+	int			pending_count = 0;
+	int			connected_count = 0;
+	int			i;
 
-	conninfo_options = PQconninfoParse(conninfo, NULL);
+	if (node_list->node_count == 0)
+		return 0;
 
-	if (conninfo_options == NULL)
-	{
-		log_error(_("unable to parse provided conninfo string \"%s\""), conninfo);
-		return false;
-	}
+	if (max_parallel < 1)
+		max_parallel = 1;
 
-	for (conninfo_option = conninfo_options; conninfo_option->keyword != NULL; conninfo_option++)
+	if (max_parallel > node_list->node_count)
+		max_parallel = node_list->node_count;
+
+	pending = arena_alloc0(sizeof(NodeInfoListCell *) * max_parallel);
+	start_times = arena_alloc0(sizeof(instr_time) * max_parallel);
+	timeouts = arena_alloc0(sizeof(int) * max_parallel);
+	poll_statuses = arena_alloc0(sizeof(PostgresPollingStatusType) * max_parallel);
+	pollfds = arena_alloc0(sizeof(struct pollfd) * max_parallel);
+
+	cell = node_list->head;
+
+	while (cell != NULL || pending_count > 0)
 	{
-		if (strcmp(conninfo_option->keyword, keyword) == 0)
+		int			poll_timeout = -1;
+		instr_time	current_time;
+
+		/* start new connection attempts, up to the permitted maximum */
+		while (cell != NULL && pending_count < max_parallel)
 		{
-			if (conninfo_option->val != NULL && conninfo_option->val[0] != '\0')
+			t_conninfo_param_list conninfo_params = T_CONNINFO_PARAM_LIST_INITIALIZER;
+			char	   *errmsg = NULL;
+			char	   *connect_timeout = NULL;
+			t_node_info *node_info = cell->node_info;
+
+			/* an existing usable connection can be used as-is */
+			if (PQstatus(node_info->conn) == CONNECTION_OK)
 			{
-				strncpy(output, conninfo_option->val, MAXLEN);
-				break;
+				connected_count++;
+				cell = cell->next;
+				continue;
 			}
-		}
-	}
 
-	PQconninfoFree(conninfo_options);
+			node_info->conn = NULL;
 
-	return true;
-}
+			initialize_conninfo_params(&conninfo_params, false);
 
+			if (parse_conninfo_string(node_info->conninfo, &conninfo_params, &errmsg, false) == false)
+			{
+				log_warning(_("unable to parse conninfo string \"%s\" for node \"%s\" (ID: %i)"),
+							node_info->conninfo,
+							node_info->node_name,
+							node_info->node_id);
+				log_detail("%s", errmsg);
+				free_conninfo_params(&conninfo_params);
+				cell = cell->next;
+				continue;
+			}
 
-/*
- * Get a default conninfo value for the provided parameter, and copy
- * it to the 'output' buffer.
- *
- * Returns true on success, or false on failure (provided keyword not found).
- *
- */
-bool
-get_conninfo_default_value(const char *param, char *output, int maxlen)
-{
-	PQconninfoOption *defs = NULL;
-	PQconninfoOption *def = NULL;
-	bool found = false;
+			/* same defaults as _establish_db_connection() */
+			param_set_ine(&conninfo_params, "connect_timeout", "2");
+			param_set_ine(&conninfo_params, "fallback_application_name", "repmgr");
+			param_set(&conninfo_params, "options", "-csearch_path=");
 
-	defs = PQconndefaults();
+			/* libpq treats any connect_timeout value below 2 as 2 */
+			connect_timeout = param_get(&conninfo_params, "connect_timeout");
+			timeouts[pending_count] = atoi(connect_timeout);
+			if (timeouts[pending_count] < 2)
+				timeouts[pending_count] = 2;
 
-	for (def = defs; def->keyword; def++)
-	{
-		if (strncmp(def->keyword, param, maxlen) == 0)
-		{
-			strncpy(output, def->val, maxlen);
-			found = true;
+			log_verbose(LOG_DEBUG, "establish_node_connections_parallel(): connecting to node %i", node_info->node_id);
+
+			node_info->conn = PQconnectStartParams((const char **) conninfo_params.keywords,
+												   (const char **) conninfo_params.values,
+												   true);
+			free_conninfo_params(&conninfo_params);
+
+			if (node_info->conn == NULL || PQstatus(node_info->conn) == CONNECTION_BAD)
+			{
+				cell = cell->next;
+				continue;
+			}
+
+			pending[pending_count] = cell;
+			poll_statuses[pending_count] = PGRES_POLLING_WRITING;
+			INSTR_TIME_SET_CURRENT(start_times[pending_count]);
+			pending_count++;
+
+			cell = cell->next;
 		}
-	}
 
-	PQconninfoFree(defs);
+		if (pending_count == 0)
+			continue;
 
-	return found;
-}
+		INSTR_TIME_SET_CURRENT(current_time);
 
+		for (i = 0; i < pending_count; i++)
+		{
+			instr_time	elapsed = current_time;
+			int			remaining_ms;
 
-void
-initialize_conninfo_params(t_conninfo_param_list *param_list, bool set_defaults)
-{
-	PQconninfoOption *defs = NULL;
-	PQconninfoOption *def = NULL;
-	int			c;
+			pollfds[i].fd = PQsocket(pending[i]->node_info->conn);
+			pollfds[i].events = (poll_statuses[i] == PGRES_POLLING_WRITING) ? POLLOUT : POLLIN;
+			pollfds[i].revents = 0;
 
-	defs = PQconndefaults();
-	param_list->size = 0;
+			INSTR_TIME_SUBTRACT(elapsed, start_times[i]);
+			remaining_ms = (timeouts[i] * 1000) - (int) INSTR_TIME_GET_MILLISEC(elapsed);
 
-	/* Count maximum number of parameters */
-	for (def = defs; def->keyword; def++)
-		param_list->size++;
+			if (remaining_ms < 0)
+				remaining_ms = 0;
 
-	/* Initialize our internal parameter list */
-	param_list->keywords = pg_malloc0(sizeof(char *) * (param_list->size + 1));
-	param_list->values = pg_malloc0(sizeof(char *) * (param_list->size + 1));
+			if (poll_timeout == -1 || remaining_ms < poll_timeout)
+				poll_timeout = remaining_ms;
+		}
 
-	for (c = 0; c < param_list->size; c++)
-	{
-		param_list->keywords[c] = NULL;
-		param_list->values[c] = NULL;
-	}
+		if (poll(pollfds, pending_count, poll_timeout) < 0 && errno != EINTR)
+		{
+			log_warning(_("establish_node_connections_parallel(): poll() returned with error"));
+			log_detail("%s", strerror(errno));
 
-	if (set_defaults == true)
-	{
-		/* Pre-set any defaults */
+			for (i = 0; i < pending_count; i++)
+			{
+				PQfinish(pending[i]->node_info->conn);
+				pending[i]->node_info->conn = NULL;
+			}
 
-		for (def = defs; def->keyword; def++)
+			break;
+		}
+
+		INSTR_TIME_SET_CURRENT(current_time);
+
+		/*
+		 * Work backwards, so any completed connection attempt can be replaced
+		 * with the last entry (which will already have been processed).
+		 */
+		for (i = pending_count - 1; i >= 0; i--)
 		{
-			if (def->val != NULL && def->val[0] != '\0')
+			t_node_info *node_info = pending[i]->node_info;
+			bool		finished = false;
+
+			if (pollfds[i].revents != 0)
 			{
-				param_set(param_list, def->keyword, def->val);
+				poll_statuses[i] = PQconnectPoll(node_info->conn);
+
+				if (poll_statuses[i] == PGRES_POLLING_OK)
+				{
+					connected_count++;
+					finished = true;
+				}
+				else if (poll_statuses[i] == PGRES_POLLING_FAILED)
+				{
+					finished = true;
+				}
+			}
+
+			if (finished == false)
+			{
+				instr_time	elapsed = current_time;
+
+				INSTR_TIME_SUBTRACT(elapsed, start_times[i]);
+
+				if (INSTR_TIME_GET_DOUBLE(elapsed) >= (double) timeouts[i])
+				{
+					log_verbose(LOG_DEBUG, "establish_node_connections_parallel(): timeout (%i secs) reached for node %i",
+								timeouts[i], node_info->node_id);
+					PQfinish(node_info->conn);
+					node_info->conn = NULL;
+					finished = true;
+				}
+			}
+
+			if (finished == true)
+			{
+				pending[i] = pending[pending_count - 1];
+				poll_statuses[i] = poll_statuses[pending_count - 1];
+				start_times[i] = start_times[pending_count - 1];
+				timeouts[i] = timeouts[pending_count - 1];
+				pending_count--;
 			}
 		}
 	}
 
-	PQconninfoFree(defs);
+	arena_free(pending);
+	arena_free(start_times);
+	arena_free(timeouts);
+	arena_free(poll_statuses);
+	arena_free(pollfds);
+
+	log_verbose(LOG_DEBUG, "establish_node_connections_parallel(): connected to %i of %i nodes",
+				connected_count, node_list->node_count);
+
+	return connected_count;
 }
 
 
+/*
+ * Close any connections opened by establish_node_connections_parallel()
+ */
 void
-free_conninfo_params(t_conninfo_param_list *param_list)
+close_node_connections(NodeInfoList *node_list)
 {
-	int			c;
+	NodeInfoListCell *cell = NULL;
 
-	for (c = 0; c < param_list->size; c++)
+	for (cell = node_list->head; cell; cell = cell->next)
 	{
-		if (param_list->keywords != NULL && param_list->keywords[c] != NULL)
-			pfree(param_list->keywords[c]);
-
-		if (param_list->values != NULL && param_list->values[c] != NULL)
-			pfree(param_list->values[c]);
+		close_connection(&cell->node_info->conn);
 	}
+}
 
-	if (param_list->keywords != NULL)
-		pfree(param_list->keywords);
 
-	if (param_list->values != NULL)
-		pfree(param_list->values);
-}
+/*
+ * _execute_node_queries_parallel()
+ *
+ * Send "queries[i]" to "nodes[i]" (which must have an open, idle connection)
+ * for each of the "node_count" nodes without waiting for the result, then
+ * wait for the results to arrive and pass each node's result to the provided
+ * handler as soon as it is available. The handler is passed NULL if the
+ * query could not be sent, or if no result arrived within "timeout" seconds;
+ * in the latter case the query is cancelled and the connection closed
+ * before the handler is called, as it cannot be reused until the server
+ * responds.
+ * Otherwise the result is cleared after the handler returns; the connection
+ * is idle at that point, so the handler can issue further queries on it if
+ * required.
+ */
+static void
+_execute_node_queries_parallel(t_node_info **nodes, const char **queries, int node_count, t_node_query_result_handler handler, int timeout)
+{
+	t_node_info **pending = NULL;
+	struct pollfd *pollfds = NULL;
+	int			pending_count = 0;
+	instr_time	start_time;
+	int			i;
 
+	if (node_count == 0)
+		return;
 
+	INSTR_TIME_SET_CURRENT(start_time);
 
-void
-copy_conninfo_params(t_conninfo_param_list *dest_list, t_conninfo_param_list *source_list)
-{
-	int			c;
+	pending = arena_alloc0(sizeof(t_node_info *) * node_count);
+	pollfds = arena_alloc0(sizeof(struct pollfd) * node_count);
 
-	for (c = 0; c < source_list->size && source_list->keywords[c] != NULL; c++)
+	for (i = 0; i < node_count; i++)
 	{
-		if (source_list->values[c] != NULL && source_list->values[c][0] != '\0')
+		log_verbose(LOG_DEBUG, "_execute_node_queries_parallel(): node %i:\n%s",
+					nodes[i]->node_id, queries[i]);
+
+		if (PQsendQuery(nodes[i]->conn, queries[i]) == 0)
 		{
-			param_set(dest_list, source_list->keywords[c], source_list->values[c]);
+			log_db_error(nodes[i]->conn, queries[i],
+						 _("_execute_node_queries_parallel(): unable to send query to node %i"),
+						 nodes[i]->node_id);
+			handler(nodes[i], NULL);
+			continue;
 		}
-	}
-}
 
-void
-param_set(t_conninfo_param_list *param_list, const char *param, const char *value)
-{
-	int			c;
-	int			value_len = strlen(value) + 1;
-	int			param_len;
+		pending[pending_count++] = nodes[i];
+	}
 
-	/*
-	 * Scan array to see if the parameter is already set - if not, replace it
-	 */
-	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
+	while (pending_count > 0)
 	{
-		if (strcmp(param_list->keywords[c], param) == 0)
+		instr_time	elapsed;
+		int			remaining_ms;
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, start_time);
+		remaining_ms = (timeout * 1000) - (int) INSTR_TIME_GET_MILLISEC(elapsed);
+
+		if (remaining_ms <= 0)
 		{
-			if (param_list->values[c] != NULL)
-				pfree(param_list->values[c]);
+			for (i = 0; i < pending_count; i++)
+			{
+				t_node_info *node_info = pending[i];
+				char		errbuf[ERRBUFF_SIZE] = "";
+				PGcancel   *pgcancel = PQgetCancel(node_info->conn);
 
-			param_list->values[c] = pg_malloc0(value_len);
-			strncpy(param_list->values[c], value, value_len);
+				log_warning(_("_execute_node_queries_parallel(): timeout (%i secs) reached waiting for node %i"),
+							timeout, node_info->node_id);
 
-			return;
-		}
-	}
+				if (pgcancel != NULL)
+				{
+					if (PQcancel(pgcancel, errbuf, ERRBUFF_SIZE) == 0)
+						log_verbose(LOG_DEBUG, "_execute_node_queries_parallel(): unable to cancel query on node %i:\n%s",
+									node_info->node_id, errbuf);
+					PQfreeCancel(pgcancel);
+				}
 
-	/*
-	 * Sanity-check that the caller is not trying to overflow the array;
-	 * in practice this is highly unlikely, and if it ever happens, this means
-	 * something is highly wrong.
-	 */
-	Assert(c < param_list->size);
+				close_connection(&node_info->conn);
+				handler(node_info, NULL);
+			}
 
-	/*
-	 * Parameter not in array - add it and its associated value
-	 */
-	param_len = strlen(param) + 1;
+			break;
+		}
 
-	param_list->keywords[c] = pg_malloc0(param_len);
-	param_list->values[c] = pg_malloc0(value_len);
+		for (i = 0; i < pending_count; i++)
+		{
+			pollfds[i].fd = PQsocket(pending[i]->conn);
+			pollfds[i].events = POLLIN;
+			pollfds[i].revents = 0;
+		}
 
-	strncpy(param_list->keywords[c], param, param_len);
-	strncpy(param_list->values[c], value, value_len);
-}
+		if (poll(pollfds, pending_count, remaining_ms) < 0)
+		{
+			if (errno == EINTR)
+				continue;
 
+			log_warning(_("_execute_node_queries_parallel(): poll() returned with error"));
+			log_detail("%s", strerror(errno));
 
-/*
- * Like param_set(), but will only set the parameter if it doesn't exist
- */
-void
-param_set_ine(t_conninfo_param_list *param_list, const char *param, const char *value)
-{
-	int			c;
-	int			value_len = strlen(value) + 1;
-	int			param_len;
-
-	/*
-	 * Scan array to see if the parameter is already set - if so, do nothing
-	 */
-	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
-	{
-		if (strcmp(param_list->keywords[c], param) == 0)
-		{
-			/* parameter exists, do nothing */
-			return;
+			/* fall back to waiting for each outstanding result in turn */
+			for (i = 0; i < pending_count; i++)
+				pollfds[i].revents = POLLIN;
 		}
-	}
-
-	/*
-	 * Sanity-check that the caller is not trying to overflow the array;
-	 * in practice this is highly unlikely, and if it ever happens, this means
-	 * something is highly wrong.
-	 */
-	Assert(c < param_list->size);
 
-	/*
-	 * Parameter not in array - add it and its associated value
-	 */
-	param_len = strlen(param) + 1;
+		/*
+		 * Work backwards, so any completed query can be replaced with the
+		 * last entry (which will already have been processed).
+		 */
+		for (i = pending_count - 1; i >= 0; i--)
+		{
+			t_node_info *node_info = pending[i];
+			PGresult   *res = NULL;
+			PGresult   *first_res = NULL;
 
-	param_list->keywords[c] = pg_malloc0(param_len);
-	param_list->values[c] = pg_malloc0(value_len);
+			if (pollfds[i].revents == 0)
+				continue;
 
-	strncpy(param_list->keywords[c], param, param_len);
-	strncpy(param_list->values[c], value, value_len);
-}
+			if (PQconsumeInput(node_info->conn) == 1 && PQisBusy(node_info->conn) == 1)
+				continue;
 
+			/*
+			 * Consume all results before calling the handler, so the
+			 * connection is ready for reuse.
+			 */
+			while ((res = PQgetResult(node_info->conn)) != NULL)
+			{
+				if (first_res == NULL)
+					first_res = res;
+				else
+					PQclear(res);
+			}
 
-char *
-param_get(t_conninfo_param_list *param_list, const char *param)
-{
-	int			c;
+			handler(node_info, first_res);
+			PQclear(first_res);
 
-	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
-	{
-		if (strcmp(param_list->keywords[c], param) == 0)
-		{
-			if (param_list->values[c] != NULL && param_list->values[c][0] != '\0')
-				return param_list->values[c];
-			else
-				return NULL;
+			pending[i] = pending[pending_count - 1];
+			pending_count--;
 		}
 	}
 
-	return NULL;
+	arena_free(pending);
+	arena_free(pollfds);
 }
 
 
 /*
- * Validate a conninfo string by attempting to parse it.
+ * Prepared monitoring queries
  *
- * "errmsg": passed to PQconninfoParse(), may be NULL
+ * repmgrd executes a small number of queries on every monitoring cycle.
+ * If enabled with enable_prepared_monitoring_queries(), these are prepared
+ * (for the server version of the connection in question) the first time
+ * they are executed on a connection, and subsequently executed with
+ * PQexecPrepared(), saving the server from parsing and planning them
+ * each time.
  *
- * NOTE: PQconninfoParse() verifies the string format and checks for
- * valid options but does not sanity check values.
+ * Connections are identified by their PGconn pointer together with the
+ * backend PID, so a reconnection (including PQreset()) results in the
+ * statements being prepared again. If a statement turns out not to exist
+ * (e.g. following "DISCARD ALL"), the query is executed unprepared and
+ * prepared again on the next call.
  */
 
-bool
-validate_conninfo_string(const char *conninfo_str, char **errmsg)
+#define PREPARED_STATEMENT_CONNECTIONS 8
+
+typedef enum
 {
-	PQconninfoOption *connOptions = NULL;
+	MQ_RECOVERY_TYPE = 0,
+	MQ_NODE_CURRENT_LSN,
+	MQ_PRIMARY_CURRENT_LSN,
+	MQ_REPLICATION_INFO,
+	MQ_REPLICATION_INFO_WITNESS,
+	MQ_COUNT
+} t_monitoring_query;
 
-	connOptions = PQconninfoParse(conninfo_str, errmsg);
+static const char *monitoring_query_names[MQ_COUNT] = {
+	"repmgr_recovery_type",
+	"repmgr_node_current_lsn",
+	"repmgr_primary_current_lsn",
+	"repmgr_replication_info",
+	"repmgr_replication_info_witness"
+};
 
-	if (connOptions == NULL)
-		return false;
+typedef struct
+{
+	PGconn	   *conn;
+	int			backend_pid;
+	unsigned int prepared;
+} t_prepared_statement_conn;
 
-	return true;
-}
+static bool prepared_monitoring_queries = false;
+static t_prepared_statement_conn prepared_statement_conns[PREPARED_STATEMENT_CONNECTIONS];
+static int	prepared_statement_conn_next = 0;
 
+static void _build_monitoring_query(PGconn *conn, t_monitoring_query query_id, PQExpBufferData *query);
+static void _build_node_current_lsn_query(PGconn *conn, PQExpBufferData *query);
 
-/*
- * Parse a conninfo string into a t_conninfo_param_list
- *
- * See conn_to_param_list() to do the same for a PGconn.
- *
- * "errmsg": passed to PQconninfoParse(), may be NULL
- *
- * "ignore_local_params": ignores those parameters specific
- * to a local installation, i.e. when parsing an upstream
- * node's conninfo string for inclusion into "primary_conninfo",
- * don't copy that node's values
- */
-bool
-parse_conninfo_string(const char *conninfo_str, t_conninfo_param_list *param_list, char **errmsg, bool ignore_local_params)
+
+void
+enable_prepared_monitoring_queries(bool enable)
 {
-	PQconninfoOption *connOptions = NULL;
-	PQconninfoOption *option = NULL;
+	prepared_monitoring_queries = enable;
 
-	connOptions = PQconninfoParse(conninfo_str, errmsg);
+	if (enable == false)
+	{
+		memset(prepared_statement_conns, 0, sizeof(prepared_statement_conns));
+		prepared_statement_conn_next = 0;
+	}
+}
 
-	if (connOptions == NULL)
-		return false;
 
-	for (option = connOptions; option && option->keyword; option++)
-	{
-		/* Ignore non-set or blank parameter values */
-		if ((option->val == NULL) ||
-			(option->val != NULL && option->val[0] == '\0'))
-			continue;
+static t_prepared_statement_conn *
+_get_prepared_statement_conn(PGconn *conn)
+{
+	int			backend_pid = PQbackendPID(conn);
+	t_prepared_statement_conn *entry = NULL;
+	int			i;
 
-		/* Ignore settings specific to the upstream node */
-		if (ignore_local_params == true)
+	for (i = 0; i < PREPARED_STATEMENT_CONNECTIONS; i++)
+	{
+		if (prepared_statement_conns[i].conn == conn)
 		{
-			if (strcmp(option->keyword, "application_name") == 0)
-				continue;
-			if (strcmp(option->keyword, "passfile") == 0)
-				continue;
-			if (strcmp(option->keyword, "servicefile") == 0)
-				continue;
+			entry = &prepared_statement_conns[i];
+			break;
 		}
-		param_set(param_list, option->keyword, option->val);
 	}
 
-	PQconninfoFree(connOptions);
+	/* evict the oldest entry; statements will be prepared again if needed */
+	if (entry == NULL)
+	{
+		entry = &prepared_statement_conns[prepared_statement_conn_next];
+		prepared_statement_conn_next = (prepared_statement_conn_next + 1) % PREPARED_STATEMENT_CONNECTIONS;
+		entry->conn = conn;
+		entry->backend_pid = 0;
+	}
 
-	return true;
+	if (entry->backend_pid != backend_pid)
+	{
+		entry->backend_pid = backend_pid;
+		entry->prepared = 0;
+	}
+
+	return entry;
+}
+
+
+static bool
+_result_has_sqlstate(PGresult *res, const char *sqlstate)
+{
+	char	   *res_sqlstate = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+
+	return res_sqlstate != NULL && strcmp(res_sqlstate, sqlstate) == 0;
 }
 
 
 /*
- * Parse a PGconn into a t_conninfo_param_list
- *
- * See parse_conninfo_string() to do the same for a conninfo string
+ * _exec_monitoring_query()
  *
- * NOTE: the current use case for this is to take an active connection,
- * replace the existing username (typically replacing it with the superuser
- * or replication user name), and make a new connection as that user.
- * If the "password" field is set, it will cause any connection made with
- * these parameters to fail (unless of course the password happens to be the
- * same). Therefore we remove the password altogether, and rely on it being
- * available via .pgpass.
+ * Execute the specified monitoring query, using a prepared statement if
+ * enabled. The caller must PQclear() the result.
  */
-void
-conn_to_param_list(PGconn *conn, t_conninfo_param_list *param_list)
+static PGresult *
+_exec_monitoring_query(PGconn *conn, t_monitoring_query query_id)
 {
-	PQconninfoOption *connOptions = NULL;
-	PQconninfoOption *option = NULL;
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	t_prepared_statement_conn *entry = NULL;
+	const char *statement_name = monitoring_query_names[query_id];
 
-	connOptions = PQconninfo(conn);
-	for (option = connOptions; option && option->keyword; option++)
+	if (prepared_monitoring_queries == true && PQstatus(conn) == CONNECTION_OK)
 	{
-		/* Ignore non-set or blank parameter values */
-		if ((option->val == NULL) ||
-			(option->val != NULL && option->val[0] == '\0'))
-			continue;
+		entry = _get_prepared_statement_conn(conn);
 
-		/* Ignore "password" */
-		if (strcmp(option->keyword, "password") == 0)
-			continue;
+		if (entry->prepared & (1U << query_id))
+		{
+			res = PQexecPrepared(conn, statement_name, 0, NULL, NULL, NULL, 0);
 
-		param_set(param_list, option->keyword, option->val);
-	}
+			/* 26000: invalid_sql_statement_name */
+			if (_result_has_sqlstate(res, "26000") == false)
+				return res;
 
-	PQconninfoFree(connOptions);
-}
+			log_verbose(LOG_DEBUG, "_exec_monitoring_query(): prepared statement \"%s\" not found",
+						statement_name);
+			PQclear(res);
+			entry->prepared &= ~(1U << query_id);
+			entry = NULL;
+		}
+	}
 
+	initPQExpBuffer(&query);
+	_build_monitoring_query(conn, query_id, &query);
 
-/*
- * Converts param list to string; caller must free returned pointer
- */
-char *
-param_list_to_string(t_conninfo_param_list *param_list)
-{
-	int			c;
-	PQExpBufferData conninfo_buf;
-	char	   *conninfo_str = NULL;
-	int			len = 0;
+	if (entry != NULL)
+	{
+		log_verbose(LOG_DEBUG, "_exec_monitoring_query(): preparing \"%s\":\n%s",
+					statement_name, query.data);
 
-	initPQExpBuffer(&conninfo_buf);
+		res = PQprepare(conn, statement_name, query.data, 0, NULL);
 
-	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
-	{
-		if (param_list->values[c] != NULL && param_list->values[c][0] != '\0')
+		/* 42P05: duplicate_prepared_statement */
+		if (PQresultStatus(res) == PGRES_COMMAND_OK || _result_has_sqlstate(res, "42P05"))
 		{
-			if (c > 0)
-				appendPQExpBufferChar(&conninfo_buf, ' ');
+			PQclear(res);
+			termPQExpBuffer(&query);
+			entry->prepared |= (1U << query_id);
 
-			/* XXX escape value */
-			appendPQExpBuffer(&conninfo_buf,
-							  "%s=%s",
-							  param_list->keywords[c],
-							  param_list->values[c]);
+			return PQexecPrepared(conn, statement_name, 0, NULL, NULL, NULL, 0);
 		}
-	}
 
-	len = strlen(conninfo_buf.data) + 1;
-	conninfo_str = pg_malloc0(len);
+		log_verbose(LOG_DEBUG, "_exec_monitoring_query(): unable to prepare \"%s\":\n  %s",
+					statement_name, PQerrorMessage(conn));
+		PQclear(res);
+	}
 
-	strncpy(conninfo_str, conninfo_buf.data, len);
+	log_verbose(LOG_DEBUG, "_exec_monitoring_query():\n%s", query.data);
 
-	termPQExpBuffer(&conninfo_buf);
+	res = PQexec(conn, query.data);
+	termPQExpBuffer(&query);
 
-	return conninfo_str;
+	return res;
 }
 
 
-/*
- * Run a conninfo string through the parser, and pass it back as a normal
- * conninfo string. This is mainly intended for converting connection URIs
- * to parameter/value conninfo strings.
- *
- * Caller must free returned pointer.
- */
-
-char *
-normalize_conninfo_string(const char *conninfo_str)
+static void
+_build_monitoring_query(PGconn *conn, t_monitoring_query query_id, PQExpBufferData *query)
 {
-	t_conninfo_param_list conninfo_params = T_CONNINFO_PARAM_LIST_INITIALIZER;
-	bool		parse_success = false;
-	char	   *normalized_string = NULL;
-	char	   *errmsg = NULL;
+	switch (query_id)
+	{
+		case MQ_RECOVERY_TYPE:
+			appendPQExpBufferStr(query,
+								 "SELECT pg_catalog.pg_is_in_recovery()");
+			break;
 
-	initialize_conninfo_params(&conninfo_params, false);
+		case MQ_NODE_CURRENT_LSN:
+			_build_node_current_lsn_query(conn, query);
+			break;
 
-	parse_success = parse_conninfo_string(conninfo_str, &conninfo_params, &errmsg, false);
+		case MQ_PRIMARY_CURRENT_LSN:
+			if (PQserverVersion(conn) >= 100000)
+				appendPQExpBufferStr(query,
+									 "SELECT pg_catalog.pg_current_wal_lsn()");
+			else
+				appendPQExpBufferStr(query,
+									 "SELECT pg_catalog.pg_current_xlog_location()");
+			break;
 
-	if (parse_success == false)
-	{
-		log_error(_("unable to parse provided conninfo string \"%s\""), conninfo_str);
-		log_detail("%s", errmsg);
-		free_conninfo_params(&conninfo_params);
-		return NULL;
+		case MQ_REPLICATION_INFO:
+			_build_replication_info_query(conn, STANDBY, false, query);
+			break;
+
+		case MQ_REPLICATION_INFO_WITNESS:
+			_build_replication_info_query(conn, WITNESS, false, query);
+			break;
+
+		case MQ_COUNT:
+			break;
 	}
+}
 
 
-	normalized_string = param_list_to_string(&conninfo_params);
-	free_conninfo_params(&conninfo_params);
+/* =============================== */
+/* conninfo manipulation functions */
+/* =============================== */
 
-	return normalized_string;
-}
 
 /*
- * check whether the libpq version in use recognizes the "passfile" parameter
- * (should be 9.6 and later)
+ * get_conninfo_value()
+ *
+ * Extract the value represented by 'keyword' in 'conninfo' and copy
+ * it to the 'output' buffer.
+ *
+ * Returns true on success, or false on failure (conninfo string could
+ * not be parsed, or provided keyword not found).
  */
+
 bool
-has_passfile(void)
+get_conninfo_value(const char *conninfo, const char *keyword, char *output)
 {
-	PQconninfoOption *defs = PQconndefaults();
-	PQconninfoOption *def = NULL;
-    bool has_passfile = false;
+	PQconninfoOption *conninfo_options = NULL;
+	PQconninfoOption *conninfo_option = NULL;
 
-   	for (def = defs; def->keyword; def++)
-    {
+	conninfo_options = PQconninfoParse(conninfo, NULL);
+
+	if (conninfo_options == NULL)
+	{
+		log_error(_("unable to parse provided conninfo string \"%s\""), conninfo);
+		return false;
+	}
+
+	for (conninfo_option = conninfo_options; conninfo_option->keyword != NULL; conninfo_option++)
+	{
+		if (strcmp(conninfo_option->keyword, keyword) == 0)
+		{
+			if (conninfo_option->val != NULL && conninfo_option->val[0] != '\0')
+			{
+				strncpy(output, conninfo_option->val, MAXLEN);
+				break;
+			}
+		}
+	}
+
+	PQconninfoFree(conninfo_options);
+
+	return true;
+}
+
+
+/*
+ * Get a default conninfo value for the provided parameter, and copy
+ * it to the 'output' buffer.
+ *
+ * Returns true on success, or false on failure (provided keyword not found).
+ *
+ */
+bool
+get_conninfo_default_value(const char *param, char *output, int maxlen)
+{
+	PQconninfoOption *defs = NULL;
+	PQconninfoOption *def = NULL;
+	bool found = false;
+
+	defs = PQconndefaults();
+
+	for (def = defs; def->keyword; def++)
+	{
+		if (strncmp(def->keyword, param, maxlen) == 0)
+		{
+			strncpy(output, def->val, maxlen);
+			found = true;
+		}
+	}
+
+	PQconninfoFree(defs);
+
+	return found;
+}
+
+
+void
+initialize_conninfo_params(t_conninfo_param_list *param_list, bool set_defaults)
+{
+	PQconninfoOption *defs = NULL;
+	PQconninfoOption *def = NULL;
+	int			c;
+
+	defs = PQconndefaults();
+	param_list->size = 0;
+
+	/* Count maximum number of parameters */
+	for (def = defs; def->keyword; def++)
+		param_list->size++;
+
+	/* Initialize our internal parameter list */
+	param_list->keywords = pg_malloc0(sizeof(char *) * (param_list->size + 1));
+	param_list->values = pg_malloc0(sizeof(char *) * (param_list->size + 1));
+
+	for (c = 0; c < param_list->size; c++)
+	{
+		param_list->keywords[c] = NULL;
+		param_list->values[c] = NULL;
+	}
+
+	if (set_defaults == true)
+	{
+		/* Pre-set any defaults */
+
+		for (def = defs; def->keyword; def++)
+		{
+			if (def->val != NULL && def->val[0] != '\0')
+			{
+				param_set(param_list, def->keyword, def->val);
+			}
+		}
+	}
+
+	PQconninfoFree(defs);
+}
+
+
+void
+free_conninfo_params(t_conninfo_param_list *param_list)
+{
+	int			c;
+
+	for (c = 0; c < param_list->size; c++)
+	{
+		if (param_list->keywords != NULL && param_list->keywords[c] != NULL)
+			pfree(param_list->keywords[c]);
+
+		if (param_list->values != NULL && param_list->values[c] != NULL)
+			pfree(param_list->values[c]);
+	}
+
+	if (param_list->keywords != NULL)
+		pfree(param_list->keywords);
+
+	if (param_list->values != NULL)
+		pfree(param_list->values);
+}
+
+
+
+void
+copy_conninfo_params(t_conninfo_param_list *dest_list, t_conninfo_param_list *source_list)
+{
+	int			c;
+
+	for (c = 0; c < source_list->size && source_list->keywords[c] != NULL; c++)
+	{
+		if (source_list->values[c] != NULL && source_list->values[c][0] != '\0')
+		{
+			param_set(dest_list, source_list->keywords[c], source_list->values[c]);
+		}
+	}
+}
+
+void
+param_set(t_conninfo_param_list *param_list, const char *param, const char *value)
+{
+	int			c;
+	int			value_len = strlen(value) + 1;
+	int			param_len;
+
+	/*
+	 * Scan array to see if the parameter is already set - if not, replace it
+	 */
+	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
+	{
+		if (strcmp(param_list->keywords[c], param) == 0)
+		{
+			if (param_list->values[c] != NULL)
+				pfree(param_list->values[c]);
+
+			param_list->values[c] = pg_malloc0(value_len);
+			strncpy(param_list->values[c], value, value_len);
+
+			return;
+		}
+	}
+
+	/*
+	 * Sanity-check that the caller is not trying to overflow the array;
+	 * in practice this is highly unlikely, and if it ever happens, this means
+	 * something is highly wrong.
+	 */
+	Assert(c < param_list->size);
+
+	/*
+	 * Parameter not in array - add it and its associated value
+	 */
+	param_len = strlen(param) + 1;
+
+	param_list->keywords[c] = pg_malloc0(param_len);
+	param_list->values[c] = pg_malloc0(value_len);
+
+	strncpy(param_list->keywords[c], param, param_len);
+	strncpy(param_list->values[c], value, value_len);
+}
+
+
+/*
+ * Like param_set(), but will only set the parameter if it doesn't exist
+ */
+void
+param_set_ine(t_conninfo_param_list *param_list, const char *param, const char *value)
+{
+	int			c;
+	int			value_len = strlen(value) + 1;
+	int			param_len;
+
+	/*
+	 * Scan array to see if the parameter is already set - if so, do nothing
+	 */
+	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
+	{
+		if (strcmp(param_list->keywords[c], param) == 0)
+		{
+			/* parameter exists, do nothing */
+			return;
+		}
+	}
+
+	/*
+	 * Sanity-check that the caller is not trying to overflow the array;
+	 * in practice this is highly unlikely, and if it ever happens, this means
+	 * something is highly wrong.
+	 */
+	Assert(c < param_list->size);
+
+	/*
+	 * Parameter not in array - add it and its associated value
+	 */
+	param_len = strlen(param) + 1;
+
+	param_list->keywords[c] = pg_malloc0(param_len);
+	param_list->values[c] = pg_malloc0(value_len);
+
+	strncpy(param_list->keywords[c], param, param_len);
+	strncpy(param_list->values[c], value, value_len);
+}
+
+
+char *
+param_get(t_conninfo_param_list *param_list, const char *param)
+{
+	int			c;
+
+	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
+	{
+		if (strcmp(param_list->keywords[c], param) == 0)
+		{
+			if (param_list->values[c] != NULL && param_list->values[c][0] != '\0')
+				return param_list->values[c];
+			else
+				return NULL;
+		}
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Validate a conninfo string by attempting to parse it.
+ *
+ * "errmsg": passed to PQconninfoParse(), may be NULL
+ *
+ * NOTE: PQconninfoParse() verifies the string format and checks for
+ * valid options but does not sanity check values.
+ */
+
+bool
+validate_conninfo_string(const char *conninfo_str, char **errmsg)
+{
+	PQconninfoOption *connOptions = NULL;
+
+	connOptions = PQconninfoParse(conninfo_str, errmsg);
+
+	if (connOptions == NULL)
+		return false;
+
+	return true;
+}
+
+
+/*
+ * Parse a conninfo string into a t_conninfo_param_list
+ *
+ * See conn_to_param_list() to do the same for a PGconn.
+ *
+ * "errmsg": passed to PQconninfoParse(), may be NULL
+ *
+ * "ignore_local_params": ignores those parameters specific
+ * to a local installation, i.e. when parsing an upstream
+ * node's conninfo string for inclusion into "primary_conninfo",
+ * don't copy that node's values
+ */
+bool
+parse_conninfo_string(const char *conninfo_str, t_conninfo_param_list *param_list, char **errmsg, bool ignore_local_params)
+{
+	PQconninfoOption *connOptions = NULL;
+	PQconninfoOption *option = NULL;
+
+	connOptions = PQconninfoParse(conninfo_str, errmsg);
+
+	if (connOptions == NULL)
+		return false;
+
+	for (option = connOptions; option && option->keyword; option++)
+	{
+		/* Ignore non-set or blank parameter values */
+		if ((option->val == NULL) ||
+			(option->val != NULL && option->val[0] == '\0'))
+			continue;
+
+		/* Ignore settings specific to the upstream node */
+		if (ignore_local_params == true)
+		{
+			if (strcmp(option->keyword, "application_name") == 0)
+				continue;
+			if (strcmp(option->keyword, "passfile") == 0)
+				continue;
+			if (strcmp(option->keyword, "servicefile") == 0)
+				continue;
+		}
+		param_set(param_list, option->keyword, option->val);
+	}
+
+	PQconninfoFree(connOptions);
+
+	return true;
+}
+
+
+/*
+ * Parse a PGconn into a t_conninfo_param_list
+ *
+ * See parse_conninfo_string() to do the same for a conninfo string
+ *
+ * NOTE: the current use case for this is to take an active connection,
+ * replace the existing username (typically replacing it with the superuser
+ * or replication user name), and make a new connection as that user.
+ * If the "password" field is set, it will cause any connection made with
+ * these parameters to fail (unless of course the password happens to be the
+ * same). Therefore we remove the password altogether, and rely on it being
+ * available via .pgpass.
+ */
+void
+conn_to_param_list(PGconn *conn, t_conninfo_param_list *param_list)
+{
+	PQconninfoOption *connOptions = NULL;
+	PQconninfoOption *option = NULL;
+
+	connOptions = PQconninfo(conn);
+	for (option = connOptions; option && option->keyword; option++)
+	{
+		/* Ignore non-set or blank parameter values */
+		if ((option->val == NULL) ||
+			(option->val != NULL && option->val[0] == '\0'))
+			continue;
+
+		/* Ignore "password" */
+		if (strcmp(option->keyword, "password") == 0)
+			continue;
+
+		param_set(param_list, option->keyword, option->val);
+	}
+
+	PQconninfoFree(connOptions);
+}
+
+
+/*
+ * Converts param list to string; caller must free returned pointer
+ */
+char *
+param_list_to_string(t_conninfo_param_list *param_list)
+{
+	int			c;
+	PQExpBufferData conninfo_buf;
+	char	   *conninfo_str = NULL;
+	int			len = 0;
+
+	initPQExpBuffer(&conninfo_buf);
+
+	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
+	{
+		if (param_list->values[c] != NULL && param_list->values[c][0] != '\0')
+		{
+			if (c > 0)
+				appendPQExpBufferChar(&conninfo_buf, ' ');
+
+			/* XXX escape value */
+			appendPQExpBuffer(&conninfo_buf,
+							  "%s=%s",
+							  param_list->keywords[c],
+							  param_list->values[c]);
+		}
+	}
+
+	len = strlen(conninfo_buf.data) + 1;
+	conninfo_str = pg_malloc0(len);
+
+	strncpy(conninfo_str, conninfo_buf.data, len);
+
+	termPQExpBuffer(&conninfo_buf);
+
+	return conninfo_str;
+}
+
+
+/*
+ * Run a conninfo string through the parser, and pass it back as a normal
+ * conninfo string. This is mainly intended for converting connection URIs
+ * to parameter/value conninfo strings.
+ *
+ * Caller must free returned pointer.
+ */
+
+char *
+normalize_conninfo_string(const char *conninfo_str)
+{
+	t_conninfo_param_list conninfo_params = T_CONNINFO_PARAM_LIST_INITIALIZER;
+	bool		parse_success = false;
+	char	   *normalized_string = NULL;
+	char	   *errmsg = NULL;
+
+	initialize_conninfo_params(&conninfo_params, false);
+
+	parse_success = parse_conninfo_string(conninfo_str, &conninfo_params, &errmsg, false);
+
+	if (parse_success == false)
+	{
+		log_error(_("unable to parse provided conninfo string \"%s\""), conninfo_str);
+		log_detail("%s", errmsg);
+		free_conninfo_params(&conninfo_params);
+		return NULL;
+	}
+
+
+	normalized_string = param_list_to_string(&conninfo_params);
+	free_conninfo_params(&conninfo_params);
+
+	return normalized_string;
+}
+
+/*
+ * check whether the libpq version in use recognizes the "passfile" parameter
+ * (should be 9.6 and later)
+ */
+bool
+has_passfile(void)
+{
+	PQconninfoOption *defs = PQconndefaults();
+	PQconninfoOption *def = NULL;
+    bool has_passfile = false;
+
+   	for (def = defs; def->keyword; def++)
+    {
         if (strcmp(def->keyword, "passfile") == 0)
         {
             has_passfile = true;
@@ -1373,16 +2079,12 @@ get_recovery_type(PGconn *conn)
 	PGresult   *res = NULL;
 	RecoveryType recovery_type = RECTYPE_UNKNOWN;
 
-	const char	   *sqlquery = "SELECT pg_catalog.pg_is_in_recovery()";
-
-	log_verbose(LOG_DEBUG, "get_recovery_type(): %s", sqlquery);
-
-	res = PQexec(conn, sqlquery);
+	res = _exec_monitoring_query(conn, MQ_RECOVERY_TYPE);
 
 	if (PQresultStatus(res) != PGRES_TUPLES_OK)
 	{
 		log_db_error(conn,
-					 sqlquery,
+					 NULL,
 					 _("unable to determine if server is in recovery"));
 
 		recovery_type = RECTYPE_UNKNOWN;
@@ -1581,16 +2283,49 @@ get_primary_node_id(PGconn *conn)
 
 
 
+/*
+ * Return the number of WAL files awaiting archiving.
+ *
+ * On a primary, this is derived from pg_stat_archiver and the current WAL
+ * position, which avoids scanning the archive_status directory; during an
+ * archiving outage this can contain many thousands of files, and scanning
+ * it generates considerable metadata I/O at a time the server is
+ * likely to be under pressure anyway.
+ *
+ * The directory is scanned if the backlog cannot be derived this way,
+ * e.g. on a standby, or if nothing has been archived yet.
+ */
 int
 get_ready_archive_files(PGconn *conn, const char *data_directory)
 {
 	char		archive_status_dir[MAXPGPATH] = "";
 	struct stat statbuf;
-	struct dirent *arcdir_ent;
-	DIR		   *arcdir;
-
 	int			ready_count = 0;
 
+	_get_archive_status_dir(conn, data_directory, archive_status_dir);
+
+	/* sanity-check directory path */
+	if (stat(archive_status_dir, &statbuf) == -1)
+	{
+		log_error(_("unable to access archive_status directory \"%s\""),
+				  archive_status_dir);
+		log_detail("%s", strerror(errno));
+
+		return ARCHIVE_STATUS_DIR_ERROR;
+	}
+
+	ready_count = _estimate_ready_archive_files(conn, archive_status_dir);
+
+	if (ready_count >= 0)
+		return ready_count;
+
+	return _count_ready_archive_files(archive_status_dir);
+}
+
+
+static void
+_get_archive_status_dir(PGconn *conn, const char *data_directory, char *archive_status_dir)
+{
 	if (PQserverVersion(conn) >= 100000)
 	{
 		snprintf(archive_status_dir, MAXPGPATH,
@@ -1603,17 +2338,160 @@ get_ready_archive_files(PGconn *conn, const char *data_directory)
 				 "%s/pg_xlog/archive_status",
 				 data_directory);
 	}
+}
 
-	/* sanity-check directory path */
-	if (stat(archive_status_dir, &statbuf) == -1)
+
+/*
+ * Estimate the archive backlog as the number of WAL segments between the
+ * one last archived and the one currently being written.
+ *
+ * Returns -1 if no estimate can be made, in which case the caller should
+ * fall back to scanning the archive_status directory.
+ *
+ * The estimate is only used if the ".ready" file for the first segment
+ * it counts actually exists; this guards against the case where
+ * "archive_mode" was enabled after having been disabled for a while, in
+ * which case pg_stat_archiver's last archived WAL may lie before segments
+ * which were never marked ready. History and backup history files awaiting
+ * archiving are not included in the estimate.
+ */
+static int
+_estimate_ready_archive_files(PGconn *conn, const char *archive_status_dir)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	uint32		archived_tli = 0,
+				archived_log = 0,
+				archived_seg = 0;
+	uint32		current_tli = 0,
+				current_log = 0,
+				current_seg = 0;
+	uint64		wal_segment_size = 0;
+	uint64		segments_per_xlogid = 0;
+	uint64		archived_segno = 0,
+				current_segno = 0,
+				next_segno = 0;
+	char		ready_file[MAXPGPATH + 32] = "";
+	struct stat statbuf;
+	int64		ready_count = 0;
+
+	if (PQserverVersion(conn) < 90400)
+		return -1;
+
+	initPQExpBuffer(&query);
+
+	/*
+	 * Before PostgreSQL 11, "wal_segment_size" is reported in units of
+	 * XLOG_BLCKSZ ("8kB"); from PostgreSQL 11 in bytes.
+	 */
+	appendPQExpBufferStr(&query,
+						 " SELECT a.last_archived_wal, ");
+
+	if (PQserverVersion(conn) >= 100000)
 	{
-		log_error(_("unable to access archive_status directory \"%s\""),
-				  archive_status_dir);
-		log_detail("%s", strerror(errno));
+		appendPQExpBufferStr(&query,
+							 "        pg_catalog.pg_walfile_name(pg_catalog.pg_current_wal_lsn()), ");
+	}
+	else
+	{
+		appendPQExpBufferStr(&query,
+							 "        pg_catalog.pg_xlogfile_name(pg_catalog.pg_current_xlog_location()), ");
+	}
 
-		return ARCHIVE_STATUS_DIR_ERROR;
+	appendPQExpBufferStr(&query,
+						 "        (SELECT s.setting::BIGINT * CASE s.unit "
+						 "                                    WHEN '8kB' THEN 8192 "
+						 "                                    WHEN 'MB' THEN 1048576 "
+						 "                                    ELSE 1 END "
+						 "           FROM pg_catalog.pg_settings s "
+						 "          WHERE s.name = 'wal_segment_size') "
+						 "   FROM pg_catalog.pg_stat_archiver a "
+						 "  WHERE NOT pg_catalog.pg_is_in_recovery() "
+						 "    AND pg_catalog.current_setting('archive_mode') != 'off' ");
+
+	log_verbose(LOG_DEBUG, "_estimate_ready_archive_files():\n  %s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	termPQExpBuffer(&query);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0)
+	{
+		PQclear(res);
+		return -1;
+	}
+
+	if (PQgetisnull(res, 0, 0) || PQgetisnull(res, 0, 2))
+	{
+		PQclear(res);
+		return -1;
+	}
+
+	/*
+	 * Only WAL segment file names are usable; the last archived file may
+	 * also be a history, backup history or ".partial" file.
+	 */
+	if (strlen(PQgetvalue(res, 0, 0)) != 24 ||
+		sscanf(PQgetvalue(res, 0, 0), "%08X%08X%08X", &archived_tli, &archived_log, &archived_seg) != 3 ||
+		sscanf(PQgetvalue(res, 0, 1), "%08X%08X%08X", &current_tli, &current_log, &current_seg) != 3)
+	{
+		PQclear(res);
+		return -1;
+	}
+
+	wal_segment_size = (uint64) atoll(PQgetvalue(res, 0, 2));
+
+	PQclear(res);
+
+	/* the backlog spans a timeline switch; leave this to the directory scan */
+	if (archived_tli != current_tli)
+		return -1;
+
+	if (wal_segment_size == 0 || wal_segment_size > UINT64CONST(0x100000000))
+		return -1;
+
+	segments_per_xlogid = UINT64CONST(0x100000000) / wal_segment_size;
+
+	archived_segno = (uint64) archived_log * segments_per_xlogid + archived_seg;
+	current_segno = (uint64) current_log * segments_per_xlogid + current_seg;
+
+	/* the segment currently being written is not yet ready */
+	if (current_segno <= archived_segno + 1)
+		return 0;
+
+	ready_count = (int64) (current_segno - archived_segno - 1);
+
+	next_segno = archived_segno + 1;
+
+	snprintf(ready_file, sizeof(ready_file),
+			 "%s/%08X%08X%08X.ready",
+			 archive_status_dir,
+			 current_tli,
+			 (uint32) (next_segno / segments_per_xlogid),
+			 (uint32) (next_segno % segments_per_xlogid));
+
+	if (stat(ready_file, &statbuf) == -1)
+	{
+		log_verbose(LOG_DEBUG, "_estimate_ready_archive_files(): \"%s\" not found, estimate of %lli files discarded",
+					ready_file, (long long int) ready_count);
+		return -1;
 	}
 
+	if (ready_count > PG_INT32_MAX)
+		return PG_INT32_MAX;
+
+	return (int) ready_count;
+}
+
+
+static int
+_count_ready_archive_files(const char *archive_status_dir)
+{
+	struct dirent *arcdir_ent;
+	DIR		   *arcdir;
+
+	int			ready_count = 0;
+
 	arcdir = opendir(archive_status_dir);
 
 	if (arcdir == NULL)
@@ -1626,30 +2504,42 @@ get_ready_archive_files(PGconn *conn, const char *data_directory)
 	}
 
 	while ((arcdir_ent = readdir(arcdir)) != NULL)
-	{
-		struct stat statbuf;
-		char		file_path[MAXPGPATH + sizeof(arcdir_ent->d_name)];
-		int			basenamelen = 0;
-
-		snprintf(file_path, sizeof(file_path),
-				 "%s/%s",
-				 archive_status_dir,
-				 arcdir_ent->d_name);
-
-		/* skip non-files */
-		if (stat(file_path, &statbuf) == 0 && !S_ISREG(statbuf.st_mode))
-		{
-			continue;
-		}
-
-		basenamelen = (int) strlen(arcdir_ent->d_name) - 6;
+	{
+		int			basenamelen = (int) strlen(arcdir_ent->d_name) - 6;
 
 		/*
 		 * count anything ending in ".ready"; for a more precise
 		 * implementation see: src/backend/postmaster/pgarch.c
 		 */
-		if (strcmp(arcdir_ent->d_name + basenamelen, ".ready") == 0)
-			ready_count++;
+		if (basenamelen < 0 || strcmp(arcdir_ent->d_name + basenamelen, ".ready") != 0)
+			continue;
+
+		/*
+		 * skip non-files; the file type is usually available from the
+		 * directory entry, so only stat() when it isn't
+		 */
+#ifdef DT_REG
+		if (arcdir_ent->d_type != DT_UNKNOWN)
+		{
+			if (arcdir_ent->d_type != DT_REG)
+				continue;
+		}
+		else
+#endif
+		{
+			struct stat statbuf;
+			char		file_path[MAXPGPATH + sizeof(arcdir_ent->d_name)];
+
+			snprintf(file_path, sizeof(file_path),
+					 "%s/%s",
+					 archive_status_dir,
+					 arcdir_ent->d_name);
+
+			if (stat(file_path, &statbuf) == 0 && !S_ISREG(statbuf.st_mode))
+				continue;
+		}
+
+		ready_count++;
 	}
 
 	closedir(arcdir);
@@ -1817,6 +2707,127 @@ get_timeline_history(PGconn *repl_conn, TimeLineID tli)
 }
 
 
+/*
+ * Checking whether a node can follow another requires IDENTIFY_SYSTEM and
+ * TIMELINE_HISTORY to be executed over replication connections; when
+ * several candidates are evaluated, or a check is retried, the same
+ * results would be retrieved repeatedly. The following functions cache
+ * these results so that, for the duration of an operation, each follow
+ * check after the first does not need a replication connection.
+ *
+ * A node's system identification is cached by node ID. As a node's
+ * timeline can change, e.g. if it is promoted, the cache must be cleared
+ * with clear_follow_check_cache() at the start of each operation. Note the
+ * cached "xlogpos" reflects the time the identification was retrieved.
+ *
+ * A timeline's history never changes once created, so history entries are
+ * cached by system identifier and timeline.
+ */
+bool
+get_cached_system_identification(int node_id, t_system_identification *identification)
+{
+	SystemIdentificationCacheEntry *entry;
+
+	for (entry = system_identification_cache; entry != NULL; entry = entry->next)
+	{
+		if (entry->node_id == node_id)
+		{
+			*identification = entry->identification;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void
+cache_system_identification(int node_id, t_system_identification *identification)
+{
+	SystemIdentificationCacheEntry *entry;
+
+	for (entry = system_identification_cache; entry != NULL; entry = entry->next)
+	{
+		if (entry->node_id == node_id)
+		{
+			entry->identification = *identification;
+			return;
+		}
+	}
+
+	entry = pg_malloc0(sizeof(SystemIdentificationCacheEntry));
+	entry->node_id = node_id;
+	entry->identification = *identification;
+	entry->next = system_identification_cache;
+	system_identification_cache = entry;
+}
+
+
+/*
+ * Return a palloc'd copy of the cached history entry for "tli", which
+ * the caller should pfree(), or NULL if not cached.
+ */
+TimeLineHistoryEntry *
+get_cached_timeline_history(uint64 system_identifier, TimeLineID tli)
+{
+	TimelineHistoryCacheEntry *entry;
+
+	for (entry = timeline_history_cache; entry != NULL; entry = entry->next)
+	{
+		if (entry->system_identifier == system_identifier && entry->tli == tli)
+		{
+			TimeLineHistoryEntry *history = (TimeLineHistoryEntry *) palloc(sizeof(TimeLineHistoryEntry));
+
+			*history = entry->history;
+			return history;
+		}
+	}
+
+	return NULL;
+}
+
+
+void
+cache_timeline_history(uint64 system_identifier, TimeLineID tli, TimeLineHistoryEntry *history)
+{
+	TimelineHistoryCacheEntry *entry;
+
+	for (entry = timeline_history_cache; entry != NULL; entry = entry->next)
+	{
+		if (entry->system_identifier == system_identifier && entry->tli == tli)
+			return;
+	}
+
+	entry = pg_malloc0(sizeof(TimelineHistoryCacheEntry));
+	entry->system_identifier = system_identifier;
+	entry->tli = tli;
+	entry->history = *history;
+	entry->next = timeline_history_cache;
+	timeline_history_cache = entry;
+}
+
+
+/*
+ * Discard cached system identifications; timeline history entries
+ * remain valid and are retained.
+ */
+void
+clear_follow_check_cache(void)
+{
+	SystemIdentificationCacheEntry *entry = system_identification_cache;
+
+	while (entry != NULL)
+	{
+		SystemIdentificationCacheEntry *next = entry->next;
+
+		pfree(entry);
+		entry = next;
+	}
+
+	system_identification_cache = NULL;
+}
+
+
 /* =============================== */
 /* user/role information functions */
 /* =============================== */
@@ -2226,6 +3237,236 @@ repmgrd_pause(PGconn *conn, bool pause)
 	return success;
 }
 
+/*
+ * repmgrd_pause_parallel()
+ *
+ * Pause or unpause repmgrd on each node in the provided list with an open
+ * connection (as set up by establish_node_connections_parallel()). The
+ * request is dispatched to all nodes at once, so the overall time taken is
+ * bounded by the slowest node, rather than the sum of all nodes.
+ *
+ * For each node queried, "details" is set to an empty string on success, or
+ * the error message on failure.
+ *
+ * Returns the number of nodes successfully paused/unpaused.
+ */
+int
+repmgrd_pause_parallel(NodeInfoList *node_list, bool pause, int timeout)
+{
+	NodeInfoListCell *cell = NULL;
+	t_node_info **nodes = NULL;
+	const char **queries = NULL;
+	int			query_count = 0;
+	int			success_count = 0;
+	int			i;
+
+	if (node_list->node_count == 0)
+		return 0;
+
+	nodes = arena_alloc0(sizeof(t_node_info *) * node_list->node_count);
+	queries = arena_alloc0(sizeof(char *) * node_list->node_count);
+
+	for (cell = node_list->head; cell; cell = cell->next)
+	{
+		t_node_info *node_info = cell->node_info;
+
+		if (PQstatus(node_info->conn) != CONNECTION_OK)
+			continue;
+
+		node_info->details[0] = '\0';
+
+		nodes[query_count] = node_info;
+		queries[query_count] = pause == true
+			? "SELECT repmgr.repmgrd_pause(TRUE)"
+			: "SELECT repmgr.repmgrd_pause(FALSE)";
+		query_count++;
+	}
+
+	_execute_node_queries_parallel(nodes, queries, query_count, _repmgrd_pause_result, timeout);
+
+	for (i = 0; i < query_count; i++)
+	{
+		if (nodes[i]->details[0] == '\0')
+			success_count++;
+	}
+
+	arena_free(nodes);
+	arena_free(queries);
+
+	return success_count;
+}
+
+
+static void
+_repmgrd_pause_result(t_node_info *node_info, PGresult *res)
+{
+	if (PQresultStatus(res) == PGRES_TUPLES_OK)
+		return;
+
+	log_error(_("unable to execute \"SELECT repmgr.repmgrd_pause()\" on node %i"),
+			  node_info->node_id);
+	log_detail("%s", PQerrorMessage(node_info->conn));
+
+	snprintf(node_info->details, sizeof(node_info->details),
+			 "%s", PQerrorMessage(node_info->conn));
+
+	/* ensure "details" is non-empty even if libpq provided no message */
+	if (node_info->details[0] == '\0')
+		snprintf(node_info->details, sizeof(node_info->details),
+				 "%s", _("unknown error"));
+}
+
+
+/*
+ * get_repmgrd_status_parallel()
+ *
+ * Retrieve the repmgrd status information displayed by "repmgr service
+ * status" (repmgrd PID, whether it is running and/or paused, when the
+ * upstream was last seen, and whether WAL replay is paused with WAL pending)
+ * from each node in the provided list with an open connection. As with the
+ * other *_parallel() functions, the query is dispatched to all nodes at once.
+ *
+ * NOTE: "replication_info->wal_replay_paused" is only set if WAL replay is
+ * paused *and* there is received WAL still to be replayed, as with
+ * is_wal_replay_paused(conn, true).
+ *
+ * Each queried node's "replication_info" will be allocated if necessary and
+ * populated, and its "recovery_type" set. If the query fails for a node
+ * (e.g. as the repmgr extension is not installed), "replication_info" is
+ * left with its initial values and "recovery_type" is RECTYPE_UNKNOWN.
+ *
+ * Returns the number of nodes for which repmgrd status was retrieved.
+ */
+int
+get_repmgrd_status_parallel(NodeInfoList *node_list, int timeout)
+{
+	NodeInfoListCell *cell = NULL;
+	t_node_info **nodes = NULL;
+	const char **queries = NULL;
+	PQExpBufferData *query_bufs = NULL;
+	int			query_count = 0;
+	int			success_count = 0;
+	int			i;
+
+	if (node_list->node_count == 0)
+		return 0;
+
+	nodes = arena_alloc0(sizeof(t_node_info *) * node_list->node_count);
+	queries = arena_alloc0(sizeof(char *) * node_list->node_count);
+	query_bufs = arena_alloc0(sizeof(PQExpBufferData) * node_list->node_count);
+
+	for (cell = node_list->head; cell; cell = cell->next)
+	{
+		t_node_info *node_info = cell->node_info;
+		PQExpBufferData *query = NULL;
+
+		node_info->recovery_type = RECTYPE_UNKNOWN;
+
+		if (PQstatus(node_info->conn) != CONNECTION_OK)
+			continue;
+
+		if (node_info->replication_info == NULL)
+			node_info->replication_info = pg_malloc0(sizeof(ReplInfo));
+
+		init_replication_info(node_info->replication_info);
+
+		query = &query_bufs[query_count];
+		initPQExpBuffer(query);
+
+		appendPQExpBufferStr(query,
+							 " SELECT pg_catalog.pg_is_in_recovery(), "
+							 "        repmgr.get_repmgrd_pid(), "
+							 "        repmgr.repmgrd_is_running(), "
+							 "        repmgr.repmgrd_is_paused(), ");
+
+		if (PQserverVersion(node_info->conn) >= 100000)
+		{
+			appendPQExpBufferStr(query,
+								 "        CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
+								 "          THEN FALSE "
+								 "          ELSE pg_catalog.pg_is_wal_replay_paused() "
+								 "               AND pg_catalog.pg_last_wal_replay_lsn() < pg_catalog.pg_last_wal_receive_lsn() "
+								 "        END, ");
+		}
+		else
+		{
+			appendPQExpBufferStr(query,
+								 "        CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
+								 "          THEN FALSE "
+								 "          ELSE pg_catalog.pg_is_xlog_replay_paused() "
+								 "               AND pg_catalog.pg_last_xlog_replay_location() < pg_catalog.pg_last_xlog_receive_location() "
+								 "        END, ");
+		}
+
+		/* see get_upstream_last_seen() */
+		if (node_info->type == WITNESS)
+		{
+			appendPQExpBufferStr(query,
+								 "        repmgr.get_upstream_last_seen() ");
+		}
+		else
+		{
+			appendPQExpBufferStr(query,
+								 "        CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
+								 "          THEN -1 "
+								 "          ELSE repmgr.get_upstream_last_seen() "
+								 "        END ");
+		}
+
+		nodes[query_count] = node_info;
+		queries[query_count] = query->data;
+		query_count++;
+	}
+
+	_execute_node_queries_parallel(nodes, queries, query_count, _get_repmgrd_status_result, timeout);
+
+	for (i = 0; i < query_count; i++)
+	{
+		if (nodes[i]->recovery_type != RECTYPE_UNKNOWN)
+			success_count++;
+
+		termPQExpBuffer(&query_bufs[i]);
+	}
+
+	arena_free(nodes);
+	arena_free(queries);
+	arena_free(query_bufs);
+
+	return success_count;
+}
+
+
+static void
+_get_repmgrd_status_result(t_node_info *node_info, PGresult *res)
+{
+	ReplInfo   *replication_info = node_info->replication_info;
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0)
+	{
+		log_db_error(node_info->conn, NULL,
+					 _("get_repmgrd_status_parallel(): unable to query node %i"),
+					 node_info->node_id);
+		return;
+	}
+
+	replication_info->in_recovery = atobool(PQgetvalue(res, 0, 0));
+	node_info->recovery_type = replication_info->in_recovery == true
+		? RECTYPE_STANDBY
+		: RECTYPE_PRIMARY;
+
+	if (!PQgetisnull(res, 0, 1))
+		replication_info->repmgrd_pid = atoi(PQgetvalue(res, 0, 1));
+	if (!PQgetisnull(res, 0, 2))
+		replication_info->repmgrd_running = atobool(PQgetvalue(res, 0, 2));
+	if (!PQgetisnull(res, 0, 3))
+		replication_info->repmgrd_paused = atobool(PQgetvalue(res, 0, 3));
+	if (!PQgetisnull(res, 0, 4))
+		replication_info->wal_replay_paused = atobool(PQgetvalue(res, 0, 4));
+	if (!PQgetisnull(res, 0, 5))
+		replication_info->upstream_last_seen = atoi(PQgetvalue(res, 0, 5));
+}
+
+
 pid_t
 get_wal_receiver_pid(PGconn *conn)
 {
@@ -2250,6 +3491,60 @@ get_wal_receiver_pid(PGconn *conn)
 }
 
 
+/*
+ * Determine how long ago the local WAL receiver last received a message
+ * from its upstream.
+ *
+ * Returns the number of seconds since the last message, or -1 if no WAL
+ * receiver is streaming or the information is not available (PostgreSQL 9.5
+ * and earlier, or the user cannot view the details in "pg_stat_wal_receiver").
+ *
+ * "receiver_timeout" is set to the value of "wal_receiver_timeout", in
+ * milliseconds.
+ */
+int
+get_wal_receiver_last_msg_age(PGconn *conn, int *receiver_timeout)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	int			last_msg_age = -1;
+
+	*receiver_timeout = 0;
+
+	if (PQserverVersion(conn) < 90600)
+		return -1;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBufferStr(&query,
+						 " SELECT EXTRACT(epoch FROM (pg_catalog.clock_timestamp() - w.last_msg_receipt_time))::INT, "
+						 "        (SELECT s.setting::INT FROM pg_catalog.pg_settings s WHERE s.name = 'wal_receiver_timeout') "
+						 "   FROM pg_catalog.pg_stat_wal_receiver w "
+						 "  WHERE w.pid = repmgr.get_wal_receiver_pid() "
+						 "    AND w.status = 'streaming' ");
+
+	log_verbose(LOG_DEBUG, "get_wal_receiver_last_msg_age():\n  %s", query.data);
+
+	res = PQexec(conn, query.data);
+	termPQExpBuffer(&query);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_warning(_("unable to query WAL receiver status"));
+		log_detail("%s", PQerrorMessage(conn));
+	}
+	else if (PQntuples(res) == 1 && !PQgetisnull(res, 0, 0))
+	{
+		last_msg_age = atoi(PQgetvalue(res, 0, 0));
+		*receiver_timeout = atoi(PQgetvalue(res, 0, 1));
+	}
+
+	PQclear(res);
+
+	return last_msg_age;
+}
+
+
 int
 repmgrd_get_upstream_node_id(PGconn *conn)
 {
@@ -2798,58 +4093,130 @@ get_primary_node_record(PGconn *conn, t_node_info *node_info)
 		return false;
 	}
 
-	record_status = get_node_record(conn, primary_node_id, node_info);
+	record_status = get_node_record(conn, primary_node_id, node_info);
+
+	return record_status == RECORD_FOUND ? true : false;
+}
+
+
+/*
+ * Get the local node record; if this fails, exit. Many operations
+ * depend on this being available, so we'll centralize the check
+ * and failure messages here.
+ */
+bool
+get_local_node_record(PGconn *conn, int node_id, t_node_info *node_info)
+{
+	RecordStatus record_status = get_node_record(conn, node_id, node_info);
+
+	if (record_status != RECORD_FOUND)
+	{
+		log_error(_("unable to retrieve record for local node"));
+		log_detail(_("local node id is  %i"), node_id);
+		log_hint(_("check this node was correctly registered"));
+
+		PQfinish(conn);
+		exit(ERR_BAD_CONFIG);
+	}
+
+	return true;
+}
+
+
+static
+void
+_populate_node_records(PGresult *res, NodeInfoList *node_list)
+{
+	int			i;
+	int			ntuples;
+
+	_release_node_list_entries(node_list);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		return;
+	}
+
+	ntuples = PQntuples(res);
+
+	if (ntuples == 0)
+		return;
+
+	_init_node_tables(node_list, ntuples);
+
+	for (i = 0; i < ntuples; i++)
+		_populate_node_record(res, &node_list->node_table[i], i, true);
+
+	_build_node_list_index(node_list);
 
-	return record_status == RECORD_FOUND ? true : false;
+	return;
 }
 
 
 /*
- * Get the local node record; if this fails, exit. Many operations
- * depend on this being available, so we'll centralize the check
- * and failure messages here.
+ * set_node_info_list()
+ *
+ * Populate the provided list with copies of the provided node records,
+ * as if it had been populated from a query result. Any connection handles
+ * and replication info in the provided records are not copied.
  */
-bool
-get_local_node_record(PGconn *conn, int node_id, t_node_info *node_info)
+void
+set_node_info_list(NodeInfoList *node_list, t_node_info *node_records, int node_count)
 {
-	RecordStatus record_status = get_node_record(conn, node_id, node_info);
+	int			i;
 
-	if (record_status != RECORD_FOUND)
-	{
-		log_error(_("unable to retrieve record for local node"));
-		log_detail(_("local node id is  %i"), node_id);
-		log_hint(_("check this node was correctly registered"));
+	_release_node_list_entries(node_list);
 
-		PQfinish(conn);
-		exit(ERR_BAD_CONFIG);
+	if (node_count == 0)
+		return;
+
+	_init_node_tables(node_list, node_count);
+
+	for (i = 0; i < node_count; i++)
+	{
+		node_list->node_table[i] = node_records[i];
+		node_list->node_table[i].conn = NULL;
+		node_list->node_table[i].replication_info = NULL;
 	}
 
-	return true;
+	_build_node_list_index(node_list);
 }
 
 
-static
-void
-_populate_node_records(PGresult *res, NodeInfoList *node_list)
+/*
+ * Allocate (or reuse) and link the node tables for a list of "count"
+ * zeroed node records. The list must be empty.
+ */
+static void
+_init_node_tables(NodeInfoList *node_list, int count)
 {
 	int			i;
 
-	clear_node_info_list(node_list);
-
-	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	/*
+	 * Allocate all cells and node records in one go, reusing the existing
+	 * tables if large enough; repmgrd repopulates the same lists on each
+	 * monitoring cycle.
+	 */
+	if (count > node_list->table_capacity)
 	{
-		return;
-	}
+		if (node_list->cell_table != NULL)
+			pfree(node_list->cell_table);
+		if (node_list->node_table != NULL)
+			pfree(node_list->node_table);
 
-	for (i = 0; i < PQntuples(res); i++)
-	{
-		NodeInfoListCell *cell;
+		node_list->cell_table = (NodeInfoListCell *) pg_malloc(sizeof(NodeInfoListCell) * count);
+		node_list->node_table = (t_node_info *) pg_malloc(sizeof(t_node_info) * count);
+		node_list->table_capacity = count;
+	}
 
-		cell = (NodeInfoListCell *) pg_malloc0(sizeof(NodeInfoListCell));
+	memset(node_list->cell_table, 0, sizeof(NodeInfoListCell) * count);
+	memset(node_list->node_table, 0, sizeof(t_node_info) * count);
 
-		cell->node_info = pg_malloc0(sizeof(t_node_info));
+	for (i = 0; i < count; i++)
+	{
+		NodeInfoListCell *cell = &node_list->cell_table[i];
 
-		_populate_node_record(res, cell->node_info, i, true);
+		cell->node_info = &node_list->node_table[i];
 
 		if (node_list->tail)
 			node_list->tail->next = cell;
@@ -2860,7 +4227,47 @@ _populate_node_records(PGresult *res, NodeInfoList *node_list)
 		node_list->node_count++;
 	}
 
-	return;
+	node_list->table_count = count;
+}
+
+
+/*
+ * Node IDs are arbitrary positive integers, so the index is a simple
+ * open-addressing hash table mapping node_id to the node's position
+ * (plus one; zero denotes an empty slot) in "node_table".
+ */
+static void
+_build_node_list_index(NodeInfoList *node_list)
+{
+	int			index_size = 16;
+	unsigned int mask;
+	int			i;
+
+	while (index_size < node_list->table_count * 2)
+		index_size <<= 1;
+
+	if (index_size > node_list->node_index_size)
+	{
+		if (node_list->node_index != NULL)
+			pfree(node_list->node_index);
+
+		node_list->node_index = (int *) pg_malloc(sizeof(int) * index_size);
+		node_list->node_index_size = index_size;
+	}
+
+	memset(node_list->node_index, 0, sizeof(int) * node_list->node_index_size);
+
+	mask = (unsigned int) node_list->node_index_size - 1;
+
+	for (i = 0; i < node_list->table_count; i++)
+	{
+		unsigned int slot = ((unsigned int) node_list->node_table[i].node_id * 2654435761U) & mask;
+
+		while (node_list->node_index[slot] != 0)
+			slot = (slot + 1) & mask;
+
+		node_list->node_index[slot] = i + 1;
+	}
 }
 
 
@@ -3010,6 +4417,53 @@ get_child_nodes(PGconn *conn, int node_id, NodeInfoList *node_list)
 }
 
 
+/*
+ * update_node_list_attached()
+ *
+ * Set the "attached" status of each node in the provided list according to
+ * whether a walsender with the node's name as "application_name" is present
+ * in pg_stat_replication, as get_child_nodes() does. Used by repmgrd to
+ * refresh the status of cached child node records.
+ */
+bool
+update_node_list_attached(PGconn *conn, NodeInfoList *node_list)
+{
+	PGresult   *res = NULL;
+	NodeInfoListCell *cell = NULL;
+	const char *sqlquery = "SELECT application_name FROM pg_catalog.pg_stat_replication";
+	int			i;
+
+	log_verbose(LOG_DEBUG, "update_node_list_attached():\n%s", sqlquery);
+
+	res = PQexec(conn, sqlquery);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, sqlquery, _("update_node_list_attached(): unable to execute query"));
+		PQclear(res);
+		return false;
+	}
+
+	for (cell = node_list->head; cell; cell = cell->next)
+	{
+		cell->node_info->attached = NODE_DETACHED;
+
+		for (i = 0; i < PQntuples(res); i++)
+		{
+			if (strcmp(cell->node_info->node_name, PQgetvalue(res, i, 0)) == 0)
+			{
+				cell->node_info->attached = NODE_ATTACHED;
+				break;
+			}
+		}
+	}
+
+	PQclear(res);
+
+	return true;
+}
+
+
 void
 get_node_records_by_priority(PGconn *conn, NodeInfoList *node_list)
 {
@@ -3320,75 +4774,54 @@ update_node_record_set_active_standby(PGconn *conn, int this_node_id)
 }
 
 
+/*
+ * Mark the specified node as the active primary, and any other active
+ * primary as inactive.
+ *
+ * This is executed immediately after promotion, so is done with a single
+ * statement (and therefore a single round trip) rather than an explicit
+ * transaction containing one update for each node.
+ */
 bool
 update_node_record_set_primary(PGconn *conn, int this_node_id)
 {
 	PQExpBufferData query;
 	PGresult   *res = NULL;
+	bool		success = true;
 
 	log_debug(_("setting node %i as primary and marking existing primary as failed"),
 			  this_node_id);
 
-	begin_transaction(conn);
-
 	initPQExpBuffer(&query);
 
 	appendPQExpBuffer(&query,
 					  "  UPDATE repmgr.nodes "
-					  "     SET active = FALSE "
-					  "   WHERE type = 'primary' "
-					  "     AND active IS TRUE "
-					  "     AND node_id != %i ",
+					  "     SET type = CASE WHEN node_id = %i THEN 'primary' ELSE type END, "
+					  "         upstream_node_id = CASE WHEN node_id = %i THEN NULL ELSE upstream_node_id END, "
+					  "         active = (node_id = %i) "
+					  "   WHERE node_id = %i "
+					  "      OR (type = 'primary' AND active IS TRUE) ",
+					  this_node_id,
+					  this_node_id,
+					  this_node_id,
 					  this_node_id);
 
-	res = PQexec(conn, query.data);
-
-	if (PQresultStatus(res) != PGRES_COMMAND_OK)
-	{
-		log_db_error(conn, query.data,
-					 _("update_node_record_set_primary(): unable to set old primary node as inactive"));
-
-		termPQExpBuffer(&query);
-		PQclear(res);
-
-		rollback_transaction(conn);
-
-		return false;
-	}
-
-	termPQExpBuffer(&query);
-	PQclear(res);
-
-	initPQExpBuffer(&query);
-
-	appendPQExpBuffer(&query,
-					  "  UPDATE repmgr.nodes"
-					  "     SET type = 'primary', "
-					  "         upstream_node_id = NULL, "
-					  "         active = TRUE "
-					  "   WHERE node_id = %i ",
-					  this_node_id);
+	log_verbose(LOG_DEBUG, "update_node_record_set_primary():\n  %s", query.data);
 
 	res = PQexec(conn, query.data);
 
 	if (PQresultStatus(res) != PGRES_COMMAND_OK)
 	{
 		log_db_error(conn, query.data,
-					 _("unable to set current node %i as active primary"),
+					 _("update_node_record_set_primary(): unable to set current node %i as active primary"),
 					 this_node_id);
-
-		termPQExpBuffer(&query);
-		PQclear(res);
-
-		rollback_transaction(conn);
-
-		return false;
+		success = false;
 	}
 
 	termPQExpBuffer(&query);
 	PQclear(res);
 
-	return commit_transaction(conn);
+	return success;
 }
 
 
@@ -3466,105 +4899,336 @@ update_node_record_status(PGconn *conn, int this_node_id, char *type, int upstre
 		success = false;
 	}
 
-	termPQExpBuffer(&query);
-	PQclear(res);
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
+
+/*
+ * Update node record's "conninfo" and "priority" fields. Called by repmgrd
+ * following a configuration file reload.
+ */
+bool
+update_node_record_conn_priority(PGconn *conn, t_configuration_options *options)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "UPDATE repmgr.nodes "
+					  "   SET conninfo = '%s', "
+					  "       priority = %d "
+					  " WHERE node_id = %d ",
+					  options->conninfo,
+					  options->priority,
+					  options->node_id);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+	{
+		log_db_error(conn, query.data, _("update_node_record_conn_priority(): unable to execute query"));
+		success = false;
+	}
+
+	termPQExpBuffer(&query);
+
+	PQclear(res);
+
+	return success;
+}
+
+
+/*
+ * Copy node records from primary to witness servers.
+ *
+ * This is used when initially registering a witness server, and
+ * by repmgrd to update the node records when required.
+ *
+ * If the records on both servers are identical (as determined by comparing
+ * a hash of each server's records), nothing is done; otherwise only new,
+ * changed and removed records are applied to the witness server.
+ */
+
+bool
+witness_copy_node_records(PGconn *primary_conn, PGconn *witness_conn)
+{
+	PGresult   *res = NULL;
+	NodeInfoList primary_nodes = T_NODE_INFO_LIST_INITIALIZER;
+	NodeInfoList witness_nodes = T_NODE_INFO_LIST_INITIALIZER;
+	NodeInfoListCell *cell = NULL;
+	char		primary_hash[MAXLEN] = "";
+	char		witness_hash[MAXLEN] = "";
+	t_node_info **changed_nodes = NULL;
+	int			changed_count = 0;
+	PQExpBufferData delete_ids;
+	int			delete_count = 0;
+	bool		success = true;
+
+	/* nothing to do if the node records are identical */
+	if (_get_node_records_hash(primary_conn, primary_hash) == true
+		&& _get_node_records_hash(witness_conn, witness_hash) == true
+		&& strcmp(primary_hash, witness_hash) == 0)
+	{
+		log_verbose(LOG_DEBUG, "witness_copy_node_records(): node records unchanged");
+		return true;
+	}
+
+	if (get_all_node_records(primary_conn, &primary_nodes) == false
+		|| get_all_node_records(witness_conn, &witness_nodes) == false)
+	{
+		/* get_all_node_records() will display any error message */
+		clear_node_info_list(&primary_nodes);
+		clear_node_info_list(&witness_nodes);
+
+		return false;
+	}
+
+	/*
+	 * Determine which records are new or changed (to be inserted), and which
+	 * records are changed or no longer present (to be deleted).
+	 */
+	changed_nodes = (t_node_info **) arena_alloc0(sizeof(t_node_info *) * (primary_nodes.node_count + 1));
+	initPQExpBuffer(&delete_ids);
+
+	for (cell = primary_nodes.head; cell; cell = cell->next)
+	{
+		t_node_info *witness_node = find_node_in_list(&witness_nodes, cell->node_info->node_id);
+
+		if (witness_node != NULL && _node_records_equal(cell->node_info, witness_node) == true)
+			continue;
+
+		changed_nodes[changed_count++] = cell->node_info;
+
+		if (witness_node != NULL)
+		{
+			appendPQExpBuffer(&delete_ids, "%s%i",
+							  delete_count == 0 ? "" : ", ",
+							  witness_node->node_id);
+			delete_count++;
+		}
+	}
+
+	for (cell = witness_nodes.head; cell; cell = cell->next)
+	{
+		if (find_node_in_list(&primary_nodes, cell->node_info->node_id) != NULL)
+			continue;
+
+		appendPQExpBuffer(&delete_ids, "%s%i",
+						  delete_count == 0 ? "" : ", ",
+						  cell->node_info->node_id);
+		delete_count++;
+	}
+
+	log_verbose(LOG_DEBUG, "witness_copy_node_records(): %i record(s) to delete, %i record(s) to insert",
+				delete_count, changed_count);
+
+	if (changed_count == 0 && delete_count == 0)
+		goto cleanup;
+
+	begin_transaction(witness_conn);
+
+	/* Defer constraints */
+
+	res = PQexec(witness_conn, "SET CONSTRAINTS ALL DEFERRED");
+
+	if (!res || PQresultStatus(res) != PGRES_COMMAND_OK)
+	{
+		log_db_error(witness_conn, NULL, ("witness_copy_node_records(): unable to defer constraints"));
+
+		rollback_transaction(witness_conn);
+		PQclear(res);
+
+		success = false;
+		goto cleanup;
+	}
+
+	PQclear(res);
+
+	if (delete_count > 0)
+	{
+		PQExpBufferData query;
+
+		initPQExpBuffer(&query);
+
+		appendPQExpBuffer(&query,
+						  "DELETE FROM repmgr.nodes "
+						  " WHERE node_id IN (%s)",
+						  delete_ids.data);
+
+		log_verbose(LOG_DEBUG, "witness_copy_node_records():\n  %s", query.data);
+
+		res = PQexec(witness_conn, query.data);
+
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			log_db_error(witness_conn, query.data, _("witness_copy_node_records(): unable to delete node records"));
+			success = false;
+		}
+
+		termPQExpBuffer(&query);
+		PQclear(res);
+	}
+
+	if (success == true && changed_count > 0)
+		success = _insert_node_records(witness_conn, changed_nodes, changed_count);
+
+	/* and done */
+	if (success == true)
+		success = commit_transaction(witness_conn);
+	else
+		rollback_transaction(witness_conn);
+
+cleanup:
+	arena_free(changed_nodes);
+	termPQExpBuffer(&delete_ids);
+	clear_node_info_list(&primary_nodes);
+	clear_node_info_list(&witness_nodes);
 
 	return success;
 }
 
 
 /*
- * Update node record's "conninfo" and "priority" fields. Called by repmgrd
- * following a configuration file reload.
+ * Retrieve a hash of the contents of "repmgr.nodes", to determine cheaply
+ * whether the records on two nodes differ.
  */
-bool
-update_node_record_conn_priority(PGconn *conn, t_configuration_options *options)
+static bool
+_get_node_records_hash(PGconn *conn, char *hash)
 {
-	PQExpBufferData query;
 	PGresult   *res = NULL;
-	bool		success = true;
-
-	initPQExpBuffer(&query);
+	const char *sqlquery =
+		" SELECT pg_catalog.md5(COALESCE(pg_catalog.string_agg( "
+		"          (n.node_id, n.type, n.upstream_node_id, n.node_name, n.conninfo, "
+		"           n.repluser, n.slot_name, n.location, n.priority, n.active, n.config_file)::TEXT, "
+		"          ',' ORDER BY n.node_id), '')) "
+		"   FROM repmgr.nodes n ";
 
-	appendPQExpBuffer(&query,
-					  "UPDATE repmgr.nodes "
-					  "   SET conninfo = '%s', "
-					  "       priority = %d "
-					  " WHERE node_id = %d ",
-					  options->conninfo,
-					  options->priority,
-					  options->node_id);
+	log_verbose(LOG_DEBUG, "_get_node_records_hash():\n%s", sqlquery);
 
-	res = PQexec(conn, query.data);
+	res = PQexec(conn, sqlquery);
 
-	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1)
 	{
-		log_db_error(conn, query.data, _("update_node_record_conn_priority(): unable to execute query"));
-		success = false;
+		log_db_error(conn, sqlquery, _("_get_node_records_hash(): unable to execute query"));
+		PQclear(res);
+
+		return false;
 	}
 
-	termPQExpBuffer(&query);
+	snprintf(hash, MAXLEN, "%s", PQgetvalue(res, 0, 0));
 
 	PQclear(res);
 
-	return success;
+	return true;
+}
+
+
+static bool
+_node_records_equal(t_node_info *node_a, t_node_info *node_b)
+{
+	return node_a->node_id == node_b->node_id
+		&& node_a->type == node_b->type
+		&& node_a->upstream_node_id == node_b->upstream_node_id
+		&& node_a->priority == node_b->priority
+		&& node_a->active == node_b->active
+		&& strcmp(node_a->node_name, node_b->node_name) == 0
+		&& strcmp(node_a->conninfo, node_b->conninfo) == 0
+		&& strcmp(node_a->repluser, node_b->repluser) == 0
+		&& strcmp(node_a->slot_name, node_b->slot_name) == 0
+		&& strcmp(node_a->location, node_b->location) == 0
+		&& strcmp(node_a->config_file, node_b->config_file) == 0;
 }
 
 
 /*
- * Copy node records from primary to witness servers.
- *
- * This is used when initially registering a witness server, and
- * by repmgrd to update the node records when required.
+ * Insert the provided node records as-is with a single INSERT statement.
+ * Unlike create_node_record(), no attempt is made to determine the upstream
+ * node of standbys without one.
  */
-
-bool
-witness_copy_node_records(PGconn *primary_conn, PGconn *witness_conn)
+static bool
+_insert_node_records(PGconn *conn, t_node_info **nodes, int node_count)
 {
+	PQExpBufferData query;
 	PGresult   *res = NULL;
-	NodeInfoList nodes = T_NODE_INFO_LIST_INITIALIZER;
-	NodeInfoListCell *cell = NULL;
-
-	begin_transaction(witness_conn);
-
-	/* Defer constraints */
+	const char **param_values = NULL;
+	char	   *int_values = NULL;
+	bool		success = true;
+	int			i;
 
-	res = PQexec(witness_conn, "SET CONSTRAINTS ALL DEFERRED");
+	/* node_id, upstream_node_id and priority for each node */
+	param_values = (const char **) arena_alloc0(sizeof(char *) * node_count * NODE_RECORD_PARAM_COUNT);
+	int_values = (char *) arena_alloc0(NODE_RECORD_INT_LEN * 3 * node_count);
 
-	if (!res || PQresultStatus(res) != PGRES_COMMAND_OK)
-	{
-		log_db_error(witness_conn, NULL, ("witness_copy_node_records(): unable to defer constraints"));
+	initPQExpBuffer(&query);
 
-		rollback_transaction(witness_conn);
-		PQclear(res);
+	appendPQExpBufferStr(&query,
+						 "INSERT INTO repmgr.nodes "
+						 "       (node_id, type, upstream_node_id, "
+						 "        node_name, conninfo, repluser, slot_name, "
+						 "        location, priority, active, config_file) "
+						 "VALUES ");
+
+	for (i = 0; i < node_count; i++)
+	{
+		t_node_info *node_info = nodes[i];
+		const char **values = &param_values[i * NODE_RECORD_PARAM_COUNT];
+		char	   *node_id = &int_values[(i * 3) * NODE_RECORD_INT_LEN];
+		char	   *upstream_node_id = &int_values[(i * 3 + 1) * NODE_RECORD_INT_LEN];
+		char	   *priority = &int_values[(i * 3 + 2) * NODE_RECORD_INT_LEN];
+		int			p = i * NODE_RECORD_PARAM_COUNT;
+
+		snprintf(node_id, NODE_RECORD_INT_LEN, "%i", node_info->node_id);
+		snprintf(upstream_node_id, NODE_RECORD_INT_LEN, "%i", node_info->upstream_node_id);
+		snprintf(priority, NODE_RECORD_INT_LEN, "%i", node_info->priority);
+
+		values[0] = node_id;
+		values[1] = get_node_type_string(node_info->type);
+		values[2] = node_info->upstream_node_id == NO_UPSTREAM_NODE ? NULL : upstream_node_id;
+		values[3] = node_info->node_name;
+		values[4] = node_info->conninfo;
+		values[5] = node_info->repluser;
+		values[6] = node_info->slot_name[0] == '\0' ? NULL : node_info->slot_name;
+		values[7] = node_info->location;
+		values[8] = priority;
+		values[9] = node_info->active == true ? "TRUE" : "FALSE";
+		values[10] = node_info->config_file;
 
-		return false;
+		appendPQExpBuffer(&query,
+						  "%s($%i::INT, $%i, $%i::INT, $%i, $%i, $%i, $%i, $%i, $%i::INT, $%i::BOOL, $%i)",
+						  i == 0 ? "" : ", ",
+						  p + 1, p + 2, p + 3, p + 4, p + 5, p + 6,
+						  p + 7, p + 8, p + 9, p + 10, p + 11);
 	}
 
-	PQclear(res);
-
-	/* truncate existing records */
-
-	if (truncate_node_records(witness_conn) == false)
-	{
-		rollback_transaction(witness_conn);
-
-		return false;
-	}
+	log_verbose(LOG_DEBUG, "_insert_node_records(): inserting %i node record(s)", node_count);
 
-	get_all_node_records(primary_conn, &nodes);
+	res = PQexecParams(conn,
+					   query.data,
+					   node_count * NODE_RECORD_PARAM_COUNT,
+					   NULL,
+					   param_values,
+					   NULL,
+					   NULL,
+					   0);
 
-	for (cell = nodes.head; cell; cell = cell->next)
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
 	{
-		create_node_record(witness_conn, NULL, cell->node_info);
+		log_db_error(conn, NULL, _("_insert_node_records(): unable to insert node records"));
+		success = false;
 	}
 
-	/* and done */
-	commit_transaction(witness_conn);
-
-	clear_node_info_list(&nodes);
+	termPQExpBuffer(&query);
+	PQclear(res);
+	arena_free(param_values);
+	arena_free(int_values);
 
-	return true;
+	return success;
 }
 
 
@@ -3656,6 +5320,30 @@ update_node_record_slot_name(PGconn *primary_conn, int node_id, char *slot_name)
 
 void
 clear_node_info_list(NodeInfoList *nodes)
+{
+	_release_node_list_entries(nodes);
+
+	if (nodes->cell_table != NULL)
+		pfree(nodes->cell_table);
+	if (nodes->node_table != NULL)
+		pfree(nodes->node_table);
+	if (nodes->node_index != NULL)
+		pfree(nodes->node_index);
+
+	nodes->cell_table = NULL;
+	nodes->node_table = NULL;
+	nodes->table_capacity = 0;
+	nodes->node_index = NULL;
+	nodes->node_index_size = 0;
+}
+
+
+/*
+ * Close any open connections and free the list's entries, but retain the
+ * node tables (if any) for reuse by _populate_node_records().
+ */
+static void
+_release_node_list_entries(NodeInfoList *nodes)
 {
 	NodeInfoListCell *cell = NULL;
 	NodeInfoListCell *next_cell = NULL;
@@ -3684,14 +5372,108 @@ clear_node_info_list(NodeInfoList *nodes)
 		if (cell->node_info->replication_info != NULL)
 			pfree(cell->node_info->replication_info);
 
-		pfree(cell->node_info);
-		pfree(cell);
+		/* cells in the node table are freed by clear_node_info_list() */
+		if (nodes->cell_table == NULL
+			|| cell < nodes->cell_table
+			|| cell >= nodes->cell_table + nodes->table_count)
+		{
+			pfree(cell->node_info);
+			pfree(cell);
+		}
+
 		cell = next_cell;
 	}
 
 	nodes->head = NULL;
 	nodes->tail = NULL;
 	nodes->node_count = 0;
+	nodes->table_count = 0;
+}
+
+
+/*
+ * The index is only usable if no cells have been appended to the list since
+ * it was populated from a query result.
+ */
+static bool
+_node_list_is_indexed(NodeInfoList *node_list)
+{
+	return node_list->node_index != NULL
+		&& node_list->table_count > 0
+		&& node_list->node_count == node_list->table_count;
+}
+
+
+/*
+ * get_node_list_position()
+ *
+ * Return the zero-based position in the provided list of the node with the
+ * specified ID, or -1 if not found.
+ *
+ * For lists populated from a query result this is a constant-time index
+ * lookup; otherwise the list is scanned.
+ */
+int
+get_node_list_position(NodeInfoList *node_list, int node_id)
+{
+	NodeInfoListCell *cell = NULL;
+	int			position = 0;
+
+	if (_node_list_is_indexed(node_list))
+	{
+		unsigned int mask = (unsigned int) node_list->node_index_size - 1;
+		unsigned int slot = ((unsigned int) node_id * 2654435761U) & mask;
+
+		while (node_list->node_index[slot] != 0)
+		{
+			int			i = node_list->node_index[slot] - 1;
+
+			if (node_list->node_table[i].node_id == node_id)
+				return i;
+
+			slot = (slot + 1) & mask;
+		}
+
+		return -1;
+	}
+
+	for (cell = node_list->head; cell; cell = cell->next)
+	{
+		if (cell->node_info->node_id == node_id)
+			return position;
+
+		position++;
+	}
+
+	return -1;
+}
+
+
+/*
+ * find_node_in_list()
+ *
+ * Return a pointer to the record in the provided list of the node with the
+ * specified ID, or NULL if not found.
+ */
+t_node_info *
+find_node_in_list(NodeInfoList *node_list, int node_id)
+{
+	NodeInfoListCell *cell = NULL;
+
+	if (_node_list_is_indexed(node_list))
+	{
+		int			position = get_node_list_position(node_list, node_id);
+
+		return (position < 0) ? NULL : &node_list->node_table[position];
+	}
+
+	for (cell = node_list->head; cell; cell = cell->next)
+	{
+		if (cell->node_info->node_id == node_id)
+			return cell->node_info;
+	}
+
+	return NULL;
 }
 
 
@@ -4210,6 +5992,22 @@ _create_event(PGconn *conn, t_configuration_options *options, int node_id, char
 
 		*dst_ptr = '\0';
 
+		/*
+		 * If background execution has been enabled (repmgrd only), hand the
+		 * command over so the caller is not blocked until it completes; its
+		 * outcome will be logged but cannot be reported to the caller.
+		 */
+		if (background_commands_enabled() == true)
+		{
+			log_info(_("queueing notification command for event \"%s\""),
+					 event);
+
+			log_detail(_("command is:\n  %s"), parsed_command);
+			queue_background_command(parsed_command);
+
+			return success;
+		}
+
 		log_info(_("executing notification command for event \"%s\""),
 				 event);
 
@@ -4227,30 +6025,103 @@ _create_event(PGconn *conn, t_configuration_options *options, int node_id, char
 }
 
 
-PGresult *
-get_event_records(PGconn *conn, int node_id, const char *node_name, const char *event, bool all, int limit)
+/*
+ * Append a condition selecting events before ("<") or after (">") the
+ * position provided with "cluster event --before/--after".
+ *
+ * As event timestamps are not unique, a "timestamp,node_id,event" key is
+ * compared against the full sort order so no events are skipped between
+ * pages; a plain timestamp is compared against the event timestamp only.
+ */
+static bool
+_append_event_pagination_clause(PGconn *conn, PQExpBufferData *where_clause, const char *value, const char *operator)
 {
-	PGresult   *res;
+	t_event_pagination_key key;
+	char	   *escaped_timestamp = NULL;
+	char	   *escaped_event = NULL;
 
-	PQExpBufferData query;
-	PQExpBufferData where_clause;
+	if (parse_event_pagination_key(value, &key) == false)
+		return false;
 
+	escaped_timestamp = escape_string(conn, key.timestamp);
+
+	if (escaped_timestamp == NULL)
+		return false;
+
+	if (key.node_id == UNKNOWN_NODE_ID)
+	{
+		append_where_clause(where_clause,
+							"e.event_timestamp %s '%s'::TIMESTAMP WITH TIME ZONE",
+							operator,
+							escaped_timestamp);
+		pfree(escaped_timestamp);
+
+		return true;
+	}
+
+	escaped_event = escape_string(conn, key.event);
+
+	if (escaped_event == NULL)
+	{
+		pfree(escaped_timestamp);
+		return false;
+	}
+
+	append_where_clause(where_clause,
+						"(e.event_timestamp, e.node_id, e.event) %s ('%s'::TIMESTAMP WITH TIME ZONE, %i, '%s')",
+						operator,
+						escaped_timestamp,
+						key.node_id,
+						escaped_event);
+
+	pfree(escaped_timestamp);
+	pfree(escaped_event);
+
+	return true;
+}
+
+
+/*
+ * Build the query used by "repmgr cluster event".
+ *
+ * Filters are expressed against columns of "repmgr.events" so the
+ * (node_id, event_timestamp) and (event, event_timestamp) indexes can be
+ * used; "before" and "after" provide keyset pagination on
+ * (event_timestamp, node_id, event). If only "after" is provided, the events
+ * immediately following that position are selected, but still returned in
+ * reverse chronological order.
+ *
+ * The penultimate column contains a "timestamp,node_id,event" key (with the
+ * full-precision event timestamp), for use with "before" and "after"; the
+ * final column is used only for sorting.
+ */
+static bool
+_build_event_records_query(PGconn *conn, PQExpBufferData *query, int node_id, const char *node_name, const char *event, bool all, int limit, const char *before, const char *after)
+{
+	PQExpBufferData where_clause;
+	bool		ascending = (after[0] != '\0' && before[0] == '\0');
+	bool		success = true;
 
-	initPQExpBuffer(&query);
 	initPQExpBuffer(&where_clause);
 
+	if (ascending == true)
+		appendPQExpBufferStr(query,
+							 "SELECT * FROM (\n");
+
 	/* LEFT JOIN used here as a node record may have been removed */
-	appendPQExpBufferStr(&query,
+	appendPQExpBufferStr(query,
 						 "   SELECT e.node_id, n.node_name, e.event, e.successful, "
 						 "          pg_catalog.to_char(e.event_timestamp, 'YYYY-MM-DD HH24:MI:SS') AS timestamp, "
-						 "          e.details "
+						 "          e.details, "
+						 "          e.event_timestamp || ',' || e.node_id || ',' || e.event AS pagination_key, "
+						 "          e.event_timestamp "
 						 "     FROM repmgr.events e "
 						 "LEFT JOIN repmgr.nodes n ON e.node_id = n.node_id ");
 
 	if (node_id != UNKNOWN_NODE_ID)
 	{
 		append_where_clause(&where_clause,
-							"n.node_id=%i", node_id);
+							"e.node_id=%i", node_id);
 	}
 	else if (node_name[0] != '\0')
 	{
@@ -4260,11 +6131,12 @@ get_event_records(PGconn *conn, int node_id, const char *node_name, const char *
 		{
 			log_error(_("unable to escape value provided for node name"));
 			log_detail(_("node name is: \"%s\""), node_name);
+			success = false;
 		}
 		else
 		{
 			append_where_clause(&where_clause,
-								"n.node_name='%s'",
+								"e.node_id IN (SELECT node_id FROM repmgr.nodes WHERE node_name='%s')",
 								escaped);
 			pfree(escaped);
 		}
@@ -4278,6 +6150,7 @@ get_event_records(PGconn *conn, int node_id, const char *node_name, const char *
 		{
 			log_error(_("unable to escape value provided for event"));
 			log_detail(_("event is: \"%s\""), event);
+			success = false;
 		}
 		else
 		{
@@ -4288,28 +6161,114 @@ get_event_records(PGconn *conn, int node_id, const char *node_name, const char *
 		}
 	}
 
-	appendPQExpBuffer(&query, "\n%s\n",
+	if (before[0] != '\0')
+	{
+		if (_append_event_pagination_clause(conn, &where_clause, before, "<") == false)
+		{
+			log_error(_("invalid value provided for --before"));
+			log_detail(_("value is: \"%s\""), before);
+			success = false;
+		}
+	}
+
+	if (after[0] != '\0')
+	{
+		if (_append_event_pagination_clause(conn, &where_clause, after, ">") == false)
+		{
+			log_error(_("invalid value provided for --after"));
+			log_detail(_("value is: \"%s\""), after);
+			success = false;
+		}
+	}
+
+	appendPQExpBuffer(query, "\n%s\n",
 					  where_clause.data);
 
-	appendPQExpBufferStr(&query,
-						 " ORDER BY e.event_timestamp DESC");
+	if (ascending == true)
+		appendPQExpBufferStr(query,
+							 " ORDER BY e.event_timestamp ASC, e.node_id ASC, e.event ASC");
+	else
+		appendPQExpBufferStr(query,
+							 " ORDER BY e.event_timestamp DESC, e.node_id DESC, e.event DESC");
 
 	if (all == false && limit > 0)
 	{
-		appendPQExpBuffer(&query, " LIMIT %i",
+		appendPQExpBuffer(query, " LIMIT %i",
 						  limit);
 	}
 
-	log_debug("do_cluster_event():\n%s", query.data);
+	if (ascending == true)
+		appendPQExpBufferStr(query,
+							 "\n) e ORDER BY e.event_timestamp DESC, e.node_id DESC, e.event DESC");
+
+	termPQExpBuffer(&where_clause);
+
+	return success;
+}
+
+
+PGresult *
+get_event_records(PGconn *conn, int node_id, const char *node_name, const char *event, bool all, int limit, const char *before, const char *after)
+{
+	PGresult   *res;
+	PQExpBufferData query;
+
+	initPQExpBuffer(&query);
+
+	if (_build_event_records_query(conn, &query, node_id, node_name, event, all, limit, before, after) == false)
+	{
+		termPQExpBuffer(&query);
+		return NULL;
+	}
+
+	log_debug("get_event_records():\n%s", query.data);
 	res = PQexec(conn, query.data);
 
 	termPQExpBuffer(&query);
-	termPQExpBuffer(&where_clause);
 
 	return res;
 }
 
 
+/*
+ * As get_event_records(), but send the query in single-row mode so the
+ * caller can process an arbitrarily large result set one row at a time
+ * via PQgetResult(), without buffering it client-side.
+ */
+bool
+send_event_records_query(PGconn *conn, int node_id, const char *node_name, const char *event, bool all, int limit, const char *before, const char *after)
+{
+	PQExpBufferData query;
+	bool		success = true;
+
+	initPQExpBuffer(&query);
+
+	if (_build_event_records_query(conn, &query, node_id, node_name, event, all, limit, before, after) == false)
+	{
+		termPQExpBuffer(&query);
+		return false;
+	}
+
+	log_debug("send_event_records_query():\n%s", query.data);
+
+	if (PQsendQuery(conn, query.data) == 0)
+	{
+		log_error(_("unable to send event query:\n  %s"),
+				  PQerrorMessage(conn));
+		success = false;
+	}
+	else if (PQsetSingleRowMode(conn) == 0)
+	{
+		/* result will be delivered in one piece, which is still usable */
+		log_debug("send_event_records_query(): unable to enable single-row mode");
+	}
+
+	termPQExpBuffer(&query);
+
+	return success;
+}
+
+
 /* ========================== */
 /* replication slot functions */
 /* ========================== */
@@ -4318,7 +6277,7 @@ get_event_records(PGconn *conn, int node_id, const char *node_name, const char *
 void
 create_slot_name(char *slot_name, int node_id)
 {
-	maxlen_snprintf(slot_name, "repmgr_slot_%i", node_id);
+	snprintf(slot_name, NAMEDATALEN, "repmgr_slot_%i", node_id);
 }
 
 
@@ -4397,105 +6356,424 @@ create_replication_slot_replprot(PGconn *conn, PGconn *repl_conn, char *slot_nam
 
 	appendPQExpBufferChar(&query, ';');
 
-	res = PQexec(repl_conn, query.data);
+	res = PQexec(repl_conn, query.data);
+
+
+	if ((PQresultStatus(res) != PGRES_TUPLES_OK || !PQntuples(res)) && error_msg != NULL)
+	{
+		appendPQExpBuffer(error_msg,
+						  _("unable to create replication slot \"%s\" on the upstream node: %s\n"),
+						  slot_name,
+						  PQerrorMessage(conn));
+		success = false;
+	}
+
+	PQclear(res);
+	return success;
+}
+
+
+bool
+create_replication_slot_sql(PGconn *conn, char *slot_name, PQExpBufferData *error_msg)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+
+	ReplSlotStatus slot_status = _verify_replication_slot(conn, slot_name, error_msg);
+
+	/* Replication slot is unusable */
+	if (slot_status == SLOT_NOT_PHYSICAL || slot_status == SLOT_ACTIVE)
+		return false;
+
+	/* Replication slot can be reused */
+	if (slot_status == SLOT_INACTIVE)
+		return true;
+
+	initPQExpBuffer(&query);
+
+	/* In 9.6 and later, reserve the LSN straight away */
+	if (PQserverVersion(conn) >= 90600)
+	{
+		appendPQExpBuffer(&query,
+						  "SELECT * FROM pg_catalog.pg_create_physical_replication_slot('%s', TRUE)",
+						  slot_name);
+	}
+	else
+	{
+		appendPQExpBuffer(&query,
+						  "SELECT * FROM pg_catalog.pg_create_physical_replication_slot('%s')",
+						  slot_name);
+	}
+
+	log_debug(_("create_replication_slot_sql(): creating slot \"%s\" on upstream"), slot_name);
+	log_verbose(LOG_DEBUG, "create_replication_slot_sql():\n%s", query.data);
+
+	res = PQexec(conn, query.data);
+	termPQExpBuffer(&query);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK && error_msg != NULL)
+	{
+		appendPQExpBuffer(error_msg,
+						  _("unable to create replication slot \"%s\" on the upstream node: %s\n"),
+						  slot_name,
+						  PQerrorMessage(conn));
+		success = false;
+	}
+
+	PQclear(res);
+	return success;
+}
+
+
+bool
+drop_replication_slot_sql(PGconn *conn, char *slot_name)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "SELECT pg_catalog.pg_drop_replication_slot('%s')",
+					  slot_name);
+
+	log_verbose(LOG_DEBUG, "drop_replication_slot_sql():\n  %s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data,
+					 _("drop_replication_slot_sql(): unable to drop replication slot \"%s\""),
+					 slot_name);
+
+		success = false;
+	}
+	else
+	{
+		log_verbose(LOG_DEBUG, "replication slot \"%s\" successfully dropped",
+					slot_name);
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
+
+bool
+drop_replication_slot_replprot(PGconn *repl_conn, char *slot_name)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "DROP_REPLICATION_SLOT %s",
+					  slot_name);
+
+	log_verbose(LOG_DEBUG, "drop_replication_slot_replprot():\n  %s", query.data);
+
+	res = PQexec(repl_conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(repl_conn, query.data,
+					 _("drop_replication_slot_sql(): unable to drop replication slot \"%s\""),
+					 slot_name);
+
+		success = false;
+	}
+	else
+	{
+		log_verbose(LOG_DEBUG, "replication slot \"%s\" successfully dropped",
+					slot_name);
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
+
+RecordStatus
+get_slot_record(PGconn *conn, char *slot_name, t_replication_slot *record)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	RecordStatus record_status = RECORD_FOUND;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "SELECT slot_name, slot_type, active "
+					  "  FROM pg_catalog.pg_replication_slots "
+					  " WHERE slot_name = '%s' ",
+					  slot_name);
+
+	log_verbose(LOG_DEBUG, "get_slot_record():\n%s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data,
+					 _("get_slot_record(): unable to query pg_replication_slots"));
+
+		record_status = RECORD_ERROR;
+	}
+	else if (!PQntuples(res))
+	{
+		record_status = RECORD_NOT_FOUND;
+	}
+	else
+	{
+		snprintf(record->slot_name,
+				 sizeof(record->slot_name),
+				 "%s", PQgetvalue(res, 0, 0));
+		snprintf(record->slot_type,
+				 sizeof(record->slot_type),
+				 "%s", PQgetvalue(res, 0, 1));
+		record->active = atobool(PQgetvalue(res, 0, 2));
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return record_status;
+}
+
+
+int
+get_free_replication_slot_count(PGconn *conn, int *max_replication_slots)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	int			free_slots = 0;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBufferStr(&query,
+						 " SELECT pg_catalog.current_setting('max_replication_slots')::INT - "
+						 "          pg_catalog.count(*) "
+						 "          AS free_slots, "
+						 "        pg_catalog.current_setting('max_replication_slots')::INT "
+						 "          AS max_replication_slots "
+						 "   FROM pg_catalog.pg_replication_slots s"
+						 "  WHERE s.slot_type = 'physical'");
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data,
+					 _("get_free_replication_slot_count(): unable to execute replication slot query"));
+
+		free_slots = UNKNOWN_VALUE;
+	}
+	else if (PQntuples(res) == 0)
+	{
+		free_slots = UNKNOWN_VALUE;
+	}
+	else
+	{
+		free_slots = atoi(PQgetvalue(res, 0, 0));
+		if (max_replication_slots != NULL)
+			*max_replication_slots = atoi(PQgetvalue(res, 0, 1));
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return free_slots;
+}
+
+
+int
+get_inactive_replication_slots(PGconn *conn, KeyValueList *list)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	int			i, inactive_slots = 0;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBufferStr(&query,
+						 "   SELECT slot_name, slot_type "
+						 "     FROM pg_catalog.pg_replication_slots "
+						 "    WHERE active IS FALSE "
+						 "      AND slot_type = 'physical' "
+						 " ORDER BY slot_name ");
+
+	res = PQexec(conn, query.data);
 
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data,
+					 _("get_inactive_replication_slots(): unable to execute replication slot query"));
 
-	if ((PQresultStatus(res) != PGRES_TUPLES_OK || !PQntuples(res)) && error_msg != NULL)
+		inactive_slots = -1;
+	}
+	else
 	{
-		appendPQExpBuffer(error_msg,
-						  _("unable to create replication slot \"%s\" on the upstream node: %s\n"),
-						  slot_name,
-						  PQerrorMessage(conn));
-		success = false;
+		inactive_slots = PQntuples(res);
+
+		for (i = 0; i < inactive_slots; i++)
+		{
+			key_value_list_set(list,
+							   PQgetvalue(res, i, 0),
+							   PQgetvalue(res, i, 1));
+		}
 	}
 
+	termPQExpBuffer(&query);
 	PQclear(res);
-	return success;
+
+	return inactive_slots;
 }
 
 
-bool
-create_replication_slot_sql(PGconn *conn, char *slot_name, PQExpBufferData *error_msg)
+/*
+ * get_replication_slot_retention()
+ *
+ * Retrieve the amount of WAL retained by each physical replication slot on
+ * the (primary) node, i.e. the distance between its current WAL location and
+ * the slot's "restart_lsn", together with details of the node whose record
+ * specifies the slot, if any.
+ *
+ * "slots" is set to an array (to be freed by the caller), or NULL if no
+ * slots were found.
+ *
+ * Returns the number of slots found, or -1 on error.
+ */
+int
+get_replication_slot_retention(PGconn *conn, t_replication_slot_retention **slots)
 {
 	PQExpBufferData query;
 	PGresult   *res = NULL;
-	bool		success = true;
-
-	ReplSlotStatus slot_status = _verify_replication_slot(conn, slot_name, error_msg);
+	int			slot_count = 0;
+	int			i;
 
-	/* Replication slot is unusable */
-	if (slot_status == SLOT_NOT_PHYSICAL || slot_status == SLOT_ACTIVE)
-		return false;
+	*slots = NULL;
 
-	/* Replication slot can be reused */
-	if (slot_status == SLOT_INACTIVE)
-		return true;
+	/* no replication slots in PostgreSQL 9.3 */
+	if (PQserverVersion(conn) < 90400)
+		return 0;
 
 	initPQExpBuffer(&query);
 
-	/* In 9.6 and later, reserve the LSN straight away */
-	if (PQserverVersion(conn) >= 90600)
+	if (PQserverVersion(conn) >= 100000)
 	{
-		appendPQExpBuffer(&query,
-						  "SELECT * FROM pg_catalog.pg_create_physical_replication_slot('%s', TRUE)",
-						  slot_name);
+		appendPQExpBufferStr(&query,
+							 "   SELECT s.slot_name, s.active, "
+							 "          COALESCE(pg_catalog.pg_wal_lsn_diff(pg_catalog.pg_current_wal_lsn(), s.restart_lsn), 0)::BIGINT, ");
 	}
 	else
 	{
-		appendPQExpBuffer(&query,
-						  "SELECT * FROM pg_catalog.pg_create_physical_replication_slot('%s')",
-						  slot_name);
+		appendPQExpBufferStr(&query,
+							 "   SELECT s.slot_name, s.active, "
+							 "          COALESCE(pg_catalog.pg_xlog_location_diff(pg_catalog.pg_current_xlog_location(), s.restart_lsn), 0)::BIGINT, ");
 	}
 
-	log_debug(_("create_replication_slot_sql(): creating slot \"%s\" on upstream"), slot_name);
-	log_verbose(LOG_DEBUG, "create_replication_slot_sql():\n%s", query.data);
+	appendPQExpBufferStr(&query,
+						 "          n.node_id, n.node_name, n.active "
+						 "     FROM pg_catalog.pg_replication_slots s "
+						 "LEFT JOIN repmgr.nodes n "
+						 "       ON n.slot_name = s.slot_name "
+						 "    WHERE s.slot_type = 'physical' "
+						 " ORDER BY s.slot_name ");
+
+	log_verbose(LOG_DEBUG, "get_replication_slot_retention():\n%s", query.data);
 
 	res = PQexec(conn, query.data);
-	termPQExpBuffer(&query);
 
-	if (PQresultStatus(res) != PGRES_TUPLES_OK && error_msg != NULL)
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
 	{
-		appendPQExpBuffer(error_msg,
-						  _("unable to create replication slot \"%s\" on the upstream node: %s\n"),
-						  slot_name,
-						  PQerrorMessage(conn));
-		success = false;
+		log_db_error(conn, query.data,
+					 _("get_replication_slot_retention(): unable to execute replication slot query"));
+
+		slot_count = -1;
+	}
+	else if (PQntuples(res) > 0)
+	{
+		slot_count = PQntuples(res);
+
+		*slots = pg_malloc0(sizeof(t_replication_slot_retention) * slot_count);
+
+		for (i = 0; i < slot_count; i++)
+		{
+			t_replication_slot_retention *slot = &(*slots)[i];
+
+			snprintf(slot->slot_name, sizeof(slot->slot_name),
+					 "%s", PQgetvalue(res, i, 0));
+			slot->active = atobool(PQgetvalue(res, i, 1));
+			slot->retained_wal_bytes = strtoull(PQgetvalue(res, i, 2), NULL, 10);
+
+			if (PQgetisnull(res, i, 3))
+			{
+				slot->node_id = UNKNOWN_NODE_ID;
+			}
+			else
+			{
+				slot->node_id = atoi(PQgetvalue(res, i, 3));
+				snprintf(slot->node_name, sizeof(slot->node_name),
+						 "%s", PQgetvalue(res, i, 4));
+				slot->node_active = atobool(PQgetvalue(res, i, 5));
+			}
+		}
 	}
 
+	termPQExpBuffer(&query);
 	PQclear(res);
-	return success;
+
+	return slot_count;
 }
 
 
+
+/* ==================== */
+/* tablespace functions */
+/* ==================== */
+
 bool
-drop_replication_slot_sql(PGconn *conn, char *slot_name)
+get_tablespace_name_by_location(PGconn *conn, const char *location, char *name)
 {
 	PQExpBufferData query;
 	PGresult   *res = NULL;
-	bool		success = true;
+	bool	    success = true;
 
 	initPQExpBuffer(&query);
 
 	appendPQExpBuffer(&query,
-					  "SELECT pg_catalog.pg_drop_replication_slot('%s')",
-					  slot_name);
+					  "SELECT spcname "
+					  "  FROM pg_catalog.pg_tablespace "
+					  " WHERE pg_catalog.pg_tablespace_location(oid) = '%s'",
+					  location);
 
-	log_verbose(LOG_DEBUG, "drop_replication_slot_sql():\n  %s", query.data);
+	log_verbose(LOG_DEBUG, "get_tablespace_name_by_location():\n%s", query.data);
 
 	res = PQexec(conn, query.data);
 
 	if (PQresultStatus(res) != PGRES_TUPLES_OK)
 	{
 		log_db_error(conn, query.data,
-					 _("drop_replication_slot_sql(): unable to drop replication slot \"%s\""),
-					 slot_name);
-
+					 _("get_tablespace_name_by_location(): unable to execute tablespace query"));
+		success = false;
+	}
+	else if (PQntuples(res) == 0)
+	{
 		success = false;
 	}
 	else
 	{
-		log_verbose(LOG_DEBUG, "replication slot \"%s\" successfully dropped",
-					slot_name);
+		snprintf(name, MAXLEN,
+				 "%s", PQgetvalue(res, 0, 0));
 	}
 
 	termPQExpBuffer(&query);
@@ -4504,597 +6782,754 @@ drop_replication_slot_sql(PGconn *conn, char *slot_name)
 	return success;
 }
 
+/* ============================ */
+/* asynchronous query functions */
+/* ============================ */
 
 bool
-drop_replication_slot_replprot(PGconn *repl_conn, char *slot_name)
+cancel_query(PGconn *conn, int timeout)
+{
+	char		errbuf[ERRBUFF_SIZE] = "";
+	PGcancel   *pgcancel = NULL;
+
+	if (wait_connection_availability(conn, timeout) != 1)
+		return false;
+
+	pgcancel = PQgetCancel(conn);
+
+	if (pgcancel == NULL)
+		return false;
+
+	/*
+	 * PQcancel can only return 0 if socket()/connect()/send() fails, in any
+	 * of those cases we can assume something bad happened to the connection
+	 */
+	if (PQcancel(pgcancel, errbuf, ERRBUFF_SIZE) == 0)
+	{
+		log_warning(_("unable to cancel current query"));
+		log_detail("\n%s", errbuf);
+		PQfreeCancel(pgcancel);
+		return false;
+	}
+
+	PQfreeCancel(pgcancel);
+
+	return true;
+}
+
+
+/*
+ * Wait until current query finishes, ignoring any results.
+ * Usually this will be an async query or query cancellation.
+ *
+ * Returns 1 for success; 0 if any error ocurred; -1 if timeout reached.
+ */
+int
+wait_connection_availability(PGconn *conn, int timeout)
 {
-	PQExpBufferData query;
 	PGresult   *res = NULL;
-	bool		success = true;
+	fd_set		read_set;
+	int			sock = PQsocket(conn);
+	struct timeval tmout,
+				before,
+				after;
+	struct timezone tz;
+	long long	timeout_ms;
 
-	initPQExpBuffer(&query);
+	/* calculate timeout in microseconds */
+	timeout_ms = (long long) timeout * 1000000;
+
+	while (timeout_ms > 0)
+	{
+		if (PQconsumeInput(conn) == 0)
+		{
+			log_warning(_("wait_connection_availability(): unable to receive data from connection"));
+			log_detail("%s", PQerrorMessage(conn));
+			return 0;
+		}
+
+		if (PQisBusy(conn) == 0)
+		{
+			do
+			{
+				res = PQgetResult(conn);
+				PQclear(res);
+			} while (res != NULL);
+
+			break;
+		}
+
+		tmout.tv_sec = 0;
+		tmout.tv_usec = 250000;
+
+		FD_ZERO(&read_set);
+		FD_SET(sock, &read_set);
+
+		gettimeofday(&before, &tz);
+		if (select(sock, &read_set, NULL, NULL, &tmout) == -1)
+		{
+			log_warning(_("wait_connection_availability(): select() returned with error"));
+			log_detail("%s", strerror(errno));
+			return -1;
+		}
+
+		gettimeofday(&after, &tz);
+
+		timeout_ms -= (after.tv_sec * 1000000 + after.tv_usec) -
+			(before.tv_sec * 1000000 + before.tv_usec);
+	}
+
+
+	if (timeout_ms >= 0)
+	{
+		return 1;
+	}
+
+	log_warning(_("wait_connection_availability(): timeout (%i secs) reached"), timeout);
+	return -1;
+}
+
+
+/* =========================== */
+/* node availability functions */
+/* =========================== */
+
+bool
+is_server_available(const char *conninfo)
+{
+	return _is_server_available(conninfo, false);
+}
+
+
+bool
+is_server_available_quiet(const char *conninfo)
+{
+	return _is_server_available(conninfo, true);
+}
+
+
+static bool
+_is_server_available(const char *conninfo, bool quiet)
+{
+	PGPing		status = PQping(conninfo);
+
+	log_verbose(LOG_DEBUG, "is_server_available(): ping status for \"%s\" is %s", conninfo, print_pqping_status(status));
+	if (status == PQPING_OK)
+		return true;
+
+	if (quiet == false)
+	{
+		log_warning(_("unable to ping \"%s\""), conninfo);
+		log_detail(_("PQping() returned \"%s\""), print_pqping_status(status));
+	}
 
-	appendPQExpBuffer(&query,
-					  "DROP_REPLICATION_SLOT %s",
-					  slot_name);
+	return false;
+}
 
-	log_verbose(LOG_DEBUG, "drop_replication_slot_replprot():\n  %s", query.data);
 
-	res = PQexec(repl_conn, query.data);
+bool
+is_server_available_params(t_conninfo_param_list *param_list)
+{
+	PGPing		status = PQpingParams((const char **) param_list->keywords,
+									  (const char **) param_list->values,
+									  false);
 
-	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	/* deparsing the param_list adds overhead, so only do it if needed  */
+	if (log_level == LOG_DEBUG || status != PQPING_OK)
 	{
-		log_db_error(repl_conn, query.data,
-					 _("drop_replication_slot_sql(): unable to drop replication slot \"%s\""),
-					 slot_name);
+		char *conninfo_str = param_list_to_string(param_list);
+		log_verbose(LOG_DEBUG, "is_server_available_params(): ping status for \"%s\" is %s", conninfo_str, print_pqping_status(status));
 
-		success = false;
-	}
-	else
-	{
-		log_verbose(LOG_DEBUG, "replication slot \"%s\" successfully dropped",
-					slot_name);
+		if (status != PQPING_OK)
+		{
+			log_warning(_("unable to ping \"%s\""), conninfo_str);
+			log_detail(_("PQping() returned \"%s\""), print_pqping_status(status));
+		}
+
+		pfree(conninfo_str);
 	}
 
-	termPQExpBuffer(&query);
-	PQclear(res);
+	if (status == PQPING_OK)
+		return true;
 
-	return success;
+	return false;
 }
 
 
-RecordStatus
-get_slot_record(PGconn *conn, char *slot_name, t_replication_slot *record)
+/*
+ * Check whether a TCP connection can be opened to "host" and "port"
+ * within "timeout_ms" milliseconds.
+ */
+static bool
+is_tcp_port_reachable(const char *host, const char *port, int timeout_ms)
 {
-	PQExpBufferData query;
-	PGresult   *res = NULL;
-	RecordStatus record_status = RECORD_FOUND;
-
-	initPQExpBuffer(&query);
+	struct addrinfo hints;
+	struct addrinfo *addrs = NULL;
+	struct addrinfo *addr = NULL;
+	instr_time	start_time;
+	bool		reachable = false;
 
-	appendPQExpBuffer(&query,
-					  "SELECT slot_name, slot_type, active "
-					  "  FROM pg_catalog.pg_replication_slots "
-					  " WHERE slot_name = '%s' ",
-					  slot_name);
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
 
-	log_verbose(LOG_DEBUG, "get_slot_record():\n%s", query.data);
+	if (getaddrinfo(host, port, &hints, &addrs) != 0)
+		return false;
 
-	res = PQexec(conn, query.data);
+	INSTR_TIME_SET_CURRENT(start_time);
 
-	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	for (addr = addrs; addr != NULL && reachable == false; addr = addr->ai_next)
 	{
-		log_db_error(conn, query.data,
-					 _("get_slot_record(): unable to query pg_replication_slots"));
+		int			sock = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+		int			remaining_ms = timeout_ms - elapsed_ms(start_time);
 
-		record_status = RECORD_ERROR;
-	}
-	else if (!PQntuples(res))
-	{
-		record_status = RECORD_NOT_FOUND;
-	}
-	else
-	{
-		snprintf(record->slot_name,
-				 sizeof(record->slot_name),
-				 "%s", PQgetvalue(res, 0, 0));
-		snprintf(record->slot_type,
-				 sizeof(record->slot_type),
-				 "%s", PQgetvalue(res, 0, 1));
-		record->active = atobool(PQgetvalue(res, 0, 2));
+		if (sock < 0)
+			continue;
+
+		if (remaining_ms > 0 && fcntl(sock, F_SETFL, O_NONBLOCK) == 0)
+		{
+			if (connect(sock, addr->ai_addr, addr->ai_addrlen) == 0)
+			{
+				reachable = true;
+			}
+			else if (errno == EINPROGRESS)
+			{
+				struct pollfd pfd;
+
+				pfd.fd = sock;
+				pfd.events = POLLOUT;
+				pfd.revents = 0;
+
+				if (poll(&pfd, 1, remaining_ms) == 1)
+				{
+					int			so_error = 0;
+					socklen_t	len = sizeof(so_error);
+
+					if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &so_error, &len) == 0 && so_error == 0)
+						reachable = true;
+				}
+			}
+		}
+
+		close(sock);
 	}
 
-	termPQExpBuffer(&query);
-	PQclear(res);
+	freeaddrinfo(addrs);
 
-	return record_status;
+	return reachable;
 }
 
 
-int
-get_free_replication_slot_count(PGconn *conn, int *max_replication_slots)
+/*
+ * Variant of is_server_available_params() intended for repeated probing
+ * of an unreachable node.
+ *
+ * If the node is specified by a single TCP host (or host address), first
+ * check whether the PostgreSQL port is reachable at all within "timeout_ms"
+ * milliseconds. This means a node which is down or isolated is detected
+ * without waiting for "connect_timeout" to expire (which cannot be less
+ * than 2 seconds); PQping() is only executed once the port is known to
+ * be reachable.
+ */
+bool
+probe_server_available_params(t_conninfo_param_list *param_list, int timeout_ms)
 {
-	PQExpBufferData query;
-	PGresult   *res = NULL;
-	int			free_slots = 0;
-
-	initPQExpBuffer(&query);
-
-	appendPQExpBufferStr(&query,
-						 " SELECT pg_catalog.current_setting('max_replication_slots')::INT - "
-						 "          pg_catalog.count(*) "
-						 "          AS free_slots, "
-						 "        pg_catalog.current_setting('max_replication_slots')::INT "
-						 "          AS max_replication_slots "
-						 "   FROM pg_catalog.pg_replication_slots s"
-						 "  WHERE s.slot_type = 'physical'");
+	const char *host = param_get(param_list, "hostaddr");
+	const char *port = param_get(param_list, "port");
 
-	res = PQexec(conn, query.data);
+	if (host == NULL || host[0] == '\0')
+		host = param_get(param_list, "host");
 
-	if (PQresultStatus(res) != PGRES_TUPLES_OK)
-	{
-		log_db_error(conn, query.data,
-					 _("get_free_replication_slot_count(): unable to execute replication slot query"));
+	if (port == NULL || port[0] == '\0')
+		port = DEF_PGPORT_STR;
 
-		free_slots = UNKNOWN_VALUE;
-	}
-	else if (PQntuples(res) == 0)
-	{
-		free_slots = UNKNOWN_VALUE;
-	}
-	else
+	/*
+	 * Skip the TCP check for Unix sockets and multiple hosts, for which
+	 * libpq's own logic is needed.
+	 */
+	if (host != NULL && host[0] != '\0' && host[0] != '/'
+		&& strchr(host, ',') == NULL && strchr(port, ',') == NULL)
 	{
-		free_slots = atoi(PQgetvalue(res, 0, 0));
-		if (max_replication_slots != NULL)
-			*max_replication_slots = atoi(PQgetvalue(res, 0, 1));
+		if (is_tcp_port_reachable(host, port, timeout_ms) == false)
+		{
+			log_verbose(LOG_DEBUG, "probe_server_available_params(): unable to reach %s:%s within %i ms",
+						host, port, timeout_ms);
+			return false;
+		}
 	}
 
-	termPQExpBuffer(&query);
-	PQclear(res);
-
-	return free_slots;
+	return is_server_available_params(param_list);
 }
 
 
-int
-get_inactive_replication_slots(PGconn *conn, KeyValueList *list)
+
+/*
+ * Simple throw-away query to stop a connection handle going stale.
+ */
+ExecStatusType
+connection_ping(PGconn *conn)
 {
-	PQExpBufferData query;
-	PGresult   *res = NULL;
-	int			i, inactive_slots = 0;
+	PGresult   *res = PQexec(conn, "SELECT TRUE");
+	ExecStatusType ping_result;
 
-	initPQExpBuffer(&query);
+	log_verbose(LOG_DEBUG, "connection_ping(): result is %s", PQresStatus(PQresultStatus(res)));
 
-	appendPQExpBufferStr(&query,
-						 "   SELECT slot_name, slot_type "
-						 "     FROM pg_catalog.pg_replication_slots "
-						 "    WHERE active IS FALSE "
-						 "      AND slot_type = 'physical' "
-						 " ORDER BY slot_name ");
+	ping_result = PQresultStatus(res);
+	PQclear(res);
 
-	res = PQexec(conn, query.data);
+	return ping_result;
+}
 
-	if (PQresultStatus(res) != PGRES_TUPLES_OK)
-	{
-		log_db_error(conn, query.data,
-					 _("get_inactive_replication_slots(): unable to execute replication slot query"));
 
-		inactive_slots = -1;
-	}
-	else
-	{
-		inactive_slots = PQntuples(res);
+ExecStatusType
+connection_ping_reconnect(PGconn *conn)
+{
+	ExecStatusType ping_result = connection_ping(conn);
 
-		for (i = 0; i < inactive_slots; i++)
-		{
-			key_value_list_set(list,
-							   PQgetvalue(res, i, 0),
-							   PQgetvalue(res, i, 1));
-		}
+	if (PQstatus(conn) != CONNECTION_OK)
+	{
+		log_warning(_("connection error, attempting to reset"));
+		log_detail("\n%s", PQerrorMessage(conn));
+		PQreset(conn);
+		ping_result = connection_ping(conn);
 	}
 
-	termPQExpBuffer(&query);
-	PQclear(res);
+	log_verbose(LOG_DEBUG, "connection_ping_reconnect(): result is %s", PQresStatus(ping_result));
 
-	return inactive_slots;
+	return ping_result;
 }
 
 
 
 /* ==================== */
-/* tablespace functions */
+/* monitoring functions */
 /* ==================== */
 
+/*
+ * add_monitoring_records()
+ *
+ * Write the provided monitoring records to the primary with a single
+ * multi-row INSERT. As with other monitoring updates, the query is sent
+ * asynchronously, so the monitoring loop is not held up by a slow primary.
+ *
+ * Before sending the query, the result of any previously sent update is
+ * collected; if that update is still in progress, no new query is sent.
+ *
+ * Returns true if the query was sent.
+ */
 bool
-get_tablespace_name_by_location(PGconn *conn, const char *location, char *name)
+add_monitoring_records(PGconn *primary_conn, t_monitoring_record *records, int record_count)
 {
 	PQExpBufferData query;
 	PGresult   *res = NULL;
-	bool	    success = true;
-
-	initPQExpBuffer(&query);
-
-	appendPQExpBuffer(&query,
-					  "SELECT spcname "
-					  "  FROM pg_catalog.pg_tablespace "
-					  " WHERE pg_catalog.pg_tablespace_location(oid) = '%s'",
-					  location);
-
-	log_verbose(LOG_DEBUG, "get_tablespace_name_by_location():\n%s", query.data);
+	bool		success = true;
+	int			i;
 
-	res = PQexec(conn, query.data);
+	if (record_count == 0)
+		return true;
 
-	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	/* collect the result of the previous update, if any */
+	if (PQconsumeInput(primary_conn) == 0)
 	{
-		log_db_error(conn, query.data,
-					 _("get_tablespace_name_by_location(): unable to execute tablespace query"));
-		success = false;
+		log_warning(_("unable to write monitoring history to primary:\n  %s"),
+					PQerrorMessage(primary_conn));
+		return false;
 	}
-	else if (PQntuples(res) == 0)
+
+	while (PQisBusy(primary_conn) == 0 && (res = PQgetResult(primary_conn)) != NULL)
 	{
-		success = false;
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			log_warning(_("previous monitoring history update failed:\n  %s"),
+						PQresultErrorMessage(res));
+
+		PQclear(res);
 	}
-	else
+
+	if (PQisBusy(primary_conn) == 1)
 	{
-		snprintf(name, MAXLEN,
-				 "%s", PQgetvalue(res, 0, 0));
+		log_verbose(LOG_WARNING, _("previous monitoring history update still in progress"));
+		return false;
 	}
 
-	termPQExpBuffer(&query);
-	PQclear(res);
+	initPQExpBuffer(&query);
 
-	return success;
-}
+	appendPQExpBufferStr(&query,
+						 "INSERT INTO repmgr.monitoring_history "
+						 "           (primary_node_id, "
+						 "            standby_node_id, "
+						 "            last_monitor_time, "
+						 "            last_apply_time, "
+						 "            last_wal_primary_location, "
+						 "            last_wal_standby_location, "
+						 "            replication_lag, "
+						 "            apply_lag ) "
+						 "     VALUES ");
 
-/* ============================ */
-/* asynchronous query functions */
-/* ============================ */
+	for (i = 0; i < record_count; i++)
+	{
+		t_monitoring_record *record = &records[i];
 
-bool
-cancel_query(PGconn *conn, int timeout)
-{
-	char		errbuf[ERRBUFF_SIZE] = "";
-	PGcancel   *pgcancel = NULL;
+		if (i > 0)
+			appendPQExpBufferStr(&query, ", ");
 
-	if (wait_connection_availability(conn, timeout) != 1)
-		return false;
+		appendPQExpBuffer(&query,
+						  "(%i, "
+						  " %i, "
+						  " '%s'::TIMESTAMP WITH TIME ZONE, ",
+						  record->primary_node_id,
+						  record->standby_node_id,
+						  record->monitor_timestamp);
+
+		/* no transactions may have been replayed yet */
+		if (record->last_xact_replay_timestamp[0] == '\0')
+		{
+			appendPQExpBufferStr(&query, " NULL, ");
+		}
+		else
+		{
+			appendPQExpBuffer(&query,
+							  " '%s'::TIMESTAMP WITH TIME ZONE, ",
+							  record->last_xact_replay_timestamp);
+		}
 
-	pgcancel = PQgetCancel(conn);
+		appendPQExpBuffer(&query,
+						  " '%X/%X', "
+						  " '%X/%X', "
+						  " %llu, "
+						  " %llu) ",
+						  format_lsn(record->primary_last_wal_location),
+						  format_lsn(record->last_wal_receive_lsn),
+						  record->replication_lag_bytes,
+						  record->apply_lag_bytes);
+	}
 
-	if (pgcancel == NULL)
-		return false;
+	log_verbose(LOG_DEBUG, "add_monitoring_records():\n%s", query.data);
 
-	/*
-	 * PQcancel can only return 0 if socket()/connect()/send() fails, in any
-	 * of those cases we can assume something bad happened to the connection
-	 */
-	if (PQcancel(pgcancel, errbuf, ERRBUFF_SIZE) == 0)
+	if (PQsendQuery(primary_conn, query.data) == 0)
 	{
-		log_warning(_("unable to cancel current query"));
-		log_detail("\n%s", errbuf);
-		PQfreeCancel(pgcancel);
-		return false;
+		log_warning(_("query could not be sent to primary:\n  %s"),
+					PQerrorMessage(primary_conn));
+		success = false;
 	}
 
-	PQfreeCancel(pgcancel);
+	termPQExpBuffer(&query);
 
-	return true;
+	return success;
 }
 
 
-/*
- * Wait until current query finishes, ignoring any results.
- * Usually this will be an async query or query cancellation.
- *
- * Returns 1 for success; 0 if any error ocurred; -1 if timeout reached.
- */
-int
-wait_connection_availability(PGconn *conn, int timeout)
+void
+set_standby_last_updated(PGconn *local_conn)
 {
-	PGresult   *res = NULL;
-	fd_set		read_set;
-	int			sock = PQsocket(conn);
-	struct timeval tmout,
-				before,
-				after;
-	struct timezone tz;
-	long long	timeout_ms;
+	PGresult   *res = PQexec(local_conn, "SELECT repmgr.standby_set_last_updated()");
 
-	/* calculate timeout in microseconds */
-	timeout_ms = (long long) timeout * 1000000;
+	/* not critical if the above query fails */
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		log_warning(_("set_standby_last_updated(): unable to set last_updated:\n  %s"),
+					PQerrorMessage(local_conn));
 
-	while (timeout_ms > 0)
-	{
-		if (PQconsumeInput(conn) == 0)
-		{
-			log_warning(_("wait_connection_availability(): unable to receive data from connection"));
-			log_detail("%s", PQerrorMessage(conn));
-			return 0;
-		}
+	PQclear(res);
+}
 
-		if (PQisBusy(conn) == 0)
-		{
-			do
-			{
-				res = PQgetResult(conn);
-				PQclear(res);
-			} while (res != NULL);
 
-			break;
-		}
+/*
+ * Store a monitoring sample in the local node's shared memory, from where
+ * it can be retrieved with "repmgr.get_recent_monitoring()".
+ */
+void
+add_monitoring_sample(PGconn *local_conn, t_monitoring_record *record)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
 
-		tmout.tv_sec = 0;
-		tmout.tv_usec = 250000;
+	initPQExpBuffer(&query);
 
-		FD_ZERO(&read_set);
-		FD_SET(sock, &read_set);
+	appendPQExpBuffer(&query,
+					  "SELECT repmgr.add_monitoring_sample(%i, ",
+					  record->primary_node_id);
 
-		gettimeofday(&before, &tz);
-		if (select(sock, &read_set, NULL, NULL, &tmout) == -1)
-		{
-			log_warning(_("wait_connection_availability(): select() returned with error"));
-			log_detail("%s", strerror(errno));
-			return -1;
-		}
+	/* primary's LSN not known, e.g. if monitoring history is not enabled */
+	if (record->primary_last_wal_location == InvalidXLogRecPtr)
+	{
+		appendPQExpBufferStr(&query, "NULL, ");
+	}
+	else
+	{
+		appendPQExpBuffer(&query,
+						  "'%X/%X', ",
+						  format_lsn(record->primary_last_wal_location));
+	}
 
-		gettimeofday(&after, &tz);
+	appendPQExpBuffer(&query,
+					  "'%X/%X', ",
+					  format_lsn(record->last_wal_receive_lsn));
 
-		timeout_ms -= (after.tv_sec * 1000000 + after.tv_usec) -
-			(before.tv_sec * 1000000 + before.tv_usec);
+	if (record->last_xact_replay_timestamp[0] == '\0')
+	{
+		appendPQExpBufferStr(&query, "NULL, ");
+	}
+	else
+	{
+		appendPQExpBuffer(&query,
+						  "'%s'::TIMESTAMP WITH TIME ZONE, ",
+						  record->last_xact_replay_timestamp);
 	}
 
-
-	if (timeout_ms >= 0)
+	if (record->primary_last_wal_location == InvalidXLogRecPtr)
 	{
-		return 1;
+		appendPQExpBuffer(&query,
+						  "NULL, %llu)",
+						  record->apply_lag_bytes);
+	}
+	else
+	{
+		appendPQExpBuffer(&query,
+						  "%llu, %llu)",
+						  record->replication_lag_bytes,
+						  record->apply_lag_bytes);
 	}
 
-	log_warning(_("wait_connection_availability(): timeout (%i secs) reached"), timeout);
-	return -1;
-}
+	log_verbose(LOG_DEBUG, "add_monitoring_sample():\n  %s", query.data);
 
+	res = PQexec(local_conn, query.data);
+	termPQExpBuffer(&query);
 
-/* =========================== */
-/* node availability functions */
-/* =========================== */
+	/* not critical if the above query fails */
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		log_warning(_("add_monitoring_sample(): unable to store monitoring sample:\n  %s"),
+					PQerrorMessage(local_conn));
 
-bool
-is_server_available(const char *conninfo)
-{
-	return _is_server_available(conninfo, false);
+	PQclear(res);
 }
 
 
-bool
-is_server_available_quiet(const char *conninfo)
+/*
+ * Store the duration of a failover phase in the local node's shared memory,
+ * from where it can be retrieved with "repmgr.get_failover_phase_timings()"
+ * and "repmgr.get_failover_phase_histogram()".
+ */
+void
+set_failover_phase_timing(PGconn *local_conn, const char *phase, int64 duration_us)
 {
-	return _is_server_available(conninfo, true);
-}
+	PQExpBufferData query;
+	PGresult   *res = NULL;
 
+	initPQExpBuffer(&query);
 
-static bool
-_is_server_available(const char *conninfo, bool quiet)
-{
-	PGPing		status = PQping(conninfo);
+	appendPQExpBuffer(&query,
+					  "SELECT repmgr.set_failover_phase_timing('%s', " INT64_FORMAT ")",
+					  phase,
+					  duration_us);
 
-	log_verbose(LOG_DEBUG, "is_server_available(): ping status for \"%s\" is %s", conninfo, print_pqping_status(status));
-	if (status == PQPING_OK)
-		return true;
+	log_verbose(LOG_DEBUG, "set_failover_phase_timing():\n  %s", query.data);
 
-	if (quiet == false)
-	{
-		log_warning(_("unable to ping \"%s\""), conninfo);
-		log_detail(_("PQping() returned \"%s\""), print_pqping_status(status));
-	}
+	res = PQexec(local_conn, query.data);
+	termPQExpBuffer(&query);
 
-	return false;
+	/* not critical if the above query fails */
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		log_warning(_("set_failover_phase_timing(): unable to store failover phase timing:\n  %s"),
+					PQerrorMessage(local_conn));
+
+	PQclear(res);
 }
 
 
-bool
-is_server_available_params(t_conninfo_param_list *param_list)
+int
+get_number_of_monitoring_records_to_delete(PGconn *primary_conn, int keep_history, int node_id)
 {
-	PGPing		status = PQpingParams((const char **) param_list->keywords,
-									  (const char **) param_list->values,
-									  false);
+	PQExpBufferData query;
+	int				record_count = -1;
+	PGresult	   *res = NULL;
 
-	/* deparsing the param_list adds overhead, so only do it if needed  */
-	if (log_level == LOG_DEBUG || status != PQPING_OK)
-	{
-		char *conninfo_str = param_list_to_string(param_list);
-		log_verbose(LOG_DEBUG, "is_server_available_params(): ping status for \"%s\" is %s", conninfo_str, print_pqping_status(status));
+	initPQExpBuffer(&query);
 
-		if (status != PQPING_OK)
-		{
-			log_warning(_("unable to ping \"%s\""), conninfo_str);
-			log_detail(_("PQping() returned \"%s\""), print_pqping_status(status));
-		}
+	appendPQExpBuffer(&query,
+					  "SELECT pg_catalog.count(*) "
+					  "  FROM repmgr.monitoring_history "
+					  " WHERE pg_catalog.age(pg_catalog.now(), last_monitor_time) >= '%d days'::interval",
+					  keep_history);
 
-		pfree(conninfo_str);
+	if (node_id != UNKNOWN_NODE_ID)
+	{
+		appendPQExpBuffer(&query,
+						  "  AND standby_node_id = %i", node_id);
 	}
 
-	if (status == PQPING_OK)
-		return true;
-
-	return false;
-}
-
-
+	log_verbose(LOG_DEBUG, "get_number_of_monitoring_records_to_delete():\n  %s", query.data);
 
-/*
- * Simple throw-away query to stop a connection handle going stale.
- */
-ExecStatusType
-connection_ping(PGconn *conn)
-{
-	PGresult   *res = PQexec(conn, "SELECT TRUE");
-	ExecStatusType ping_result;
+	res = PQexec(primary_conn, query.data);
 
-	log_verbose(LOG_DEBUG, "connection_ping(): result is %s", PQresStatus(PQresultStatus(res)));
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(primary_conn, query.data,
+					 _("get_number_of_monitoring_records_to_delete(): unable to query number of monitoring records to clean up"));
+	}
+	else
+	{
+		record_count = atoi(PQgetvalue(res, 0, 0));
+	}
 
-	ping_result = PQresultStatus(res);
+	termPQExpBuffer(&query);
 	PQclear(res);
 
-	return ping_result;
+	return record_count;
 }
 
 
-ExecStatusType
-connection_ping_reconnect(PGconn *conn)
+bool
+delete_monitoring_records(PGconn *primary_conn, int keep_history, int node_id)
 {
-	ExecStatusType ping_result = connection_ping(conn);
+	PQExpBufferData query;
+	bool			success = true;
+	PGresult	   *res = NULL;
 
-	if (PQstatus(conn) != CONNECTION_OK)
+	initPQExpBuffer(&query);
+
+	if (keep_history > 0 || node_id != UNKNOWN_NODE_ID)
 	{
-		log_warning(_("connection error, attempting to reset"));
-		log_detail("\n%s", PQerrorMessage(conn));
-		PQreset(conn);
-		ping_result = connection_ping(conn);
+		appendPQExpBuffer(&query,
+						  "DELETE FROM repmgr.monitoring_history "
+						  " WHERE pg_catalog.age(pg_catalog.now(), last_monitor_time) >= '%d days'::INTERVAL ",
+						  keep_history);
+
+		if (node_id != UNKNOWN_NODE_ID)
+		{
+			appendPQExpBuffer(&query,
+							  "  AND standby_node_id = %i", node_id);
+		}
+	}
+	else
+	{
+		appendPQExpBufferStr(&query,
+							 "TRUNCATE TABLE repmgr.monitoring_history");
 	}
 
-	log_verbose(LOG_DEBUG, "connection_ping_reconnect(): result is %s", PQresStatus(ping_result));
+	res = PQexec(primary_conn, query.data);
 
-	return ping_result;
-}
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+	{
+		log_db_error(primary_conn, query.data,
+					 _("delete_monitoring_records(): unable to delete monitoring records"));
+		success = false;
+	}
 
+	termPQExpBuffer(&query);
+	PQclear(res);
 
+	return success;
+}
 
-/* ==================== */
-/* monitoring functions */
-/* ==================== */
 
-void
-add_monitoring_record(PGconn *primary_conn,
-					  PGconn *local_conn,
-					  int primary_node_id,
-					  int local_node_id,
-					  char *monitor_standby_timestamp,
-					  XLogRecPtr primary_last_wal_location,
-					  XLogRecPtr last_wal_receive_lsn,
-					  char *last_xact_replay_timestamp,
-					  long long unsigned int replication_lag_bytes,
-					  long long unsigned int apply_lag_bytes
-)
+/*
+ * From PostgreSQL 11, "repmgr.monitoring_history" is created as a table
+ * partitioned by day.
+ */
+bool
+is_monitoring_history_partitioned(PGconn *conn)
 {
-	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		partitioned = false;
+	const char *sqlquery =
+		"SELECT c.relkind = 'p' "
+		"  FROM pg_catalog.pg_class c "
+		" WHERE c.oid = 'repmgr.monitoring_history'::pg_catalog.regclass ";
 
-	initPQExpBuffer(&query);
+	log_verbose(LOG_DEBUG, "is_monitoring_history_partitioned():\n  %s", sqlquery);
 
-	appendPQExpBuffer(&query,
-					  "INSERT INTO repmgr.monitoring_history "
-					  "           (primary_node_id, "
-					  "            standby_node_id, "
-					  "            last_monitor_time, "
-					  "            last_apply_time, "
-					  "            last_wal_primary_location, "
-					  "            last_wal_standby_location, "
-					  "            replication_lag, "
-					  "            apply_lag ) "
-					  "     VALUES(%i, "
-					  "            %i, "
-					  "            '%s'::TIMESTAMP WITH TIME ZONE, "
-					  "            '%s'::TIMESTAMP WITH TIME ZONE, "
-					  "            '%X/%X', "
-					  "            '%X/%X', "
-					  "            %llu, "
-					  "            %llu) ",
-					  primary_node_id,
-					  local_node_id,
-					  monitor_standby_timestamp,
-					  last_xact_replay_timestamp,
-					  format_lsn(primary_last_wal_location),
-					  format_lsn(last_wal_receive_lsn),
-					  replication_lag_bytes,
-					  apply_lag_bytes);
-
-	log_verbose(LOG_DEBUG, "standby_monitor:()\n%s", query.data);
+	res = PQexec(conn, sqlquery);
 
-	if (PQsendQuery(primary_conn, query.data) == 0)
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
 	{
-		log_warning(_("query could not be sent to primary:\n  %s"),
-					PQerrorMessage(primary_conn));
+		log_db_error(conn, sqlquery, _("is_monitoring_history_partitioned(): unable to execute query"));
 	}
-	else
+	else if (PQntuples(res) == 1)
 	{
-		PGresult   *res = PQexec(local_conn, "SELECT repmgr.standby_set_last_updated()");
-
-		/* not critical if the above query fails */
-		if (PQresultStatus(res) != PGRES_TUPLES_OK)
-			log_warning(_("add_monitoring_record(): unable to set last_updated:\n  %s"),
-						PQerrorMessage(local_conn));
-
-		PQclear(res);
+		partitioned = atobool(PQgetvalue(res, 0, 0));
 	}
 
-	termPQExpBuffer(&query);
+	PQclear(res);
 
-	return;
+	return partitioned;
 }
 
 
+/*
+ * Create partitions for the current day and the following "days_ahead" days,
+ * if not already present.
+ *
+ * Returns the number of partitions created, or -1 on error.
+ */
 int
-get_number_of_monitoring_records_to_delete(PGconn *primary_conn, int keep_history, int node_id)
+create_monitoring_history_partitions(PGconn *primary_conn, int days_ahead)
 {
 	PQExpBufferData query;
-	int				record_count = -1;
-	PGresult	   *res = NULL;
+	PGresult   *res = NULL;
+	int			partitions_created = -1;
 
 	initPQExpBuffer(&query);
 
 	appendPQExpBuffer(&query,
-					  "SELECT pg_catalog.count(*) "
-					  "  FROM repmgr.monitoring_history "
-					  " WHERE pg_catalog.age(pg_catalog.now(), last_monitor_time) >= '%d days'::interval",
-					  keep_history);
-
-	if (node_id != UNKNOWN_NODE_ID)
-	{
-		appendPQExpBuffer(&query,
-						  "  AND standby_node_id = %i", node_id);
-	}
+					  "SELECT repmgr.create_monitoring_history_partitions(%i)",
+					  days_ahead);
 
-	log_verbose(LOG_DEBUG, "get_number_of_monitoring_records_to_delete():\n  %s", query.data);
+	log_verbose(LOG_DEBUG, "create_monitoring_history_partitions():\n  %s", query.data);
 
 	res = PQexec(primary_conn, query.data);
 
 	if (PQresultStatus(res) != PGRES_TUPLES_OK)
 	{
 		log_db_error(primary_conn, query.data,
-					 _("get_number_of_monitoring_records_to_delete(): unable to query number of monitoring records to clean up"));
+					 _("create_monitoring_history_partitions(): unable to create partitions"));
 	}
 	else
 	{
-		record_count = atoi(PQgetvalue(res, 0, 0));
+		partitions_created = atoi(PQgetvalue(res, 0, 0));
 	}
 
 	termPQExpBuffer(&query);
 	PQclear(res);
 
-	return record_count;
+	return partitions_created;
 }
 
 
-bool
-delete_monitoring_records(PGconn *primary_conn, int keep_history, int node_id)
+/*
+ * Drop partitions containing only records older than "keep_history" days.
+ *
+ * Returns the number of partitions dropped, or -1 on error.
+ */
+int
+drop_monitoring_history_partitions(PGconn *primary_conn, int keep_history)
 {
 	PQExpBufferData query;
-	bool			success = true;
-	PGresult	   *res = NULL;
+	PGresult   *res = NULL;
+	int			partitions_dropped = -1;
 
 	initPQExpBuffer(&query);
 
-	if (keep_history > 0 || node_id != UNKNOWN_NODE_ID)
-	{
-		appendPQExpBuffer(&query,
-						  "DELETE FROM repmgr.monitoring_history "
-						  " WHERE pg_catalog.age(pg_catalog.now(), last_monitor_time) >= '%d days'::INTERVAL ",
-						  keep_history);
+	appendPQExpBuffer(&query,
+					  "SELECT repmgr.drop_monitoring_history_partitions(%i)",
+					  keep_history);
 
-		if (node_id != UNKNOWN_NODE_ID)
-		{
-			appendPQExpBuffer(&query,
-							  "  AND standby_node_id = %i", node_id);
-		}
-	}
-	else
-	{
-		appendPQExpBufferStr(&query,
-							 "TRUNCATE TABLE repmgr.monitoring_history");
-	}
+	log_verbose(LOG_DEBUG, "drop_monitoring_history_partitions():\n  %s", query.data);
 
 	res = PQexec(primary_conn, query.data);
 
-	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
 	{
 		log_db_error(primary_conn, query.data,
-					 _("delete_monitoring_records(): unable to delete monitoring records"));
-		success = false;
+					 _("drop_monitoring_history_partitions(): unable to drop partitions"));
+	}
+	else
+	{
+		partitions_dropped = atoi(PQgetvalue(res, 0, 0));
 	}
 
 	termPQExpBuffer(&query);
 	PQclear(res);
 
-	return success;
+	return partitions_dropped;
 }
 
 /*
@@ -5232,6 +7667,89 @@ notify_follow_primary(PGconn *conn, int primary_node_id)
 }
 
 
+/*
+ * notify_follow_primary_parallel()
+ *
+ * As notify_follow_primary(), but for each node in the provided list with
+ * an open connection. The notification is dispatched to all nodes at once,
+ * so following a promotion all followers are notified within a single
+ * round trip, rather than one after the other.
+ *
+ * Returns the number of nodes successfully notified.
+ */
+int
+notify_follow_primary_parallel(NodeInfoList *node_list, int primary_node_id, int timeout)
+{
+	NodeInfoListCell *cell = NULL;
+	PQExpBufferData query;
+	t_node_info **nodes = NULL;
+	const char **queries = NULL;
+	int			query_count = 0;
+	int			success_count = 0;
+	int			i;
+
+	if (node_list->node_count == 0)
+		return 0;
+
+	initPQExpBuffer(&query);
+	appendPQExpBuffer(&query,
+					  "SELECT repmgr.notify_follow_primary(%i)",
+					  primary_node_id);
+
+	nodes = arena_alloc0(sizeof(t_node_info *) * node_list->node_count);
+	queries = arena_alloc0(sizeof(char *) * node_list->node_count);
+
+	for (cell = node_list->head; cell; cell = cell->next)
+	{
+		t_node_info *node_info = cell->node_info;
+
+		if (PQstatus(node_info->conn) != CONNECTION_OK)
+			continue;
+
+		node_info->details[0] = '\0';
+
+		nodes[query_count] = node_info;
+		queries[query_count] = query.data;
+		query_count++;
+	}
+
+	_execute_node_queries_parallel(nodes, queries, query_count, _notify_follow_primary_result, timeout);
+
+	for (i = 0; i < query_count; i++)
+	{
+		if (nodes[i]->details[0] == '\0')
+			success_count++;
+	}
+
+	arena_free(nodes);
+	arena_free(queries);
+	termPQExpBuffer(&query);
+
+	return success_count;
+}
+
+
+static void
+_notify_follow_primary_result(t_node_info *node_info, PGresult *res)
+{
+	if (PQresultStatus(res) == PGRES_TUPLES_OK)
+		return;
+
+	log_warning(_("unable to execute repmgr.notify_follow_primary() on node \"%s\" (ID: %i)"),
+				node_info->node_name,
+				node_info->node_id);
+	log_detail("%s", PQerrorMessage(node_info->conn));
+
+	snprintf(node_info->details, sizeof(node_info->details),
+			 "%s", PQerrorMessage(node_info->conn));
+
+	/* ensure "details" is non-empty even if libpq provided no message */
+	if (node_info->details[0] == '\0')
+		snprintf(node_info->details, sizeof(node_info->details),
+				 "%s", _("unknown error"));
+}
+
+
 bool
 get_new_primary(PGconn *conn, int *primary_node_id)
 {
@@ -5291,6 +7809,45 @@ reset_voting_status(PGconn *conn)
 }
 
 
+/*
+ * Publish the electoral term and the receive LSN, replay LSN and
+ * replication lag (in seconds) with which the local node stands as
+ * promotion candidate; sibling nodes read these via
+ * repmgr.get_election_status().
+ */
+bool
+set_prevote(PGconn *conn, int electoral_term, XLogRecPtr lsn, XLogRecPtr replay_lsn, int lag_time)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "SELECT repmgr.set_prevote(%i, '%X/%X', '%X/%X', %i)",
+					  electoral_term,
+					  format_lsn(lsn),
+					  format_lsn(replay_lsn),
+					  lag_time);
+
+	log_verbose(LOG_DEBUG, "set_prevote():\n  %s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data, _("unable to execute repmgr.set_prevote()"));
+		success = false;
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
+
 /* ============================ */
 /* replication status functions */
 /* ============================ */
@@ -5309,14 +7866,7 @@ get_primary_current_lsn(PGconn *conn)
 	PGresult   *res = NULL;
 	XLogRecPtr	ptr = InvalidXLogRecPtr;
 
-	if (PQserverVersion(conn) >= 100000)
-	{
-		res = PQexec(conn, "SELECT pg_catalog.pg_current_wal_lsn()");
-	}
-	else
-	{
-		res = PQexec(conn, "SELECT pg_catalog.pg_current_xlog_location()");
-	}
+	res = _exec_monitoring_query(conn, MQ_PRIMARY_CURRENT_LSN);
 
 	if (PQresultStatus(res) == PGRES_TUPLES_OK)
 	{
@@ -5369,15 +7919,32 @@ get_last_wal_receive_location(PGconn *conn)
 XLogRecPtr
 get_node_current_lsn(PGconn *conn)
 {
-	PQExpBufferData query;
 	PGresult   *res = NULL;
 	XLogRecPtr	ptr = InvalidXLogRecPtr;
 
-	initPQExpBuffer(&query);
+	res = _exec_monitoring_query(conn, MQ_NODE_CURRENT_LSN);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, NULL, _("unable to execute get_node_current_lsn()"));
+	}
+	else if (!PQgetisnull(res, 0, 0))
+	{
+		ptr = parse_lsn(PQgetvalue(res, 0, 0));
+	}
+
+	PQclear(res);
+
+	return ptr;
+}
 
+
+static void
+_build_node_current_lsn_query(PGconn *conn, PQExpBufferData *query)
+{
 	if (PQserverVersion(conn) >= 100000)
 	{
-		appendPQExpBufferStr(&query,
+		appendPQExpBufferStr(query,
 							 " WITH lsn_states AS ( "
 							 "  SELECT "
 							 "    CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
@@ -5399,7 +7966,7 @@ get_node_current_lsn(PGconn *conn)
 	}
 	else
 	{
-		appendPQExpBufferStr(&query,
+		appendPQExpBufferStr(query,
 							 " WITH lsn_states AS ( "
 							 "  SELECT "
 							 "    CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
@@ -5420,7 +7987,7 @@ get_node_current_lsn(PGconn *conn)
 							 " ) ");
 	}
 
-	appendPQExpBufferStr(&query,
+	appendPQExpBufferStr(query,
 						 " SELECT "
 						 "   CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
 						 "     THEN current_wal_lsn "
@@ -5436,51 +8003,176 @@ get_node_current_lsn(PGconn *conn)
 						 "   END "
 						 "     AS current_lsn "
 						 "   FROM lsn_states ");
+}
 
-	res = PQexec(conn, query.data);
 
-	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+void
+init_replication_info(ReplInfo *replication_info)
+{
+	memset(replication_info->current_timestamp, 0, sizeof(replication_info->current_timestamp));
+	replication_info->in_recovery = false;
+	replication_info->timeline_id = UNKNOWN_TIMELINE_ID;
+	replication_info->last_wal_receive_lsn = InvalidXLogRecPtr;
+	replication_info->last_wal_replay_lsn = InvalidXLogRecPtr;
+	memset(replication_info->last_xact_replay_timestamp, 0, sizeof(replication_info->last_xact_replay_timestamp));
+	replication_info->replication_lag_time = 0;
+	replication_info->receiving_streamed_wal = true;
+	replication_info->wal_replay_paused = false;
+	replication_info->upstream_last_seen = -1;
+	replication_info->upstream_node_id = UNKNOWN_NODE_ID;
+	replication_info->repmgrd_pid = UNKNOWN_PID;
+	replication_info->repmgrd_running = false;
+	replication_info->repmgrd_paused = false;
+	replication_info->voting_status = VS_UNKNOWN;
+	replication_info->current_electoral_term = -1;
+	replication_info->prevote_term = -1;
+	replication_info->prevote_lsn = InvalidXLogRecPtr;
+	replication_info->prevote_replay_lsn = InvalidXLogRecPtr;
+	replication_info->prevote_lag_time = 0;
+}
+
+
+bool
+get_replication_info(PGconn *conn, t_server_type node_type, ReplInfo *replication_info)
+{
+	PGresult   *res = NULL;
+	bool		success = true;
+
+	res = _exec_monitoring_query(conn, node_type == WITNESS
+								 ? MQ_REPLICATION_INFO_WITNESS
+								 : MQ_REPLICATION_INFO);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || !PQntuples(res))
 	{
-		log_db_error(conn, query.data, _("unable to execute get_node_current_lsn()"));
+		log_db_error(conn, NULL, _("get_replication_info(): unable to execute query"));
+
+		success = false;
 	}
-	else if (!PQgetisnull(res, 0, 0))
+	else
 	{
-		ptr = parse_lsn(PQgetvalue(res, 0, 0));
+		_populate_replication_info(res, false, replication_info);
 	}
 
-	termPQExpBuffer(&query);
 	PQclear(res);
 
-	return ptr;
+	return success;
+}
+
+
+/*
+ * get_replication_info_parallel()
+ *
+ * Retrieve replication information, together with the repmgrd state relevant
+ * to a promotion candidate election (see repmgr.get_election_status()), from
+ * each node in the provided list with an open connection (as set up by
+ * establish_node_connections_parallel()). The query is dispatched to all
+ * nodes at once, so only a single round trip is needed in total, rather than
+ * several per node.
+ *
+ * Each queried node's "replication_info" will be allocated if necessary and
+ * populated. If the query fails for a node (e.g. as the node's repmgr
+ * extension predates get_election_status()), the individual queries are
+ * executed instead; if these fail too, "replication_info" is set to NULL.
+ *
+ * Returns the number of nodes for which replication information was retrieved.
+ */
+int
+get_replication_info_parallel(NodeInfoList *node_list, int timeout)
+{
+	NodeInfoListCell *cell = NULL;
+	t_node_info **nodes = NULL;
+	const char **queries = NULL;
+	PQExpBufferData *query_bufs = NULL;
+	int			query_count = 0;
+	int			success_count = 0;
+	int			i;
+
+	if (node_list->node_count == 0)
+		return 0;
+
+	nodes = arena_alloc0(sizeof(t_node_info *) * node_list->node_count);
+	queries = arena_alloc0(sizeof(char *) * node_list->node_count);
+	query_bufs = arena_alloc0(sizeof(PQExpBufferData) * node_list->node_count);
+
+	for (cell = node_list->head; cell; cell = cell->next)
+	{
+		t_node_info *node_info = cell->node_info;
+
+		if (PQstatus(node_info->conn) != CONNECTION_OK)
+			continue;
+
+		if (node_info->replication_info == NULL)
+			node_info->replication_info = pg_malloc0(sizeof(ReplInfo));
+
+		init_replication_info(node_info->replication_info);
+
+		initPQExpBuffer(&query_bufs[query_count]);
+		_build_replication_info_query(node_info->conn, node_info->type, true, &query_bufs[query_count]);
+
+		nodes[query_count] = node_info;
+		queries[query_count] = query_bufs[query_count].data;
+		query_count++;
+	}
+
+	_execute_node_queries_parallel(nodes, queries, query_count, _get_replication_info_result, timeout);
+
+	for (i = 0; i < query_count; i++)
+	{
+		if (nodes[i]->replication_info != NULL)
+			success_count++;
+
+		termPQExpBuffer(&query_bufs[i]);
+	}
+
+	arena_free(nodes);
+	arena_free(queries);
+	arena_free(query_bufs);
+
+	return success_count;
 }
 
 
-void
-init_replication_info(ReplInfo *replication_info)
-{
-	memset(replication_info->current_timestamp, 0, sizeof(replication_info->current_timestamp));
-	replication_info->in_recovery = false;
-	replication_info->timeline_id = UNKNOWN_TIMELINE_ID;
-	replication_info->last_wal_receive_lsn = InvalidXLogRecPtr;
-	replication_info->last_wal_replay_lsn = InvalidXLogRecPtr;
-	memset(replication_info->last_xact_replay_timestamp, 0, sizeof(replication_info->last_xact_replay_timestamp));
-	replication_info->replication_lag_time = 0;
-	replication_info->receiving_streamed_wal = true;
-	replication_info->wal_replay_paused = false;
-	replication_info->upstream_last_seen = -1;
-	replication_info->upstream_node_id = UNKNOWN_NODE_ID;
+static void
+_get_replication_info_result(t_node_info *node_info, PGresult *res)
+{
+	if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0)
+	{
+		_populate_replication_info(res, true, node_info->replication_info);
+		return;
+	}
+
+	log_warning(_("unable to retrieve election status from node %i"),
+				node_info->node_id);
+	log_detail("%s", PQerrorMessage(node_info->conn));
+	/* connection closed as the node did not respond in time */
+	if (node_info->conn == NULL)
+	{
+		pfree(node_info->replication_info);
+		node_info->replication_info = NULL;
+		return;
+	}
+
+	log_hint(_("check the repmgr extension on this node is up-to-date"));
+
+	log_verbose(LOG_DEBUG, "get_replication_info_parallel(): falling back to individual queries for node %i",
+				node_info->node_id);
+
+	if (get_replication_info(node_info->conn, node_info->type, node_info->replication_info) == false)
+	{
+		pfree(node_info->replication_info);
+		node_info->replication_info = NULL;
+		return;
+	}
+
+	node_info->replication_info->repmgrd_pid = repmgrd_get_pid(node_info->conn);
+	node_info->replication_info->repmgrd_paused = repmgrd_is_paused(node_info->conn);
 }
 
 
-bool
-get_replication_info(PGconn *conn, t_server_type node_type, ReplInfo *replication_info)
+static void
+_build_replication_info_query(PGconn *conn, t_server_type node_type, bool election_status, PQExpBufferData *query)
 {
-	PQExpBufferData query;
-	PGresult   *res = NULL;
-	bool		success = true;
-
-	initPQExpBuffer(&query);
-	appendPQExpBufferStr(&query,
+	appendPQExpBufferStr(query,
 						 " SELECT ts, "
 						 "        in_recovery, "
 						 "        last_wal_receive_lsn, "
@@ -5498,7 +8190,22 @@ get_replication_info(PGconn *conn, t_server_type node_type, ReplInfo *replicatio
 						 "        last_wal_receive_lsn >= last_wal_replay_lsn AS receiving_streamed_wal, "
 						 "        wal_replay_paused, "
 						 "        upstream_last_seen, "
-						 "        upstream_node_id "
+						 "        upstream_node_id ");
+
+	if (election_status == true)
+	{
+		appendPQExpBufferStr(query,
+							 "        , es.repmgrd_pid, "
+							 "        es.repmgrd_paused, "
+							 "        es.voting_status, "
+							 "        es.current_electoral_term, "
+							 "        es.prevote_term, "
+							 "        es.prevote_lsn, "
+							 "        es.prevote_replay_lsn, "
+							 "        es.prevote_lag_time ");
+	}
+
+	appendPQExpBufferStr(query,
 						 "   FROM ( "
 						 " SELECT CURRENT_TIMESTAMP AS ts, "
 						 "        pg_catalog.pg_is_in_recovery() AS in_recovery, "
@@ -5507,7 +8214,7 @@ get_replication_info(PGconn *conn, t_server_type node_type, ReplInfo *replicatio
 
 	if (PQserverVersion(conn) >= 100000)
 	{
-		appendPQExpBufferStr(&query,
+		appendPQExpBufferStr(query,
 							 "        COALESCE(pg_catalog.pg_last_wal_receive_lsn(), '0/0'::PG_LSN) AS last_wal_receive_lsn, "
 							 "        COALESCE(pg_catalog.pg_last_wal_replay_lsn(),  '0/0'::PG_LSN) AS last_wal_replay_lsn, "
 							 "        CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
@@ -5519,19 +8226,19 @@ get_replication_info(PGconn *conn, t_server_type node_type, ReplInfo *replicatio
 	{
 		if (PQserverVersion(conn) >= 90400)
 		{
-			appendPQExpBufferStr(&query,
+			appendPQExpBufferStr(query,
 								 "        COALESCE(pg_catalog.pg_last_xlog_receive_location(), '0/0'::PG_LSN) AS last_wal_receive_lsn, "
 								 "        COALESCE(pg_catalog.pg_last_xlog_replay_location(),  '0/0'::PG_LSN) AS last_wal_replay_lsn, ");
 		}
 		else
 		{
 			/* 9.3 does not have "pg_lsn" datatype */
-			appendPQExpBufferStr(&query,
+			appendPQExpBufferStr(query,
 								 "        COALESCE(pg_catalog.pg_last_xlog_receive_location(), '0/0') AS last_wal_receive_lsn, "
 								 "        COALESCE(pg_catalog.pg_last_xlog_replay_location(),  '0/0') AS last_wal_replay_lsn, ");
 		}
 
-		appendPQExpBufferStr(&query,
+		appendPQExpBufferStr(query,
 							 "        CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
 							 "          THEN FALSE "
 							 "          ELSE pg_catalog.pg_is_xlog_replay_paused() "
@@ -5541,59 +8248,71 @@ get_replication_info(PGconn *conn, t_server_type node_type, ReplInfo *replicatio
 	/* Add information about upstream node from shared memory */
 	if (node_type == WITNESS)
 	{
-		appendPQExpBufferStr(&query,
+		appendPQExpBufferStr(query,
 							 "        repmgr.get_upstream_last_seen() AS upstream_last_seen, "
 							 "        repmgr.get_upstream_node_id() AS upstream_node_id ");
 	}
 	else
 	{
-		appendPQExpBufferStr(&query,
+		appendPQExpBufferStr(query,
 							 "        CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
 							 "          THEN -1 "
 							 "          ELSE repmgr.get_upstream_last_seen() "
 							 "        END AS upstream_last_seen, ");
-		appendPQExpBufferStr(&query,
+		appendPQExpBufferStr(query,
 							 "        CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
 							 "          THEN -1 "
 							 "          ELSE repmgr.get_upstream_node_id() "
 							 "        END AS upstream_node_id ");
 	}
 
-	appendPQExpBufferStr(&query,
+	appendPQExpBufferStr(query,
 						 "          ) q ");
 
-	log_verbose(LOG_DEBUG, "get_replication_info():\n%s", query.data);
-
-	res = PQexec(conn, query.data);
-
-	if (PQresultStatus(res) != PGRES_TUPLES_OK || !PQntuples(res))
-	{
-		log_db_error(conn, query.data, _("get_replication_info(): unable to execute query"));
+	if (election_status == true)
+		appendPQExpBufferStr(query,
+							 "  CROSS JOIN repmgr.get_election_status() es ");
+}
 
-		success = false;
-	}
-	else
-	{
-		snprintf(replication_info->current_timestamp,
-				 sizeof(replication_info->current_timestamp),
-				 "%s", PQgetvalue(res, 0, 0));
-		replication_info->in_recovery = atobool(PQgetvalue(res, 0, 1));
-		replication_info->last_wal_receive_lsn = parse_lsn(PQgetvalue(res, 0, 2));
-		replication_info->last_wal_replay_lsn = parse_lsn(PQgetvalue(res, 0, 3));
-		snprintf(replication_info->last_xact_replay_timestamp,
-				 sizeof(replication_info->last_xact_replay_timestamp),
-				 "%s", PQgetvalue(res, 0, 4));
-		replication_info->replication_lag_time = atoi(PQgetvalue(res, 0, 5));
-		replication_info->receiving_streamed_wal = atobool(PQgetvalue(res, 0, 6));
-		replication_info->wal_replay_paused = atobool(PQgetvalue(res, 0, 7));
-		replication_info->upstream_last_seen = atoi(PQgetvalue(res, 0, 8));
-		replication_info->upstream_node_id = atoi(PQgetvalue(res, 0, 9));
-	}
 
-	termPQExpBuffer(&query);
-	PQclear(res);
+static void
+_populate_replication_info(PGresult *res, bool election_status, ReplInfo *replication_info)
+{
+	snprintf(replication_info->current_timestamp,
+			 sizeof(replication_info->current_timestamp),
+			 "%s", PQgetvalue(res, 0, 0));
+	replication_info->in_recovery = atobool(PQgetvalue(res, 0, 1));
+	replication_info->last_wal_receive_lsn = parse_lsn(PQgetvalue(res, 0, 2));
+	replication_info->last_wal_replay_lsn = parse_lsn(PQgetvalue(res, 0, 3));
+	snprintf(replication_info->last_xact_replay_timestamp,
+			 sizeof(replication_info->last_xact_replay_timestamp),
+			 "%s", PQgetvalue(res, 0, 4));
+	replication_info->replication_lag_time = atoi(PQgetvalue(res, 0, 5));
+	replication_info->receiving_streamed_wal = atobool(PQgetvalue(res, 0, 6));
+	replication_info->wal_replay_paused = atobool(PQgetvalue(res, 0, 7));
+	replication_info->upstream_last_seen = atoi(PQgetvalue(res, 0, 8));
+	replication_info->upstream_node_id = atoi(PQgetvalue(res, 0, 9));
+
+	if (election_status == false)
+		return;
 
-	return success;
+	/* values will be NULL if the repmgr shared library is not loaded */
+	if (!PQgetisnull(res, 0, 10))
+		replication_info->repmgrd_pid = atoi(PQgetvalue(res, 0, 10));
+	if (!PQgetisnull(res, 0, 11))
+		replication_info->repmgrd_paused = atobool(PQgetvalue(res, 0, 11));
+	if (!PQgetisnull(res, 0, 12))
+		replication_info->voting_status = (NodeVotingStatus) atoi(PQgetvalue(res, 0, 12));
+	if (!PQgetisnull(res, 0, 13))
+		replication_info->current_electoral_term = atoi(PQgetvalue(res, 0, 13));
+	if (!PQgetisnull(res, 0, 14))
+		replication_info->prevote_term = atoi(PQgetvalue(res, 0, 14));
+	if (!PQgetisnull(res, 0, 15))
+		replication_info->prevote_lsn = parse_lsn(PQgetvalue(res, 0, 15));
+	if (!PQgetisnull(res, 0, 16))
+		replication_info->prevote_replay_lsn = parse_lsn(PQgetvalue(res, 0, 16));
+	if (!PQgetisnull(res, 0, 17))
+		replication_info->prevote_lag_time = atoi(PQgetvalue(res, 0, 17));
 }
 
 
@@ -5692,6 +8411,98 @@ get_node_timeline(PGconn *conn, char *timeline_id_str)
 }
 
 
+/*
+ * get_node_status_parallel()
+ *
+ * For each node in the provided list with an open connection (as set up by
+ * establish_node_connections_parallel()), retrieve the node's recovery type
+ * and (PostgreSQL 9.6 and later) its current timeline. The queries are
+ * dispatched to all nodes at once, so the round-trip time for all nodes
+ * is bounded by the slowest node, rather than the sum of all queries.
+ *
+ * Results are stored in each node's "recovery_type" field and, if allocated,
+ * in "replication_info->timeline_id" / "timeline_id_str". Nodes for which the
+ * query fails retain RECTYPE_UNKNOWN / UNKNOWN_TIMELINE_ID.
+ */
+void
+get_node_status_parallel(NodeInfoList *node_list, int timeout)
+{
+	NodeInfoListCell *cell = NULL;
+	t_node_info **nodes = NULL;
+	const char **queries = NULL;
+	int			query_count = 0;
+
+	if (node_list->node_count == 0)
+		return;
+
+	nodes = pg_malloc0(sizeof(t_node_info *) * node_list->node_count);
+	queries = pg_malloc0(sizeof(char *) * node_list->node_count);
+
+	for (cell = node_list->head; cell; cell = cell->next)
+	{
+		t_node_info *node_info = cell->node_info;
+
+		node_info->recovery_type = RECTYPE_UNKNOWN;
+
+		if (node_info->replication_info != NULL)
+		{
+			node_info->replication_info->timeline_id = UNKNOWN_TIMELINE_ID;
+			strncpy(node_info->replication_info->timeline_id_str, "?", MAXLEN);
+		}
+
+		if (PQstatus(node_info->conn) != CONNECTION_OK)
+			continue;
+
+		/*
+		 * pg_control_checkpoint() was introduced in PostgreSQL 9.6
+		 */
+		if (PQserverVersion(node_info->conn) >= 90600)
+		{
+			queries[query_count] =
+				"SELECT pg_catalog.pg_is_in_recovery(), "
+				"       (SELECT timeline_id FROM pg_catalog.pg_control_checkpoint()) ";
+		}
+		else
+		{
+			queries[query_count] =
+				"SELECT pg_catalog.pg_is_in_recovery(), NULL ";
+		}
+
+		nodes[query_count] = node_info;
+		query_count++;
+	}
+
+	_execute_node_queries_parallel(nodes, queries, query_count, _get_node_status_result, timeout);
+
+	pfree(nodes);
+	pfree(queries);
+}
+
+
+static void
+_get_node_status_result(t_node_info *node_info, PGresult *res)
+{
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0)
+	{
+		log_db_error(node_info->conn, NULL,
+					 _("get_node_status_parallel(): unable to query node %i"),
+					 node_info->node_id);
+		return;
+	}
+
+	node_info->recovery_type = (strcmp(PQgetvalue(res, 0, 0), "t") == 0)
+		? RECTYPE_STANDBY
+		: RECTYPE_PRIMARY;
+
+	if (node_info->replication_info != NULL && PQgetisnull(res, 0, 1) == 0)
+	{
+		node_info->replication_info->timeline_id = atoi(PQgetvalue(res, 0, 1));
+		snprintf(node_info->replication_info->timeline_id_str, MAXLEN,
+				 "%i", node_info->replication_info->timeline_id);
+	}
+}
+
+
 void
 get_node_replication_stats(PGconn *conn, t_node_info *node_info)
 {
@@ -5757,6 +8568,288 @@ get_node_replication_stats(PGconn *conn, t_node_info *node_info)
 }
 
 
+/*
+ * get_node_transfer_rate()
+ *
+ * Estimate the rate (in bytes per second) at which data can be retrieved
+ * from the node, by timing the retrieval of a "sample_size" byte value
+ * generated by the server. This includes a single round trip and reflects
+ * the network path to the node and its current CPU load, but not its
+ * storage throughput.
+ *
+ * Returns -1 if the query failed.
+ */
+double
+get_node_transfer_rate(PGconn *conn, int sample_size)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	instr_time	start_time;
+	instr_time	elapsed;
+	double		transfer_rate = -1;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "SELECT pg_catalog.repeat('x', %i)",
+					  sample_size);
+
+	log_verbose(LOG_DEBUG, "get_node_transfer_rate():\n  %s", query.data);
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	res = PQexec(conn, query.data);
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data, _("get_node_transfer_rate(): unable to execute query"));
+	}
+	else if (INSTR_TIME_GET_DOUBLE(elapsed) > 0)
+	{
+		transfer_rate = (double) PQgetlength(res, 0, 0) / INSTR_TIME_GET_DOUBLE(elapsed);
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return transfer_rate;
+}
+
+
+/*
+ * get_node_check_info()
+ *
+ * Collect the state needed by all the "repmgr node check" checks with two
+ * queries: one for the node's own status, and one for its downstream nodes.
+ * The replication statistics in "node_info" are populated as with
+ * get_node_replication_stats().
+ *
+ * Returns false if either query failed; any values which could not be
+ * retrieved are left at their "unknown" defaults.
+ */
+bool
+get_node_check_info(PGconn *conn, t_node_info *node_info, t_node_check_info *check_info)
+{
+	PQExpBufferData query;
+	PQExpBufferData has_pg_settings;
+	PGresult   *res = NULL;
+	bool		success = true;
+	int			i;
+
+	initPQExpBuffer(&has_pg_settings);
+
+	/* superusers can always read pg_settings; from PostgreSQL 10 non-superusers may have been granted access */
+	appendPQExpBufferStr(&has_pg_settings,
+						 "pg_catalog.current_setting('is_superuser')::BOOLEAN");
+
+	if (PQserverVersion(conn) >= 100000)
+	{
+		appendPQExpBufferStr(&has_pg_settings,
+							 " OR pg_catalog.pg_has_role('pg_monitor','MEMBER') "
+							 " OR pg_catalog.pg_has_role('pg_read_all_settings','MEMBER')");
+	}
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBufferStr(&query,
+						 " SELECT pg_catalog.current_setting('max_wal_senders')::INT AS max_wal_senders, "
+						 "        (SELECT pg_catalog.count(*) FROM pg_catalog.pg_stat_replication) AS attached_wal_receivers, ");
+
+	/* no replication slots in PostgreSQL 9.3 */
+	if (PQserverVersion(conn) < 90400)
+	{
+		appendPQExpBufferStr(&query,
+							 "        0 AS max_replication_slots, "
+							 "        0 AS total_replication_slots, "
+							 "        0 AS active_replication_slots, "
+							 "        0 AS inactive_replication_slots, ");
+	}
+	else
+	{
+		appendPQExpBufferStr(&query,
+							 "        current_setting('max_replication_slots')::INT AS max_replication_slots, "
+							 "        (SELECT pg_catalog.count(*) FROM pg_catalog.pg_replication_slots WHERE slot_type='physical') AS total_replication_slots, "
+							 "        (SELECT pg_catalog.count(*) FROM pg_catalog.pg_replication_slots WHERE active IS TRUE AND slot_type='physical')  AS active_replication_slots, "
+							 "        (SELECT pg_catalog.count(*) FROM pg_catalog.pg_replication_slots WHERE active IS FALSE AND slot_type='physical') AS inactive_replication_slots, ");
+	}
+
+	appendPQExpBufferStr(&query,
+						 "        pg_catalog.pg_is_in_recovery() AS in_recovery, "
+						 "        CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
+						 "          THEN 0 ");
+
+	if (PQserverVersion(conn) >= 100000)
+	{
+		appendPQExpBufferStr(&query,
+							 "        WHEN (pg_catalog.pg_last_wal_receive_lsn() = pg_catalog.pg_last_wal_replay_lsn()) ");
+	}
+	else
+	{
+		appendPQExpBufferStr(&query,
+							 "        WHEN (pg_catalog.pg_last_xlog_receive_location() = pg_catalog.pg_last_xlog_replay_location()) ");
+	}
+
+	appendPQExpBuffer(&query,
+					  "          THEN 0 "
+					  "        ELSE EXTRACT(epoch FROM (pg_catalog.clock_timestamp() - pg_catalog.pg_last_xact_replay_timestamp()))::INT "
+					  "          END "
+					  "        AS lag_seconds, "
+					  "        %s AS has_pg_settings, "
+					  "        CASE WHEN %s "
+					  "          THEN pg_catalog.current_setting('data_directory') "
+					  "          ELSE NULL "
+					  "        END AS data_directory, "
+					  "        un.node_id AS upstream_node_id, "
+					  "        un.node_name AS upstream_node_name, "
+					  "        un.conninfo AS upstream_conninfo "
+					  "   FROM (SELECT 1) dummy "
+					  "LEFT JOIN repmgr.nodes un "
+					  "       ON un.node_id = %i ",
+					  has_pg_settings.data,
+					  has_pg_settings.data,
+					  node_info->upstream_node_id);
+
+	termPQExpBuffer(&has_pg_settings);
+
+	log_verbose(LOG_DEBUG, "get_node_check_info():\n%s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1)
+	{
+		log_db_error(conn, query.data, _("get_node_check_info(): unable to retrieve node status"));
+		success = false;
+	}
+	else
+	{
+		node_info->max_wal_senders = atoi(PQgetvalue(res, 0, 0));
+		node_info->attached_wal_receivers = atoi(PQgetvalue(res, 0, 1));
+		node_info->max_replication_slots = atoi(PQgetvalue(res, 0, 2));
+		node_info->total_replication_slots = atoi(PQgetvalue(res, 0, 3));
+		node_info->active_replication_slots = atoi(PQgetvalue(res, 0, 4));
+		node_info->inactive_replication_slots = atoi(PQgetvalue(res, 0, 5));
+		node_info->recovery_type = strcmp(PQgetvalue(res, 0, 6), "f") == 0 ? RECTYPE_PRIMARY : RECTYPE_STANDBY;
+
+		check_info->recovery_type = node_info->recovery_type;
+		check_info->replication_lag_seconds = atoi(PQgetvalue(res, 0, 7));
+		check_info->has_pg_settings = atobool(PQgetvalue(res, 0, 8));
+
+		if (!PQgetisnull(res, 0, 9))
+		{
+			check_info->data_directory_found = true;
+			snprintf(check_info->data_directory, sizeof(check_info->data_directory),
+					 "%s", PQgetvalue(res, 0, 9));
+		}
+
+		if (!PQgetisnull(res, 0, 10))
+		{
+			check_info->upstream_node_found = true;
+			check_info->upstream_node_info.node_id = atoi(PQgetvalue(res, 0, 10));
+			snprintf(check_info->upstream_node_info.node_name, sizeof(check_info->upstream_node_info.node_name),
+					 "%s", PQgetvalue(res, 0, 11));
+			snprintf(check_info->upstream_node_info.conninfo, sizeof(check_info->upstream_node_info.conninfo),
+					 "%s", PQgetvalue(res, 0, 12));
+		}
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	/*
+	 * Downstream nodes, together with their attachment status and whether
+	 * any expected replication slot is missing
+	 */
+	initPQExpBuffer(&query);
+
+	appendPQExpBufferStr(&query,
+						 "  SELECT n.node_id, "
+						 "         n.type, "
+						 "         n.upstream_node_id, "
+						 "         n.node_name, "
+						 "         n.conninfo, "
+						 "         n.repluser, "
+						 "         n.slot_name, "
+						 "         n.location, "
+						 "         n.priority, "
+						 "         n.active, "
+						 "         n.config_file, "
+						 "         '' AS upstream_node_name, "
+						 "         EXISTS (SELECT 1 FROM pg_catalog.pg_stat_replication sr "
+						 "                  WHERE sr.application_name = n.node_name) AS attached, ");
+
+	if (PQserverVersion(conn) < 90400)
+	{
+		appendPQExpBufferStr(&query,
+							 "         FALSE AS slot_missing ");
+	}
+	else
+	{
+		appendPQExpBufferStr(&query,
+							 "         (n.slot_name IS NOT NULL AND n.type = 'standby' "
+							 "          AND NOT EXISTS (SELECT 1 FROM pg_catalog.pg_replication_slots rs "
+							 "                           WHERE rs.slot_name = n.slot_name)) AS slot_missing ");
+	}
+
+	appendPQExpBuffer(&query,
+					  "    FROM repmgr.nodes n "
+					  "   WHERE n.upstream_node_id = %i "
+					  "ORDER BY n.node_id ",
+					  node_info->node_id);
+
+	log_verbose(LOG_DEBUG, "get_node_check_info():\n%s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data, _("get_node_check_info(): unable to retrieve downstream node records"));
+		success = false;
+	}
+	else
+	{
+		_populate_node_records(res, &check_info->downstream_nodes);
+
+		/* rows are in the same order as the list just populated */
+		for (i = 0; i < PQntuples(res); i++)
+		{
+			NodeInfoListCell *cell = NULL;
+
+			if (atobool(PQgetvalue(res, i, 13)) == false)
+				continue;
+
+			cell = (NodeInfoListCell *) pg_malloc0(sizeof(NodeInfoListCell));
+			cell->node_info = pg_malloc0(sizeof(t_node_info));
+
+			_populate_node_record(res, cell->node_info, i, true);
+
+			if (check_info->missing_slots.tail)
+				check_info->missing_slots.tail->next = cell;
+			else
+				check_info->missing_slots.head = cell;
+
+			check_info->missing_slots.tail = cell;
+			check_info->missing_slots.node_count++;
+		}
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
+
+void
+clear_node_check_info(t_node_check_info *check_info)
+{
+	clear_node_info_list(&check_info->downstream_nodes);
+	clear_node_info_list(&check_info->missing_slots);
+}
+
+
 NodeAttached
 is_downstream_node_attached(PGconn *conn, char *node_name)
 {
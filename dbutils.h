@@ -175,8 +175,36 @@ typedef struct
 	bool		wal_replay_paused;
 	int			upstream_last_seen;
 	int			upstream_node_id;
+	/*
+	 * repmgrd state, only populated by get_replication_info_parallel() and
+	 * (except voting status / electoral term) get_repmgrd_status_parallel()
+	 */
+	pid_t		repmgrd_pid;
+	bool		repmgrd_running;
+	bool		repmgrd_paused;
+	NodeVotingStatus voting_status;
+	int			current_electoral_term;
+	/* pre-vote; "prevote_term" is -1 if the node does not provide this */
+	int			prevote_term;
+	XLogRecPtr	prevote_lsn;
+	XLogRecPtr	prevote_replay_lsn;
+	int			prevote_lag_time;
 } ReplInfo;
 
+
+/* a single row for "repmgr.monitoring_history" */
+typedef struct
+{
+	int			primary_node_id;
+	int			standby_node_id;
+	char		monitor_timestamp[MAXLEN];
+	char		last_xact_replay_timestamp[MAXLEN];
+	XLogRecPtr	primary_last_wal_location;
+	XLogRecPtr	last_wal_receive_lsn;
+	long long unsigned int replication_lag_bytes;
+	long long unsigned int apply_lag_bytes;
+} t_monitoring_record;
+
 /*
  * Struct to store node information.
  *
@@ -197,7 +225,7 @@ typedef struct s_node_info
 	char		location[MAXLEN];
 	int			priority;
 	bool		active;
-	char		slot_name[MAXLEN];
+	char		slot_name[NAMEDATALEN];
 	char		config_file[MAXPGPATH];
 	/* used during failover to track node status */
 	XLogRecPtr	last_wal_receive_lsn;
@@ -256,19 +284,70 @@ typedef struct NodeInfoListCell
 	t_node_info *node_info;
 } NodeInfoListCell;
 
+/*
+ * Lists populated from a query result (see _populate_node_records()) store
+ * their cells and node records in two contiguous tables, which are reused
+ * if the list is repopulated with no more than "table_capacity" records,
+ * together with a node_id index used by find_node_in_list() and
+ * get_node_list_position(). Cells appended individually are not indexed.
+ */
 typedef struct NodeInfoList
 {
 	NodeInfoListCell *head;
 	NodeInfoListCell *tail;
 	int			node_count;
+	NodeInfoListCell *cell_table;
+	t_node_info *node_table;
+	int			table_count;
+	int			table_capacity;
+	int		   *node_index;
+	int			node_index_size;
 } NodeInfoList;
 
 #define T_NODE_INFO_LIST_INITIALIZER { \
 	NULL, \
 	NULL, \
+	0, \
+	NULL, \
+	NULL, \
+	0, \
+	0, \
+	NULL, \
 	0 \
 }
 
+
+/*
+ * Node state collected by get_node_check_info(), so "repmgr node check"
+ * can evaluate all checks without further queries on the local node.
+ */
+typedef struct s_node_check_info
+{
+	RecoveryType recovery_type;
+	int			replication_lag_seconds;
+	bool		has_pg_settings;
+	bool		data_directory_found;
+	char		data_directory[MAXPGPATH];
+	bool		upstream_node_found;
+	t_node_info upstream_node_info;
+	/* "attached" is set for each downstream node */
+	NodeInfoList downstream_nodes;
+	/* downstream standbys whose replication slot is missing */
+	NodeInfoList missing_slots;
+} t_node_check_info;
+
+#define T_NODE_CHECK_INFO_INITIALIZER { \
+	RECTYPE_UNKNOWN, \
+	UNKNOWN_REPLICATION_LAG, \
+	false, \
+	false, \
+	"", \
+	false, \
+	T_NODE_INFO_INITIALIZER, \
+	T_NODE_INFO_LIST_INITIALIZER, \
+	T_NODE_INFO_LIST_INITIALIZER \
+}
+
 typedef struct s_event_info
 {
 	char	   *node_name;
@@ -282,6 +361,18 @@ typedef struct s_event_info
 	UNKNOWN_NODE_ID \
 }
 
+/*
+ * Position in the event history, as provided with "cluster event --before/--after";
+ * either a timestamp, or a "timestamp,node_id,event" key as displayed by
+ * "cluster event" itself.
+ */
+typedef struct s_event_pagination_key
+{
+	char		timestamp[MAXLEN];
+	int			node_id;		/* UNKNOWN_NODE_ID if only a timestamp was provided */
+	char		event[MAXLEN];
+} t_event_pagination_key;
+
 
 /*
  * Struct to store list of conninfo keywords and values
@@ -309,6 +400,21 @@ typedef struct s_replication_slot
 	bool		active;
 } t_replication_slot;
 
+/*
+ * Struct to store the WAL retained by a physical replication slot, together
+ * with details of the node (if any) whose record specifies the slot
+ */
+typedef struct s_replication_slot_retention
+{
+	char		slot_name[MAXLEN];
+	bool		active;
+	uint64		retained_wal_bytes;
+	/* UNKNOWN_NODE_ID if no node record specifies this slot */
+	int			node_id;
+	char		node_name[NAMEDATALEN];
+	bool		node_active;
+} t_replication_slot_retention;
+
 #define T_REPLICATION_SLOT_INITIALIZER { "", "", false }
 
 
@@ -380,6 +486,7 @@ typedef struct RepmgrdInfo {
 /* utility functions */
 
 XLogRecPtr	parse_lsn(const char *str);
+bool		parse_event_pagination_key(const char *str, t_event_pagination_key *key);
 bool		atobool(const char *value);
 
 /* connection functions */
@@ -402,6 +509,9 @@ PGconn	   *get_primary_connection_quiet(PGconn *standby_conn, int *primary_id, c
 PGconn	   *duplicate_connection(PGconn *conn, const char *user, bool replication);
 
 void		close_connection(PGconn **conn);
+int			establish_node_connections_parallel(NodeInfoList *node_list, int max_parallel);
+void		close_node_connections(NodeInfoList *node_list);
+void		enable_prepared_monitoring_queries(bool enable);
 
 /* conninfo manipulation functions */
 bool		get_conninfo_value(const char *conninfo, const char *keyword, char *output);
@@ -445,6 +555,11 @@ int			get_ready_archive_files(PGconn *conn, const char *data_directory);
 bool		identify_system(PGconn *repl_conn, t_system_identification *identification);
 uint64		system_identifier(PGconn *conn);
 TimeLineHistoryEntry *get_timeline_history(PGconn *repl_conn, TimeLineID tli);
+bool		get_cached_system_identification(int node_id, t_system_identification *identification);
+void		cache_system_identification(int node_id, t_system_identification *identification);
+TimeLineHistoryEntry *get_cached_timeline_history(uint64 system_identifier, TimeLineID tli);
+void		cache_timeline_history(uint64 system_identifier, TimeLineID tli, TimeLineHistoryEntry *history);
+void		clear_follow_check_cache(void);
 
 /* user/role information functions */
 bool		can_execute_pg_promote(PGconn *conn);
@@ -462,7 +577,10 @@ pid_t		repmgrd_get_pid(PGconn *conn);
 bool		repmgrd_is_running(PGconn *conn);
 bool		repmgrd_is_paused(PGconn *conn);
 bool		repmgrd_pause(PGconn *conn, bool pause);
+int			repmgrd_pause_parallel(NodeInfoList *node_list, bool pause, int timeout);
+int			get_repmgrd_status_parallel(NodeInfoList *node_list, int timeout);
 pid_t		get_wal_receiver_pid(PGconn *conn);
+int			get_wal_receiver_last_msg_age(PGconn *conn, int *receiver_timeout);
 int			repmgrd_get_upstream_node_id(PGconn *conn);
 bool		repmgrd_set_upstream_node_id(PGconn *conn, int node_id);
 
@@ -494,6 +612,7 @@ bool		get_all_node_records(PGconn *conn, NodeInfoList *node_list);
 void		get_downstream_node_records(PGconn *conn, int node_id, NodeInfoList *nodes);
 void		get_active_sibling_node_records(PGconn *conn, int node_id, int upstream_node_id, NodeInfoList *node_list);
 bool		get_child_nodes(PGconn *conn, int node_id, NodeInfoList *node_list);
+bool		update_node_list_attached(PGconn *conn, NodeInfoList *node_list);
 void		get_node_records_by_priority(PGconn *conn, NodeInfoList *node_list);
 bool		get_all_node_records_with_upstream(PGconn *conn, NodeInfoList *node_list);
 bool		get_downstream_nodes_with_missing_slot(PGconn *conn, int this_node_id, NodeInfoList *noede_list);
@@ -514,6 +633,9 @@ bool		update_node_record_slot_name(PGconn *primary_conn, int node_id, char *slot
 bool		witness_copy_node_records(PGconn *primary_conn, PGconn *witness_conn);
 
 void		clear_node_info_list(NodeInfoList *nodes);
+void		set_node_info_list(NodeInfoList *node_list, t_node_info *node_records, int node_count);
+t_node_info *find_node_in_list(NodeInfoList *node_list, int node_id);
+int			get_node_list_position(NodeInfoList *node_list, int node_id);
 
 /* PostgreSQL configuration file location functions */
 bool		get_datadir_configuration_files(PGconn *conn, KeyValueList *list);
@@ -525,7 +647,8 @@ void		config_file_list_add(t_configfile_list *list, const char *file, const char
 bool		create_event_record(PGconn *conn, t_configuration_options *options, int node_id, char *event, bool successful, char *details);
 bool		create_event_notification(PGconn *conn, t_configuration_options *options, int node_id, char *event, bool successful, char *details);
 bool		create_event_notification_extended(PGconn *conn, t_configuration_options *options, int node_id, char *event, bool successful, char *details, t_event_info *event_info);
-PGresult   *get_event_records(PGconn *conn, int node_id, const char *node_name, const char *event, bool all, int limit);
+PGresult   *get_event_records(PGconn *conn, int node_id, const char *node_name, const char *event, bool all, int limit, const char *before, const char *after);
+bool		send_event_records_query(PGconn *conn, int node_id, const char *node_name, const char *event, bool all, int limit, const char *before, const char *after);
 
 /* replication slot functions */
 void		create_slot_name(char *slot_name, int node_id);
@@ -538,6 +661,7 @@ bool		drop_replication_slot_replprot(PGconn *repl_conn, char *slot_name);
 RecordStatus get_slot_record(PGconn *conn, char *slot_name, t_replication_slot *record);
 int			get_free_replication_slot_count(PGconn *conn, int *max_replication_slots);
 int			get_inactive_replication_slots(PGconn *conn, KeyValueList *list);
+int			get_replication_slot_retention(PGconn *conn, t_replication_slot_retention **slots);
 
 /* tablespace functions */
 bool		get_tablespace_name_by_location(PGconn *conn, const char *location, char *name);
@@ -550,25 +674,21 @@ int			wait_connection_availability(PGconn *conn, int timeout);
 bool		is_server_available(const char *conninfo);
 bool		is_server_available_quiet(const char *conninfo);
 bool		is_server_available_params(t_conninfo_param_list *param_list);
+bool		probe_server_available_params(t_conninfo_param_list *param_list, int timeout_ms);
 ExecStatusType	connection_ping(PGconn *conn);
 ExecStatusType	connection_ping_reconnect(PGconn *conn);
 
 /* monitoring functions  */
-void
-add_monitoring_record(PGconn *primary_conn,
-					  PGconn *local_conn,
-					  int primary_node_id,
-					  int local_node_id,
-					  char *monitor_standby_timestamp,
-					  XLogRecPtr primary_last_wal_location,
-					  XLogRecPtr last_wal_receive_lsn,
-					  char *last_xact_replay_timestamp,
-					  long long unsigned int replication_lag_bytes,
-					  long long unsigned int apply_lag_bytes
-);
+bool		add_monitoring_records(PGconn *primary_conn, t_monitoring_record *records, int record_count);
+void		set_standby_last_updated(PGconn *local_conn);
+void		add_monitoring_sample(PGconn *local_conn, t_monitoring_record *record);
+void		set_failover_phase_timing(PGconn *local_conn, const char *phase, int64 duration_us);
 
 int			get_number_of_monitoring_records_to_delete(PGconn *primary_conn, int keep_history, int node_id);
 bool		delete_monitoring_records(PGconn *primary_conn, int keep_history, int node_id);
+bool		is_monitoring_history_partitioned(PGconn *conn);
+int			create_monitoring_history_partitions(PGconn *primary_conn, int days_ahead);
+int			drop_monitoring_history_partitions(PGconn *primary_conn, int keep_history);
 
 
 
@@ -578,8 +698,10 @@ int			get_current_term(PGconn *conn);
 void		increment_current_term(PGconn *conn);
 bool		announce_candidature(PGconn *conn, t_node_info *this_node, t_node_info *other_node, int electoral_term);
 void		notify_follow_primary(PGconn *conn, int primary_node_id);
+int			notify_follow_primary_parallel(NodeInfoList *node_list, int primary_node_id, int timeout);
 bool		get_new_primary(PGconn *conn, int *primary_node_id);
 void		reset_voting_status(PGconn *conn);
+bool		set_prevote(PGconn *conn, int electoral_term, XLogRecPtr lsn, XLogRecPtr replay_lsn, int lag_time);
 
 /* replication status functions */
 XLogRecPtr	get_primary_current_lsn(PGconn *conn);
@@ -587,9 +709,14 @@ XLogRecPtr	get_node_current_lsn(PGconn *conn);
 XLogRecPtr	get_last_wal_receive_location(PGconn *conn);
 void		init_replication_info(ReplInfo *replication_info);
 bool		get_replication_info(PGconn *conn, t_server_type node_type, ReplInfo *replication_info);
+int			get_replication_info_parallel(NodeInfoList *node_list, int timeout);
 int			get_replication_lag_seconds(PGconn *conn);
 TimeLineID	get_node_timeline(PGconn *conn, char *timeline_id_str);
+void		get_node_status_parallel(NodeInfoList *node_list, int timeout);
 void		get_node_replication_stats(PGconn *conn, t_node_info *node_info);
+double		get_node_transfer_rate(PGconn *conn, int sample_size);
+bool		get_node_check_info(PGconn *conn, t_node_info *node_info, t_node_check_info *check_info);
+void		clear_node_check_info(t_node_check_info *check_info);
 NodeAttached is_downstream_node_attached(PGconn *conn, char *node_name);
 void		set_upstream_last_seen(PGconn *conn, int upstream_node_id);
 int			get_upstream_last_seen(PGconn *conn, t_server_type node_type);
@@ -36,16 +36,37 @@
 
 /* #define REPMGR_DEBUG */
 
+/*
+ * Each buffered log record consists of a two-byte header (destination and
+ * syslog priority) followed by the formatted, NUL-terminated message.
+ */
+#define LOG_RECORD_HEADER_LEN 2
+
+#define LOG_DEST_STDERR 'E'
+#define LOG_DEST_SYSLOG 'S'
+
 static int	detect_log_facility(const char *facility);
 static void
 _stderr_log_with_level(const char *level_name, int level, const char *fmt, va_list ap)
 __attribute__((format(PG_PRINTF_ATTRIBUTE, 3, 0)));
+static bool
+_buffer_log_record(char destination, int level, const char *prefix, const char *fmt, va_list ap)
+__attribute__((format(PG_PRINTF_ATTRIBUTE, 4, 0)));
+static bool
+_buffer_log_record_format(char destination, int level, const char *prefix, const char *fmt,...)
+__attribute__((format(PG_PRINTF_ATTRIBUTE, 4, 5)));
+static char *
+format_log_message(const char *fmt, va_list ap)
+__attribute__((format(PG_PRINTF_ATTRIBUTE, 1, 0)));
+static void format_json_log_line(PQExpBufferData *line, const char *level_name, const char *message);
+static const char *get_log_timestamp(void);
 
 int			log_type = REPMGR_STDERR;
 int			log_level = LOG_INFO;
 int			last_log_level = LOG_INFO;
 int			verbose_logging = false;
 int			terse_logging = false;
+LogFormat	log_format = LOG_FORMAT_TEXT;
 
 /*
  * Global variable to be set by the main application to ensure any log output
@@ -53,6 +74,33 @@ int			terse_logging = false;
  */
 int			logger_output_mode = OM_DAEMON;
 
+/*
+ * Optional in-process log buffer; when enabled (currently repmgrd only),
+ * log records are accumulated here and written out by logger_flush(),
+ * which is called at idle points and before any action which must not
+ * be preceded by missing log output.
+ */
+static char *log_buffer = NULL;
+static size_t log_buffer_size = 0;
+static size_t log_buffer_used = 0;
+static bool log_buffer_atexit_registered = false;
+
+/* cached timestamp, reformatted only when the second changes */
+static time_t log_timestamp_time = 0;
+static char log_timestamp_buf[64] = "";
+
+/*
+ * Contextual information included in JSON log records. The node ID is
+ * taken from the configuration; an application can register a hook to
+ * provide further details.
+ */
+static int	log_context_node_id = UNKNOWN_NODE_ID;
+static log_context_hook_type log_context_hook = NULL;
+
+/* phase timing to be attached to the next JSON log record */
+static const char *log_phase_name = NULL;
+static double log_phase_elapsed_ms = 0;
+
 extern void
 stderr_log_with_level(const char *level_name, int level, const char *fmt,...)
 {
@@ -66,8 +114,6 @@ stderr_log_with_level(const char *level_name, int level, const char *fmt,...)
 static void
 _stderr_log_with_level(const char *level_name, int level, const char *fmt, va_list ap)
 {
-	char		buf[100];
-
 	/*
 	 * Store the requested level so that if there's a subsequent log_hint() or
 	 * log_detail(), we can suppress that if --terse was specified,
@@ -76,29 +122,337 @@ _stderr_log_with_level(const char *level_name, int level, const char *fmt, va_li
 
 	if (log_level >= level)
 	{
+		char		prefix[128];
+
+		if (log_format == LOG_FORMAT_JSON)
+		{
+			PQExpBufferData line;
+			char	   *message = format_log_message(fmt, ap);
+
+			initPQExpBuffer(&line);
+			format_json_log_line(&line, level_name, message);
+			pfree(message);
+
+			if (log_buffer == NULL ||
+				_buffer_log_record_format(LOG_DEST_STDERR, level, "", "%s", line.data) == false)
+			{
+				fputs(line.data, stderr);
+				fprintf(stderr, "\n");
+				fflush(stderr);
+			}
+
+			termPQExpBuffer(&line);
+			return;
+		}
+
+		/* any phase timing is only reported in JSON format */
+		log_phase_name = NULL;
 
 		/* Format log line prefix with timestamp if in daemon mode */
 		if (logger_output_mode == OM_DAEMON)
 		{
-			time_t		t;
-			struct tm  *tm;
-
-			time(&t);
-			tm = localtime(&t);
-			strftime(buf, sizeof(buf), "[%Y-%m-%d %H:%M:%S]", tm);
-			fprintf(stderr, "%s [%s] ", buf, level_name);
+			snprintf(prefix, sizeof(prefix), "[%s] [%s] ",
+					 get_log_timestamp(), level_name);
 		}
 		else
 		{
-			fprintf(stderr, "%s: ", level_name);
+			snprintf(prefix, sizeof(prefix), "%s: ", level_name);
 		}
 
+		if (log_buffer != NULL &&
+			_buffer_log_record(LOG_DEST_STDERR, level, prefix, fmt, ap) == true)
+			return;
+
+		fputs(prefix, stderr);
 		vfprintf(stderr, fmt, ap);
 		fprintf(stderr, "\n");
 		fflush(stderr);
 	}
 }
 
+
+#ifdef HAVE_SYSLOG
+extern void
+syslog_log_with_level(int level, const char *fmt,...)
+{
+	va_list		arglist;
+
+	va_start(arglist, fmt);
+
+	if (log_buffer == NULL ||
+		_buffer_log_record(LOG_DEST_SYSLOG, level, "", fmt, arglist) == false)
+	{
+		/* ensure buffered records are not overtaken */
+		logger_flush();
+		vsyslog(level, fmt, arglist);
+	}
+
+	va_end(arglist);
+}
+#endif
+
+
+/*
+ * Format a JSON log record, e.g.:
+ *
+ *   {"time":"2020-06-01 12:00:00","monotonic_us":123456789,"level":"INFO",
+ *    "node_id":2,"monitoring_state":"normal","electoral_term":3,
+ *    "message":"..."}
+ *
+ * "phase" and "elapsed_ms" are included if set with logger_set_phase_timing().
+ */
+static void
+format_json_log_line(PQExpBufferData *line, const char *level_name, const char *message)
+{
+	struct timespec ts;
+	t_log_context context;
+
+	context.node_id = log_context_node_id;
+	context.monitoring_state = NULL;
+	context.electoral_term = -1;
+
+	if (log_context_hook != NULL)
+		(*log_context_hook) (&context);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	appendPQExpBufferStr(line, "{\"time\":");
+	append_json_string(line, get_log_timestamp());
+
+	appendPQExpBuffer(line, ",\"monotonic_us\":%lld",
+					  (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+
+	appendPQExpBufferStr(line, ",\"level\":");
+	append_json_string(line, level_name);
+
+	if (context.node_id != UNKNOWN_NODE_ID)
+		appendPQExpBuffer(line, ",\"node_id\":%i", context.node_id);
+
+	if (context.monitoring_state != NULL)
+	{
+		appendPQExpBufferStr(line, ",\"monitoring_state\":");
+		append_json_string(line, context.monitoring_state);
+	}
+
+	if (context.electoral_term >= 0)
+		appendPQExpBuffer(line, ",\"electoral_term\":%i", context.electoral_term);
+
+	if (log_phase_name != NULL)
+	{
+		appendPQExpBufferStr(line, ",\"phase\":");
+		append_json_string(line, log_phase_name);
+		appendPQExpBuffer(line, ",\"elapsed_ms\":%.3f", log_phase_elapsed_ms);
+
+		log_phase_name = NULL;
+	}
+
+	appendPQExpBufferStr(line, ",\"message\":");
+	append_json_string(line, message);
+	appendPQExpBufferChar(line, '}');
+}
+
+
+/*
+ * Format a log message into a palloc'd string.
+ */
+static char *
+format_log_message(const char *fmt, va_list ap)
+{
+	size_t		len = 256;
+
+	for (;;)
+	{
+		char	   *message = pg_malloc(len);
+		va_list		ap_copy;
+		int			n;
+
+		va_copy(ap_copy, ap);
+		n = vsnprintf(message, len, fmt, ap_copy);
+		va_end(ap_copy);
+
+		if (n >= 0 && (size_t) n < len)
+			return message;
+
+		pfree(message);
+		len = (n >= 0) ? (size_t) n + 1 : len * 2;
+	}
+}
+
+
+/*
+ * Return the "YYYY-MM-DD HH:MM:SS" log line timestamp; localtime() and
+ * strftime() are only called when the current second has changed since
+ * the timestamp was last formatted.
+ */
+static const char *
+get_log_timestamp(void)
+{
+	time_t		t;
+
+	time(&t);
+
+	if (t != log_timestamp_time || log_timestamp_buf[0] == '\0')
+	{
+		struct tm  *tm = localtime(&t);
+
+		strftime(log_timestamp_buf, sizeof(log_timestamp_buf), "%Y-%m-%d %H:%M:%S", tm);
+		log_timestamp_time = t;
+	}
+
+	return log_timestamp_buf;
+}
+
+
+/*
+ * Append a formatted record to the log buffer, flushing the buffer first
+ * if there is insufficient space.
+ *
+ * Records with level ERROR or more severe are written out immediately,
+ * together with any preceding buffered records.
+ *
+ * Returns false if the record could not be buffered (i.e. it is larger
+ * than the buffer itself); the caller must then write it out directly.
+ */
+static bool
+_buffer_log_record(char destination, int level, const char *prefix, const char *fmt, va_list ap)
+{
+	int			attempt;
+	size_t		prefix_len = strlen(prefix);
+
+	for (attempt = 0; attempt < 2; attempt++)
+	{
+		size_t		available = log_buffer_size - log_buffer_used;
+		char	   *record = log_buffer + log_buffer_used;
+		va_list		ap_copy;
+		int			message_len;
+
+		if (available > LOG_RECORD_HEADER_LEN + prefix_len + 1)
+		{
+			va_copy(ap_copy, ap);
+			message_len = vsnprintf(record + LOG_RECORD_HEADER_LEN + prefix_len,
+									available - LOG_RECORD_HEADER_LEN - prefix_len,
+									fmt, ap_copy);
+			va_end(ap_copy);
+
+			if (message_len >= 0 &&
+				(size_t) message_len < available - LOG_RECORD_HEADER_LEN - prefix_len)
+			{
+				record[0] = destination;
+				record[1] = (char) level;
+				memcpy(record + LOG_RECORD_HEADER_LEN, prefix, prefix_len);
+
+				log_buffer_used += LOG_RECORD_HEADER_LEN + prefix_len + message_len + 1;
+
+				if (level <= LOG_ERROR)
+					logger_flush();
+
+				return true;
+			}
+
+			/* record cannot fit even in an empty buffer */
+			if (message_len < 0 || log_buffer_used == 0)
+				break;
+		}
+
+		logger_flush();
+	}
+
+	return false;
+}
+
+
+static bool
+_buffer_log_record_format(char destination, int level, const char *prefix, const char *fmt,...)
+{
+	va_list		arglist;
+	bool		buffered;
+
+	va_start(arglist, fmt);
+	buffered = _buffer_log_record(destination, level, prefix, fmt, arglist);
+	va_end(arglist);
+
+	return buffered;
+}
+
+
+/*
+ * Write out any buffered log records. This is a no-op if log buffering
+ * is not enabled.
+ */
+void
+logger_flush(void)
+{
+	size_t		pos = 0;
+	bool		stderr_written = false;
+
+	if (log_buffer == NULL || log_buffer_used == 0)
+		return;
+
+	while (pos < log_buffer_used)
+	{
+		char		destination = log_buffer[pos];
+		const char *message = log_buffer + pos + LOG_RECORD_HEADER_LEN;
+
+#ifdef HAVE_SYSLOG
+		if (destination == LOG_DEST_SYSLOG)
+		{
+			syslog((int) log_buffer[pos + 1], "%s", message);
+		}
+		else
+#endif
+		{
+			fputs(message, stderr);
+			fputc('\n', stderr);
+			stderr_written = true;
+		}
+
+		pos += LOG_RECORD_HEADER_LEN + strlen(message) + 1;
+	}
+
+	log_buffer_used = 0;
+
+	if (stderr_written == true)
+		fflush(stderr);
+}
+
+
+/*
+ * Enable log buffering with a buffer of the specified size (in kilobytes),
+ * or disable it if "size_kb" is 0. Any records in an existing buffer are
+ * written out first.
+ */
+void
+logger_set_buffer_size(int size_kb)
+{
+	size_t		new_size = (size_t) size_kb * 1024;
+
+	if (new_size == log_buffer_size)
+		return;
+
+	logger_flush();
+
+	if (log_buffer != NULL)
+	{
+		pfree(log_buffer);
+		log_buffer = NULL;
+		log_buffer_size = 0;
+	}
+
+	if (new_size == 0)
+		return;
+
+	log_buffer = pg_malloc(new_size);
+	log_buffer_size = new_size;
+	log_buffer_used = 0;
+
+	/* ensure nothing is lost when exit() is called from anywhere */
+	if (log_buffer_atexit_registered == false)
+	{
+		atexit(logger_flush);
+		log_buffer_atexit_registered = true;
+	}
+}
+
 void
 log_hint(const char *fmt,...)
 {
@@ -191,6 +545,9 @@ logger_init(t_configuration_options *opts, const char *ident)
 		ident = DEFAULT_IDENT;
 	}
 
+	log_format = opts->log_format;
+	log_context_node_id = opts->node_id;
+
 	if (level && *level)
 	{
 		l = detect_log_level(level);
@@ -293,6 +650,8 @@ logger_init(t_configuration_options *opts, const char *ident)
 bool
 logger_shutdown(void)
 {
+	logger_flush();
+
 #ifdef HAVE_SYSLOG
 	if (log_type == REPMGR_SYSLOG)
 		closelog();
@@ -329,6 +688,35 @@ logger_set_terse(void)
 }
 
 
+/*
+ * Register a function to provide additional context for JSON log records.
+ */
+void
+logger_set_context_hook(log_context_hook_type hook)
+{
+	log_context_hook = hook;
+}
+
+
+/*
+ * Attach the name and duration of an operational phase (e.g. a failover
+ * phase) to the next log record emitted in JSON format.
+ */
+void
+logger_set_phase_timing(const char *phase, double elapsed_ms)
+{
+	log_phase_name = phase;
+	log_phase_elapsed_ms = elapsed_ms;
+}
+
+
+void
+logger_set_format(LogFormat new_log_format)
+{
+	log_format = new_log_format;
+}
+
+
 void
 logger_set_level(int new_log_level)
 {
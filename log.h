@@ -33,6 +33,19 @@ extern void
 stderr_log_with_level(const char *level_name, int level, const char *fmt,...)
 __attribute__((format(PG_PRINTF_ATTRIBUTE, 3, 4)));
 
+#define DEFAULT_LOG_BUFFER_SIZE 0
+#define DEFAULT_LOG_FORMAT LOG_FORMAT_TEXT
+
+/* additional context included in JSON log records */
+typedef struct
+{
+	int			node_id;
+	const char *monitoring_state;
+	int			electoral_term;
+} t_log_context;
+
+typedef void (*log_context_hook_type) (t_log_context *context);
+
 #define LOG_EMERG	0			/* system is unusable */
 #define LOG_ALERT	1			/* action must be taken immediately */
 #define LOG_CRIT	2			/* critical conditions */
@@ -57,51 +70,55 @@ __attribute__((format(PG_PRINTF_ATTRIBUTE, 3, 4)));
 
 #include <syslog.h>
 
+extern void
+syslog_log_with_level(int level, const char *fmt,...)
+__attribute__((format(PG_PRINTF_ATTRIBUTE, 2, 3)));
+
 #define log_debug(...) \
 	if (log_type == REPMGR_SYSLOG) \
-		syslog(LOG_DEBUG, __VA_ARGS__); \
+		syslog_log_with_level(LOG_DEBUG, __VA_ARGS__); \
 	else \
 		stderr_log_debug(__VA_ARGS__);
 
 #define log_info(...) \
 	{ \
-		if (log_type == REPMGR_SYSLOG) syslog(LOG_INFO, __VA_ARGS__); \
+		if (log_type == REPMGR_SYSLOG) syslog_log_with_level(LOG_INFO, __VA_ARGS__); \
 		else stderr_log_info(__VA_ARGS__); \
 	}
 
 #define log_notice(...) \
 	{ \
-		if (log_type == REPMGR_SYSLOG) syslog(LOG_NOTICE, __VA_ARGS__); \
+		if (log_type == REPMGR_SYSLOG) syslog_log_with_level(LOG_NOTICE, __VA_ARGS__); \
 		else stderr_log_notice(__VA_ARGS__); \
 	}
 
 #define log_warning(...) \
 	{ \
-		if (log_type == REPMGR_SYSLOG) syslog(LOG_WARNING, __VA_ARGS__); \
+		if (log_type == REPMGR_SYSLOG) syslog_log_with_level(LOG_WARNING, __VA_ARGS__); \
 		else stderr_log_warning(__VA_ARGS__); \
 	}
 
 #define log_error(...) \
 	{ \
-		if (log_type == REPMGR_SYSLOG) syslog(LOG_ERROR, __VA_ARGS__); \
+		if (log_type == REPMGR_SYSLOG) syslog_log_with_level(LOG_ERROR, __VA_ARGS__); \
 		else stderr_log_error(__VA_ARGS__); \
 	}
 
 #define log_crit(...) \
 	{ \
-		if (log_type == REPMGR_SYSLOG) syslog(LOG_CRIT, __VA_ARGS__); \
+		if (log_type == REPMGR_SYSLOG) syslog_log_with_level(LOG_CRIT, __VA_ARGS__); \
 		else stderr_log_crit(__VA_ARGS__); \
 	}
 
 #define log_alert(...) \
 	{ \
-		if (log_type == REPMGR_SYSLOG) syslog(LOG_ALERT, __VA_ARGS__); \
+		if (log_type == REPMGR_SYSLOG) syslog_log_with_level(LOG_ALERT, __VA_ARGS__); \
 		else stderr_log_alert(__VA_ARGS__); \
 	}
 
 #define log_emerg(...) \
 	{ \
-		if (log_type == REPMGR_SYSLOG) syslog(LOG_ALERT, __VA_ARGS__); \
+		if (log_type == REPMGR_SYSLOG) syslog_log_with_level(LOG_ALERT, __VA_ARGS__); \
 		else stderr_log_alert(__VA_ARGS__); \
 	}
 #else
@@ -130,6 +147,11 @@ void		logger_set_verbose(void);
 void		logger_set_terse(void);
 void		logger_set_min_level(int min_log_level);
 void		logger_set_level(int new_log_level);
+void		logger_set_format(LogFormat new_log_format);
+void		logger_set_buffer_size(int size_kb);
+void		logger_set_context_hook(log_context_hook_type hook);
+void		logger_set_phase_timing(const char *phase, double elapsed_ms);
+void		logger_flush(void);
 
 void
 log_detail(const char *fmt,...)
@@ -146,5 +168,6 @@ extern int	log_level;
 extern int	verbose_logging;
 extern int	terse_logging;
 extern int	logger_output_mode;
+extern LogFormat log_format;
 
 #endif							/* _REPMGR_LOG_H_ */
@@ -0,0 +1,271 @@
+/*
+ * memarena.c
+ *
+ * Simple arena allocator for short-lived allocations.
+ *
+ * repmgrd allocates and frees a steady stream of small objects (list cells,
+ * scratch arrays used by the parallel query helpers etc.) on each monitoring
+ * cycle. Rather than passing each of these through malloc()/free(), callers
+ * can make an arena "current" with memory_arena_switch_to(); arena_alloc0()
+ * then carves allocations out of the arena's blocks, arena_free() becomes
+ * a no-op for them, and the whole arena is released in one go with
+ * memory_arena_reset(), e.g. at the end of each monitoring cycle.
+ *
+ * If no arena is current, arena_alloc0() and arena_free() fall back to
+ * pg_malloc0() and pfree(), so code using them works unchanged in the
+ * repmgr client, which does not use arenas.
+ *
+ * Copyright (c) 2ndQuadrant, 2010-2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "repmgr.h"
+#include "memarena.h"
+
+typedef struct MemoryArenaBlock
+{
+	struct MemoryArenaBlock *next;
+	Size		size;			/* usable bytes following the block header */
+	Size		used;
+} MemoryArenaBlock;
+
+#define ARENA_BLOCK_HEADER_SIZE MAXALIGN(sizeof(MemoryArenaBlock))
+#define ARENA_BLOCK_DATA(block) ((char *) (block) + ARENA_BLOCK_HEADER_SIZE)
+
+/*
+ * Each allocation returned by arena_alloc0() is preceded by a chunk header
+ * recording which arena (if any) it came from, so arena_free() can tell
+ * heap allocations from arena allocations regardless of which arena is
+ * current when it is called.
+ */
+typedef struct MemoryArenaChunk
+{
+	MemoryArena *arena;
+} MemoryArenaChunk;
+
+#define ARENA_CHUNK_HEADER_SIZE MAXALIGN(sizeof(MemoryArenaChunk))
+
+struct MemoryArena
+{
+	const char *name;
+	/* most recently allocated block first */
+	MemoryArenaBlock *blocks;
+	Size		next_block_size;
+
+	/* instrumentation since the last reset */
+	int			alloc_count;
+	Size		alloc_bytes;
+	int			block_count;
+	Size		block_bytes;
+};
+
+static MemoryArena *current_arena = NULL;
+
+static MemoryArenaBlock *_memory_arena_add_block(MemoryArena *arena, Size min_size);
+static void _memory_arena_free_blocks(MemoryArena *arena);
+
+
+/*
+ * Create an arena whose first block has "block_size" usable bytes; "name"
+ * must have static storage and is used for instrumentation output only.
+ */
+MemoryArena *
+memory_arena_create(const char *name, Size block_size)
+{
+	MemoryArena *arena = pg_malloc0(sizeof(MemoryArena));
+
+	arena->name = name;
+	arena->next_block_size = MAXALIGN(block_size);
+
+	(void) _memory_arena_add_block(arena, arena->next_block_size);
+
+	return arena;
+}
+
+
+void
+memory_arena_destroy(MemoryArena *arena)
+{
+	if (arena == NULL)
+		return;
+
+	if (current_arena == arena)
+		current_arena = NULL;
+
+	_memory_arena_free_blocks(arena);
+	pfree(arena);
+}
+
+
+/*
+ * Release everything allocated from the arena since the last reset.
+ *
+ * The arena keeps a single block sized to hold everything allocated in the
+ * preceding cycle (capped at MEMORY_ARENA_MAX_BLOCK_SIZE), so a steady-state
+ * cycle is served from one block without further calls to malloc().
+ */
+void
+memory_arena_reset(MemoryArena *arena)
+{
+	Size		keep_size;
+
+	if (arena == NULL)
+		return;
+
+	if (arena->alloc_count > 0)
+	{
+		log_verbose(LOG_DEBUG, "memory arena \"%s\": %i allocation(s) totalling %lu bytes in %i block(s) of %lu bytes",
+					arena->name,
+					arena->alloc_count,
+					(unsigned long) arena->alloc_bytes,
+					arena->block_count,
+					(unsigned long) arena->block_bytes);
+	}
+
+	if (arena->block_count == 1)
+	{
+		arena->blocks->used = 0;
+	}
+	else
+	{
+		keep_size = Min(MAXALIGN(arena->alloc_bytes), MEMORY_ARENA_MAX_BLOCK_SIZE);
+
+		if (keep_size < arena->blocks->size)
+			keep_size = arena->blocks->size;
+
+		_memory_arena_free_blocks(arena);
+
+		arena->next_block_size = keep_size;
+		(void) _memory_arena_add_block(arena, keep_size);
+	}
+
+	arena->alloc_count = 0;
+	arena->alloc_bytes = 0;
+}
+
+
+/*
+ * Make "arena" the target of subsequent arena_alloc0() calls (NULL to
+ * allocate from the heap); returns the previously current arena.
+ */
+MemoryArena *
+memory_arena_switch_to(MemoryArena *arena)
+{
+	MemoryArena *old_arena = current_arena;
+
+	current_arena = arena;
+
+	return old_arena;
+}
+
+
+/*
+ * Allocate "size" zeroed bytes from the current arena, or from the heap if
+ * no arena is current. The result must be released with arena_free(),
+ * not pfree().
+ */
+void *
+arena_alloc0(Size size)
+{
+	MemoryArenaChunk *chunk = NULL;
+	Size		chunk_size = ARENA_CHUNK_HEADER_SIZE + MAXALIGN(size);
+
+	if (current_arena == NULL)
+	{
+		chunk = pg_malloc0(chunk_size);
+	}
+	else
+	{
+		MemoryArenaBlock *block = current_arena->blocks;
+
+		if (block->size - block->used < chunk_size)
+			block = _memory_arena_add_block(current_arena, chunk_size);
+
+		chunk = (MemoryArenaChunk *) (ARENA_BLOCK_DATA(block) + block->used);
+		block->used += chunk_size;
+
+		memset(chunk, 0, chunk_size);
+		chunk->arena = current_arena;
+
+		current_arena->alloc_count++;
+		current_arena->alloc_bytes += chunk_size;
+	}
+
+	return (char *) chunk + ARENA_CHUNK_HEADER_SIZE;
+}
+
+
+/*
+ * Free an allocation made by arena_alloc0(); allocations made from an arena
+ * are reclaimed when the arena is reset.
+ */
+void
+arena_free(void *ptr)
+{
+	MemoryArenaChunk *chunk = NULL;
+
+	if (ptr == NULL)
+		return;
+
+	chunk = (MemoryArenaChunk *) ((char *) ptr - ARENA_CHUNK_HEADER_SIZE);
+
+	if (chunk->arena == NULL)
+		pfree(chunk);
+}
+
+
+static MemoryArenaBlock *
+_memory_arena_add_block(MemoryArena *arena, Size min_size)
+{
+	MemoryArenaBlock *block = NULL;
+	Size		block_size = arena->next_block_size;
+
+	if (block_size < min_size)
+		block_size = min_size;
+
+	block = pg_malloc(ARENA_BLOCK_HEADER_SIZE + block_size);
+	block->size = block_size;
+	block->used = 0;
+	block->next = arena->blocks;
+	arena->blocks = block;
+
+	arena->block_count++;
+	arena->block_bytes += block_size;
+
+	/* double the size of subsequent blocks, up to the maximum */
+	if (arena->next_block_size < MEMORY_ARENA_MAX_BLOCK_SIZE)
+		arena->next_block_size = Min(arena->next_block_size * 2, MEMORY_ARENA_MAX_BLOCK_SIZE);
+
+	return block;
+}
+
+
+static void
+_memory_arena_free_blocks(MemoryArena *arena)
+{
+	MemoryArenaBlock *block = arena->blocks;
+
+	while (block != NULL)
+	{
+		MemoryArenaBlock *next_block = block->next;
+
+		pfree(block);
+		block = next_block;
+	}
+
+	arena->blocks = NULL;
+	arena->block_count = 0;
+	arena->block_bytes = 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * memarena.h
+ * Copyright (c) 2ndQuadrant, 2010-2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MEMARENA_H_
+#define _MEMARENA_H_
+
+#define MEMORY_ARENA_DEFAULT_BLOCK_SIZE (8 * 1024)
+#define MEMORY_ARENA_MAX_BLOCK_SIZE (1024 * 1024)
+
+typedef struct MemoryArena MemoryArena;
+
+extern MemoryArena *memory_arena_create(const char *name, Size block_size);
+extern void memory_arena_destroy(MemoryArena *arena);
+extern void memory_arena_reset(MemoryArena *arena);
+extern MemoryArena *memory_arena_switch_to(MemoryArena *arena);
+
+extern void *arena_alloc0(Size size);
+extern void arena_free(void *ptr);
+
+#endif							/* _MEMARENA_H_ */
@@ -1,2 +1,407 @@
 -- complain if script is sourced in psql, rather than via CREATE EXTENSION
 \echo Use "CREATE EXTENSION repmgr" to load this file. \quit
+
+DO $repmgr$
+DECLARE
+  DECLARE server_version_num INT;
+BEGIN
+  SELECT setting
+    FROM pg_catalog.pg_settings
+   WHERE name = 'server_version_num'
+    INTO server_version_num;
+  /* no PG_LSN datatype in 9.3 */
+  IF server_version_num >= 90400 THEN
+    EXECUTE $repmgr_func$
+CREATE FUNCTION get_election_status(
+  OUT repmgrd_pid INT,
+  OUT repmgrd_paused BOOL,
+  OUT upstream_node_id INT,
+  OUT upstream_last_seen INT,
+  OUT voting_status INT,
+  OUT current_electoral_term INT,
+  OUT prevote_term INT,
+  OUT prevote_lsn PG_LSN,
+  OUT prevote_replay_lsn PG_LSN,
+  OUT prevote_lag_time INT)
+  RETURNS RECORD
+  AS 'MODULE_PATHNAME', 'get_election_status'
+  LANGUAGE C STRICT
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+CREATE FUNCTION get_repmgrd_state(
+  OUT local_node_id INT,
+  OUT repmgrd_pid INT,
+  OUT repmgrd_pidfile TEXT,
+  OUT repmgrd_running BOOL,
+  OUT repmgrd_paused BOOL,
+  OUT upstream_node_id INT,
+  OUT upstream_last_seen INT,
+  OUT voting_status INT,
+  OUT current_electoral_term INT,
+  OUT candidate_node_id INT,
+  OUT follow_new_primary BOOL,
+  OUT last_updated TIMESTAMP WITH TIME ZONE,
+  OUT prevote_term INT,
+  OUT prevote_lsn PG_LSN,
+  OUT prevote_replay_lsn PG_LSN,
+  OUT prevote_lag_time INT)
+  RETURNS RECORD
+  AS 'MODULE_PATHNAME', 'get_repmgrd_state'
+  LANGUAGE C STRICT
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+CREATE FUNCTION set_prevote(INT, PG_LSN, PG_LSN, INT)
+  RETURNS VOID
+  AS 'MODULE_PATHNAME', 'set_prevote'
+  LANGUAGE C STRICT
+    $repmgr_func$;
+  ELSE
+    EXECUTE $repmgr_func$
+CREATE FUNCTION get_election_status(
+  OUT repmgrd_pid INT,
+  OUT repmgrd_paused BOOL,
+  OUT upstream_node_id INT,
+  OUT upstream_last_seen INT,
+  OUT voting_status INT,
+  OUT current_electoral_term INT,
+  OUT prevote_term INT,
+  OUT prevote_lsn TEXT,
+  OUT prevote_replay_lsn TEXT,
+  OUT prevote_lag_time INT)
+  RETURNS RECORD
+  AS 'MODULE_PATHNAME', 'get_election_status'
+  LANGUAGE C STRICT
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+CREATE FUNCTION get_repmgrd_state(
+  OUT local_node_id INT,
+  OUT repmgrd_pid INT,
+  OUT repmgrd_pidfile TEXT,
+  OUT repmgrd_running BOOL,
+  OUT repmgrd_paused BOOL,
+  OUT upstream_node_id INT,
+  OUT upstream_last_seen INT,
+  OUT voting_status INT,
+  OUT current_electoral_term INT,
+  OUT candidate_node_id INT,
+  OUT follow_new_primary BOOL,
+  OUT last_updated TIMESTAMP WITH TIME ZONE,
+  OUT prevote_term INT,
+  OUT prevote_lsn TEXT,
+  OUT prevote_replay_lsn TEXT,
+  OUT prevote_lag_time INT)
+  RETURNS RECORD
+  AS 'MODULE_PATHNAME', 'get_repmgrd_state'
+  LANGUAGE C STRICT
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+CREATE FUNCTION set_prevote(INT, TEXT, TEXT, INT)
+  RETURNS VOID
+  AS 'MODULE_PATHNAME', 'set_prevote'
+  LANGUAGE C STRICT
+    $repmgr_func$;
+  END IF;
+END$repmgr$;
+
+DO $repmgr$
+DECLARE
+  DECLARE server_version_num INT;
+BEGIN
+  SELECT setting
+    FROM pg_catalog.pg_settings
+   WHERE name = 'server_version_num'
+    INTO server_version_num;
+  /* no PG_LSN datatype in 9.3 */
+  IF server_version_num >= 90400 THEN
+    EXECUTE $repmgr_func$
+CREATE FUNCTION add_monitoring_sample(
+  primary_node_id INT,
+  last_wal_primary_location PG_LSN,
+  last_wal_standby_location PG_LSN,
+  last_apply_time TIMESTAMP WITH TIME ZONE,
+  replication_lag BIGINT,
+  apply_lag BIGINT)
+  RETURNS VOID
+  AS 'MODULE_PATHNAME', 'add_monitoring_sample'
+  LANGUAGE C CALLED ON NULL INPUT
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+CREATE FUNCTION get_recent_monitoring(
+  OUT sample_time TIMESTAMP WITH TIME ZONE,
+  OUT primary_node_id INT,
+  OUT last_wal_primary_location PG_LSN,
+  OUT last_wal_standby_location PG_LSN,
+  OUT last_apply_time TIMESTAMP WITH TIME ZONE,
+  OUT replication_lag BIGINT,
+  OUT apply_lag BIGINT,
+  OUT apply_time_lag DOUBLE PRECISION)
+  RETURNS SETOF RECORD
+  AS 'MODULE_PATHNAME', 'get_recent_monitoring'
+  LANGUAGE C STRICT
+    $repmgr_func$;
+  ELSE
+    EXECUTE $repmgr_func$
+CREATE FUNCTION add_monitoring_sample(
+  primary_node_id INT,
+  last_wal_primary_location TEXT,
+  last_wal_standby_location TEXT,
+  last_apply_time TIMESTAMP WITH TIME ZONE,
+  replication_lag BIGINT,
+  apply_lag BIGINT)
+  RETURNS VOID
+  AS 'MODULE_PATHNAME', 'add_monitoring_sample'
+  LANGUAGE C CALLED ON NULL INPUT
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+CREATE FUNCTION get_recent_monitoring(
+  OUT sample_time TIMESTAMP WITH TIME ZONE,
+  OUT primary_node_id INT,
+  OUT last_wal_primary_location TEXT,
+  OUT last_wal_standby_location TEXT,
+  OUT last_apply_time TIMESTAMP WITH TIME ZONE,
+  OUT replication_lag BIGINT,
+  OUT apply_lag BIGINT,
+  OUT apply_time_lag DOUBLE PRECISION)
+  RETURNS SETOF RECORD
+  AS 'MODULE_PATHNAME', 'get_recent_monitoring'
+  LANGUAGE C STRICT
+    $repmgr_func$;
+  END IF;
+END$repmgr$;
+
+CREATE FUNCTION set_failover_phase_timing(
+  phase TEXT,
+  duration_us BIGINT)
+  RETURNS VOID
+  AS 'MODULE_PATHNAME', 'set_failover_phase_timing'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION get_failover_phase_timings(
+  OUT phase TEXT,
+  OUT last_recorded TIMESTAMP WITH TIME ZONE,
+  OUT last_duration_us BIGINT,
+  OUT count BIGINT,
+  OUT total_us BIGINT,
+  OUT max_us BIGINT)
+  RETURNS SETOF RECORD
+  AS 'MODULE_PATHNAME', 'get_failover_phase_timings'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION get_failover_phase_histogram(
+  OUT phase TEXT,
+  OUT bucket_le_ms BIGINT,
+  OUT count BIGINT)
+  RETURNS SETOF RECORD
+  AS 'MODULE_PATHNAME', 'get_failover_phase_histogram'
+  LANGUAGE C STRICT;
+
+/* notify repmgrd of changes to node records */
+
+CREATE FUNCTION notify_nodes_changed()
+  RETURNS TRIGGER
+  AS $repmgr_func$
+BEGIN
+  /* TRUNCATE: all records have changed */
+  IF TG_LEVEL = 'STATEMENT' THEN
+    PERFORM pg_catalog.pg_notify('repmgr_nodes_changed', '');
+    RETURN NULL;
+  END IF;
+
+  IF TG_OP IN ('UPDATE', 'DELETE') THEN
+    PERFORM pg_catalog.pg_notify('repmgr_nodes_changed', OLD.node_id::TEXT);
+  END IF;
+
+  IF TG_OP IN ('INSERT', 'UPDATE') THEN
+    PERFORM pg_catalog.pg_notify('repmgr_nodes_changed', NEW.node_id::TEXT);
+  END IF;
+
+  RETURN NULL;
+END
+$repmgr_func$
+  LANGUAGE plpgsql;
+
+CREATE TRIGGER nodes_changed
+  AFTER INSERT OR UPDATE OR DELETE ON repmgr.nodes
+  FOR EACH ROW EXECUTE PROCEDURE repmgr.notify_nodes_changed();
+
+CREATE TRIGGER nodes_truncated
+  AFTER TRUNCATE ON repmgr.nodes
+  FOR EACH STATEMENT EXECUTE PROCEDURE repmgr.notify_nodes_changed();
+
+CREATE INDEX idx_events_node_id_timestamp
+          ON repmgr.events (node_id, event_timestamp);
+
+CREATE INDEX idx_events_event_timestamp
+          ON repmgr.events (event, event_timestamp);
+
+/* monitoring history partition maintenance functions */
+
+CREATE FUNCTION create_monitoring_history_partitions(days_ahead INT)
+  RETURNS INT
+  AS $repmgr_func$
+DECLARE
+  partition_date DATE;
+  partition_name TEXT;
+  partitions_created INT := 0;
+  legacy_upper_bound TIMESTAMP WITH TIME ZONE;
+BEGIN
+  IF NOT EXISTS (SELECT 1
+                   FROM pg_catalog.pg_class
+                  WHERE oid = 'repmgr.monitoring_history'::pg_catalog.regclass
+                    AND relkind = 'p') THEN
+    RETURN 0;
+  END IF;
+
+  /* prevent concurrent invocations from attempting to create the same partition */
+  PERFORM pg_catalog.pg_advisory_xact_lock('repmgr.monitoring_history'::pg_catalog.regclass::pg_catalog.oid::BIGINT);
+
+  /*
+   * If the table was converted to a partitioned table on upgrade, the
+   * records which existed at the time are in "monitoring_history_legacy";
+   * daily partitions start after its range.
+   */
+  SELECT pg_catalog.substring(pg_catalog.pg_get_expr(c.relpartbound, c.oid) FROM ' TO \(''([^'']+)''\)$')::TIMESTAMP WITH TIME ZONE
+    INTO legacy_upper_bound
+    FROM pg_catalog.pg_inherits i
+INNER JOIN pg_catalog.pg_class c
+        ON c.oid = i.inhrelid
+   WHERE i.inhparent = 'repmgr.monitoring_history'::pg_catalog.regclass
+     AND c.relname = 'monitoring_history_legacy';
+
+  FOR i IN 0..days_ahead LOOP
+    partition_date := CURRENT_DATE + i;
+    partition_name := 'monitoring_history_' || pg_catalog.to_char(partition_date, 'YYYYMMDD');
+
+    CONTINUE WHEN legacy_upper_bound IS NOT NULL
+              AND partition_date::TIMESTAMP WITH TIME ZONE < legacy_upper_bound;
+
+    CONTINUE WHEN EXISTS (SELECT 1
+                            FROM pg_catalog.pg_class c
+                      INNER JOIN pg_catalog.pg_namespace n
+                              ON n.oid = c.relnamespace
+                           WHERE n.nspname = 'repmgr'
+                             AND c.relname = partition_name);
+
+    BEGIN
+      EXECUTE pg_catalog.format(
+        'CREATE TABLE repmgr.%I PARTITION OF repmgr.monitoring_history FOR VALUES FROM (%L) TO (%L)',
+        partition_name,
+        partition_date::TIMESTAMP WITH TIME ZONE,
+        (partition_date + 1)::TIMESTAMP WITH TIME ZONE);
+      partitions_created := partitions_created + 1;
+    EXCEPTION
+      /* default partition already contains rows for this range */
+      WHEN check_violation THEN
+        RAISE NOTICE 'unable to create partition "%"', partition_name
+          USING DETAIL = SQLERRM;
+      /* range is covered by another partition */
+      WHEN invalid_object_definition THEN
+        RAISE NOTICE 'unable to create partition "%"', partition_name
+          USING DETAIL = SQLERRM;
+    END;
+  END LOOP;
+
+  RETURN partitions_created;
+END
+$repmgr_func$
+  LANGUAGE plpgsql STRICT;
+
+CREATE FUNCTION drop_monitoring_history_partitions(keep_days INT)
+  RETURNS INT
+  AS $repmgr_func$
+DECLARE
+  partition_rec RECORD;
+  upper_bound TIMESTAMP WITH TIME ZONE;
+  partitions_dropped INT := 0;
+BEGIN
+  IF NOT EXISTS (SELECT 1
+                   FROM pg_catalog.pg_class
+                  WHERE oid = 'repmgr.monitoring_history'::pg_catalog.regclass
+                    AND relkind = 'p') THEN
+    RETURN 0;
+  END IF;
+
+  FOR partition_rec IN
+    SELECT c.oid::pg_catalog.regclass AS partition_name,
+           pg_catalog.pg_get_expr(c.relpartbound, c.oid) AS partition_bound
+      FROM pg_catalog.pg_inherits i
+INNER JOIN pg_catalog.pg_class c
+        ON c.oid = i.inhrelid
+     WHERE i.inhparent = 'repmgr.monitoring_history'::pg_catalog.regclass
+  LOOP
+    /* the default partition has no upper bound */
+    CONTINUE WHEN partition_rec.partition_bound !~ ' TO \(''[^'']+''\)$';
+
+    upper_bound := pg_catalog.substring(partition_rec.partition_bound FROM ' TO \(''([^'']+)''\)$')::TIMESTAMP WITH TIME ZONE;
+
+    IF upper_bound <= pg_catalog.now() - (keep_days || ' days')::INTERVAL THEN
+      EXECUTE pg_catalog.format('DROP TABLE %s', partition_rec.partition_name);
+      partitions_dropped := partitions_dropped + 1;
+    END IF;
+  END LOOP;
+
+  RETURN partitions_dropped;
+END
+$repmgr_func$
+  LANGUAGE plpgsql STRICT;
+
+/*
+ * From PostgreSQL 11, convert "monitoring_history" to a partitioned table.
+ * Existing records are retained in the partition "monitoring_history_legacy",
+ * which will be dropped by drop_monitoring_history_partitions() once all
+ * the records it contains have expired.
+ */
+DO $repmgr$
+DECLARE
+  DECLARE server_version_num INT;
+BEGIN
+  SELECT setting
+    FROM pg_catalog.pg_settings
+   WHERE name = 'server_version_num'
+    INTO server_version_num;
+  IF server_version_num >= 110000 THEN
+    /* statements executed dynamically, as they can't be parsed by earlier versions */
+    EXECUTE $repmgr_func$
+ALTER TABLE repmgr.monitoring_history RENAME TO monitoring_history_legacy
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+ALTER INDEX IF EXISTS repmgr.idx_monitoring_history_time RENAME TO idx_monitoring_history_legacy_time
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+CREATE TABLE repmgr.monitoring_history
+  (LIKE repmgr.monitoring_history_legacy)
+  PARTITION BY RANGE (last_monitor_time)
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+CREATE TABLE repmgr.monitoring_history_default
+  PARTITION OF repmgr.monitoring_history DEFAULT
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+CREATE INDEX idx_monitoring_history_time
+          ON repmgr.monitoring_history (last_monitor_time, standby_node_id)
+    $repmgr_func$;
+    EXECUTE pg_catalog.format(
+      'ALTER TABLE repmgr.monitoring_history ATTACH PARTITION repmgr.monitoring_history_legacy FOR VALUES FROM (MINVALUE) TO (%L)',
+      (CURRENT_DATE + 1)::TIMESTAMP WITH TIME ZONE);
+    EXECUTE $repmgr_func$
+CREATE OR REPLACE VIEW repmgr.replication_status AS
+  SELECT m.primary_node_id, m.standby_node_id, n.node_name AS standby_name,
+ 	     n.type AS node_type, n.active, last_monitor_time,
+         CASE WHEN n.type='standby' THEN m.last_wal_primary_location ELSE NULL END AS last_wal_primary_location,
+         m.last_wal_standby_location,
+         CASE WHEN n.type='standby' THEN pg_catalog.pg_size_pretty(m.replication_lag) ELSE NULL END AS replication_lag,
+         CASE WHEN n.type='standby' THEN
+           CASE WHEN replication_lag > 0 THEN age(now(), m.last_apply_time) ELSE '0'::INTERVAL END
+           ELSE NULL
+         END AS replication_time_lag,
+         CASE WHEN n.type='standby' THEN pg_catalog.pg_size_pretty(m.apply_lag) ELSE NULL END AS apply_lag,
+         AGE(NOW(), CASE WHEN pg_catalog.pg_is_in_recovery() THEN repmgr.standby_get_last_updated() ELSE m.last_monitor_time END) AS communication_time_lag
+    FROM repmgr.monitoring_history m
+    JOIN repmgr.nodes n ON m.standby_node_id = n.node_id
+   WHERE (m.standby_node_id, m.last_monitor_time) IN (
+	          SELECT m1.standby_node_id, MAX(m1.last_monitor_time)
+			    FROM repmgr.monitoring_history m1 GROUP BY 1
+         )
+    $repmgr_func$;
+  END IF;
+END$repmgr$;
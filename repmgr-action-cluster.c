@@ -51,13 +51,17 @@ typedef enum
 	EV_DETAILS
 }			EventHeader;
 
+/* column returned by get_event_records() but not displayed */
+#define EV_PAGINATION_KEY EVENT_HEADER_COUNT
+
 
 struct ColHeader headers_show[SHOW_HEADER_COUNT];
 struct ColHeader headers_event[EVENT_HEADER_COUNT];
 
 static int	build_cluster_matrix(t_node_matrix_rec ***matrix_rec_dest, ItemList *warnings, int *error_code);
 static int	build_cluster_crosscheck(t_node_status_cube ***cube_dest, ItemList *warnings, int *error_code);
-static void cube_set_node_status(t_node_status_cube **cube, int n, int node_id, int matrix_node_id, int connection_node_id, int connection_status);
+static void cube_set_node_status(t_node_status_cube **cube, NodeInfoList *nodes, int node_id, int matrix_node_id, int connection_node_id, int connection_status);
+static void stream_cluster_events(PGconn *conn, int column_count);
 
 /*
  * CLUSTER SHOW
@@ -168,10 +172,6 @@ do_cluster_show(void)
 
 	for (cell = nodes.head; cell; cell = cell->next)
 	{
-		PQExpBufferData node_status;
-		PQExpBufferData upstream;
-		PQExpBufferData buf;
-
 		cell->node_info->replication_info = palloc0(sizeof(ReplInfo));
 		if (cell->node_info->replication_info == NULL)
 		{
@@ -180,8 +180,21 @@ do_cluster_show(void)
 		}
 
 		init_replication_info(cell->node_info->replication_info);
+	}
 
-		cell->node_info->conn = establish_db_connection_quiet(cell->node_info->conninfo);
+	/*
+	 * Connect to all nodes concurrently, then retrieve each node's recovery
+	 * type and timeline in a single round trip, so the overall time taken
+	 * is bounded by the slowest node rather than the sum of all nodes.
+	 */
+	(void) establish_node_connections_parallel(&nodes, nodes.node_count);
+	get_node_status_parallel(&nodes, config_file_options.async_query_timeout);
+
+	for (cell = nodes.head; cell; cell = cell->next)
+	{
+		PQExpBufferData node_status;
+		PQExpBufferData upstream;
+		PQExpBufferData buf;
 
 		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
 		{
@@ -191,7 +204,10 @@ do_cluster_show(void)
 			{
 				char		error[MAXLEN];
 
-				strncpy(error, PQerrorMessage(cell->node_info->conn), MAXLEN);
+				if (cell->node_info->conn == NULL)
+					strncpy(error, _("timeout expired"), MAXLEN);
+				else
+					strncpy(error, PQerrorMessage(cell->node_info->conn), MAXLEN);
 				item_list_append_format(&warnings,
 										"when attempting to connect to node \"%s\" (ID: %i), following error encountered :\n\"%s\"",
 										cell->node_info->node_name, cell->node_info->node_id, trim(error));
@@ -203,12 +219,6 @@ do_cluster_show(void)
 										cell->node_info->node_name, cell->node_info->node_id);
 			}
 		}
-		else
-		{
-			/* NOP on pre-9.6 servers */
-			cell->node_info->replication_info->timeline_id = get_node_timeline(cell->node_info->conn,
-																			   cell->node_info->replication_info->timeline_id_str);
-		}
 
 		initPQExpBuffer(&node_status);
 		initPQExpBuffer(&upstream);
@@ -385,6 +395,8 @@ do_cluster_show(void)
  *   --all
  *   --node-[id|name]
  *   --event
+ *   --before
+ *   --after
  *   --csv
  *   --compact
  */
@@ -399,12 +411,33 @@ do_cluster_event(void)
 
 	conn = establish_db_connection(config_file_options.conninfo, true);
 
+	/*
+	 * If --compact or --csv provided, simply omit the "Details" column.
+	 * In --csv mode we'd need to quote/escape the contents "Details" column,
+	 * which is doable but which will remain a TODO for now.
+	 */
+	if (runtime_options.compact == true || runtime_options.output_mode == OM_CSV)
+		column_count --;
+
+	/*
+	 * CSV output doesn't need column widths, so rows can be emitted as they
+	 * arrive rather than buffering what may be a very large result set.
+	 */
+	if (runtime_options.output_mode == OM_CSV)
+	{
+		stream_cluster_events(conn, column_count);
+		PQfinish(conn);
+		return;
+	}
+
 	res = get_event_records(conn,
 							runtime_options.node_id,
 							runtime_options.node_name,
 							runtime_options.event,
 							runtime_options.all,
-							runtime_options.limit);
+							runtime_options.limit,
+							runtime_options.before,
+							runtime_options.after);
 
 	if (PQresultStatus(res) != PGRES_TUPLES_OK)
 	{
@@ -431,14 +464,6 @@ do_cluster_event(void)
 	strncpy(headers_event[EV_TIMESTAMP].title, _("Timestamp"), MAXLEN);
 	strncpy(headers_event[EV_DETAILS].title, _("Details"), MAXLEN);
 
-	/*
-	 * If --compact or --csv provided, simply omit the "Details" column.
-	 * In --csv mode we'd need to quote/escape the contents "Details" column,
-	 * which is doable but which will remain a TODO for now.
-	 */
-	if (runtime_options.compact == true || runtime_options.output_mode == OM_CSV)
-		column_count --;
-
 	for (i = 0; i < column_count; i++)
 	{
 		headers_event[i].max_length = strlen(headers_event[i].title);
@@ -522,6 +547,29 @@ do_cluster_event(void)
 		printf("\n");
 	}
 
+	/*
+	 * If a full page of events was displayed, show how to display the next
+	 * one, using the position (full-precision timestamp, node ID and event)
+	 * of the last event as the key.
+	 */
+	if (runtime_options.output_mode == OM_TEXT &&
+		runtime_options.all == false &&
+		PQntuples(res) == runtime_options.limit)
+	{
+		puts("");
+
+		if (runtime_options.after[0] != '\0' && runtime_options.before[0] == '\0')
+		{
+			printf(_("more events may be available; to display later events, execute with --after=\"%s\"\n"),
+				   PQgetvalue(res, 0, EV_PAGINATION_KEY));
+		}
+		else
+		{
+			printf(_("more events may be available; to display earlier events, execute with --before=\"%s\"\n"),
+				   PQgetvalue(res, PQntuples(res) - 1, EV_PAGINATION_KEY));
+		}
+	}
+
 	PQclear(res);
 
 	PQfinish(conn);
@@ -531,6 +579,79 @@ do_cluster_event(void)
 }
 
 
+/*
+ * Emit events as CSV one row at a time, as they are received from the
+ * server.
+ */
+static void
+stream_cluster_events(PGconn *conn, int column_count)
+{
+	PGresult   *res;
+	int			row_count = 0;
+	bool		query_error = false;
+
+	if (send_event_records_query(conn,
+								 runtime_options.node_id,
+								 runtime_options.node_name,
+								 runtime_options.event,
+								 runtime_options.all,
+								 runtime_options.limit,
+								 runtime_options.before,
+								 runtime_options.after) == false)
+	{
+		PQfinish(conn);
+		exit(ERR_DB_QUERY);
+	}
+
+	while ((res = PQgetResult(conn)) != NULL)
+	{
+		ExecStatusType status = PQresultStatus(res);
+
+		if (status == PGRES_SINGLE_TUPLE || status == PGRES_TUPLES_OK)
+		{
+			int			i;
+
+			for (i = 0; i < PQntuples(res); i++)
+			{
+				int			j;
+
+				for (j = 0; j < column_count; j++)
+				{
+					printf("%s", PQgetvalue(res, i, j));
+					if ((j + 1) < column_count)
+					{
+						printf(",");
+					}
+				}
+
+				printf("\n");
+				row_count++;
+			}
+		}
+		else if (query_error == false)
+		{
+			log_error(_("unable to execute event query:\n  %s"),
+					  PQerrorMessage(conn));
+			query_error = true;
+		}
+
+		PQclear(res);
+	}
+
+	if (query_error == true)
+	{
+		PQfinish(conn);
+		exit(ERR_DB_QUERY);
+	}
+
+	if (row_count == 0)
+	{
+		/* print this message directly, rather than as a log line */
+		printf(_("no matching events found\n"));
+	}
+}
+
+
 void
 do_cluster_crosscheck(void)
 {
@@ -876,27 +997,20 @@ do_cluster_matrix()
 }
 
 
+/*
+ * The matrix is built in the same order as the provided node list, so the
+ * list's node_id index gives each node's position directly.
+ */
 static void
-matrix_set_node_status(t_node_matrix_rec **matrix_rec_list, int n, int node_id, int connection_node_id, int connection_status)
+matrix_set_node_status(t_node_matrix_rec **matrix_rec_list, NodeInfoList *nodes, int node_id, int connection_node_id, int connection_status)
 {
-	int			i,
-				j;
+	int			i = get_node_list_position(nodes, node_id);
+	int			j = get_node_list_position(nodes, connection_node_id);
 
-	for (i = 0; i < n; i++)
-	{
-		if (matrix_rec_list[i]->node_id == node_id)
-		{
-			for (j = 0; j < n; j++)
-			{
-				if (matrix_rec_list[i]->node_status_list[j]->node_id == connection_node_id)
-				{
-					matrix_rec_list[i]->node_status_list[j]->node_status = connection_status;
-					break;
-				}
-			}
-			break;
-		}
-	}
+	if (i < 0 || j < 0)
+		return;
+
+	matrix_rec_list[i]->node_status_list[j]->node_status = connection_status;
 }
 
 
@@ -911,8 +1025,9 @@ build_cluster_matrix(t_node_matrix_rec ***matrix_rec_dest, ItemList *warnings, i
 	NodeInfoList nodes = T_NODE_INFO_LIST_INITIALIZER;
 	NodeInfoListCell *cell = NULL;
 
-	PQExpBufferData command;
-	PQExpBufferData command_output;
+	t_parallel_command *remote_commands = NULL;
+	int		   *remote_command_node_ids = NULL;
+	int			remote_command_count = 0;
 
 	t_node_matrix_rec **matrix_rec_list;
 
@@ -984,57 +1099,48 @@ build_cluster_matrix(t_node_matrix_rec ***matrix_rec_dest, ItemList *warnings, i
 		i++;
 	}
 
-	/* Fetch `repmgr cluster show --csv` output for each node */
-	i = 0;
+	/*
+	 * Check connectivity from the local node to each node; connection
+	 * attempts are made concurrently.
+	 */
+	(void) establish_node_connections_parallel(&nodes, config_file_options.parallel_jobs);
+
+	remote_commands = (t_parallel_command *) pg_malloc0(sizeof(t_parallel_command) * nodes.node_count);
+	remote_command_node_ids = (int *) pg_malloc0(sizeof(int) * nodes.node_count);
 
 	for (cell = nodes.head; cell; cell = cell->next)
 	{
 		int			connection_status = 0;
 		t_conninfo_param_list remote_conninfo = T_CONNINFO_PARAM_LIST_INITIALIZER;
-		char	   *host = NULL,
-				   *p = NULL;
+		char	   *host = NULL;
 		int			connection_node_id = cell->node_info->node_id;
-		int			x,
-					y;
-		PGconn	   *node_conn = NULL;
-
-		initialize_conninfo_params(&remote_conninfo, false);
-		parse_conninfo_string(cell->node_info->conninfo,
-							  &remote_conninfo,
-							  NULL,
-							  false);
-
-		host = param_get(&remote_conninfo, "host");
-
-		node_conn = establish_db_connection_quiet(cell->node_info->conninfo);
+		PQExpBufferData command;
 
 		connection_status =
-			(PQstatus(node_conn) == CONNECTION_OK) ? 0 : -1;
+			(PQstatus(cell->node_info->conn) == CONNECTION_OK) ? 0 : -1;
 
+		close_connection(&cell->node_info->conn);
 
 		matrix_set_node_status(matrix_rec_list,
-							   nodes.node_count,
+							   &nodes,
 							   local_node_id,
 							   connection_node_id,
 							   connection_status);
 
-
 		if (connection_status)
-		{
-			free_conninfo_params(&remote_conninfo);
-			PQfinish(node_conn);
-			node_conn = NULL;
 			continue;
-		}
 
 		/* We don't need to issue `cluster show --csv` for the local node */
 		if (connection_node_id == local_node_id)
-		{
-			free_conninfo_params(&remote_conninfo);
-			PQfinish(node_conn);
-			node_conn = NULL;
 			continue;
-		}
+
+		initialize_conninfo_params(&remote_conninfo, false);
+		parse_conninfo_string(cell->node_info->conninfo,
+							  &remote_conninfo,
+							  NULL,
+							  false);
+
+		host = param_get(&remote_conninfo, "host");
 
 		initPQExpBuffer(&command);
 
@@ -1064,20 +1170,42 @@ build_cluster_matrix(t_node_matrix_rec ***matrix_rec_dest, ItemList *warnings, i
 
 		log_verbose(LOG_DEBUG, "build_cluster_matrix(): executing:\n  %s", command.data);
 
-		initPQExpBuffer(&command_output);
+		init_parallel_command(&remote_commands[remote_command_count]);
 
-		(void) remote_command(host,
-							  runtime_options.remote_user,
-							  command.data,
-							  config_file_options.ssh_options,
-							  &command_output);
+		make_remote_command(host,
+							runtime_options.remote_user,
+							command.data,
+							config_file_options.ssh_options,
+							&remote_commands[remote_command_count].command);
 
-		p = command_output.data;
+		remote_command_node_ids[remote_command_count] = connection_node_id;
+		remote_command_count++;
 
 		termPQExpBuffer(&command);
+		free_conninfo_params(&remote_conninfo);
+	}
 
+	/* Fetch `repmgr cluster show --csv` output from each reachable node */
+	execute_commands_parallel(remote_commands,
+							  remote_command_count,
+							  config_file_options.parallel_jobs,
+							  config_file_options.remote_command_timeout);
+
+	for (i = 0; i < remote_command_count; i++)
+	{
+		int			connection_node_id = remote_command_node_ids[i];
+		char	   *p = remote_commands[i].output.data;
+
+		if (remote_commands[i].timed_out == true)
+		{
+			item_list_append_format(warnings,
+									"node %i did not respond within %i seconds",
+									connection_node_id,
+									config_file_options.remote_command_timeout);
+			*error_code = ERR_BAD_SSH;
+		}
 		/* no output returned - probably SSH error */
-		if (p[0] == '\0' || p[0] == '\n')
+		else if (p[0] == '\0' || p[0] == '\n')
 		{
 			item_list_append_format(warnings,
 									"node %i inaccessible via SSH",
@@ -1088,40 +1216,42 @@ build_cluster_matrix(t_node_matrix_rec ***matrix_rec_dest, ItemList *warnings, i
 		{
 			for (j = 0; j < nodes.node_count; j++)
 			{
-				if (sscanf(p, "%d,%d", &x, &y) != 2)
+				int			values[2] = {UNKNOWN_NODE_ID, -2};
+				char	   *line = p;
+				char	   *line_end = strchr(line, '\n');
+				int			line_len = (line_end != NULL) ? (int) (line_end - line) : (int) strlen(line);
+
+				/* each line contains: node ID, connection status */
+				if (parse_csv_int_line(&p, values, 2) == false)
 				{
 					matrix_set_node_status(matrix_rec_list,
-										   nodes.node_count,
+										   &nodes,
 										   connection_node_id,
-										   x,
+										   values[0],
 										   -2);
 
 					item_list_append_format(warnings,
-											"unable to parse --csv output for node %i; output returned was:\n\"%s\"",
-											connection_node_id, p);
+											"unable to parse --csv output for node %i; output returned was:\n\"%.*s\"",
+											connection_node_id, line_len, line);
 					*error_code = ERR_INTERNAL;
 				}
 				else
 				{
 					matrix_set_node_status(matrix_rec_list,
-										   nodes.node_count,
+										   &nodes,
 										   connection_node_id,
-										   x,
-										   (y == -1) ? -1 : 0);
+										   values[0],
+										   (values[1] == -1) ? -1 : 0);
 				}
-
-				while (*p && (*p != '\n'))
-					p++;
-				if (*p == '\n')
-					p++;
 			}
 		}
 
-		termPQExpBuffer(&command_output);
-		PQfinish(node_conn);
-		free_conninfo_params(&remote_conninfo);
+		term_parallel_command(&remote_commands[i]);
 	}
 
+	pfree(remote_commands);
+	pfree(remote_command_node_ids);
+
 	*matrix_rec_dest = matrix_rec_list;
 
 	node_count = nodes.node_count;
@@ -1142,6 +1272,7 @@ build_cluster_crosscheck(t_node_status_cube ***dest_cube, ItemList *warnings, in
 	NodeInfoListCell *cell = NULL;
 
 	t_node_status_cube **cube;
+	t_parallel_command *remote_commands = NULL;
 
 	int			node_count = 0;
 
@@ -1221,19 +1352,16 @@ build_cluster_crosscheck(t_node_status_cube ***dest_cube, ItemList *warnings, in
 
 
 	/*
-	 * Build the connection cube
+	 * Execute `repmgr cluster matrix --csv` on each node; the commands are
+	 * executed concurrently.
 	 */
+	remote_commands = (t_parallel_command *) pg_malloc0(sizeof(t_parallel_command) * nodes.node_count);
+
 	i = 0;
 
 	for (cell = nodes.head; cell; cell = cell->next)
 	{
-		int			remote_node_id = UNKNOWN_NODE_ID;
 		PQExpBufferData command;
-		PQExpBufferData command_output;
-
-		char	   *p = NULL;
-
-		remote_node_id = cell->node_info->node_id;
 
 		initPQExpBuffer(&command);
 
@@ -1253,12 +1381,12 @@ build_cluster_crosscheck(t_node_status_cube ***dest_cube, ItemList *warnings, in
 								 " -L NOTICE");
 		}
 
-		initPQExpBuffer(&command_output);
+		init_parallel_command(&remote_commands[i]);
 
 		if (cube[i]->node_id == config_file_options.node_id)
 		{
-			(void) local_command_simple(command.data,
-										&command_output);
+			appendPQExpBufferStr(&remote_commands[i].command,
+								 command.data);
 		}
 		else
 		{
@@ -1282,11 +1410,11 @@ build_cluster_crosscheck(t_node_status_cube ***dest_cube, ItemList *warnings, in
 
 			log_verbose(LOG_DEBUG, "build_cluster_crosscheck(): executing\n  %s", quoted_command.data);
 
-			(void) remote_command(host,
-								  runtime_options.remote_user,
-								  quoted_command.data,
-								  config_file_options.ssh_options,
-								  &command_output);
+			make_remote_command(host,
+								runtime_options.remote_user,
+								quoted_command.data,
+								config_file_options.ssh_options,
+								&remote_commands[i].command);
 
 			free_conninfo_params(&remote_conninfo);
 			termPQExpBuffer(&quoted_command);
@@ -1294,54 +1422,74 @@ build_cluster_crosscheck(t_node_status_cube ***dest_cube, ItemList *warnings, in
 
 		termPQExpBuffer(&command);
 
-		p = command_output.data;
+		i++;
+	}
+
+	execute_commands_parallel(remote_commands,
+							  nodes.node_count,
+							  config_file_options.parallel_jobs,
+							  config_file_options.remote_command_timeout);
+
+	/*
+	 * Build the connection cube
+	 */
+	for (i = 0; i < nodes.node_count; i++)
+	{
+		int			remote_node_id = cube[i]->node_id;
+		char	   *p = remote_commands[i].output.data;
+
+		if (remote_commands[i].timed_out == true)
+		{
+			item_list_append_format(warnings,
+									"node %i did not respond within %i seconds",
+									remote_node_id,
+									config_file_options.remote_command_timeout);
+			term_parallel_command(&remote_commands[i]);
+			*error_code = ERR_BAD_SSH;
+			continue;
+		}
 
 		if (p[0] == '\0' || p[0] == '\n')
 		{
 			item_list_append_format(warnings,
 									"node %i inaccessible via SSH",
 									remote_node_id);
-			termPQExpBuffer(&command_output);
+			term_parallel_command(&remote_commands[i]);
 			*error_code = ERR_BAD_SSH;
 			continue;
 		}
 
 		for (j = 0; j < (nodes.node_count * nodes.node_count); j++)
 		{
-			int			matrix_rec_node_id;
-			int			node_status_node_id;
-			int			node_status;
+			int			values[3] = {UNKNOWN_NODE_ID, UNKNOWN_NODE_ID, -2};
 
-			if (sscanf(p, "%d,%d,%d", &matrix_rec_node_id, &node_status_node_id, &node_status) != 3)
+			/* each line contains: matrix node ID, connection node ID, connection status */
+			if (parse_csv_int_line(&p, values, 3) == false)
 			{
 				cube_set_node_status(cube,
-									 nodes.node_count,
+									 &nodes,
 									 remote_node_id,
-									 matrix_rec_node_id,
-									 node_status_node_id,
+									 values[0],
+									 values[1],
 									 -2);
 				*error_code = ERR_INTERNAL;
 			}
 			else
 			{
 				cube_set_node_status(cube,
-									 nodes.node_count,
+									 &nodes,
 									 remote_node_id,
-									 matrix_rec_node_id,
-									 node_status_node_id,
-									 node_status);
+									 values[0],
+									 values[1],
+									 values[2]);
 			}
-
-			while (*p && (*p != '\n'))
-				p++;
-			if (*p == '\n')
-				p++;
 		}
-		termPQExpBuffer(&command_output);
 
-		i++;
+		term_parallel_command(&remote_commands[i]);
 	}
 
+	pfree(remote_commands);
+
 	*dest_cube = cube;
 
 	node_count = nodes.node_count;
@@ -1352,35 +1500,21 @@ build_cluster_crosscheck(t_node_status_cube ***dest_cube, ItemList *warnings, in
 }
 
 
+/*
+ * As with matrix_set_node_status(), each dimension of the cube is in the
+ * same order as the provided node list.
+ */
 static void
-cube_set_node_status(t_node_status_cube **cube, int n, int execute_node_id, int matrix_node_id, int connection_node_id, int connection_status)
+cube_set_node_status(t_node_status_cube **cube, NodeInfoList *nodes, int execute_node_id, int matrix_node_id, int connection_node_id, int connection_status)
 {
-	int			h,
-				i,
-				j;
+	int			h = get_node_list_position(nodes, execute_node_id);
+	int			i = get_node_list_position(nodes, matrix_node_id);
+	int			j = get_node_list_position(nodes, connection_node_id);
 
+	if (h < 0 || i < 0 || j < 0)
+		return;
 
-	for (h = 0; h < n; h++)
-	{
-		if (cube[h]->node_id == execute_node_id)
-		{
-			for (i = 0; i < n; i++)
-			{
-				if (cube[h]->matrix_list_rec[i]->node_id == matrix_node_id)
-				{
-					for (j = 0; j < n; j++)
-					{
-						if (cube[h]->matrix_list_rec[i]->node_status_list[j]->node_id == connection_node_id)
-						{
-							cube[h]->matrix_list_rec[i]->node_status_list[j]->node_status = connection_status;
-							break;
-						}
-					}
-					break;
-				}
-			}
-		}
-	}
+	cube[h]->matrix_list_rec[i]->node_status_list[j]->node_status = connection_status;
 }
 
 
@@ -1390,6 +1524,7 @@ do_cluster_cleanup(void)
 	PGconn	   *conn = NULL;
 	PGconn	   *primary_conn = NULL;
 	int			entries_to_delete = 0;
+	int			partitions_dropped = 0;
 	PQExpBufferData event_details;
 
 	conn = establish_db_connection(config_file_options.conninfo, true);
@@ -1402,6 +1537,40 @@ do_cluster_cleanup(void)
 
 	log_debug(_("number of days of monitoring history to retain: %i"), runtime_options.keep_history);
 
+	initPQExpBuffer(&event_details);
+
+	/*
+	 * If the monitoring history table is partitioned, first drop any
+	 * partitions which contain only expired records; this is not possible
+	 * if only records for a particular node are to be deleted.
+	 */
+	if (runtime_options.node_id == UNKNOWN_NODE_ID && is_monitoring_history_partitioned(primary_conn) == true)
+	{
+		partitions_dropped = drop_monitoring_history_partitions(primary_conn, runtime_options.keep_history);
+
+		if (partitions_dropped < 0)
+		{
+			appendPQExpBufferStr(&event_details,
+								 _("unable to drop monitoring history partitions"));
+
+			log_error("%s", event_details.data);
+			log_detail("%s", PQerrorMessage(primary_conn));
+
+			create_event_notification(primary_conn,
+									  &config_file_options,
+									  config_file_options.node_id,
+									  "cluster_cleanup",
+									  false,
+									  event_details.data);
+
+			PQfinish(primary_conn);
+			exit(ERR_DB_QUERY);
+		}
+
+		log_info(_("%i monitoring history partition(s) dropped"), partitions_dropped);
+	}
+
+	/* delete any remaining expired records, e.g. in the current partition */
 	entries_to_delete = get_number_of_monitoring_records_to_delete(primary_conn,
 																   runtime_options.keep_history,
 																   runtime_options.node_id);
@@ -1412,9 +1581,10 @@ do_cluster_cleanup(void)
 		PQfinish(primary_conn);
 		exit(ERR_DB_QUERY);
 	}
-	else if (entries_to_delete == 0)
+	else if (entries_to_delete == 0 && partitions_dropped == 0)
 	{
 		log_info(_("no monitoring records to delete"));
+		termPQExpBuffer(&event_details);
 		PQfinish(primary_conn);
 		return;
 	}
@@ -1422,36 +1592,38 @@ do_cluster_cleanup(void)
 	log_debug("at least %i monitoring records for deletion",
 			  entries_to_delete);
 
-	initPQExpBuffer(&event_details);
-
-	if (delete_monitoring_records(primary_conn, runtime_options.keep_history, runtime_options.node_id) == false)
+	/* nothing to do if only partitions were dropped */
+	if (entries_to_delete > 0)
 	{
-		appendPQExpBufferStr(&event_details,
-						  _("unable to delete monitoring records"));
+		if (delete_monitoring_records(primary_conn, runtime_options.keep_history, runtime_options.node_id) == false)
+		{
+			appendPQExpBufferStr(&event_details,
+							  _("unable to delete monitoring records"));
 
-		log_error("%s", event_details.data);
-		log_detail("%s", PQerrorMessage(primary_conn));
+			log_error("%s", event_details.data);
+			log_detail("%s", PQerrorMessage(primary_conn));
 
-		create_event_notification(primary_conn,
-								  &config_file_options,
-								  config_file_options.node_id,
-								  "cluster_cleanup",
-								  false,
-								  event_details.data);
+			create_event_notification(primary_conn,
+									  &config_file_options,
+									  config_file_options.node_id,
+									  "cluster_cleanup",
+									  false,
+									  event_details.data);
 
-		PQfinish(primary_conn);
-		exit(ERR_DB_QUERY);
-	}
+			PQfinish(primary_conn);
+			exit(ERR_DB_QUERY);
+		}
 
-	if (vacuum_table(primary_conn, "repmgr.monitoring_history") == false)
-	{
-		/* annoying if this fails, but not fatal */
-		log_warning(_("unable to vacuum table \"repmgr.monitoring_history\""));
-		log_detail("%s", PQerrorMessage(primary_conn));
-	}
-	else
-	{
-		log_info(_("vacuum of table \"repmgr.monitoring_history\" completed"));
+		if (vacuum_table(primary_conn, "repmgr.monitoring_history") == false)
+		{
+			/* annoying if this fails, but not fatal */
+			log_warning(_("unable to vacuum table \"repmgr.monitoring_history\""));
+			log_detail("%s", PQerrorMessage(primary_conn));
+		}
+		else
+		{
+			log_info(_("vacuum of table \"repmgr.monitoring_history\" completed"));
+		}
 	}
 
 	if (runtime_options.keep_history == 0)
@@ -1475,6 +1647,11 @@ do_cluster_cleanup(void)
 						  _("; records newer than %i day(s) retained"),
 						  runtime_options.keep_history);
 
+	if (partitions_dropped > 0)
+		appendPQExpBuffer(&event_details,
+						  _("; %i partition(s) dropped"),
+						  partitions_dropped);
+
 	create_event_notification(primary_conn,
 							  &config_file_options,
 							  config_file_options.node_id,
@@ -1541,6 +1718,8 @@ do_cluster_help(void)
 	printf(_("    --limit                   maximum number of events to display (default: %i)\n"), CLUSTER_EVENT_LIMIT);
 	printf(_("    --all                     display all events (overrides --limit)\n"));
 	printf(_("    --event                   filter specific event\n"));
+	printf(_("    --before=TIMESTAMP        only display events before this timestamp\n"));
+	printf(_("    --after=TIMESTAMP         only display events after this timestamp\n"));
 	printf(_("    --node-id                 restrict entries to node with this ID\n"));
 	printf(_("    --node-name               restrict entries to node with this name\n"));
 	printf(_("    --compact                 omit \"Details\" column"));
@@ -45,13 +45,13 @@ static void _do_node_restore_config(void);
 
 static void do_node_check_replication_connection(void);
 static CheckStatus do_node_check_archive_ready(PGconn *conn, OutputMode mode, CheckStatusList *list_output);
-static CheckStatus do_node_check_downstream(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output);
-static CheckStatus do_node_check_upstream(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output);
-static CheckStatus do_node_check_replication_lag(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output);
-static CheckStatus do_node_check_role(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output);
+static CheckStatus do_node_check_downstream(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output);
+static CheckStatus do_node_check_upstream(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output);
+static CheckStatus do_node_check_replication_lag(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output);
+static CheckStatus do_node_check_role(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output);
 static CheckStatus do_node_check_slots(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output);
-static CheckStatus do_node_check_missing_slots(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output);
-static CheckStatus do_node_check_data_directory(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output);
+static CheckStatus do_node_check_missing_slots(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output);
+static CheckStatus do_node_check_data_directory(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output);
 static CheckStatus do_node_check_replication_config_owner(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output);
 static CheckStatus do_node_check_db_connection(PGconn *conn, OutputMode mode);
 
@@ -729,6 +729,7 @@ do_node_check(void)
 	PQExpBufferData output;
 
 	t_node_info node_info = T_NODE_INFO_INITIALIZER;
+	t_node_check_info check_info = T_NODE_CHECK_INFO_INITIALIZER;
 
 	CheckStatus return_code;
 	CheckStatusList status_list = {NULL, NULL};
@@ -844,8 +845,11 @@ do_node_check(void)
 		exit(ERR_BAD_CONFIG);
 	}
 
-	/* add replication statistics to node record */
-	get_node_replication_stats(conn, &node_info);
+	/*
+	 * Collect all the information needed by the individual checks, and add
+	 * replication statistics to node record
+	 */
+	(void) get_node_check_info(conn, &node_info, &check_info);
 
 	/*
 	 * handle specific checks ======================
@@ -864,6 +868,7 @@ do_node_check(void)
 		return_code = do_node_check_upstream(conn,
 											 runtime_options.output_mode,
 											 &node_info,
+											 &check_info,
 											 NULL);
 		PQfinish(conn);
 		exit(return_code);
@@ -874,6 +879,7 @@ do_node_check(void)
 		return_code = do_node_check_downstream(conn,
 											   runtime_options.output_mode,
 											   &node_info,
+											   &check_info,
 											   NULL);
 		PQfinish(conn);
 		exit(return_code);
@@ -884,6 +890,7 @@ do_node_check(void)
 		return_code = do_node_check_replication_lag(conn,
 													runtime_options.output_mode,
 													&node_info,
+													&check_info,
 													NULL);
 		PQfinish(conn);
 		exit(return_code);
@@ -894,6 +901,7 @@ do_node_check(void)
 		return_code = do_node_check_role(conn,
 										 runtime_options.output_mode,
 										 &node_info,
+										 &check_info,
 										 NULL);
 		PQfinish(conn);
 		exit(return_code);
@@ -914,6 +922,7 @@ do_node_check(void)
 		return_code = do_node_check_missing_slots(conn,
 												  runtime_options.output_mode,
 												  &node_info,
+												  &check_info,
 												  NULL);
 		PQfinish(conn);
 		exit(return_code);
@@ -924,6 +933,7 @@ do_node_check(void)
 		return_code = do_node_check_data_directory(conn,
 												   runtime_options.output_mode,
 												   &node_info,
+												   &check_info,
 												   NULL);
 		PQfinish(conn);
 		exit(return_code);
@@ -953,28 +963,28 @@ do_node_check(void)
 	initPQExpBuffer(&output);
 
 	/* order functions are called is also output order */
-	if (do_node_check_role(conn, runtime_options.output_mode, &node_info, &status_list) != CHECK_STATUS_OK)
+	if (do_node_check_role(conn, runtime_options.output_mode, &node_info, &check_info, &status_list) != CHECK_STATUS_OK)
 		issue_detected = true;
 
-	if (do_node_check_replication_lag(conn, runtime_options.output_mode, &node_info, &status_list) != CHECK_STATUS_OK)
+	if (do_node_check_replication_lag(conn, runtime_options.output_mode, &node_info, &check_info, &status_list) != CHECK_STATUS_OK)
 		issue_detected = true;
 
 	if (do_node_check_archive_ready(conn, runtime_options.output_mode, &status_list) != CHECK_STATUS_OK)
 		issue_detected = true;
 
-	if (do_node_check_upstream(conn, runtime_options.output_mode, &node_info, &status_list) != CHECK_STATUS_OK)
+	if (do_node_check_upstream(conn, runtime_options.output_mode, &node_info, &check_info, &status_list) != CHECK_STATUS_OK)
 		issue_detected = true;
 
-	if (do_node_check_downstream(conn, runtime_options.output_mode, &node_info, &status_list) != CHECK_STATUS_OK)
+	if (do_node_check_downstream(conn, runtime_options.output_mode, &node_info, &check_info, &status_list) != CHECK_STATUS_OK)
 		issue_detected = true;
 
 	if (do_node_check_slots(conn, runtime_options.output_mode, &node_info, &status_list) != CHECK_STATUS_OK)
 		issue_detected = true;
 
-	if (do_node_check_missing_slots(conn, runtime_options.output_mode, &node_info, &status_list) != CHECK_STATUS_OK)
+	if (do_node_check_missing_slots(conn, runtime_options.output_mode, &node_info, &check_info, &status_list) != CHECK_STATUS_OK)
 		issue_detected = true;
 
-	if (do_node_check_data_directory(conn, runtime_options.output_mode, &node_info, &status_list) != CHECK_STATUS_OK)
+	if (do_node_check_data_directory(conn, runtime_options.output_mode, &node_info, &check_info, &status_list) != CHECK_STATUS_OK)
 		issue_detected = true;
 
 	if (runtime_options.output_mode == OM_CSV)
@@ -1030,6 +1040,7 @@ do_node_check(void)
 	printf("%s", output.data);
 	termPQExpBuffer(&output);
 	check_status_list_free(&status_list);
+	clear_node_check_info(&check_info);
 
 	PQfinish(conn);
 
@@ -1268,9 +1279,8 @@ do_node_check_archive_ready(PGconn *conn, OutputMode mode, CheckStatusList *list
 
 
 static CheckStatus
-do_node_check_downstream(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output)
+do_node_check_downstream(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output)
 {
-	NodeInfoList downstream_nodes = T_NODE_INFO_LIST_INITIALIZER;
 	NodeInfoListCell *cell = NULL;
 	int			missing_nodes_count = 0;
 	int			expected_nodes_count = 0;
@@ -1288,12 +1298,10 @@ do_node_check_downstream(PGconn *conn, OutputMode mode, t_node_info *node_info,
 
 	initPQExpBuffer(&details);
 
-	get_downstream_node_records(conn, config_file_options.node_id, &downstream_nodes);
-
 	/* if a witness node is present, we'll need to remove this from the total */
-	expected_nodes_count = downstream_nodes.node_count;
+	expected_nodes_count = check_info->downstream_nodes.node_count;
 
-	for (cell = downstream_nodes.head; cell; cell = cell->next)
+	for (cell = check_info->downstream_nodes.head; cell; cell = cell->next)
 	{
 		/* skip witness server */
 		if (cell->node_info->type == WITNESS)
@@ -1302,7 +1310,7 @@ do_node_check_downstream(PGconn *conn, OutputMode mode, t_node_info *node_info,
 			continue;
 		}
 
-		if (is_downstream_node_attached(conn, cell->node_info->node_name) != NODE_ATTACHED)
+		if (cell->node_info->attached != NODE_ATTACHED)
 		{
 			missing_nodes_count++;
 			item_list_append_format(&missing_nodes,
@@ -1435,16 +1443,15 @@ do_node_check_downstream(PGconn *conn, OutputMode mode, t_node_info *node_info,
 
 	}
 	termPQExpBuffer(&details);
-	clear_node_info_list(&downstream_nodes);
 	return status;
 }
 
 
 static CheckStatus
-do_node_check_upstream(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output)
+do_node_check_upstream(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output)
 {
 	PGconn	   *upstream_conn = NULL;
-	t_node_info upstream_node_info = T_NODE_INFO_INITIALIZER;
+	t_node_info *upstream_node_info = &check_info->upstream_node_info;
 	PQExpBufferData details;
 
 	CheckStatus status = CHECK_STATUS_OK;
@@ -1464,9 +1471,9 @@ do_node_check_upstream(PGconn *conn, OutputMode mode, t_node_info *node_info, Ch
 		appendPQExpBufferStr(&details,
 							 _("N/A - node is a witness"));
 	}
-	else if (get_node_record(conn, node_info->upstream_node_id, &upstream_node_info) != RECORD_FOUND)
+	else if (check_info->upstream_node_found == false)
 	{
-		if (get_recovery_type(conn) == RECTYPE_STANDBY)
+		if (check_info->recovery_type == RECTYPE_STANDBY)
 		{
 			appendPQExpBuffer(&details,
 							  _("node \"%s\" (ID: %i) is a standby but no upstream record found"),
@@ -1482,7 +1489,7 @@ do_node_check_upstream(PGconn *conn, OutputMode mode, t_node_info *node_info, Ch
 	}
 	else
 	{
-		upstream_conn = establish_db_connection(upstream_node_info.conninfo, true);
+		upstream_conn = establish_db_connection(upstream_node_info->conninfo, true);
 
 		/* check our node is connected */
 		if (is_downstream_node_attached(upstream_conn, config_file_options.node_name) != NODE_ATTACHED)
@@ -1491,8 +1498,8 @@ do_node_check_upstream(PGconn *conn, OutputMode mode, t_node_info *node_info, Ch
 							  _("node \"%s\" (ID: %i) is not attached to expected upstream node \"%s\" (ID: %i)"),
 							  node_info->node_name,
 							  node_info->node_id,
-							  upstream_node_info.node_name,
-							  upstream_node_info.node_id);
+							  upstream_node_info->node_name,
+							  upstream_node_info->node_id);
 			status = CHECK_STATUS_CRITICAL;
 		}
 		else
@@ -1501,8 +1508,8 @@ do_node_check_upstream(PGconn *conn, OutputMode mode, t_node_info *node_info, Ch
 							  _("node \"%s\" (ID: %i) is attached to expected upstream node \"%s\" (ID: %i)"),
 							  node_info->node_name,
 							  node_info->node_id,
-							  upstream_node_info.node_name,
-							  upstream_node_info.node_id);
+							  upstream_node_info->node_name,
+							  upstream_node_info->node_id);
 		}
 	}
 
@@ -1539,7 +1546,7 @@ do_node_check_upstream(PGconn *conn, OutputMode mode, t_node_info *node_info, Ch
 
 
 static CheckStatus
-do_node_check_replication_lag(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output)
+do_node_check_replication_lag(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output)
 {
 	CheckStatus status = CHECK_STATUS_OK;
 	int			lag_seconds = 0;
@@ -1586,7 +1593,7 @@ do_node_check_replication_lag(PGconn *conn, OutputMode mode, t_node_info *node_i
 	}
 	else
 	{
-		lag_seconds = get_replication_lag_seconds(conn);
+		lag_seconds = check_info->replication_lag_seconds;
 
 		log_debug("lag seconds: %i", lag_seconds);
 
@@ -1735,12 +1742,12 @@ do_node_check_replication_lag(PGconn *conn, OutputMode mode, t_node_info *node_i
 
 
 static CheckStatus
-do_node_check_role(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output)
+do_node_check_role(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output)
 {
 
 	CheckStatus status = CHECK_STATUS_OK;
 	PQExpBufferData details;
-	RecoveryType recovery_type = get_recovery_type(conn);
+	RecoveryType recovery_type = check_info->recovery_type;
 
 	if (mode == OM_CSV && list_output == NULL)
 	{
@@ -1904,11 +1911,11 @@ do_node_check_slots(PGconn *conn, OutputMode mode, t_node_info *node_info, Check
 
 
 static CheckStatus
-do_node_check_missing_slots(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output)
+do_node_check_missing_slots(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output)
 {
 	CheckStatus status = CHECK_STATUS_OK;
 	PQExpBufferData details;
-	NodeInfoList missing_slots = T_NODE_INFO_LIST_INITIALIZER;
+	NodeInfoList *missing_slots = &check_info->missing_slots;
 
 	if (mode == OM_CSV && list_output == NULL)
 	{
@@ -1926,11 +1933,7 @@ do_node_check_missing_slots(PGconn *conn, OutputMode mode, t_node_info *node_inf
 	}
 	else
 	{
-		get_downstream_nodes_with_missing_slot(conn,
-											   config_file_options.node_id,
-											   &missing_slots);
-
-		if (missing_slots.node_count == 0)
+		if (missing_slots->node_count == 0)
 		{
 			appendPQExpBufferStr(&details,
 								 _("node has no missing physical replication slots"));
@@ -1944,13 +1947,13 @@ do_node_check_missing_slots(PGconn *conn, OutputMode mode, t_node_info *node_inf
 
 			appendPQExpBuffer(&details,
 							  _("%i physical replication slots are missing"),
-							  missing_slots.node_count);
+							  missing_slots->node_count);
 
-			if (missing_slots.node_count)
+			if (missing_slots->node_count)
 			{
 				appendPQExpBufferStr(&details, ": ");
 
-				for (missing_slot_cell = missing_slots.head; missing_slot_cell; missing_slot_cell = missing_slot_cell->next)
+				for (missing_slot_cell = missing_slots->head; missing_slot_cell; missing_slot_cell = missing_slot_cell->next)
 				{
 					if (first_element == true)
 					{
@@ -1974,16 +1977,16 @@ do_node_check_missing_slots(PGconn *conn, OutputMode mode, t_node_info *node_inf
 			printf("REPMGR_MISSING_SLOTS %s: %s | missing_slots=%i",
 				   output_check_status(status),
 				   details.data,
-				   missing_slots.node_count);
+				   missing_slots->node_count);
 
-			if (missing_slots.node_count)
+			if (missing_slots->node_count)
 			{
 				NodeInfoListCell *missing_slot_cell = NULL;
 				bool first_element = true;
 
 				printf(";");
 
-				for (missing_slot_cell = missing_slots.head; missing_slot_cell; missing_slot_cell = missing_slot_cell->next)
+				for (missing_slot_cell = missing_slots->head; missing_slot_cell; missing_slot_cell = missing_slot_cell->next)
 				{
 					if (first_element == true)
 					{
@@ -2018,15 +2021,13 @@ do_node_check_missing_slots(PGconn *conn, OutputMode mode, t_node_info *node_inf
 			break;
 	}
 
-	clear_node_info_list(&missing_slots);
-
 	termPQExpBuffer(&details);
 	return status;
 }
 
 
 CheckStatus
-do_node_check_data_directory(PGconn *conn, OutputMode mode, t_node_info *node_info, CheckStatusList *list_output)
+do_node_check_data_directory(PGconn *conn, OutputMode mode, t_node_info *node_info, t_node_check_info *check_info, CheckStatusList *list_output)
 {
 	CheckStatus status = CHECK_STATUS_OK;
 	char actual_data_directory[MAXPGPATH] = "";
@@ -2045,10 +2046,13 @@ do_node_check_data_directory(PGconn *conn, OutputMode mode, t_node_info *node_in
 	 * Check actual data directory matches that in repmgr.conf; note this requires
 	 * a superuser connection
 	 */
-	if (connection_has_pg_settings(conn) == true)
+	if (check_info->has_pg_settings == true)
 	{
-		/* we expect to have a database connection */
-		if (get_pg_setting(conn, "data_directory", actual_data_directory) == false)
+		if (check_info->data_directory_found == true)
+		{
+			strncpy(actual_data_directory, check_info->data_directory, MAXPGPATH - 1);
+		}
+		else
 		{
 			appendPQExpBuffer(&details,
 							  _("unable to determine current \"data_directory\""));
@@ -2504,6 +2508,8 @@ do_node_rejoin(void)
 
 	bool		success = true;
 	int			follow_error_code = SUCCESS;
+	bool		rewind_required = true;
+	bool		execute_rewind = false;
 
 	/* check node is not actually running */
 	status = PQping(config_file_options.conninfo);
@@ -2663,22 +2669,46 @@ do_node_rejoin(void)
 										   min_recovery_location,
 										   primary_conn,
 										   &primary_node_record,
-										   true);
+										   true,
+										   &rewind_required);
 
 		if (can_follow == false)
 		{
 			PQfinish(primary_conn);
 			exit(ERR_REJOIN_FAIL);
 		}
+
+		/*
+		 * If the local node's history has not diverged from the rejoin
+		 * target's, pg_rewind would have nothing to do; skip it, together
+		 * with the configuration file archiving and replication slot
+		 * cleanup which go with it.
+		 */
+		if (runtime_options.force_rewind_used == true)
+		{
+			if (rewind_required == true)
+			{
+				execute_rewind = true;
+			}
+			else
+			{
+				log_notice(_("--force-rewind specified but pg_rewind is not required"));
+				log_detail(_("this node's timeline %i has not diverged from rejoin target node %i's timeline at this node's recovery point %X/%X"),
+						   tli,
+						   primary_node_record.node_id,
+						   format_lsn(min_recovery_location));
+			}
+		}
 	}
 
 
 	/*
-	 * --force-rewind specified - check prerequisites, and attempt to execute
-  	 * (if --dry-run provided, just output the command which would be executed)
+	 * --force-rewind specified and required - check prerequisites, and attempt
+	 * to execute (if --dry-run provided, just output the command which would
+	 * be executed)
 	 */
 
-	if (runtime_options.force_rewind_used == true)
+	if (execute_rewind == true)
 	{
 		PQExpBufferData msg;
 		PQExpBufferData	filebuf;
@@ -2962,7 +2992,7 @@ do_node_rejoin(void)
 	 *  - if a slot for the new upstream exists, delete that
 	 *  - warn about any other inactive replication slots
 	 */
-	if (runtime_options.force_rewind_used == false && config_file_options.use_replication_slots)
+	if (execute_rewind == false && config_file_options.use_replication_slots)
 	{
 		PGconn	   *local_conn = NULL;
 		local_conn = establish_db_connection(config_file_options.conninfo, false);
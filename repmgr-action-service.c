@@ -121,6 +121,15 @@ do_service_status(void)
 		headers_status[STATUS_PRIORITY].display = false;
 	}
 
+	/*
+	 * Connect to all nodes concurrently, then retrieve each node's repmgrd
+	 * status in a single round trip, so the overall time taken is bounded by
+	 * the slowest node (or the connection timeout, if any nodes are down)
+	 * rather than the sum of all nodes.
+	 */
+	(void) establish_node_connections_parallel(&nodes, nodes.node_count);
+	(void) get_repmgrd_status_parallel(&nodes, config_file_options.async_query_timeout);
+
 	i = 0;
 
 	for (cell = nodes.head; cell; cell = cell->next)
@@ -128,6 +137,7 @@ do_service_status(void)
 		int j;
 		PQExpBufferData node_status;
 		PQExpBufferData upstream;
+		ReplInfo   *replication_info = cell->node_info->replication_info;
 
 		repmgrd_info[i] = pg_malloc0(sizeof(RepmgrdInfo));
 		repmgrd_info[i]->node_id = cell->node_info->node_id;
@@ -139,8 +149,6 @@ do_service_status(void)
 		repmgrd_info[i]->wal_paused_pending_wal = false;
 		repmgrd_info[i]->upstream_last_seen = -1;
 
-		cell->node_info->conn = establish_db_connection_quiet(cell->node_info->conninfo);
-
 		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
 		{
 
@@ -170,11 +178,10 @@ do_service_status(void)
 		else
 		{
 			cell->node_info->node_status = NODE_STATUS_UP;
-			cell->node_info->recovery_type = get_recovery_type(cell->node_info->conn);
 
-			repmgrd_info[i]->pid = repmgrd_get_pid(cell->node_info->conn);
+			repmgrd_info[i]->pid = replication_info->repmgrd_pid;
 
-			repmgrd_info[i]->running = repmgrd_is_running(cell->node_info->conn);
+			repmgrd_info[i]->running = replication_info->repmgrd_running;
 
 			if (repmgrd_info[i]->running == true)
 			{
@@ -194,13 +201,13 @@ do_service_status(void)
 				maxlen_snprintf(repmgrd_info[i]->pid_text, "%i", repmgrd_info[i]->pid);
 			}
 
-			repmgrd_info[i]->paused = repmgrd_is_paused(cell->node_info->conn);
+			repmgrd_info[i]->paused = replication_info->repmgrd_paused;
 
-			repmgrd_info[i]->recovery_type = get_recovery_type(cell->node_info->conn);
+			repmgrd_info[i]->recovery_type = cell->node_info->recovery_type;
 
 			if (repmgrd_info[i]->recovery_type == RECTYPE_STANDBY)
 			{
-				repmgrd_info[i]->wal_paused_pending_wal = is_wal_replay_paused(cell->node_info->conn, true);
+				repmgrd_info[i]->wal_paused_pending_wal = replication_info->wal_replay_paused;
 
 				if (repmgrd_info[i]->wal_paused_pending_wal == true)
 				{
@@ -210,7 +217,7 @@ do_service_status(void)
 				}
 			}
 
-			repmgrd_info[i]->upstream_last_seen = get_upstream_last_seen(cell->node_info->conn, cell->node_info->type);
+			repmgrd_info[i]->upstream_last_seen = replication_info->upstream_last_seen;
 			if (repmgrd_info[i]->upstream_last_seen < 0)
 			{
 				maxlen_snprintf(repmgrd_info[i]->upstream_last_seen_text, "%s", _("n/a"));
@@ -400,7 +407,6 @@ _do_repmgr_pause(bool pause)
 	PGconn	   *conn = NULL;
 	NodeInfoList nodes = T_NODE_INFO_LIST_INITIALIZER;
 	NodeInfoListCell *cell = NULL;
-	int i;
 	int error_nodes = 0;
 
 	/* Connect to local database to obtain cluster connection data */
@@ -413,15 +419,19 @@ _do_repmgr_pause(bool pause)
 
 	fetch_node_records(conn, &nodes);
 
-	i = 0;
+	/*
+	 * Connect to all nodes concurrently, and (unless --dry-run was provided)
+	 * send the pause/unpause request to all nodes at once, so the overall
+	 * time taken is bounded by the slowest node rather than the sum of all
+	 * nodes.
+	 */
+	(void) establish_node_connections_parallel(&nodes, nodes.node_count);
+
+	if (runtime_options.dry_run == false)
+		(void) repmgrd_pause_parallel(&nodes, pause, config_file_options.async_query_timeout);
 
 	for (cell = nodes.head; cell; cell = cell->next)
 	{
-		log_verbose(LOG_DEBUG, "pausing node %i (%s)",
-					cell->node_info->node_id,
-					cell->node_info->node_name);
-		cell->node_info->conn = establish_db_connection_quiet(cell->node_info->conninfo);
-
 		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
 		{
 			log_warning(_("unable to connect to node %i"),
@@ -447,7 +457,8 @@ _do_repmgr_pause(bool pause)
 			}
 			else
 			{
-				bool success = repmgrd_pause(cell->node_info->conn, pause);
+				/* repmgrd_pause_parallel() sets "details" on failure */
+				bool success = cell->node_info->details[0] == '\0';
 
 				if (success == false)
 					error_nodes++;
@@ -459,9 +470,10 @@ _do_repmgr_pause(bool pause)
 								? pause == true ? "paused" : "unpaused"
 		   						: pause == true ? "not paused" : "not unpaused");
 			}
-			PQfinish(cell->node_info->conn);
 		}
-		i++;
+
+		PQfinish(cell->node_info->conn);
+		cell->node_info->conn = NULL;
 	}
 
 	if (error_nodes > 0)
@@ -47,6 +47,75 @@ typedef struct TablespaceDataList
 } TablespaceDataList;
 
 
+/*
+ * Used by barman mode to distribute the files to be copied from the Barman
+ * server between concurrently executed rsync processes
+ */
+typedef struct BarmanFileSize
+{
+	char	   *path;
+	uint64		size;
+} BarmanFileSize;
+
+typedef struct BarmanFileSizeList
+{
+	BarmanFileSize *files;
+	int			count;
+} BarmanFileSizeList;
+
+#define T_BARMAN_FILE_SIZE_LIST_INITIALIZER { \
+	NULL, \
+	0 \
+}
+
+typedef struct BarmanRestoreChunk
+{
+	/* file containing the list of files to pass to "rsync --files-from" */
+	char		list_filename[MAXPGPATH];
+	/* directory in the Barman backup, i.e. "data" or a tablespace OID */
+	char		source[MAXLEN];
+	char		destination[MAXPGPATH];
+	int			file_count;
+	uint64		bytes;
+} BarmanRestoreChunk;
+
+typedef struct BarmanRestoreChunkList
+{
+	BarmanRestoreChunk *chunks;
+	int			count;
+	int			allocated;
+	/* progress reporting */
+	int			completed_count;
+	int			failed_count;
+	int			completed_files;
+	int			total_files;
+	uint64		completed_bytes;
+	uint64		total_bytes;
+	instr_time	start_time;
+} BarmanRestoreChunkList;
+
+#define T_BARMAN_RESTORE_CHUNK_LIST_INITIALIZER { \
+	NULL, \
+	0, \
+	0, \
+	0, \
+	0, \
+	0, \
+	0, \
+	0, \
+	0 \
+}
+
+/*
+ * Create more chunks than there are rsync processes, so a process which
+ * finishes early can pick up remaining work.
+ */
+#define BARMAN_RESTORE_CHUNKS_PER_JOB	4
+
+/* rsync exit code for "partial transfer due to vanished source files" */
+#define RSYNC_ERR_VANISHED				24
+
+
 typedef struct
 {
 	int			reachable_sibling_node_count;
@@ -64,6 +133,42 @@ typedef struct
 	0 \
 }
 
+/*
+ * Tracks the progress of the follow commands executed concurrently by
+ * sibling_nodes_follow(); "nodes" is indexed by command.
+ */
+typedef struct
+{
+	t_node_info **nodes;
+	int			command_count;
+	int			completed_count;
+	int			failed_count;
+	instr_time	start_time;
+} SiblingFollowState;
+
+/*
+ * A node probed by select_clone_source() as a potential source for
+ * "standby clone --select-source".
+ */
+typedef struct
+{
+	t_node_info *node_info;
+	bool		eligible;
+	char		reason[MAXLEN];
+	XLogRecPtr	replay_lsn;
+	double		transfer_rate;
+	double		score;
+} CloneSourceCandidate;
+
+/* size of the value retrieved to estimate each candidate's transfer rate */
+#define CLONE_SOURCE_SAMPLE_SIZE			(4 * 1024 * 1024)
+
+/* pg_basebackup requires one WAL sender for the backup, one for streaming WAL */
+#define CLONE_SOURCE_MIN_FREE_WAL_SENDERS	2
+
+/* standbys replaying further than this behind the primary are not considered */
+#define CLONE_SOURCE_MAX_REPLAY_LAG			((XLogRecPtr) 64 * 1024 * 1024)
+
 static PGconn *primary_conn = NULL;
 static PGconn *source_conn = NULL;
 
@@ -101,6 +206,8 @@ static void _do_standby_promote_internal(PGconn *conn);
 static void _do_create_replication_conf(void);
 
 static void check_barman_config(void);
+static void select_clone_source(void);
+static void set_clone_source(t_node_info *node_info);
 static void check_source_server(void);
 static void check_source_server_via_barman(void);
 static bool check_upstream_config(PGconn *conn, int server_version_num, t_node_info *node_info, bool exit_on_error);
@@ -118,6 +225,10 @@ static void tablespace_data_append(TablespaceDataList *list, const char *name, c
 static void get_barman_property(char *dst, char *name, char *local_repmgr_directory);
 static int	get_tablespace_data_barman(char *, TablespaceDataList *);
 static char *make_barman_ssh_command(char *buf);
+static char *get_tablespace_destination(TablespaceDataListCell *tablespace, bool *mapping_found);
+static void get_barman_file_sizes(BarmanFileSizeList *file_sizes, const char *basebackups_directory, const char *backup_id);
+static void add_barman_restore_chunks(BarmanRestoreChunkList *chunk_list, const char *list_filename, const char *source, const char *destination, BarmanFileSizeList *file_sizes, int jobs);
+static bool run_barman_restore(BarmanRestoreChunkList *chunk_list, const char *basebackups_directory, const char *backup_id, int jobs);
 
 static bool create_recovery_file(t_node_info *node_record, t_conninfo_param_list *primary_conninfo, int server_version_num, char *dest, bool as_file);
 static void write_primary_conninfo(PQExpBufferData *dest, t_conninfo_param_list *param_list);
@@ -128,6 +239,8 @@ static bool check_free_wal_senders(int available_wal_senders, SiblingNodeStats *
 static bool check_free_slots(t_node_info *local_node_record, SiblingNodeStats *sibling_nodes_stats, bool *dry_run_success);
 
 static void sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats);
+static void sibling_node_follow_completed(int command_index, t_parallel_command *command, void *arg);
+static bool sibling_node_follow_succeeded(t_parallel_command *command);
 
 static t_remote_error_type parse_remote_error(const char *error);
 static CheckStatus parse_check_status(const char *status_str);
@@ -157,6 +270,7 @@ static CheckStatus parse_db_connection(const char *db_connection);
  *  --replication-user (only required if no upstream record)
  *  --without-barman
  *  --replication-conf-only (--recovery-conf-only)
+ *  --select-source
  */
 
 void
@@ -328,6 +442,9 @@ do_standby_clone(void)
 		 * Will error out if source connection not possible and not in
 		 * "barman" mode.
 		 */
+		if (runtime_options.select_source == true && mode != barman)
+			select_clone_source();
+
 		check_source_server();
 
 		/* attempt to retrieve upstream node record */
@@ -2481,9 +2598,10 @@ do_standby_promote(void)
 static void
 _do_standby_promote_internal(PGconn *conn)
 {
-	int			i;
 	bool		promote_success = false;
 	PQExpBufferData details;
+	instr_time	promote_start;
+	int			poll_interval_ms = POLL_INITIAL_INTERVAL_MS;
 
 	RecoveryType recovery_type = RECTYPE_UNKNOWN;
 
@@ -2515,8 +2633,14 @@ _do_standby_promote_internal(PGconn *conn)
 	 * we'll poll the server until the default timeout (60 seconds)
 	 *
 	 * For PostgreSQL 12+, use the pg_promote() function, unless one of
-	 * "service_promote_command" or "use_pg_ctl_promote" is set.
+	 * "service_promote_command" or "use_pg_ctl_promote" is set. This will
+	 * wait for the promotion to complete, so no polling is needed.
 	 */
+	log_notice(_("waiting up to %i seconds (parameter \"promote_check_timeout\") for promotion to complete"),
+			   config_file_options.promote_check_timeout);
+
+	INSTR_TIME_SET_CURRENT(promote_start);
+
 	{
 		bool use_pg_promote = false;
 
@@ -2546,11 +2670,13 @@ _do_standby_promote_internal(PGconn *conn)
 					   local_node_record.node_id);
 
 			/*
-			 * We'll check for promotion success ourselves, but will abort
-			 * if some unrecoverable error prevented the function from being
-			 * executed.
+			 * pg_promote() returns false if the promotion did not complete
+			 * within "promote_check_timeout"; in that case the check below
+			 * will report the node's status. If it returned early, some
+			 * unrecoverable error prevented the function from being executed.
 			 */
-			if (!promote_standby(conn, false, 0))
+			if (!promote_standby(conn, true, config_file_options.promote_check_timeout)
+				&& elapsed_ms(promote_start) < config_file_options.promote_check_timeout * 1000)
 			{
 				log_error(_("unable to promote server from standby to primary"));
 				exit(ERR_PROMOTION_FAIL);
@@ -2577,10 +2703,11 @@ _do_standby_promote_internal(PGconn *conn)
 		}
 	}
 
-	log_notice(_("waiting up to %i seconds (parameter \"promote_check_timeout\") for promotion to complete"),
-			   config_file_options.promote_check_timeout);
-
-	for (i = 0; i < config_file_options.promote_check_timeout; i += config_file_options.promote_check_interval)
+	/*
+	 * Poll with a short, increasing interval (up to "promote_check_interval")
+	 * as promotion usually completes within a fraction of a second.
+	 */
+	for (;;)
 	{
 		recovery_type = get_recovery_type(conn);
 
@@ -2589,7 +2716,11 @@ _do_standby_promote_internal(PGconn *conn)
 			promote_success = true;
 			break;
 		}
-		sleep(config_file_options.promote_check_interval);
+
+		if (elapsed_ms(promote_start) >= config_file_options.promote_check_timeout * 1000)
+			break;
+
+		sleep_with_backoff(&poll_interval_ms, config_file_options.promote_check_interval * 1000);
 	}
 
 	if (promote_success == false)
@@ -2610,7 +2741,8 @@ _do_standby_promote_internal(PGconn *conn)
 		}
 	}
 
-	log_verbose(LOG_INFO, _("standby promoted to primary after %i second(s)"), i);
+	log_verbose(LOG_INFO, _("standby promoted to primary after %.1f second(s)"),
+				(double) elapsed_ms(promote_start) / 1000);
 
 	/* update node information to reflect new status */
 	if (update_node_record_set_primary(conn, config_file_options.node_id) == false)
@@ -2978,7 +3110,8 @@ do_standby_follow(void)
 										   local_xlogpos,
 										   follow_target_conn,
 										   &follow_target_node_record,
-										   false);
+										   false,
+										   NULL);
 
 		if (can_follow == false)
 		{
@@ -3493,6 +3626,9 @@ do_standby_switchover(void)
 	bool		command_success = false;
 	bool		shutdown_success = false;
 	bool		dry_run_success = true;
+	instr_time	shutdown_check_start;
+	int			poll_interval_ms = POLL_INITIAL_INTERVAL_MS;
+	int			last_logged_secs = -1;
 
 	/* this flag will use to generate the final message generated */
 	bool		switchover_success = true;
@@ -4898,15 +5034,28 @@ do_standby_switchover(void)
 	termPQExpBuffer(&command_output);
 	shutdown_success = false;
 
-	/* loop for timeout waiting for current primary to stop */
+	/*
+	 * Loop for timeout waiting for current primary to stop. The check
+	 * interval starts at a fraction of a second and increases up to one
+	 * second, so a fast shutdown is detected without delay.
+	 */
+	INSTR_TIME_SET_CURRENT(shutdown_check_start);
 
-	for (i = 0; i < config_file_options.shutdown_check_timeout; i++)
+	for (;;)
 	{
 		/* Check whether primary is available */
 		PGPing		ping_res;
+		int			elapsed_secs = elapsed_ms(shutdown_check_start) / 1000;
 
-		log_info(_("checking for primary shutdown; %i of %i attempts (\"shutdown_check_timeout\")"),
-				 i + 1, config_file_options.shutdown_check_timeout);
+		if (elapsed_secs >= config_file_options.shutdown_check_timeout)
+			break;
+
+		if (elapsed_secs > last_logged_secs)
+		{
+			log_info(_("checking for primary shutdown; %i of %i seconds (\"shutdown_check_timeout\")"),
+					 elapsed_secs + 1, config_file_options.shutdown_check_timeout);
+			last_logged_secs = elapsed_secs;
+		}
 
 		ping_res = PQping(remote_conninfo);
 
@@ -4977,8 +5126,8 @@ do_standby_switchover(void)
 			termPQExpBuffer(&command_output);
 		}
 
-		log_debug("sleeping 1 second until next check");
-		sleep(1);
+		log_debug("sleeping %i milliseconds until next check", poll_interval_ms);
+		sleep_with_backoff(&poll_interval_ms, 1000);
 	}
 
 	if (shutdown_success == false)
@@ -5014,13 +5163,25 @@ do_standby_switchover(void)
 	 */
 	{
 		bool notice_emitted = false;
+		instr_time	wal_receive_check_start;
+		int			last_logged_secs = -1;
+
+		poll_interval_ms = POLL_INITIAL_INTERVAL_MS;
+		INSTR_TIME_SET_CURRENT(wal_receive_check_start);
 
-		for (i = 0; i < config_file_options.wal_receive_check_timeout; i++)
+		for (;;)
 		{
+			int			elapsed_secs;
+
 			get_replication_info(local_conn, STANDBY, &replication_info);
 			if (replication_info.last_wal_receive_lsn >= remote_last_checkpoint_lsn)
 				break;
 
+			elapsed_secs = elapsed_ms(wal_receive_check_start) / 1000;
+
+			if (elapsed_secs >= config_file_options.wal_receive_check_timeout)
+				break;
+
 			/*
 			 * We'll only output this notice if it looks like we're going to have
 			 * to wait for WAL to be flushed.
@@ -5033,9 +5194,14 @@ do_standby_switchover(void)
 				notice_emitted = true;
 			}
 
-			log_info(_("sleeping %i of maximum %i seconds waiting for standby to flush received WAL to disk"),
-					 i + 1, config_file_options.wal_receive_check_timeout);
-			sleep(1);
+			if (elapsed_secs > last_logged_secs)
+			{
+				log_info(_("waited %i of maximum %i seconds for standby to flush received WAL to disk"),
+						 elapsed_secs, config_file_options.wal_receive_check_timeout);
+				last_logged_secs = elapsed_secs;
+			}
+
+			sleep_with_backoff(&poll_interval_ms, 1000);
 		}
 	}
 
@@ -5461,6 +5627,253 @@ do_standby_switchover(void)
 }
 
 
+/*
+ * select_clone_source()
+ *
+ * For "standby clone --select-source": probe the active primary and standbys
+ * registered on the node provided with -h/--host, and point the source
+ * connection parameters at the most suitable one, so the base backup does
+ * not need to be taken from the primary.
+ *
+ * A standby is eligible if it is streaming from its upstream, is no more than
+ * CLONE_SOURCE_MAX_REPLAY_LAG bytes behind the primary, and has enough free
+ * WAL senders for pg_basebackup. Eligible standbys are ranked by the transfer
+ * rate measured with get_node_transfer_rate(), divided by the number of
+ * WAL senders already in use plus one, so a standby already feeding other
+ * nodes is less likely to be chosen. If no standby is eligible, the node
+ * provided with -h/--host is used as before.
+ */
+static void
+select_clone_source(void)
+{
+	PGconn	   *conn = NULL;
+	NodeInfoList all_nodes = T_NODE_INFO_LIST_INITIALIZER;
+	NodeInfoListCell *cell = NULL;
+	CloneSourceCandidate *candidates = NULL;
+	CloneSourceCandidate *selected = NULL;
+	XLogRecPtr	primary_lsn = InvalidXLogRecPtr;
+	int			candidate_count = 0;
+	int			i;
+
+	log_info(_("probing registered nodes to select a clone source"));
+
+	conn = establish_db_connection_by_params(&source_conninfo, false);
+
+	/* check_source_server() will report the connection failure */
+	if (PQstatus(conn) != CONNECTION_OK)
+	{
+		PQfinish(conn);
+		return;
+	}
+
+	if (get_all_node_records(conn, &all_nodes) == false || all_nodes.node_count == 0)
+	{
+		log_warning(_("unable to retrieve node records from the source node"));
+		log_detail(_("the node provided with -h/--host will be used as clone source"));
+		clear_node_info_list(&all_nodes);
+		PQfinish(conn);
+		return;
+	}
+
+	PQfinish(conn);
+
+	(void) establish_node_connections_parallel(&all_nodes, config_file_options.parallel_jobs);
+
+	candidates = pg_malloc0(sizeof(CloneSourceCandidate) * all_nodes.node_count);
+
+	/*
+	 * The transfer rate is measured for one node at a time, so the
+	 * measurements do not compete with each other for local bandwidth.
+	 */
+	for (cell = all_nodes.head; cell; cell = cell->next)
+	{
+		t_node_info *node_info = cell->node_info;
+		CloneSourceCandidate *candidate = NULL;
+		int			free_wal_senders = 0;
+
+		if (node_info->active == false)
+			continue;
+
+		if (node_info->type != PRIMARY && node_info->type != STANDBY)
+			continue;
+
+		/* the node being cloned may be registered already */
+		if (node_info->node_id == config_file_options.node_id)
+			continue;
+
+		candidate = &candidates[candidate_count++];
+		candidate->node_info = node_info;
+
+		if (PQstatus(node_info->conn) != CONNECTION_OK)
+		{
+			snprintf(candidate->reason, MAXLEN, "%s", _("node is not reachable"));
+			continue;
+		}
+
+		get_node_replication_stats(node_info->conn, node_info);
+
+		if (node_info->type == PRIMARY)
+		{
+			if (node_info->recovery_type != RECTYPE_PRIMARY)
+			{
+				snprintf(candidate->reason, MAXLEN, "%s", _("node is not running as primary"));
+				continue;
+			}
+
+			primary_lsn = get_primary_current_lsn(node_info->conn);
+		}
+		else
+		{
+			ReplInfo	replication_info;
+
+			if (node_info->recovery_type != RECTYPE_STANDBY)
+			{
+				snprintf(candidate->reason, MAXLEN, "%s", _("node is not running as a standby"));
+				continue;
+			}
+
+			init_replication_info(&replication_info);
+
+			if (get_replication_info(node_info->conn, STANDBY, &replication_info) == false)
+			{
+				snprintf(candidate->reason, MAXLEN, "%s", _("unable to retrieve replication information"));
+				continue;
+			}
+
+			if (replication_info.receiving_streamed_wal == false)
+			{
+				snprintf(candidate->reason, MAXLEN, "%s", _("node is not streaming from its upstream"));
+				continue;
+			}
+
+			candidate->replay_lsn = replication_info.last_wal_replay_lsn;
+		}
+
+		free_wal_senders = node_info->max_wal_senders - node_info->attached_wal_receivers;
+
+		if (free_wal_senders < CLONE_SOURCE_MIN_FREE_WAL_SENDERS)
+		{
+			snprintf(candidate->reason, MAXLEN,
+					 _("%i free WAL senders available, at least %i required"),
+					 free_wal_senders,
+					 CLONE_SOURCE_MIN_FREE_WAL_SENDERS);
+			continue;
+		}
+
+		candidate->transfer_rate = get_node_transfer_rate(node_info->conn, CLONE_SOURCE_SAMPLE_SIZE);
+
+		if (candidate->transfer_rate <= 0)
+		{
+			snprintf(candidate->reason, MAXLEN, "%s", _("unable to measure transfer rate"));
+			continue;
+		}
+
+		candidate->score = candidate->transfer_rate / (node_info->attached_wal_receivers + 1);
+		candidate->eligible = true;
+	}
+
+	/* the primary's current LSN is needed to check the standbys' replay lag */
+	for (i = 0; i < candidate_count; i++)
+	{
+		CloneSourceCandidate *candidate = &candidates[i];
+		t_node_info *node_info = candidate->node_info;
+
+		if (candidate->eligible == true && node_info->type == STANDBY
+			&& primary_lsn != InvalidXLogRecPtr && primary_lsn > candidate->replay_lsn
+			&& primary_lsn - candidate->replay_lsn > CLONE_SOURCE_MAX_REPLAY_LAG)
+		{
+			candidate->eligible = false;
+			snprintf(candidate->reason, MAXLEN,
+					 _("replay lag of %lu bytes exceeds %lu bytes"),
+					 (unsigned long) (primary_lsn - candidate->replay_lsn),
+					 (unsigned long) CLONE_SOURCE_MAX_REPLAY_LAG);
+		}
+
+		if (candidate->eligible == true)
+		{
+			log_info(_("node \"%s\" (ID: %i): transfer rate %.1f MB/s, %i WAL sender(s) in use"),
+					 node_info->node_name,
+					 node_info->node_id,
+					 candidate->transfer_rate / (1024 * 1024),
+					 node_info->attached_wal_receivers);
+
+			if (node_info->type == STANDBY && (selected == NULL || candidate->score > selected->score))
+				selected = candidate;
+		}
+		else
+		{
+			log_info(_("node \"%s\" (ID: %i) is not eligible as clone source"),
+					 node_info->node_name,
+					 node_info->node_id);
+			log_detail("%s", candidate->reason);
+		}
+	}
+
+	if (selected == NULL)
+	{
+		log_notice(_("no eligible standby found"));
+		log_detail(_("the node provided with -h/--host will be used as clone source"));
+	}
+	else
+	{
+		log_notice(_("selected node \"%s\" (ID: %i) as clone source"),
+				   selected->node_info->node_name,
+				   selected->node_info->node_id);
+
+		set_clone_source(selected->node_info);
+	}
+
+	pfree(candidates);
+	clear_node_info_list(&all_nodes);
+}
+
+
+/*
+ * Point the source connection parameters (and the host used for SSH
+ * operations) at the provided node. The user and database provided on the
+ * command line are retained.
+ */
+static void
+set_clone_source(t_node_info *node_info)
+{
+	t_conninfo_param_list node_conninfo = T_CONNINFO_PARAM_LIST_INITIALIZER;
+	const char *keywords[] = {"host", "hostaddr", "port", NULL};
+	char	   *errmsg = NULL;
+	char	   *host = NULL;
+	int			i;
+
+	initialize_conninfo_params(&node_conninfo, false);
+
+	if (parse_conninfo_string(node_info->conninfo, &node_conninfo, &errmsg, false) == false)
+	{
+		log_warning(_("unable to parse conninfo string \"%s\" for node %i"),
+					node_info->conninfo,
+					node_info->node_id);
+		log_detail("%s", errmsg);
+		log_detail(_("the node provided with -h/--host will be used as clone source"));
+		free_conninfo_params(&node_conninfo);
+		return;
+	}
+
+	/* an empty value causes libpq to use the default */
+	for (i = 0; keywords[i] != NULL; i++)
+	{
+		char	   *value = param_get(&node_conninfo, keywords[i]);
+
+		param_set(&source_conninfo, keywords[i], value == NULL ? "" : value);
+	}
+
+	host = param_get(&node_conninfo, "host");
+	if (host == NULL)
+		host = param_get(&node_conninfo, "hostaddr");
+
+	if (host != NULL)
+		strncpy(runtime_options.host, host, MAXLEN);
+
+	free_conninfo_params(&node_conninfo);
+}
+
+
 static void
 check_source_server()
 {
@@ -6873,6 +7286,8 @@ run_file_backup(t_node_info *local_node_record)
 	char		backup_id[MAXLEN] = "";
 	TablespaceDataList tablespace_list = {NULL, NULL};
 	TablespaceDataListCell *cell_t = NULL;
+	BarmanFileSizeList file_sizes = T_BARMAN_FILE_SIZE_LIST_INITIALIZER;
+	BarmanRestoreChunkList restore_chunks = T_BARMAN_RESTORE_CHUNK_LIST_INITIALIZER;
 
 	PQExpBufferData tablespace_map;
 	bool		tablespace_map_rewrite = false;
@@ -7051,6 +7466,13 @@ run_file_backup(t_node_info *local_node_record)
 			pclose(fi);
 		}
 
+		/*
+		 * If the backup is to be copied by several rsync processes, fetch
+		 * the file sizes so the files can be distributed evenly between them.
+		 */
+		if (config_file_options.barman_restore_jobs > 1)
+			get_barman_file_sizes(&file_sizes, basebackups_directory, backup_id);
+
 		/* For 9.5 and greater, create our own tablespace_map file */
 		if (source_server_version_num >= 90500)
 		{
@@ -7075,19 +7497,54 @@ run_file_backup(t_node_info *local_node_record)
 		/*
 		 * Copy all backup files from the Barman server
 		 */
-		maxlen_snprintf(command,
-						"rsync --progress -a --files-from=%s %s:%s/%s/data %s",
-						datadir_list_filename,
-						config_file_options.barman_host,
-						basebackups_directory,
-						backup_id,
-						local_data_directory);
+		add_barman_restore_chunks(&restore_chunks,
+								  datadir_list_filename,
+								  "data",
+								  local_data_directory,
+								  &file_sizes,
+								  config_file_options.barman_restore_jobs);
+
+		for (cell_t = tablespace_list.head; cell_t; cell_t = cell_t->next)
+		{
+			char	   *tblspc_dir_dest = get_tablespace_destination(cell_t, NULL);
+
+			create_pg_dir(tblspc_dir_dest, false);
+
+			/* cell_t->fptr == NULL iff the tablespace is empty */
+			if (cell_t->fptr == NULL)
+				continue;
 
-		(void) local_command(
-							 command,
-							 NULL);
+			/* close the file to ensure the contents are flushed to disk */
+			fclose(cell_t->fptr);
+			cell_t->fptr = NULL;
 
-		unlink(datadir_list_filename);
+			maxlen_snprintf(filename,
+							"%s/%s.txt",
+							local_repmgr_tmp_directory,
+							cell_t->oid);
+
+			add_barman_restore_chunks(&restore_chunks,
+									  filename,
+									  cell_t->oid,
+									  tblspc_dir_dest,
+									  &file_sizes,
+									  config_file_options.barman_restore_jobs);
+		}
+
+		for (i = 0; i < file_sizes.count; i++)
+			pfree(file_sizes.files[i].path);
+
+		if (file_sizes.files != NULL)
+			pfree(file_sizes.files);
+
+		if (run_barman_restore(&restore_chunks,
+							   basebackups_directory,
+							   backup_id,
+							   config_file_options.barman_restore_jobs) == false)
+		{
+			r = ERR_BARMAN;
+			goto stop_backup;
+		}
 
 		/*
 		 * We must create some PGDATA subdirectories because they are not
@@ -7155,68 +7612,13 @@ run_file_backup(t_node_info *local_node_record)
 	for (cell_t = tablespace_list.head; cell_t; cell_t = cell_t->next)
 	{
 		bool		mapping_found = false;
-		TablespaceListCell *cell = NULL;
-		char	   *tblspc_dir_dest = NULL;
-
-		/*
-		 * Check if tablespace path matches one of the provided tablespace
-		 * mappings
-		 */
-		if (config_file_options.tablespace_mapping.head != NULL)
-		{
-			for (cell = config_file_options.tablespace_mapping.head; cell; cell = cell->next)
-			{
-				if (strcmp(cell_t->location, cell->old_dir) == 0)
-				{
-					mapping_found = true;
-					break;
-				}
-			}
-		}
+		char	   *tblspc_dir_dest = get_tablespace_destination(cell_t, &mapping_found);
 
 		if (mapping_found == true)
 		{
-			tblspc_dir_dest = cell->new_dir;
 			log_debug(_("mapping source tablespace \"%s\" (OID %s) to \"%s\""),
 					  cell_t->location, cell_t->oid, tblspc_dir_dest);
 		}
-		else
-		{
-			tblspc_dir_dest = cell_t->location;
-		}
-
-		/*
-		 * Tablespace file copy
-		 */
-
-		if (mode == barman)
-		{
-			create_pg_dir(tblspc_dir_dest, false);
-
-			if (cell_t->fptr != NULL)	/* cell_t->fptr == NULL iff the tablespace is
-										 * empty */
-			{
-				/* close the file to ensure the contents are flushed to disk */
-				fclose(cell_t->fptr);
-
-				maxlen_snprintf(command,
-								"rsync --progress -a --files-from=%s/%s.txt %s:%s/%s/%s %s",
-								local_repmgr_tmp_directory,
-								cell_t->oid,
-								config_file_options.barman_host,
-								basebackups_directory,
-								backup_id,
-								cell_t->oid,
-								tblspc_dir_dest);
-				(void) local_command(command,
-									 NULL);
-				maxlen_snprintf(filename,
-								"%s/%s.txt",
-								local_repmgr_tmp_directory,
-								cell_t->oid);
-				unlink(filename);
-			}
-		}
 
 
 		/*
@@ -7458,6 +7860,434 @@ make_barman_ssh_command(char *buf)
 }
 
 
+/*
+ * Return the directory the tablespace should be copied to, i.e. either
+ * the tablespace's original location, or the target of a matching
+ * "tablespace_mapping" entry.
+ */
+static char *
+get_tablespace_destination(TablespaceDataListCell *tablespace, bool *mapping_found)
+{
+	TablespaceListCell *cell = NULL;
+
+	if (mapping_found != NULL)
+		*mapping_found = false;
+
+	for (cell = config_file_options.tablespace_mapping.head; cell; cell = cell->next)
+	{
+		if (strcmp(tablespace->location, cell->old_dir) == 0)
+		{
+			if (mapping_found != NULL)
+				*mapping_found = true;
+
+			return cell->new_dir;
+		}
+	}
+
+	return tablespace->location;
+}
+
+
+static int
+compare_barman_file_size_path(const void *a, const void *b)
+{
+	return strcmp(((const BarmanFileSize *) a)->path,
+				  ((const BarmanFileSize *) b)->path);
+}
+
+
+static int
+compare_barman_file_size_desc(const void *a, const void *b)
+{
+	uint64		size_a = ((const BarmanFileSize *) a)->size;
+	uint64		size_b = ((const BarmanFileSize *) b)->size;
+
+	if (size_a > size_b)
+		return -1;
+
+	if (size_a < size_b)
+		return 1;
+
+	return 0;
+}
+
+
+static int
+compare_barman_restore_chunk_desc(const void *a, const void *b)
+{
+	uint64		bytes_a = ((const BarmanRestoreChunk *) a)->bytes;
+	uint64		bytes_b = ((const BarmanRestoreChunk *) b)->bytes;
+
+	if (bytes_a > bytes_b)
+		return -1;
+
+	if (bytes_a < bytes_b)
+		return 1;
+
+	return ((const BarmanRestoreChunk *) b)->file_count - ((const BarmanRestoreChunk *) a)->file_count;
+}
+
+
+/*
+ * "barman list-files" doesn't report file sizes, so retrieve them for
+ * the entire backup with a single "find" executed on the Barman server.
+ * Paths are relative to the backup directory, e.g. "data/base/1/1259".
+ *
+ * If this fails, "file_sizes" will be empty and files will be distributed
+ * by number rather than by size.
+ */
+static void
+get_barman_file_sizes(BarmanFileSizeList *file_sizes, const char *basebackups_directory, const char *backup_id)
+{
+	char		command[MAXLEN] = "";
+	char		output[MAXLEN] = "";
+	FILE	   *fi = NULL;
+	int			allocated = 0;
+
+	maxlen_snprintf(command,
+					"ssh %s \"find %s/%s -type f -printf '%%s %%P\\\\n'\"",
+					config_file_options.barman_host,
+					basebackups_directory,
+					backup_id);
+
+	log_verbose(LOG_DEBUG, "executing:\n  %s", command);
+
+	fi = popen(command, "r");
+
+	if (fi == NULL)
+	{
+		log_warning(_("unable to execute command:\n  %s"), command);
+		return;
+	}
+
+	while (fgets(output, MAXLEN, fi) != NULL)
+	{
+		char	   *p = NULL;
+		uint64		size = strtoull(output, &p, 10);
+
+		if (p == output || *p != ' ')
+			continue;
+
+		p++;
+		string_remove_trailing_newlines(p);
+
+		if (file_sizes->count == allocated)
+		{
+			allocated = allocated == 0 ? 1024 : allocated * 2;
+			file_sizes->files = pg_realloc(file_sizes->files, sizeof(BarmanFileSize) * allocated);
+		}
+
+		file_sizes->files[file_sizes->count].path = pg_strdup(p);
+		file_sizes->files[file_sizes->count].size = size;
+		file_sizes->count++;
+	}
+
+	if (pclose(fi) != 0 || file_sizes->count == 0)
+	{
+		log_warning(_("unable to retrieve file sizes from the Barman server"));
+		log_hint(_("files will be distributed between rsync processes by number rather than size"));
+	}
+
+	if (file_sizes->count > 0)
+		qsort(file_sizes->files, file_sizes->count, sizeof(BarmanFileSize), compare_barman_file_size_path);
+
+	log_verbose(LOG_DEBUG, "get_barman_file_sizes(): retrieved sizes of %i files", file_sizes->count);
+}
+
+
+/*
+ * Split the list of files in "list_filename" (relative to "source" in the
+ * Barman backup) into chunks of roughly equal size, each of which will be
+ * copied to "destination" by a single rsync process.
+ *
+ * With a single job, the file list is used as-is.
+ */
+static void
+add_barman_restore_chunks(BarmanRestoreChunkList *chunk_list, const char *list_filename, const char *source, const char *destination, BarmanFileSizeList *file_sizes, int jobs)
+{
+	FILE	   *fi = NULL;
+	char		output[MAXLEN] = "";
+	BarmanFileSize *files = NULL;
+	int			file_count = 0;
+	int			allocated = 0;
+	int			chunk_count = 0;
+	int			first_chunk = 0;
+	FILE	  **chunk_files = NULL;
+	int			i;
+
+	fi = fopen(list_filename, "r");
+	if (fi == NULL)
+	{
+		log_error(_("cannot open file: %s"), list_filename);
+		exit(ERR_INTERNAL);
+	}
+
+	while (fgets(output, MAXLEN, fi) != NULL)
+	{
+		BarmanFileSize key;
+		BarmanFileSize *found = NULL;
+		char		path[MAXLEN] = "";
+
+		string_remove_trailing_newlines(output);
+
+		if (output[0] == '\0')
+			continue;
+
+		if (file_count == allocated)
+		{
+			allocated = allocated == 0 ? 1024 : allocated * 2;
+			files = pg_realloc(files, sizeof(BarmanFileSize) * allocated);
+		}
+
+		files[file_count].path = pg_strdup(output);
+		files[file_count].size = 0;
+
+		if (file_sizes->count > 0)
+		{
+			maxlen_snprintf(path, "%s/%s", source, output);
+			key.path = path;
+
+			found = bsearch(&key, file_sizes->files, file_sizes->count,
+							sizeof(BarmanFileSize), compare_barman_file_size_path);
+
+			if (found != NULL)
+				files[file_count].size = found->size;
+		}
+
+		file_count++;
+	}
+
+	fclose(fi);
+
+	if (file_count == 0)
+	{
+		unlink(list_filename);
+		return;
+	}
+
+	chunk_count = jobs > 1 ? jobs * BARMAN_RESTORE_CHUNKS_PER_JOB : 1;
+
+	if (chunk_count > file_count)
+		chunk_count = file_count;
+
+	if (chunk_list->count + chunk_count > chunk_list->allocated)
+	{
+		chunk_list->allocated = chunk_list->count + chunk_count;
+		chunk_list->chunks = pg_realloc(chunk_list->chunks, sizeof(BarmanRestoreChunk) * chunk_list->allocated);
+	}
+
+	first_chunk = chunk_list->count;
+
+	for (i = 0; i < chunk_count; i++)
+	{
+		BarmanRestoreChunk *chunk = &chunk_list->chunks[first_chunk + i];
+
+		memset(chunk, 0, sizeof(BarmanRestoreChunk));
+		strncpy(chunk->source, source, sizeof(chunk->source) - 1);
+		strncpy(chunk->destination, destination, sizeof(chunk->destination) - 1);
+
+		if (chunk_count == 1)
+			strncpy(chunk->list_filename, list_filename, sizeof(chunk->list_filename) - 1);
+		else
+			snprintf(chunk->list_filename, sizeof(chunk->list_filename),
+					 "%s/%s.%i.txt", local_repmgr_tmp_directory, source, i);
+	}
+
+	chunk_list->count += chunk_count;
+
+	if (chunk_count > 1)
+	{
+		chunk_files = pg_malloc0(sizeof(FILE *) * chunk_count);
+
+		for (i = 0; i < chunk_count; i++)
+		{
+			chunk_files[i] = fopen(chunk_list->chunks[first_chunk + i].list_filename, "w");
+
+			if (chunk_files[i] == NULL)
+			{
+				log_error(_("cannot open file: %s"), chunk_list->chunks[first_chunk + i].list_filename);
+				exit(ERR_INTERNAL);
+			}
+		}
+
+		/* largest files first, each added to the chunk with the least data */
+		qsort(files, file_count, sizeof(BarmanFileSize), compare_barman_file_size_desc);
+	}
+
+	for (i = 0; i < file_count; i++)
+	{
+		int			target = 0;
+		int			j;
+
+		for (j = 1; j < chunk_count; j++)
+		{
+			BarmanRestoreChunk *candidate = &chunk_list->chunks[first_chunk + j];
+			BarmanRestoreChunk *current = &chunk_list->chunks[first_chunk + target];
+
+			if (candidate->bytes < current->bytes
+				|| (candidate->bytes == current->bytes && candidate->file_count < current->file_count))
+				target = j;
+		}
+
+		chunk_list->chunks[first_chunk + target].bytes += files[i].size;
+		chunk_list->chunks[first_chunk + target].file_count++;
+
+		if (chunk_files != NULL)
+			fprintf(chunk_files[target], "%s\n", files[i].path);
+
+		pfree(files[i].path);
+	}
+
+	if (chunk_files != NULL)
+	{
+		for (i = 0; i < chunk_count; i++)
+			fclose(chunk_files[i]);
+
+		pfree(chunk_files);
+		unlink(list_filename);
+	}
+
+	pfree(files);
+
+	log_verbose(LOG_DEBUG, "add_barman_restore_chunks(): %i files in \"%s\" split into %i chunks",
+				file_count, source, chunk_count);
+}
+
+
+static void
+barman_restore_chunk_completed(int chunk_index, t_parallel_command *command, void *arg)
+{
+	BarmanRestoreChunkList *chunk_list = (BarmanRestoreChunkList *) arg;
+	BarmanRestoreChunk *chunk = &chunk_list->chunks[chunk_index];
+	instr_time	elapsed;
+	double		elapsed_secs;
+
+	if (command->return_value == RSYNC_ERR_VANISHED)
+	{
+		log_warning(_("some files in \"%s\" vanished before they could be copied"),
+					chunk->source);
+	}
+	else if (command->return_value != 0)
+	{
+		log_error(_("unable to copy files from the Barman server"));
+		log_detail(_("rsync returned %i; command was:\n  %s"),
+				   command->return_value,
+				   command->command.data);
+		chunk_list->failed_count++;
+	}
+
+	chunk_list->completed_count++;
+	chunk_list->completed_files += chunk->file_count;
+	chunk_list->completed_bytes += chunk->bytes;
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, chunk_list->start_time);
+	elapsed_secs = INSTR_TIME_GET_DOUBLE(elapsed);
+
+	if (elapsed_secs <= 0)
+		elapsed_secs = 0.001;
+
+	if (chunk_list->total_bytes > 0)
+	{
+		log_info(_("copied %i of %i file sets from Barman (%.1f of %.1f MB, %.1f MB/s)"),
+				 chunk_list->completed_count,
+				 chunk_list->count,
+				 (double) chunk_list->completed_bytes / (1024 * 1024),
+				 (double) chunk_list->total_bytes / (1024 * 1024),
+				 (double) chunk_list->completed_bytes / (1024 * 1024) / elapsed_secs);
+	}
+	else
+	{
+		log_info(_("copied %i of %i file sets from Barman (%i of %i files, %.1f files/s)"),
+				 chunk_list->completed_count,
+				 chunk_list->count,
+				 chunk_list->completed_files,
+				 chunk_list->total_files,
+				 (double) chunk_list->completed_files / elapsed_secs);
+	}
+}
+
+
+/*
+ * Copy each chunk from the Barman server with its own rsync process,
+ * running at most "jobs" of them at the same time, largest chunks first.
+ *
+ * Returns false if any rsync process failed.
+ */
+static bool
+run_barman_restore(BarmanRestoreChunkList *chunk_list, const char *basebackups_directory, const char *backup_id, int jobs)
+{
+	t_parallel_command *commands = NULL;
+	int			i;
+
+	if (chunk_list->count == 0)
+		return true;
+
+	if (jobs > 1)
+		qsort(chunk_list->chunks, chunk_list->count, sizeof(BarmanRestoreChunk), compare_barman_restore_chunk_desc);
+
+	commands = pg_malloc0(sizeof(t_parallel_command) * chunk_list->count);
+
+	for (i = 0; i < chunk_list->count; i++)
+	{
+		BarmanRestoreChunk *chunk = &chunk_list->chunks[i];
+
+		init_parallel_command(&commands[i]);
+
+		/* rsync's progress output is only useful if a single process is running */
+		appendPQExpBuffer(&commands[i].command,
+						  "rsync %s-a --files-from=%s %s:%s/%s/%s %s",
+						  jobs > 1 ? "" : "--progress ",
+						  chunk->list_filename,
+						  config_file_options.barman_host,
+						  basebackups_directory,
+						  backup_id,
+						  chunk->source,
+						  chunk->destination);
+
+		chunk_list->total_files += chunk->file_count;
+		chunk_list->total_bytes += chunk->bytes;
+	}
+
+	if (jobs > 1)
+	{
+		log_notice(_("copying %i files from Barman using %i rsync processes"),
+				   chunk_list->total_files,
+				   jobs < chunk_list->count ? jobs : chunk_list->count);
+	}
+
+	INSTR_TIME_SET_CURRENT(chunk_list->start_time);
+
+	if (jobs > 1)
+	{
+		execute_commands_parallel_callback(commands,
+										   chunk_list->count,
+										   jobs,
+										   0,
+										   barman_restore_chunk_completed,
+										   chunk_list);
+	}
+	else
+	{
+		for (i = 0; i < chunk_list->count; i++)
+		{
+			(void) local_command_return_value(commands[i].command.data,
+											  NULL,
+											  &commands[i].return_value);
+
+			barman_restore_chunk_completed(i, &commands[i], chunk_list);
+		}
+	}
+
+	for (i = 0; i < chunk_list->count; i++)
+		term_parallel_command(&commands[i]);
+
+	pfree(commands);
+
+	return chunk_list->failed_count == 0;
+}
+
+
 static int
 get_tablespace_data_barman(char *tablespace_data_barman,
 						   TablespaceDataList *tablespace_list)
@@ -8278,23 +9108,37 @@ check_free_slots(t_node_info *local_node_record, SiblingNodeStats *sibling_nodes
 }
 
 
+/*
+ * Execute STANDBY FOLLOW (or WITNESS REGISTER) on each reachable sibling
+ * node; the remote commands are executed concurrently, with at most
+ * "parallel_jobs" running at the same time, and the result reported for
+ * each node as soon as its command completes.
+ */
 static void
 sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats)
 {
-	int			failed_follow_count = 0;
 	char		host[MAXLEN] = "";
 	NodeInfoListCell *cell = NULL;
 	PQExpBufferData remote_command_str;
-	PQExpBufferData command_output;
+	t_parallel_command *commands = NULL;
+	int			command_count = 0;
+	int			i;
+	SiblingFollowState follow_state;
 
 	log_notice(_("executing STANDBY FOLLOW on %i of %i siblings"),
 			   sibling_nodes->node_count - sibling_nodes_stats->unreachable_sibling_node_count,
 			   sibling_nodes->node_count);
 
+	if (sibling_nodes->node_count == 0)
+		return;
+
+	commands = pg_malloc0(sizeof(t_parallel_command) * sibling_nodes->node_count);
+
+	memset(&follow_state, 0, sizeof(follow_state));
+	follow_state.nodes = pg_malloc0(sizeof(t_node_info *) * sibling_nodes->node_count);
+
 	for (cell = sibling_nodes->head; cell; cell = cell->next)
 	{
-		bool		success = false;
-
 		/* skip nodes previously determined as unreachable */
 		if (cell->node_info->reachable == false)
 			continue;
@@ -8334,43 +9178,55 @@ sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes
 		get_conninfo_value(cell->node_info->conninfo, "host", host);
 		log_debug("executing:\n  %s", remote_command_str.data);
 
-		initPQExpBuffer(&command_output);
+		init_parallel_command(&commands[command_count]);
 
-		success = remote_command(host,
-								 runtime_options.remote_user,
-								 remote_command_str.data,
-								 config_file_options.ssh_options,
-								 &command_output);
+		make_remote_command(host,
+							runtime_options.remote_user,
+							remote_command_str.data,
+							config_file_options.ssh_options,
+							&commands[command_count].command);
 
 		termPQExpBuffer(&remote_command_str);
 
-		if (success == false || command_output.data[0] == '0')
-		{
-			if (cell->node_info->type == WITNESS)
-			{
-				log_warning(_("WITNESS REGISTER failed on node \"%s\""),
-							cell->node_info->node_name);
-			}
-			else
-			{
-				log_warning(_("STANDBY FOLLOW failed on node \"%s\""),
-							cell->node_info->node_name);
-			}
+		follow_state.nodes[command_count] = cell->node_info;
+		command_count++;
+	}
 
-			failed_follow_count++;
-		}
+	follow_state.command_count = command_count;
 
-		termPQExpBuffer(&command_output);
+	if (command_count > 1 && config_file_options.parallel_jobs > 1)
+	{
+		log_info(_("executing follow commands on up to %i sibling nodes concurrently"),
+				 config_file_options.parallel_jobs < command_count ? config_file_options.parallel_jobs : command_count);
 	}
 
-	if (failed_follow_count == 0)
+	INSTR_TIME_SET_CURRENT(follow_state.start_time);
+
+	/*
+	 * No timeout is applied, as STANDBY FOLLOW may need to wait for the
+	 * sibling to restart and reconnect.
+	 */
+	execute_commands_parallel_callback(commands,
+									   command_count,
+									   config_file_options.parallel_jobs,
+									   0,
+									   sibling_node_follow_completed,
+									   &follow_state);
+
+	for (i = 0; i < command_count; i++)
+		term_parallel_command(&commands[i]);
+
+	pfree(commands);
+	pfree(follow_state.nodes);
+
+	if (follow_state.failed_count == 0)
 	{
 		log_info(_("STANDBY FOLLOW successfully executed on all reachable sibling nodes"));
 	}
 	else
 	{
 		log_warning(_("execution of STANDBY FOLLOW failed on %i sibling nodes"),
-					failed_follow_count);
+					follow_state.failed_count);
 	}
 
 	/*
@@ -8380,6 +9236,91 @@ sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes
 }
 
 
+static void
+sibling_node_follow_completed(int command_index, t_parallel_command *command, void *arg)
+{
+	SiblingFollowState *follow_state = (SiblingFollowState *) arg;
+	t_node_info *node_info = follow_state->nodes[command_index];
+	instr_time	elapsed;
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, follow_state->start_time);
+
+	follow_state->completed_count++;
+
+	if (sibling_node_follow_succeeded(command) == false)
+	{
+		if (node_info->type == WITNESS)
+		{
+			log_warning(_("WITNESS REGISTER failed on node \"%s\""),
+						node_info->node_name);
+		}
+		else
+		{
+			log_warning(_("STANDBY FOLLOW failed on node \"%s\""),
+						node_info->node_name);
+		}
+
+		follow_state->failed_count++;
+	}
+	else
+	{
+		if (node_info->type == WITNESS)
+		{
+			log_info(_("WITNESS REGISTER executed on node \"%s\" after %.1f seconds"),
+					 node_info->node_name,
+					 INSTR_TIME_GET_DOUBLE(elapsed));
+		}
+		else
+		{
+			log_info(_("STANDBY FOLLOW executed on node \"%s\" after %.1f seconds"),
+					 node_info->node_name,
+					 INSTR_TIME_GET_DOUBLE(elapsed));
+		}
+	}
+
+	log_verbose(LOG_DEBUG, "sibling_node_follow_completed(): %i of %i sibling commands completed",
+				follow_state->completed_count, follow_state->command_count);
+}
+
+
+/*
+ * The remote command echoes "1" on success, "0" on failure. As the output
+ * may be preceded by other text (e.g. a login banner), use the last line
+ * consisting solely of "1" or "0"; if there is no such line, only treat
+ * the command as failed if it exited with an error.
+ */
+static bool
+sibling_node_follow_succeeded(t_parallel_command *command)
+{
+	char		status = '\0';
+	char	   *line = command->output.data;
+
+	/* command could not be executed, or timed out */
+	if (command->return_value == -1)
+		return false;
+
+	while (line != NULL && *line != '\0')
+	{
+		char	   *line_end = strchr(line, '\n');
+		size_t		line_len = (line_end == NULL) ? strlen(line) : (size_t) (line_end - line);
+
+		if (line_len > 0 && line[line_len - 1] == '\r')
+			line_len--;
+
+		if (line_len == 1 && (line[0] == '0' || line[0] == '1'))
+			status = line[0];
+
+		line = (line_end == NULL) ? NULL : line_end + 1;
+	}
+
+	if (status == '\0')
+		return command->return_value == 0;
+
+	return status == '1';
+}
+
+
 
 static t_remote_error_type
 parse_remote_error(const char *error)
@@ -8826,6 +9767,8 @@ do_standby_help(void)
 	printf(_("  --upstream-node-id                  ID of the upstream node to replicate from (optional, defaults to primary node)\n"));
 	printf(_("  --without-barman                    do not use Barman even if configured\n"));
 	printf(_("  --replication-conf-only             generate replication configuration for a previously cloned instance\n"));
+	printf(_("  --select-source                     clone from the most suitable registered standby, rather than\n" \
+			 "                                        the node provided with -h/--host\n"));
 
 	puts("");
 
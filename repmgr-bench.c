@@ -0,0 +1,324 @@
+/*
+ * repmgr-bench.c - microbenchmarks for repmgr's parsing code
+ *
+ * Built and executed with "make benchmark"; not installed.
+ *
+ * Copyright (c) 2ndQuadrant, 2010-2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+
+#include "repmgr.h"
+#include "configfile.h"
+
+#define DEFAULT_BENCH_ITERATIONS	100000
+#define DEFAULT_BENCH_NODES			100
+
+typedef void (*bench_function) (void *arg);
+
+typedef struct
+{
+	char		config_file[MAXPGPATH];
+	char		base_dir[MAXPGPATH];
+} t_config_bench;
+
+typedef struct
+{
+	char	   *output;
+	int			value_count;
+	int			line_count;
+} t_csv_bench;
+
+static void run_benchmark(const char *name, bench_function function, void *arg, int iterations, int ops_per_iteration);
+
+static void bench_parse_conninfo_string(void *arg);
+static void bench_parse_output_to_argv(void *arg);
+static void bench_parse_lsn(void *arg);
+static void bench_parse_config_file(void *arg);
+static void bench_parse_csv(void *arg);
+
+static bool write_bench_config_file(t_config_bench *config_bench);
+static void make_csv_output(t_csv_bench *csv_bench, int node_count, int value_count);
+
+static const char *bench_conninfo = "host=node1.example.com port=5432 user=repmgr dbname=repmgr connect_timeout=2 application_name=node1 sslmode=prefer";
+static const char *bench_argv_string = "--state=SHUTDOWN --last-checkpoint-lsn=16/B374D848 --checkpoint-timeline=3 --wal-level=replica -X stream --checkpoint=fast";
+
+/* prevents the compiler from optimising away parse_lsn() calls */
+static volatile XLogRecPtr bench_lsn = InvalidXLogRecPtr;
+
+
+int
+main(int argc, char **argv)
+{
+	int			iterations = DEFAULT_BENCH_ITERATIONS;
+	int			node_count = DEFAULT_BENCH_NODES;
+	int			csv_iterations;
+	int			c;
+	t_config_bench config_bench;
+	t_csv_bench csv_bench;
+
+	set_progname(argv[0]);
+
+	while ((c = getopt(argc, argv, "i:n:")) != -1)
+	{
+		switch (c)
+		{
+			case 'i':
+				iterations = atoi(optarg);
+				break;
+			case 'n':
+				node_count = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, _("Usage: %s [-i ITERATIONS] [-n NODES]\n"), progname());
+				exit(ERR_BAD_CONFIG);
+		}
+	}
+
+	if (iterations < 1 || node_count < 1)
+	{
+		fprintf(stderr, _("%s: iterations and node count must be greater than zero\n"), progname());
+		exit(ERR_BAD_CONFIG);
+	}
+
+	/* only report errors encountered by the code being benchmarked */
+	log_level = LOG_ERR;
+
+	printf("%-44s %12s %14s\n", "benchmark", "operations", "ns/operation");
+
+	run_benchmark("parse_conninfo_string()", bench_parse_conninfo_string, NULL, iterations, 1);
+	run_benchmark("parse_output_to_argv()", bench_parse_output_to_argv, NULL, iterations, 1);
+	run_benchmark("parse_lsn()", bench_parse_lsn, NULL, iterations, 1);
+
+	if (write_bench_config_file(&config_bench) == true)
+	{
+		run_benchmark("ProcessRepmgrConfigFile()", bench_parse_config_file, &config_bench, iterations / 10, 1);
+		unlink(config_bench.config_file);
+		rmdir(config_bench.base_dir);
+	}
+
+	/*
+	 * "cluster matrix" parses one line per node from each node, "cluster
+	 * crosscheck" one line per node pair; the figures are per line.
+	 */
+	make_csv_output(&csv_bench, node_count, 2);
+	csv_iterations = Max(iterations / csv_bench.line_count, 10);
+	run_benchmark("cluster matrix CSV parsing (per line)", bench_parse_csv, &csv_bench, csv_iterations, csv_bench.line_count);
+	pfree(csv_bench.output);
+
+	make_csv_output(&csv_bench, node_count, 3);
+	csv_iterations = Max(iterations / csv_bench.line_count, 10);
+	run_benchmark("cluster crosscheck CSV parsing (per line)", bench_parse_csv, &csv_bench, csv_iterations, csv_bench.line_count);
+	pfree(csv_bench.output);
+
+	return SUCCESS;
+}
+
+
+static void
+run_benchmark(const char *name, bench_function function, void *arg, int iterations, int ops_per_iteration)
+{
+	instr_time	start_time;
+	instr_time	elapsed;
+	double		total_ops;
+	int			i;
+
+	if (iterations < 1)
+		iterations = 1;
+
+	/* warm up caches and any lazily initialised state */
+	function(arg);
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	for (i = 0; i < iterations; i++)
+		function(arg);
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+	total_ops = (double) iterations * ops_per_iteration;
+
+	printf("%-44s %12.0f %14.1f\n",
+		   name,
+		   total_ops,
+		   INSTR_TIME_GET_DOUBLE(elapsed) * 1000000000.0 / total_ops);
+}
+
+
+static void
+bench_parse_conninfo_string(void *arg)
+{
+	t_conninfo_param_list conninfo_params = T_CONNINFO_PARAM_LIST_INITIALIZER;
+
+	initialize_conninfo_params(&conninfo_params, false);
+	(void) parse_conninfo_string(bench_conninfo, &conninfo_params, NULL, false);
+	free_conninfo_params(&conninfo_params);
+}
+
+
+static void
+bench_parse_output_to_argv(void *arg)
+{
+	char	  **argv_array = NULL;
+
+	(void) parse_output_to_argv(bench_argv_string, &argv_array);
+	free_parsed_argv(&argv_array);
+}
+
+
+static void
+bench_parse_lsn(void *arg)
+{
+	bench_lsn = parse_lsn("16/B374D848");
+}
+
+
+static void
+bench_parse_config_file(void *arg)
+{
+	t_config_bench *config_bench = (t_config_bench *) arg;
+	ItemList	config_errors = {NULL, NULL};
+	ItemList	config_warnings = {NULL, NULL};
+
+	(void) ProcessRepmgrConfigFile(config_bench->config_file,
+								   config_bench->base_dir,
+								   &config_errors,
+								   &config_warnings);
+
+	item_list_free(&config_errors);
+	item_list_free(&config_warnings);
+}
+
+
+static void
+bench_parse_csv(void *arg)
+{
+	t_csv_bench *csv_bench = (t_csv_bench *) arg;
+	char	   *p = csv_bench->output;
+	int			values[3];
+	int			i;
+
+	for (i = 0; i < csv_bench->line_count; i++)
+		(void) parse_csv_int_line(&p, values, csv_bench->value_count);
+}
+
+
+/*
+ * Write a configuration file with a representative set of parameters
+ * to a temporary directory.
+ */
+static bool
+write_bench_config_file(t_config_bench *config_bench)
+{
+	FILE	   *fp;
+	char		template[MAXPGPATH] = "/tmp/repmgr-bench-XXXXXX";
+
+	if (mkdtemp(template) == NULL)
+	{
+		fprintf(stderr, _("%s: unable to create temporary directory: %s\n"), progname(), strerror(errno));
+		return false;
+	}
+
+	strncpy(config_bench->base_dir, template, MAXPGPATH);
+	maxpath_snprintf(config_bench->config_file, "%s/repmgr.conf", template);
+
+	fp = fopen(config_bench->config_file, "w");
+
+	if (fp == NULL)
+	{
+		fprintf(stderr, _("%s: unable to write \"%s\": %s\n"), progname(), config_bench->config_file, strerror(errno));
+		rmdir(config_bench->base_dir);
+		return false;
+	}
+
+	fprintf(fp,
+			"# repmgr-bench configuration file\n"
+			"node_id=1\n"
+			"node_name='node1'\n"
+			"conninfo='%s'\n"
+			"data_directory='/var/lib/postgresql/data'\n"
+			"use_replication_slots=true\n"
+			"pg_bindir='/usr/lib/postgresql/13/bin'\n"
+			"log_level=INFO\n"
+			"log_facility=STDERR\n"
+			"log_status_interval=300\n"
+			"failover=automatic\n"
+			"priority=100\n"
+			"location='dc1'\n"
+			"promote_command='/usr/bin/repmgr standby promote -f /etc/repmgr.conf --log-to-file'\n"
+			"follow_command='/usr/bin/repmgr standby follow -f /etc/repmgr.conf --log-to-file --upstream-node-id=%%n'\n"
+			"monitor_interval_secs=2\n"
+			"reconnect_attempts=6\n"
+			"reconnect_interval=10\n"
+			"connection_check_type=ping\n"
+			"monitoring_history=no\n"
+			"degraded_monitoring_timeout=-1\n"
+			"standby_disconnect_on_failover=false\n"
+			"primary_visibility_consensus=false\n"
+			"service_start_command='sudo systemctl start postgresql'\n"
+			"service_stop_command='sudo systemctl stop postgresql'\n"
+			"service_restart_command='sudo systemctl restart postgresql'\n"
+			"service_reload_command='sudo systemctl reload postgresql'\n"
+			"ssh_options='-q -o ConnectTimeout=10'\n"
+			"pg_basebackup_options='--checkpoint=fast'\n"
+			"parallel_jobs=8\n"
+			"remote_command_timeout=60\n",
+			bench_conninfo);
+
+	fclose(fp);
+
+	return true;
+}
+
+
+/*
+ * Generate output in the format produced by "repmgr cluster show --csv"
+ * (2 values per line) or "repmgr cluster matrix --csv" (3 values per line)
+ * for "node_count" nodes, with every tenth node unreachable.
+ */
+static void
+make_csv_output(t_csv_bench *csv_bench, int node_count, int value_count)
+{
+	PQExpBufferData output;
+	int			i,
+				j;
+
+	initPQExpBuffer(&output);
+
+	csv_bench->value_count = value_count;
+	csv_bench->line_count = 0;
+
+	for (i = 1; i <= (value_count == 3 ? node_count : 1); i++)
+	{
+		for (j = 1; j <= node_count; j++)
+		{
+			int			status = (j % 10 == 0) ? -1 : 0;
+
+			if (value_count == 3)
+				appendPQExpBuffer(&output, "%i,%i,%i\n", i, j, status);
+			else
+				appendPQExpBuffer(&output, "%i,%i\n", j, status);
+
+			csv_bench->line_count++;
+		}
+	}
+
+	csv_bench->output = pg_malloc(output.len + 1);
+	memcpy(csv_bench->output, output.data, output.len + 1);
+
+	termPQExpBuffer(&output);
+}
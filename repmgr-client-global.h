@@ -48,6 +48,7 @@ typedef struct
 	bool		no_wait;
 	bool		compact;
 	bool		detail;
+	bool		batch;
 
 	/* logging options */
 	char		log_level[MAXLEN];	/* overrides setting in repmgr.conf */
@@ -88,6 +89,7 @@ typedef struct
 	char		upstream_conninfo[MAXLEN];
 	bool		without_barman;
 	bool		replication_conf_only;
+	bool		select_source;
 
 	/* "standby clone"/"standby follow" options */
 	int			upstream_node_id;
@@ -135,6 +137,8 @@ typedef struct
 	bool		all;
 	char		event[MAXLEN];
 	int			limit;
+	char		before[MAXLEN];
+	char		after[MAXLEN];
 
 	/* "cluster cleanup" options */
 	int			keep_history;
@@ -150,7 +154,7 @@ typedef struct
 		/* configuration metadata */ \
 		false, false, false, false, false,	\
 		/* general configuration options */	\
-		"", false, false, "", -1, false, false, false, \
+		"", false, false, "", -1, false, false, false, false, \
 		/* logging options */ \
 		"", false, false, false, false,	\
 		/* output options */ \
@@ -163,7 +167,7 @@ typedef struct
 		UNKNOWN_NODE_ID, "", "", UNKNOWN_NODE_ID, \
 		/* "standby clone" options */ \
 		false, CONFIG_FILE_SAMEPATH, false, false, false, "", "", "", \
-		false, false, \
+		false, false, false, \
 		/* "standby clone"/"standby follow" options */ \
 		NO_UPSTREAM_NODE, \
 		/* "standby register" options */ \
@@ -179,7 +183,7 @@ typedef struct
 		/* "node service" options */ \
 		"", false, false, false,  \
 		/* "cluster event" options */ \
-		false, "", CLUSTER_EVENT_LIMIT,	\
+		false, "", CLUSTER_EVENT_LIMIT, "", "", \
 		/* "cluster cleanup" options */ \
 		0, \
 		/* following options for internal use */ \
@@ -287,7 +291,7 @@ extern bool drop_replication_slot_if_exists(PGconn *conn, int node_id, char *slo
 
 extern standy_join_status check_standby_join(PGconn *primary_conn, t_node_info *primary_node_record, t_node_info *standby_node_record);
 extern bool check_replication_slots_available(int node_id, PGconn* conn);
-extern bool check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *follow_target_conn, t_node_info *follow_target_node_record, bool is_rejoin);
+extern bool check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *follow_target_conn, t_node_info *follow_target_node_record, bool is_rejoin, bool *rewind_required);
 extern bool check_replication_config_owner(int pg_version, const char *data_directory, PQExpBufferData *error_msg, PQExpBufferData *detail_msg);
 
 extern void check_shared_library(PGconn *conn);
@@ -53,6 +53,7 @@
 
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <signal.h>
 
 
@@ -98,6 +99,18 @@ static t_user_type ReplicationSlotUser = USER_TYPE_UNKNOWN;
 static ItemList cli_errors = {NULL, NULL};
 static ItemList cli_warnings = {NULL, NULL};
 
+/*
+ * In --batch mode, the configuration file is parsed once, and each command
+ * is executed in a forked process which inherits the parsed configuration.
+ */
+static bool batch_config_loaded = false;
+static char batch_config_file[MAXPGPATH] = "";
+
+#define BATCH_MAX_ARGS 64
+
+static void do_batch(int argc, char **argv);
+static int	parse_batch_command(char *line, char **args, int max_args);
+
 static void _determine_replication_slot_user(PGconn *conn,
 											 t_node_info *upstream_node_record,
 											 char **replication_user);
@@ -279,6 +292,10 @@ main(int argc, char **argv)
 				runtime_options.detail = true;
 				break;
 
+			case OPT_BATCH:
+				runtime_options.batch = true;
+				break;
+
 				/*----------------------------
 				 * database connection options
 				 *----------------------------
@@ -435,6 +452,10 @@ main(int argc, char **argv)
 				runtime_options.replication_conf_only = true;
 				break;
 
+			case OPT_SELECT_SOURCE:
+				runtime_options.select_source = true;
+				break;
+
 
 				/*---------------------------
 				 * "standby register" options
@@ -594,6 +615,32 @@ main(int argc, char **argv)
 				runtime_options.all = true;
 				break;
 
+			case OPT_BEFORE:
+			{
+				t_event_pagination_key key;
+
+				if (parse_event_pagination_key(optarg, &key) == true)
+					strncpy(runtime_options.before, optarg, MAXLEN);
+				else
+					item_list_append_format(&cli_errors,
+											_("invalid value provided for \"--before\": \"%s\""),
+											optarg);
+				break;
+			}
+
+			case OPT_AFTER:
+			{
+				t_event_pagination_key key;
+
+				if (parse_event_pagination_key(optarg, &key) == true)
+					strncpy(runtime_options.after, optarg, MAXLEN);
+				else
+					item_list_append_format(&cli_errors,
+											_("invalid value provided for \"--after\": \"%s\""),
+											optarg);
+				break;
+			}
+
 				/*------------------------
 				 * "cluster cleanup" options
 				 *------------------------
@@ -818,6 +865,20 @@ main(int argc, char **argv)
 		exit_with_cli_errors(&cli_errors, NULL);
 	}
 
+	/* --batch: read commands from stdin; does not return */
+	if (runtime_options.batch == true)
+	{
+		if (optind < argc)
+		{
+			log_error(_("no command may be provided with --batch"));
+			log_hint(_("provide the commands to execute on standard input"));
+			exit(ERR_BAD_CONFIG);
+		}
+
+		free_conninfo_params(&source_conninfo);
+		do_batch(argc, argv);
+	}
+
 	/*----------
 	 * Determine the node type and action; following are valid:
 	 *
@@ -1074,10 +1135,13 @@ main(int argc, char **argv)
 	 * clone'), however if available we'll parse it anyway for options like
 	 * 'log_level', 'use_replication_slots' etc.
 	 */
-	load_config(runtime_options.config_file,
-				runtime_options.verbose,
-				runtime_options.terse,
-				argv[0]);
+	if (batch_config_loaded == false || strcmp(batch_config_file, runtime_options.config_file) != 0)
+	{
+		load_config(runtime_options.config_file,
+					runtime_options.verbose,
+					runtime_options.terse,
+					argv[0]);
+	}
 
 	check_cli_parameters(action);
 
@@ -1194,6 +1258,8 @@ main(int argc, char **argv)
 	if (runtime_options.verbose)
 		logger_set_verbose();
 
+	init_ssh_multiplexing(config_file_options.ssh_multiplexing);
+
 	if (runtime_options.terse)
 		logger_set_terse();
 
@@ -1410,6 +1476,231 @@ main(int argc, char **argv)
 
 
 
+/*
+ * --batch
+ *
+ * Read commands (without the program name, e.g. "node check --role") from
+ * standard input, one per line, and execute them in turn. Options provided
+ * together with --batch (e.g. -f/--config-file) apply to every command.
+ *
+ * The configuration file is parsed once; each command runs in a forked
+ * process which inherits the parsed configuration, so a command which
+ * terminates (as many do, via exit()) does not affect subsequent ones.
+ *
+ * After each command completes, a result line is written to stdout:
+ *
+ *   #repmgr-batch-result command=<n> exit-code=<exit code> elapsed-ms=<ms>
+ *
+ * Empty lines and lines starting with "#" are ignored. The batch exits with
+ * the exit code of the last failed command, or SUCCESS if all succeeded.
+ */
+static void
+do_batch(int argc, char **argv)
+{
+	static const t_runtime_options initial_runtime_options = T_RUNTIME_OPTIONS_INITIALIZER;
+	char		line[MAXLEN * 8];
+	char	  **child_argv;
+	int			base_argc = 0;
+	int			command_number = 0;
+	int			batch_result = SUCCESS;
+	int			i;
+
+	child_argv = pg_malloc0(sizeof(char *) * (argc + BATCH_MAX_ARGS + 1));
+
+	/* options provided with --batch are passed to each command */
+	for (i = 0; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--batch") == 0)
+			continue;
+
+		child_argv[base_argc++] = argv[i];
+	}
+
+	load_config(runtime_options.config_file,
+				runtime_options.verbose,
+				runtime_options.terse,
+				argv[0]);
+
+	batch_config_loaded = true;
+	strncpy(batch_config_file, runtime_options.config_file, MAXPGPATH);
+
+	while (fgets(line, sizeof(line), stdin) != NULL)
+	{
+		int			arg_count;
+		int			exit_code;
+		int			status;
+		pid_t		pid;
+		instr_time	start_time;
+		instr_time	elapsed;
+		size_t		len = strlen(line);
+
+		/* line too long - discard the remainder */
+		if (len > 0 && line[len - 1] != '\n' && !feof(stdin))
+		{
+			int			ch;
+
+			while ((ch = getc(stdin)) != EOF && ch != '\n')
+				;
+
+			command_number++;
+			log_error(_("batch command %i exceeds maximum length of %i characters"),
+					  command_number, (int) sizeof(line) - 1);
+			printf("#repmgr-batch-result command=%i exit-code=%i elapsed-ms=0\n",
+				   command_number, ERR_BAD_CONFIG);
+			fflush(stdout);
+			batch_result = ERR_BAD_CONFIG;
+			continue;
+		}
+
+		arg_count = parse_batch_command(line, child_argv + base_argc, BATCH_MAX_ARGS);
+
+		if (arg_count == 0)
+			continue;
+
+		command_number++;
+
+		if (arg_count < 0)
+		{
+			log_error(_("unable to parse batch command %i"), command_number);
+			log_detail(_("commands may contain at most %i arguments, and quotes must be terminated"),
+					   BATCH_MAX_ARGS);
+			printf("#repmgr-batch-result command=%i exit-code=%i elapsed-ms=0\n",
+				   command_number, ERR_BAD_CONFIG);
+			fflush(stdout);
+			batch_result = ERR_BAD_CONFIG;
+			continue;
+		}
+
+		child_argv[base_argc + arg_count] = NULL;
+
+		fflush(stdout);
+		fflush(stderr);
+
+		INSTR_TIME_SET_CURRENT(start_time);
+
+		pid = fork();
+
+		if (pid == -1)
+		{
+			log_error(_("unable to execute batch command %i"), command_number);
+			log_detail("%s", strerror(errno));
+			exit(ERR_SYS_FAILURE);
+		}
+
+		if (pid == 0)
+		{
+			/* commands don't read from the batch input */
+			if (freopen("/dev/null", "r", stdin) == NULL)
+			{
+				log_warning(_("unable to redirect stdin to \"/dev/null\""));
+			}
+
+			runtime_options = initial_runtime_options;
+
+			optind = 1;
+#ifdef HAVE_INT_OPTRESET
+			optreset = 1;
+#endif
+
+			exit(main(base_argc + arg_count, child_argv));
+		}
+
+		while (waitpid(pid, &status, 0) == -1)
+		{
+			if (errno != EINTR)
+			{
+				log_error(_("unable to wait for batch command %i"), command_number);
+				log_detail("%s", strerror(errno));
+				exit(ERR_SYS_FAILURE);
+			}
+		}
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+		if (WIFEXITED(status))
+			exit_code = WEXITSTATUS(status);
+		else
+			exit_code = ERR_SYS_FAILURE;
+
+		if (exit_code != SUCCESS)
+			batch_result = exit_code;
+
+		printf("#repmgr-batch-result command=%i exit-code=%i elapsed-ms=%.0f\n",
+			   command_number,
+			   exit_code,
+			   INSTR_TIME_GET_MILLISEC(elapsed));
+		fflush(stdout);
+	}
+
+	pfree(child_argv);
+
+	exit(batch_result);
+}
+
+
+/*
+ * Split a batch command line into whitespace-separated arguments, which
+ * may be enclosed in single or double quotes. Arguments are terminated in
+ * place in "line".
+ *
+ * Returns the number of arguments, 0 for an empty line or comment, or -1
+ * if the line could not be parsed.
+ */
+static int
+parse_batch_command(char *line, char **args, int max_args)
+{
+	char	   *src = line;
+	int			arg_count = 0;
+
+	while (*src != '\0')
+	{
+		char	   *dst;
+
+		while (*src == ' ' || *src == '\t' || *src == '\n' || *src == '\r')
+			src++;
+
+		if (*src == '\0')
+			break;
+
+		if (arg_count == 0 && *src == '#')
+			return 0;
+
+		if (arg_count == max_args)
+			return -1;
+
+		args[arg_count++] = dst = src;
+
+		while (*src != '\0' && *src != ' ' && *src != '\t' && *src != '\n' && *src != '\r')
+		{
+			if (*src == '\'' || *src == '"')
+			{
+				char		quote = *src++;
+
+				while (*src != '\0' && *src != quote)
+					*dst++ = *src++;
+
+				if (*src != quote)
+					return -1;
+
+				src++;
+			}
+			else
+			{
+				*dst++ = *src++;
+			}
+		}
+
+		if (*src != '\0')
+			src++;
+
+		*dst = '\0';
+	}
+
+	return arg_count;
+}
+
+
 /*
  * Check for useless or conflicting parameters, and also whether a
  * configuration file is required.
@@ -1452,6 +1743,12 @@ check_cli_parameters(const int action)
 										 _("-c/--fast-checkpoint has no effect in Barman mode"));
 					}
 
+					if (runtime_options.select_source)
+					{
+						item_list_append(&cli_warnings,
+										 _("--select-source has no effect in Barman mode"));
+					}
+
 
 				}
 				else
@@ -1723,6 +2020,24 @@ check_cli_parameters(const int action)
 		}
 	}
 
+	if (runtime_options.select_source == true)
+	{
+		switch (action)
+		{
+			case STANDBY_CLONE:
+				if (runtime_options.replication_conf_only == true)
+				{
+					item_list_append(&cli_warnings,
+									 _("--select-source will be ignored when --replication-conf-only is provided"));
+				}
+				break;
+			default:
+				item_list_append_format(&cli_warnings,
+										_("--select-source will be ignored when executing %s"),
+										action_name(action));
+		}
+	}
+
 	if (runtime_options.event[0])
 	{
 		switch (action)
@@ -1749,6 +2064,19 @@ check_cli_parameters(const int action)
 		}
 	}
 
+	if (runtime_options.before[0] != '\0' || runtime_options.after[0] != '\0')
+	{
+		switch (action)
+		{
+			case CLUSTER_EVENT:
+				break;
+			default:
+				item_list_append_format(&cli_warnings,
+										_("--before/--after not required when executing %s"),
+										action_name(action));
+		}
+	}
+
 	if (runtime_options.all)
 	{
 		switch (action)
@@ -2036,14 +2364,22 @@ format_node_status(t_node_info *node_info, PQExpBufferData *node_status, PQExpBu
 	if (PQstatus(node_info->conn) == CONNECTION_OK)
 	{
 		node_info->node_status = NODE_STATUS_UP;
-		node_info->recovery_type = get_recovery_type(node_info->conn);
+
+		/* recovery type may already have been retrieved by the caller */
+		if (node_info->recovery_type == RECTYPE_UNKNOWN)
+			node_info->recovery_type = get_recovery_type(node_info->conn);
+
 		/* get node's copy of its record so we can see what it thinks its status is */
 		remote_node_rec_found = get_node_record_with_upstream(node_info->conn, node_info->node_id, &remote_node_rec);
 	}
 	else
 	{
-		/* check if node is reachable, but just not letting us in */
-		if (is_server_available_quiet(node_info->conninfo))
+		/*
+		 * Check if node is reachable, but just not letting us in; if the
+		 * connection attempt timed out (no connection handle), there's no
+		 * point in trying again.
+		 */
+		if (node_info->conn != NULL && is_server_available_quiet(node_info->conninfo))
 			node_info->node_status = NODE_STATUS_REJECTED;
 		else
 			node_info->node_status = NODE_STATUS_DOWN;
@@ -2630,6 +2966,7 @@ do_help(void)
 	printf(_("  -b, --pg_bindir=PATH                path to PostgreSQL binaries (optional)\n"));
 	printf(_("  -f, --config-file=PATH              path to the repmgr configuration file\n"));
 	printf(_("  -F, --force                         force potentially dangerous operations to happen\n"));
+	printf(_("  --batch                             execute commands read from standard input, one per line\n"));
 	puts("");
 
 	printf(_("Database connection options:\n"));
@@ -4034,9 +4371,17 @@ check_standby_join(PGconn *upstream_conn, t_node_info *upstream_node_record, t_n
  * can actually be followed.
  *
  * See also comment for check_node_can_follow() in repmgrd-physical.c .
+ *
+ * The follow target's system identification and timeline history are
+ * cached, so repeated checks against the same node during the operation
+ * do not need further replication connections.
+ *
+ * If "rewind_required" is provided, it will be set to false if the local
+ * node's history has definitely not diverged from the follow target's,
+ * i.e. pg_rewind would not need to do anything.
  */
 bool
-check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *follow_target_conn, t_node_info *follow_target_node_record, bool is_rejoin)
+check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *follow_target_conn, t_node_info *follow_target_node_record, bool is_rejoin, bool *rewind_required)
 {
 	uint64		local_system_identifier = UNKNOWN_SYSTEM_IDENTIFIER;
 	PGconn	   *follow_target_repl_conn = NULL;
@@ -4045,27 +4390,35 @@ check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *fo
 
 	const char *action = is_rejoin == true ? "rejoin" : "follow";
 
-	/* check replication connection */
-	follow_target_repl_conn = establish_replication_connection_from_conn(follow_target_conn,
-																		 follow_target_node_record->repluser);
+	if (rewind_required != NULL)
+		*rewind_required = true;
 
-	if (PQstatus(follow_target_repl_conn) != CONNECTION_OK)
+	if (get_cached_system_identification(follow_target_node_record->node_id, &follow_target_identification) == false)
 	{
-		log_error(_("unable to establish a replication connection to the %s target node"), action);
-		return false;
-	}
-	else if (runtime_options.dry_run == true)
-	{
-		log_info(_("replication connection to the %s target node was successful"), action);
-	}
+		/* check replication connection */
+		follow_target_repl_conn = establish_replication_connection_from_conn(follow_target_conn,
+																			 follow_target_node_record->repluser);
 
-	/* check system_identifiers match */
-	if (identify_system(follow_target_repl_conn, &follow_target_identification) == false)
-	{
-		log_error(_("unable to query the %s target node's system identification"), action);
+		if (PQstatus(follow_target_repl_conn) != CONNECTION_OK)
+		{
+			log_error(_("unable to establish a replication connection to the %s target node"), action);
+			return false;
+		}
+		else if (runtime_options.dry_run == true)
+		{
+			log_info(_("replication connection to the %s target node was successful"), action);
+		}
 
-		PQfinish(follow_target_repl_conn);
-		return false;
+		/* check system_identifiers match */
+		if (identify_system(follow_target_repl_conn, &follow_target_identification) == false)
+		{
+			log_error(_("unable to query the %s target node's system identification"), action);
+
+			PQfinish(follow_target_repl_conn);
+			return false;
+		}
+
+		cache_system_identification(follow_target_node_record->node_id, &follow_target_identification);
 	}
 
 	local_system_identifier = get_system_identifier(config_file_options.data_directory);
@@ -4128,6 +4481,9 @@ check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *fo
 					   format_lsn(local_xlogpos),
 					   action,
 					   format_lsn(follow_target_xlogpos));
+
+			if (rewind_required != NULL)
+				*rewind_required = false;
 		}
 		else
 		{
@@ -4145,14 +4501,36 @@ check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *fo
 		/*
 		 * upstream has higher timeline - check where it forked off from this node's timeline
 		 */
-		TimeLineHistoryEntry *follow_target_history = get_timeline_history(follow_target_repl_conn,
-																		   local_tli + 1);
+		TimeLineHistoryEntry *follow_target_history = get_cached_timeline_history(follow_target_identification.system_identifier,
+																				  local_tli + 1);
 
 		if (follow_target_history == NULL)
 		{
-			/* get_timeline_history() will emit relevant error messages */
-			PQfinish(follow_target_repl_conn);
-			return false;
+			if (follow_target_repl_conn == NULL)
+			{
+				follow_target_repl_conn = establish_replication_connection_from_conn(follow_target_conn,
+																					 follow_target_node_record->repluser);
+
+				if (PQstatus(follow_target_repl_conn) != CONNECTION_OK)
+				{
+					log_error(_("unable to establish a replication connection to the %s target node"), action);
+					return false;
+				}
+			}
+
+			follow_target_history = get_timeline_history(follow_target_repl_conn,
+														 local_tli + 1);
+
+			if (follow_target_history == NULL)
+			{
+				/* get_timeline_history() will emit relevant error messages */
+				PQfinish(follow_target_repl_conn);
+				return false;
+			}
+
+			cache_timeline_history(follow_target_identification.system_identifier,
+								   local_tli + 1,
+								   follow_target_history);
 		}
 
 		log_debug("local tli: %i; local_xlogpos: %X/%X; follow_target_history->tli: %i; follow_target_history->end: %X/%X",
@@ -4195,6 +4573,16 @@ check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *fo
 			}
 		}
 
+		/*
+		 * The local node's recovery point lies before the fork, so its
+		 * history is contained in the follow target's. The comparison is
+		 * strict here as for a former primary "local_xlogpos" is the start
+		 * of the shutdown checkpoint record; if the fork point is exactly
+		 * there, the follow target does not have that record.
+		 */
+		if (local_xlogpos < follow_target_history->end && rewind_required != NULL)
+			*rewind_required = false;
+
 		if (success == true)
 		{
 			if (is_rejoin == false || (is_rejoin == true && runtime_options.force_rewind_used == false))
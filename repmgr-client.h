@@ -98,6 +98,10 @@
 #define OPT_REPMGRD_FORCE_UNPAUSE		   1045
 #define OPT_REPLICATION_CONFIG_OWNER	   1046
 #define OPT_DB_CONNECTION				   1047
+#define OPT_BEFORE						   1048
+#define OPT_AFTER						   1049
+#define OPT_BATCH						   1050
+#define OPT_SELECT_SOURCE				   1051
 
 /* These options are for internal use only */
 #define OPT_CONFIG_ARCHIVE_DIR			   2001
@@ -124,6 +128,7 @@ static struct option long_options[] =
 	{"no-wait", no_argument, NULL, 'W'},
 	{"compact", no_argument, NULL, OPT_COMPACT},
 	{"detail", no_argument, NULL, OPT_DETAIL},
+	{"batch", no_argument, NULL, OPT_BATCH},
 
 /* connection options */
 	{"dbname", required_argument, NULL, 'd'},
@@ -162,6 +167,7 @@ static struct option long_options[] =
 	{"replication-conf-only", no_argument, NULL, OPT_REPLICATION_CONF_ONLY},
 	/* deprecate this once Pg11 and earlier are unsupported */
 	{"recovery-conf-only", no_argument, NULL, OPT_REPLICATION_CONF_ONLY},
+	{"select-source", no_argument, NULL, OPT_SELECT_SOURCE},
 
 /* "standby register" options */
 	{"wait-start", required_argument, NULL, OPT_WAIT_START},
@@ -207,6 +213,8 @@ static struct option long_options[] =
 	{"all", no_argument, NULL, OPT_ALL},
 	{"event", required_argument, NULL, OPT_EVENT},
 	{"limit", required_argument, NULL, OPT_LIMIT},
+	{"before", required_argument, NULL, OPT_BEFORE},
+	{"after", required_argument, NULL, OPT_AFTER},
 
 /* "cluster cleanup" options */
 	{"keep-history", required_argument, NULL, 'k'},
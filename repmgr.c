@@ -23,9 +23,12 @@
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
+#include "access/htup_details.h"
 #include "access/xlog.h"
 #include "miscadmin.h"
 #include "replication/walreceiver.h"
+#include "storage/barrier.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
 #include "storage/lwlock.h"
@@ -36,6 +39,10 @@
 
 #if (PG_VERSION_NUM >= 90400)
 #include "utils/pg_lsn.h"
+#else
+/* no PG_LSN datatype in 9.3; LSNs are passed as text in "%X/%X" format */
+#define PG_GETARG_LSN(n)	(text_to_lsn(PG_GETARG_TEXT_PP(n)))
+#define LSNGetDatum(X)		(lsn_to_text_datum(X))
 #endif
 
 #include "utils/timestamp.h"
@@ -60,6 +67,15 @@
 #define REPMGRD_STATE_FILE PGSTAT_STAT_PERMANENT_DIRECTORY "/repmgrd_state.txt"
 #define REPMGRD_STATE_FILE_BUF_SIZE 128
 
+/* number of monitoring samples retained in shared memory */
+#define MONITORING_SAMPLE_BUFFER_SIZE 1024
+#define MONITORING_SAMPLE_COPY_BATCH 32		/* samples copied per spinlock acquisition */
+
+/* failover phase timings */
+#define FAILOVER_PHASE_SLOTS 16
+#define FAILOVER_PHASE_NAME_LEN 32
+#define FAILOVER_PHASE_HISTOGRAM_BUCKETS 12
+
 PG_MODULE_MAGIC;
 
 typedef enum
@@ -69,9 +85,19 @@ typedef enum
 	CANDIDATE_NODE
 } NodeState;
 
+/*
+ * State shared between repmgrd and the SQL functions below.
+ *
+ * Writers serialise on "lock", and increment "change_count" before and
+ * after each modification, so it is odd while a modification is in progress.
+ * Readers do not take the lock; read_shared_state() copies the struct and
+ * retries if a modification was in progress or completed meanwhile. Reads
+ * therefore never block, or are blocked by, other readers or the writer.
+ */
 typedef struct repmgrdSharedState
 {
-	LWLockId	lock;			/* protects search/modification */
+	LWLockId	lock;			/* serialises modifications */
+	uint32		change_count;
 	TimestampTz last_updated;
 	int			local_node_id;
 	int			repmgrd_pid;
@@ -84,17 +110,105 @@ typedef struct repmgrdSharedState
 	int			current_electoral_term;
 	int			candidate_node_id;
 	bool		follow_new_primary;
+	/* pre-vote published by this node as promotion candidate */
+	int			prevote_term;
+	XLogRecPtr	prevote_lsn;
+	XLogRecPtr	prevote_replay_lsn;
+	int			prevote_lag_time;
 } repmgrdSharedState;
 
+/*
+ * Monitoring samples (replication lag etc.) written by repmgrd on each
+ * monitoring cycle, stored in a fixed-size ring buffer.
+ *
+ * This is protected by a spinlock rather than the main LWLock, as it is
+ * updated frequently and access only involves copying a sample into
+ * or out of the buffer.
+ */
+typedef struct repmgrdMonitoringSample
+{
+	TimestampTz sample_time;
+	int			primary_node_id;
+	XLogRecPtr	last_wal_primary_location;	/* InvalidXLogRecPtr if not known */
+	XLogRecPtr	last_wal_standby_location;
+	TimestampTz last_apply_time;	/* 0 if not known */
+	int64		replication_lag;
+	int64		apply_lag;
+} repmgrdMonitoringSample;
+
+typedef struct repmgrdMonitoringSamples
+{
+	slock_t		mutex;
+	uint64		sample_count;	/* total number of samples ever written */
+	repmgrdMonitoringSample samples[MONITORING_SAMPLE_BUFFER_SIZE];
+} repmgrdMonitoringSamples;
+
+/*
+ * Timings of the individual phases of a failover (detection, election,
+ * promotion etc.) reported by repmgrd, together with a histogram of
+ * all durations recorded for each phase since server start.
+ *
+ * Phases are identified by name, and a slot is assigned to each phase
+ * the first time it is reported.
+ */
+typedef struct repmgrdFailoverPhaseTiming
+{
+	char		phase[FAILOVER_PHASE_NAME_LEN];
+	TimestampTz last_recorded;
+	int64		last_duration_us;
+	int64		count;
+	int64		total_us;
+	int64		max_us;
+	int64		histogram[FAILOVER_PHASE_HISTOGRAM_BUCKETS];
+} repmgrdFailoverPhaseTiming;
+
+typedef struct repmgrdFailoverPhaseTimings
+{
+	slock_t		mutex;
+	int			phase_count;
+	repmgrdFailoverPhaseTiming phases[FAILOVER_PHASE_SLOTS];
+} repmgrdFailoverPhaseTimings;
+
+/*
+ * Upper bounds (in milliseconds) of the histogram buckets; the final
+ * bucket has no upper bound.
+ */
+static const int64 failover_phase_histogram_bounds_ms[FAILOVER_PHASE_HISTOGRAM_BUCKETS - 1] = {
+	1, 5, 10, 50, 100, 500, 1000, 5000, 10000, 30000, 60000
+};
+
 static repmgrdSharedState *shared_state = NULL;
+static repmgrdMonitoringSamples *monitoring_samples = NULL;
+static repmgrdFailoverPhaseTimings *failover_phase_timings = NULL;
 
 static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
 
+#define SHARED_STATE_BEGIN_WRITE() \
+	do { \
+		LWLockAcquire(shared_state->lock, LW_EXCLUSIVE); \
+		shared_state->change_count++; \
+		pg_write_barrier(); \
+	} while (0)
+
+#define SHARED_STATE_END_WRITE() \
+	do { \
+		pg_write_barrier(); \
+		shared_state->change_count++; \
+		LWLockRelease(shared_state->lock); \
+	} while (0)
+
 
 void		_PG_init(void);
 void		_PG_fini(void);
 
 static void repmgr_shmem_startup(void);
+static void read_shared_state(repmgrdSharedState *snapshot);
+static int	copy_failover_phase_timings(repmgrdFailoverPhaseTiming *phases);
+
+#if (PG_VERSION_NUM < 90400)
+static XLogRecPtr text_to_lsn(text *lsn_text);
+static Datum lsn_to_text_datum(XLogRecPtr lsn);
+#endif
 
 Datum		set_local_node_id(PG_FUNCTION_ARGS);
 PG_FUNCTION_INFO_V1(set_local_node_id);
@@ -129,6 +243,15 @@ PG_FUNCTION_INFO_V1(get_new_primary);
 Datum		reset_voting_status(PG_FUNCTION_ARGS);
 PG_FUNCTION_INFO_V1(reset_voting_status);
 
+Datum		set_prevote(PG_FUNCTION_ARGS);
+PG_FUNCTION_INFO_V1(set_prevote);
+
+Datum		get_election_status(PG_FUNCTION_ARGS);
+PG_FUNCTION_INFO_V1(get_election_status);
+
+Datum		get_repmgrd_state(PG_FUNCTION_ARGS);
+PG_FUNCTION_INFO_V1(get_repmgrd_state);
+
 Datum		set_repmgrd_pid(PG_FUNCTION_ARGS);
 PG_FUNCTION_INFO_V1(set_repmgrd_pid);
 
@@ -150,6 +273,21 @@ PG_FUNCTION_INFO_V1(repmgrd_is_paused);
 Datum		get_wal_receiver_pid(PG_FUNCTION_ARGS);
 PG_FUNCTION_INFO_V1(get_wal_receiver_pid);
 
+Datum		add_monitoring_sample(PG_FUNCTION_ARGS);
+PG_FUNCTION_INFO_V1(add_monitoring_sample);
+
+Datum		get_recent_monitoring(PG_FUNCTION_ARGS);
+PG_FUNCTION_INFO_V1(get_recent_monitoring);
+
+Datum		set_failover_phase_timing(PG_FUNCTION_ARGS);
+PG_FUNCTION_INFO_V1(set_failover_phase_timing);
+
+Datum		get_failover_phase_timings(PG_FUNCTION_ARGS);
+PG_FUNCTION_INFO_V1(get_failover_phase_timings);
+
+Datum		get_failover_phase_histogram(PG_FUNCTION_ARGS);
+PG_FUNCTION_INFO_V1(get_failover_phase_histogram);
+
 
 /*
  * Module load callback
@@ -163,6 +301,8 @@ _PG_init(void)
 		return;
 
 	RequestAddinShmemSpace(MAXALIGN(sizeof(repmgrdSharedState)));
+	RequestAddinShmemSpace(MAXALIGN(sizeof(repmgrdMonitoringSamples)));
+	RequestAddinShmemSpace(MAXALIGN(sizeof(repmgrdFailoverPhaseTimings)));
 
 #if (PG_VERSION_NUM >= 90600)
 	RequestNamedLWLockTranche(TRANCHE_NAME, 1);
@@ -203,6 +343,8 @@ repmgr_shmem_startup(void)
 
 	/* reset in case this is a restart within the postmaster */
 	shared_state = NULL;
+	monitoring_samples = NULL;
+	failover_phase_timings = NULL;
 
 	/*
 	 * Create or attach to the shared memory state, including hash table
@@ -222,6 +364,8 @@ repmgr_shmem_startup(void)
 		shared_state->lock = LWLockAssign();
 #endif
 
+		shared_state->change_count = 0;
+		shared_state->last_updated = 0;
 		shared_state->local_node_id = UNKNOWN_NODE_ID;
 		shared_state->repmgrd_pid = UNKNOWN_PID;
 		memset(shared_state->repmgrd_pidfile, 0, MAXPGPATH);
@@ -233,12 +377,64 @@ repmgr_shmem_startup(void)
 		shared_state->voting_status = VS_NO_VOTE;
 		shared_state->candidate_node_id = UNKNOWN_NODE_ID;
 		shared_state->follow_new_primary = false;
+		shared_state->prevote_term = 0;
+		shared_state->prevote_lsn = InvalidXLogRecPtr;
+		shared_state->prevote_replay_lsn = InvalidXLogRecPtr;
+		shared_state->prevote_lag_time = 0;
+	}
+
+	monitoring_samples = ShmemInitStruct("repmgrd monitoring samples",
+										 sizeof(repmgrdMonitoringSamples),
+										 &found);
+
+	if (!found)
+	{
+		SpinLockInit(&monitoring_samples->mutex);
+		monitoring_samples->sample_count = 0;
+	}
+
+	failover_phase_timings = ShmemInitStruct("repmgrd failover phase timings",
+											 sizeof(repmgrdFailoverPhaseTimings),
+											 &found);
+
+	if (!found)
+	{
+		SpinLockInit(&failover_phase_timings->mutex);
+		failover_phase_timings->phase_count = 0;
 	}
 
 	LWLockRelease(AddinShmemInitLock);
 }
 
 
+/*
+ * Take a consistent copy of the shared state without acquiring the lock.
+ */
+static void
+read_shared_state(repmgrdSharedState *snapshot)
+{
+	volatile repmgrdSharedState *state = shared_state;
+
+	for (;;)
+	{
+		uint32		before_change_count = state->change_count;
+
+		pg_read_barrier();
+
+		memcpy(snapshot, (const void *) state, sizeof(repmgrdSharedState));
+
+		pg_read_barrier();
+
+		if ((before_change_count & 1) == 0 &&
+			before_change_count == state->change_count)
+			break;
+
+		/* a modification is in progress; it will be brief */
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+
 /* ==================== */
 /* monitoring functions */
 /* ==================== */
@@ -286,7 +482,7 @@ set_local_node_id(PG_FUNCTION_ARGS)
 
 	}
 
-	LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
+	SHARED_STATE_BEGIN_WRITE();
 
 	/* only set local_node_id once, as it should never change */
 	if (shared_state->local_node_id == UNKNOWN_NODE_ID)
@@ -307,7 +503,7 @@ set_local_node_id(PG_FUNCTION_ARGS)
 		}
 	}
 
-	LWLockRelease(shared_state->lock);
+	SHARED_STATE_END_WRITE();
 
 	PG_RETURN_VOID();
 }
@@ -316,16 +512,14 @@ set_local_node_id(PG_FUNCTION_ARGS)
 Datum
 get_local_node_id(PG_FUNCTION_ARGS)
 {
-	int			local_node_id = UNKNOWN_NODE_ID;
+	repmgrdSharedState state;
 
 	if (!shared_state)
 		PG_RETURN_NULL();
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
-	local_node_id = shared_state->local_node_id;
-	LWLockRelease(shared_state->lock);
+	read_shared_state(&state);
 
-	PG_RETURN_INT32(local_node_id);
+	PG_RETURN_INT32(state.local_node_id);
 }
 
 
@@ -338,9 +532,9 @@ standby_set_last_updated(PG_FUNCTION_ARGS)
 	if (!shared_state)
 		PG_RETURN_NULL();
 
-	LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
+	SHARED_STATE_BEGIN_WRITE();
 	shared_state->last_updated = last_updated;
-	LWLockRelease(shared_state->lock);
+	SHARED_STATE_END_WRITE();
 
 	PG_RETURN_TIMESTAMPTZ(last_updated);
 }
@@ -350,17 +544,15 @@ standby_set_last_updated(PG_FUNCTION_ARGS)
 Datum
 standby_get_last_updated(PG_FUNCTION_ARGS)
 {
-	TimestampTz last_updated;
+	repmgrdSharedState state;
 
 	/* Safety check... */
 	if (!shared_state)
 		PG_RETURN_NULL();
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
-	last_updated = shared_state->last_updated;
-	LWLockRelease(shared_state->lock);
+	read_shared_state(&state);
 
-	PG_RETURN_TIMESTAMPTZ(last_updated);
+	PG_RETURN_TIMESTAMPTZ(state.last_updated);
 }
 
 
@@ -368,6 +560,7 @@ Datum
 set_upstream_last_seen(PG_FUNCTION_ARGS)
 {
 	int			upstream_node_id = UNKNOWN_NODE_ID;
+	TimestampTz last_seen;
 
 	if (!shared_state)
 		PG_RETURN_VOID();
@@ -377,11 +570,12 @@ set_upstream_last_seen(PG_FUNCTION_ARGS)
 
 	upstream_node_id = PG_GETARG_INT32(0);
 
-	LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
+	last_seen = GetCurrentTimestamp();
 
-	shared_state->upstream_last_seen = GetCurrentTimestamp();
+	SHARED_STATE_BEGIN_WRITE();
+	shared_state->upstream_last_seen = last_seen;
 	shared_state->upstream_node_id = upstream_node_id;
-	LWLockRelease(shared_state->lock);
+	SHARED_STATE_END_WRITE();
 
 	PG_RETURN_VOID();
 }
@@ -393,15 +587,14 @@ get_upstream_last_seen(PG_FUNCTION_ARGS)
 	long		secs;
 	int			microsecs;
 	TimestampTz last_seen;
+	repmgrdSharedState state;
 
 	if (!shared_state)
 		PG_RETURN_INT32(-1);
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
-
-	last_seen = shared_state->upstream_last_seen;
+	read_shared_state(&state);
 
-	LWLockRelease(shared_state->lock);
+	last_seen = state.upstream_last_seen;
 
 	/*
 	 * "last_seen" is initialised with the PostgreSQL epoch as a
@@ -424,23 +617,21 @@ get_upstream_last_seen(PG_FUNCTION_ARGS)
 Datum
 get_upstream_node_id(PG_FUNCTION_ARGS)
 {
-	int			upstream_node_id = UNKNOWN_NODE_ID;
+	repmgrdSharedState state;
 
 	if (!shared_state)
 		PG_RETURN_NULL();
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
-	upstream_node_id = shared_state->upstream_node_id;
-	LWLockRelease(shared_state->lock);
+	read_shared_state(&state);
 
-	PG_RETURN_INT32(upstream_node_id);
+	PG_RETURN_INT32(state.upstream_node_id);
 }
 
 Datum
 set_upstream_node_id(PG_FUNCTION_ARGS)
 {
 	int			upstream_node_id = UNKNOWN_NODE_ID;
-	int			local_node_id = UNKNOWN_NODE_ID;
+	repmgrdSharedState state;
 
 	if (!shared_state)
 		PG_RETURN_NULL();
@@ -450,18 +641,16 @@ set_upstream_node_id(PG_FUNCTION_ARGS)
 
 	upstream_node_id = PG_GETARG_INT32(0);
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
-	local_node_id = shared_state->local_node_id;
-	LWLockRelease(shared_state->lock);
+	read_shared_state(&state);
 
-	if (local_node_id == upstream_node_id)
+	if (state.local_node_id == upstream_node_id)
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 				 (errmsg("upstream node id cannot be the same as the local node id"))));
 
-	LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
+	SHARED_STATE_BEGIN_WRITE();
 	shared_state->upstream_node_id = upstream_node_id;
-	LWLockRelease(shared_state->lock);
+	SHARED_STATE_END_WRITE();
 
 	PG_RETURN_VOID();
 }
@@ -476,6 +665,7 @@ Datum
 notify_follow_primary(PG_FUNCTION_ARGS)
 {
 	int			primary_node_id = UNKNOWN_NODE_ID;
+	repmgrdSharedState state;
 
 	if (!shared_state)
 		PG_RETURN_VOID();
@@ -485,32 +675,30 @@ notify_follow_primary(PG_FUNCTION_ARGS)
 
 	primary_node_id = PG_GETARG_INT32(0);
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
+	read_shared_state(&state);
 
 	/* only do something if local_node_id is initialised */
-	if (shared_state->local_node_id != UNKNOWN_NODE_ID)
+	if (state.local_node_id != UNKNOWN_NODE_ID)
 	{
 		if (primary_node_id == ELECTION_RERUN_NOTIFICATION)
 		{
 			elog(INFO, "node %i received notification to rerun promotion candidate election",
-				 shared_state->local_node_id);
+				 state.local_node_id);
 		}
 		else
 		{
 			elog(INFO, "node %i received notification to follow node %i",
-				 shared_state->local_node_id,
+				 state.local_node_id,
 				 primary_node_id);
 		}
 
-		LWLockRelease(shared_state->lock);
-		LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
+		SHARED_STATE_BEGIN_WRITE();
 		/* Explicitly set the primary node id */
 		shared_state->candidate_node_id = primary_node_id;
 		shared_state->follow_new_primary = true;
+		SHARED_STATE_END_WRITE();
 	}
 
-	LWLockRelease(shared_state->lock);
-
 	PG_RETURN_VOID();
 }
 
@@ -519,16 +707,15 @@ Datum
 get_new_primary(PG_FUNCTION_ARGS)
 {
 	int			new_primary_node_id = UNKNOWN_NODE_ID;
+	repmgrdSharedState state;
 
 	if (!shared_state)
 		PG_RETURN_INT32(UNKNOWN_NODE_ID);
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
-
-	if (shared_state->follow_new_primary == true)
-		new_primary_node_id = shared_state->candidate_node_id;
+	read_shared_state(&state);
 
-	LWLockRelease(shared_state->lock);
+	if (state.follow_new_primary == true)
+		new_primary_node_id = state.candidate_node_id;
 
 	if (new_primary_node_id == UNKNOWN_NODE_ID)
 		PG_RETURN_INT32(UNKNOWN_NODE_ID);
@@ -540,28 +727,190 @@ get_new_primary(PG_FUNCTION_ARGS)
 Datum
 reset_voting_status(PG_FUNCTION_ARGS)
 {
+	repmgrdSharedState state;
+
 	if (!shared_state)
 		PG_RETURN_NULL();
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
+	read_shared_state(&state);
 
 	/* only do something if local_node_id is initialised */
-	if (shared_state->local_node_id != UNKNOWN_NODE_ID)
+	if (state.local_node_id != UNKNOWN_NODE_ID)
 	{
-		LWLockRelease(shared_state->lock);
-		LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
-
+		SHARED_STATE_BEGIN_WRITE();
 		shared_state->voting_status = VS_NO_VOTE;
 		shared_state->candidate_node_id = UNKNOWN_NODE_ID;
 		shared_state->follow_new_primary = false;
+		shared_state->prevote_term = 0;
+		shared_state->prevote_lsn = InvalidXLogRecPtr;
+		shared_state->prevote_replay_lsn = InvalidXLogRecPtr;
+		shared_state->prevote_lag_time = 0;
+		SHARED_STATE_END_WRITE();
 	}
 
-	LWLockRelease(shared_state->lock);
+	PG_RETURN_VOID();
+}
+
+
+/*
+ * Publish the electoral term, receive and replay LSNs and replication lag
+ * (in seconds) with which this node stands as promotion candidate, so
+ * sibling candidates compare themselves against the same values this
+ * node uses.
+ */
+Datum
+set_prevote(PG_FUNCTION_ARGS)
+{
+	int			electoral_term;
+	XLogRecPtr	lsn;
+	XLogRecPtr	replay_lsn;
+	int			lag_time;
+
+	if (!shared_state)
+		PG_RETURN_VOID();
+
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1) || PG_ARGISNULL(2) || PG_ARGISNULL(3))
+		PG_RETURN_VOID();
+
+	electoral_term = PG_GETARG_INT32(0);
+	lsn = PG_GETARG_LSN(1);
+	replay_lsn = PG_GETARG_LSN(2);
+	lag_time = PG_GETARG_INT32(3);
+
+	SHARED_STATE_BEGIN_WRITE();
+	shared_state->current_electoral_term = electoral_term;
+	shared_state->prevote_term = electoral_term;
+	shared_state->prevote_lsn = lsn;
+	shared_state->prevote_replay_lsn = replay_lsn;
+	shared_state->prevote_lag_time = lag_time;
+	SHARED_STATE_END_WRITE();
 
 	PG_RETURN_VOID();
 }
 
 
+/*
+ * Returns the repmgrd state relevant to a promotion candidate election
+ * as a single row, so a candidate can survey each sibling node with one
+ * query, and the values are taken from a single consistent snapshot.
+ */
+Datum
+get_election_status(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[10];
+	bool		nulls[10];
+	repmgrdSharedState state;
+	int			upstream_last_seen_secs = -1;
+
+	if (!shared_state)
+		PG_RETURN_NULL();
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	read_shared_state(&state);
+
+	/* see comment in get_upstream_last_seen() */
+	if (state.upstream_last_seen != POSTGRES_EPOCH_JDATE)
+	{
+		long		secs;
+		int			microsecs;
+
+		TimestampDifference(state.upstream_last_seen, GetCurrentTimestamp(),
+							&secs, &microsecs);
+		upstream_last_seen_secs = (uint32)secs;
+	}
+
+	memset(nulls, 0, sizeof(nulls));
+
+	values[0] = Int32GetDatum(state.repmgrd_pid);
+	values[1] = BoolGetDatum(state.repmgrd_paused);
+	values[2] = Int32GetDatum(state.upstream_node_id);
+	values[3] = Int32GetDatum(upstream_last_seen_secs);
+	values[4] = Int32GetDatum((int) state.voting_status);
+	values[5] = Int32GetDatum(state.current_electoral_term);
+	values[6] = Int32GetDatum(state.prevote_term);
+	values[7] = LSNGetDatum(state.prevote_lsn);
+	values[8] = LSNGetDatum(state.prevote_replay_lsn);
+	values[9] = Int32GetDatum(state.prevote_lag_time);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+
+/*
+ * Returns all repmgrd state held in shared memory as a single row, taken
+ * from a single consistent snapshot.
+ *
+ * "upstream_last_seen" is the number of seconds since the upstream was
+ * last seen, or -1 if never; "repmgrd_running" indicates whether the
+ * registered repmgrd PID belongs to a running process.
+ */
+Datum
+get_repmgrd_state(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[16];
+	bool		nulls[16];
+	repmgrdSharedState state;
+	int			upstream_last_seen_secs = -1;
+
+	if (!shared_state)
+		PG_RETURN_NULL();
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	read_shared_state(&state);
+
+	if (state.upstream_last_seen != POSTGRES_EPOCH_JDATE)
+	{
+		long		secs;
+		int			microsecs;
+
+		TimestampDifference(state.upstream_last_seen, GetCurrentTimestamp(),
+							&secs, &microsecs);
+		upstream_last_seen_secs = (uint32)secs;
+	}
+
+	memset(nulls, 0, sizeof(nulls));
+
+	values[0] = Int32GetDatum(state.local_node_id);
+	values[1] = Int32GetDatum(state.repmgrd_pid);
+
+	if (state.repmgrd_pidfile[0] == '\0')
+		nulls[2] = true;
+	else
+		values[2] = PointerGetDatum(cstring_to_text(state.repmgrd_pidfile));
+
+	values[3] = BoolGetDatum(state.repmgrd_pid != UNKNOWN_PID && kill(state.repmgrd_pid, 0) == 0);
+	values[4] = BoolGetDatum(state.repmgrd_paused);
+	values[5] = Int32GetDatum(state.upstream_node_id);
+	values[6] = Int32GetDatum(upstream_last_seen_secs);
+	values[7] = Int32GetDatum((int) state.voting_status);
+	values[8] = Int32GetDatum(state.current_electoral_term);
+	values[9] = Int32GetDatum(state.candidate_node_id);
+	values[10] = BoolGetDatum(state.follow_new_primary);
+
+	if (state.last_updated == 0)
+		nulls[11] = true;
+	else
+		values[11] = TimestampTzGetDatum(state.last_updated);
+
+	values[12] = Int32GetDatum(state.prevote_term);
+	values[13] = LSNGetDatum(state.prevote_lsn);
+	values[14] = LSNGetDatum(state.prevote_replay_lsn);
+	values[15] = Int32GetDatum(state.prevote_lag_time);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+
 /*
  * Returns the repmgrd pid; or NULL if none set; or -1 if set but repmgrd
  * process not running (TODO!)
@@ -569,16 +918,14 @@ reset_voting_status(PG_FUNCTION_ARGS)
 Datum
 get_repmgrd_pid(PG_FUNCTION_ARGS)
 {
-	int repmgrd_pid = UNKNOWN_PID;
+	repmgrdSharedState state;
 
 	if (!shared_state)
 		PG_RETURN_NULL();
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
-	repmgrd_pid = shared_state->repmgrd_pid;
-	LWLockRelease(shared_state->lock);
+	read_shared_state(&state);
 
-	PG_RETURN_INT32(repmgrd_pid);
+	PG_RETURN_INT32(state.repmgrd_pid);
 }
 
 
@@ -588,21 +935,17 @@ get_repmgrd_pid(PG_FUNCTION_ARGS)
 Datum
 get_repmgrd_pidfile(PG_FUNCTION_ARGS)
 {
-	char repmgrd_pidfile[MAXPGPATH];
+	repmgrdSharedState state;
 
 	if (!shared_state)
 		PG_RETURN_NULL();
 
-	memset(repmgrd_pidfile, 0, MAXPGPATH);
-
-	LWLockAcquire(shared_state->lock, LW_SHARED);
-	strncpy(repmgrd_pidfile, shared_state->repmgrd_pidfile, MAXPGPATH);
-	LWLockRelease(shared_state->lock);
+	read_shared_state(&state);
 
-	if (repmgrd_pidfile[0] == '\0')
+	if (state.repmgrd_pidfile[0] == '\0')
 		PG_RETURN_NULL();
 
-	PG_RETURN_TEXT_P(cstring_to_text(repmgrd_pidfile));
+	PG_RETURN_TEXT_P(cstring_to_text(state.repmgrd_pidfile));
 }
 
 Datum
@@ -631,17 +974,17 @@ set_repmgrd_pid(PG_FUNCTION_ARGS)
 		elog(INFO, "set_repmgrd_pid(): provided pidfile is %s", repmgrd_pidfile);
 	}
 
-	LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
+	SHARED_STATE_BEGIN_WRITE();
 
 	shared_state->repmgrd_pid = repmgrd_pid;
 	memset(shared_state->repmgrd_pidfile, 0, MAXPGPATH);
 
 	if (repmgrd_pidfile != NULL)
 	{
-		strncpy(shared_state->repmgrd_pidfile, repmgrd_pidfile, MAXPGPATH);
+		strncpy(shared_state->repmgrd_pidfile, repmgrd_pidfile, MAXPGPATH - 1);
 	}
 
-	LWLockRelease(shared_state->lock);
+	SHARED_STATE_END_WRITE();
 	PG_RETURN_VOID();
 }
 
@@ -649,23 +992,21 @@ set_repmgrd_pid(PG_FUNCTION_ARGS)
 Datum
 repmgrd_is_running(PG_FUNCTION_ARGS)
 {
-	int repmgrd_pid = UNKNOWN_PID;
+	repmgrdSharedState state;
 	int kill_ret;
 
 	if (!shared_state)
 		PG_RETURN_NULL();
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
-	repmgrd_pid = shared_state->repmgrd_pid;
-	LWLockRelease(shared_state->lock);
+	read_shared_state(&state);
 
 	/* No PID registered - assume not running */
-	if (repmgrd_pid == UNKNOWN_PID)
+	if (state.repmgrd_pid == UNKNOWN_PID)
 	{
 		PG_RETURN_BOOL(false);
 	}
 
-	kill_ret = kill(repmgrd_pid, 0);
+	kill_ret = kill(state.repmgrd_pid, 0);
 
 	if (kill_ret == 0)
 	{
@@ -682,6 +1023,7 @@ repmgrd_pause(PG_FUNCTION_ARGS)
 	bool		pause;
 	FILE	   *file = NULL;
 	StringInfoData buf;
+	repmgrdSharedState state;
 
 	if (!shared_state)
 		PG_RETURN_NULL();
@@ -691,9 +1033,9 @@ repmgrd_pause(PG_FUNCTION_ARGS)
 
 	pause = PG_GETARG_BOOL(0);
 
-	LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
+	SHARED_STATE_BEGIN_WRITE();
 	shared_state->repmgrd_paused = pause;
-	LWLockRelease(shared_state->lock);
+	SHARED_STATE_END_WRITE();
 
 	/* write state to file */
 	file = AllocateFile(REPMGRD_STATE_FILE, PG_BINARY_W);
@@ -709,12 +1051,11 @@ repmgrd_pause(PG_FUNCTION_ARGS)
 
 	initStringInfo(&buf);
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
+	read_shared_state(&state);
 
 	appendStringInfo(&buf, "%i:%i",
-					 shared_state->local_node_id,
+					 state.local_node_id,
 					 pause ? 1 : 0);
-	LWLockRelease(shared_state->lock);
 
 	if (fwrite(buf.data, strlen(buf.data) + 1, 1, file) != 1)
 	{
@@ -732,16 +1073,14 @@ repmgrd_pause(PG_FUNCTION_ARGS)
 Datum
 repmgrd_is_paused(PG_FUNCTION_ARGS)
 {
-	bool is_paused;
+	repmgrdSharedState state;
 
 	if (!shared_state)
 		PG_RETURN_NULL();
 
-	LWLockAcquire(shared_state->lock, LW_SHARED);
-	is_paused = shared_state->repmgrd_paused;
-	LWLockRelease(shared_state->lock);
+	read_shared_state(&state);
 
-	PG_RETURN_BOOL(is_paused);
+	PG_RETURN_BOOL(state.repmgrd_paused);
 }
 
 
@@ -757,3 +1096,426 @@ get_wal_receiver_pid(PG_FUNCTION_ARGS)
 
 	PG_RETURN_INT32(wal_receiver_pid);
 }
+
+
+/* ============================= */
+/* monitoring sample ring buffer */
+/* ============================= */
+
+/*
+ * Store a monitoring sample, overwriting the oldest sample if the
+ * buffer is full.
+ *
+ * Parameters:
+ *   primary_node_id, last_wal_primary_location, last_wal_standby_location,
+ *   last_apply_time (may be NULL), replication_lag, apply_lag
+ */
+Datum
+add_monitoring_sample(PG_FUNCTION_ARGS)
+{
+	repmgrdMonitoringSample sample;
+
+	if (!monitoring_samples)
+		PG_RETURN_VOID();
+
+	/*
+	 * The primary's location and the replication lag will not be known if
+	 * repmgrd is not writing monitoring history.
+	 */
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(2) || PG_ARGISNULL(5))
+		PG_RETURN_VOID();
+
+	sample.sample_time = GetCurrentTimestamp();
+	sample.primary_node_id = PG_GETARG_INT32(0);
+	sample.last_wal_primary_location = PG_ARGISNULL(1) ? InvalidXLogRecPtr : PG_GETARG_LSN(1);
+	sample.last_wal_standby_location = PG_GETARG_LSN(2);
+	sample.last_apply_time = PG_ARGISNULL(3) ? 0 : PG_GETARG_TIMESTAMPTZ(3);
+	sample.replication_lag = PG_ARGISNULL(4) ? 0 : PG_GETARG_INT64(4);
+	sample.apply_lag = PG_GETARG_INT64(5);
+
+	SpinLockAcquire(&monitoring_samples->mutex);
+	monitoring_samples->samples[monitoring_samples->sample_count % MONITORING_SAMPLE_BUFFER_SIZE] = sample;
+	monitoring_samples->sample_count++;
+	SpinLockRelease(&monitoring_samples->mutex);
+
+	PG_RETURN_VOID();
+}
+
+
+/*
+ * Return the monitoring samples currently stored in shared memory,
+ * oldest first.
+ *
+ * All samples stored at the time of the first call are copied then, in
+ * batches of MONITORING_SAMPLE_COPY_BATCH, so the spinlock is only ever
+ * held briefly and repmgrd is not held up adding samples. Any samples
+ * overwritten by repmgrd while the copy is in progress are omitted.
+ */
+Datum
+get_recent_monitoring(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	repmgrdMonitoringSample *samples;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+		uint64		sample_count = 0;
+		int			sample_num = 0;
+		int			i;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "return type must be a row type");
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		samples = palloc(sizeof(repmgrdMonitoringSample) * MONITORING_SAMPLE_BUFFER_SIZE);
+
+		if (monitoring_samples)
+		{
+			uint64		next_sample;
+
+			SpinLockAcquire(&monitoring_samples->mutex);
+			sample_count = monitoring_samples->sample_count;
+			SpinLockRelease(&monitoring_samples->mutex);
+
+			next_sample = (sample_count > MONITORING_SAMPLE_BUFFER_SIZE)
+				? sample_count - MONITORING_SAMPLE_BUFFER_SIZE
+				: 0;
+
+			while (next_sample < sample_count)
+			{
+				uint64		current_count;
+
+				SpinLockAcquire(&monitoring_samples->mutex);
+
+				/* skip any samples overwritten since the last batch */
+				current_count = monitoring_samples->sample_count;
+				if (current_count > MONITORING_SAMPLE_BUFFER_SIZE
+					&& next_sample < current_count - MONITORING_SAMPLE_BUFFER_SIZE)
+					next_sample = current_count - MONITORING_SAMPLE_BUFFER_SIZE;
+
+				for (i = 0; i < MONITORING_SAMPLE_COPY_BATCH && next_sample < sample_count; i++)
+				{
+					samples[sample_num++] = monitoring_samples->samples[next_sample % MONITORING_SAMPLE_BUFFER_SIZE];
+					next_sample++;
+				}
+
+				SpinLockRelease(&monitoring_samples->mutex);
+			}
+		}
+
+		funcctx->user_fctx = samples;
+		funcctx->max_calls = sample_num;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	samples = (repmgrdMonitoringSample *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		repmgrdMonitoringSample *sample = &samples[funcctx->call_cntr];
+		Datum		values[8];
+		bool		nulls[8];
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[0] = TimestampTzGetDatum(sample->sample_time);
+		values[1] = Int32GetDatum(sample->primary_node_id);
+		values[3] = LSNGetDatum(sample->last_wal_standby_location);
+		values[6] = Int64GetDatum(sample->apply_lag);
+
+		if (sample->last_wal_primary_location == InvalidXLogRecPtr)
+		{
+			nulls[2] = true;
+			nulls[5] = true;
+		}
+		else
+		{
+			values[2] = LSNGetDatum(sample->last_wal_primary_location);
+			values[5] = Int64GetDatum(sample->replication_lag);
+		}
+
+		if (sample->last_apply_time == 0)
+		{
+			nulls[4] = true;
+			nulls[7] = true;
+		}
+		else
+		{
+			long		secs;
+			int			microsecs;
+
+			values[4] = TimestampTzGetDatum(sample->last_apply_time);
+
+			TimestampDifference(sample->last_apply_time, sample->sample_time,
+								&secs, &microsecs);
+			values[7] = Float8GetDatum((double) secs + (double) microsecs / 1000000.0);
+		}
+
+		SRF_RETURN_NEXT(funcctx,
+						HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+
+/* ====================== */
+/* failover phase timings */
+/* ====================== */
+
+/*
+ * Record the duration (in microseconds) of a failover phase.
+ *
+ * Parameters:
+ *   phase, duration_us
+ */
+Datum
+set_failover_phase_timing(PG_FUNCTION_ARGS)
+{
+	char	   *phase = NULL;
+	int64		duration_us;
+	repmgrdFailoverPhaseTiming *timing = NULL;
+	TimestampTz now;
+	int			bucket;
+	int			i;
+
+	if (!failover_phase_timings)
+		PG_RETURN_VOID();
+
+	phase = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	duration_us = PG_GETARG_INT64(1);
+
+	if (duration_us < 0)
+		PG_RETURN_VOID();
+
+	for (bucket = 0; bucket < FAILOVER_PHASE_HISTOGRAM_BUCKETS - 1; bucket++)
+	{
+		if (duration_us <= failover_phase_histogram_bounds_ms[bucket] * 1000)
+			break;
+	}
+
+	now = GetCurrentTimestamp();
+
+	SpinLockAcquire(&failover_phase_timings->mutex);
+
+	for (i = 0; i < failover_phase_timings->phase_count; i++)
+	{
+		if (strncmp(failover_phase_timings->phases[i].phase, phase, FAILOVER_PHASE_NAME_LEN) == 0)
+		{
+			timing = &failover_phase_timings->phases[i];
+			break;
+		}
+	}
+
+	if (timing == NULL && failover_phase_timings->phase_count < FAILOVER_PHASE_SLOTS)
+	{
+		timing = &failover_phase_timings->phases[failover_phase_timings->phase_count++];
+
+		memset(timing, 0, sizeof(repmgrdFailoverPhaseTiming));
+		strlcpy(timing->phase, phase, FAILOVER_PHASE_NAME_LEN);
+	}
+
+	if (timing != NULL)
+	{
+		timing->last_recorded = now;
+		timing->last_duration_us = duration_us;
+		timing->count++;
+		timing->total_us += duration_us;
+		if (duration_us > timing->max_us)
+			timing->max_us = duration_us;
+		timing->histogram[bucket]++;
+	}
+
+	SpinLockRelease(&failover_phase_timings->mutex);
+
+	pfree(phase);
+
+	PG_RETURN_VOID();
+}
+
+
+/*
+ * Copy the failover phase timings out of shared memory into the provided
+ * array (which must have space for FAILOVER_PHASE_SLOTS entries), and
+ * return the number of phases copied.
+ */
+static int
+copy_failover_phase_timings(repmgrdFailoverPhaseTiming *phases)
+{
+	int			phase_count = 0;
+
+	if (!failover_phase_timings)
+		return 0;
+
+	SpinLockAcquire(&failover_phase_timings->mutex);
+	phase_count = failover_phase_timings->phase_count;
+	memcpy(phases, failover_phase_timings->phases,
+		   sizeof(repmgrdFailoverPhaseTiming) * phase_count);
+	SpinLockRelease(&failover_phase_timings->mutex);
+
+	return phase_count;
+}
+
+
+/*
+ * Return the most recent duration and aggregate statistics for each
+ * failover phase reported since server start.
+ */
+Datum
+get_failover_phase_timings(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	repmgrdFailoverPhaseTiming *phases;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "return type must be a row type");
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		phases = palloc(sizeof(repmgrdFailoverPhaseTiming) * FAILOVER_PHASE_SLOTS);
+
+		funcctx->user_fctx = phases;
+		funcctx->max_calls = copy_failover_phase_timings(phases);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	phases = (repmgrdFailoverPhaseTiming *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		repmgrdFailoverPhaseTiming *timing = &phases[funcctx->call_cntr];
+		Datum		values[6];
+		bool		nulls[6];
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[0] = CStringGetTextDatum(timing->phase);
+		values[1] = TimestampTzGetDatum(timing->last_recorded);
+		values[2] = Int64GetDatum(timing->last_duration_us);
+		values[3] = Int64GetDatum(timing->count);
+		values[4] = Int64GetDatum(timing->total_us);
+		values[5] = Int64GetDatum(timing->max_us);
+
+		SRF_RETURN_NEXT(funcctx,
+						HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+
+/*
+ * Return the duration histogram for each failover phase, with one row
+ * per bucket. "count" is cumulative, i.e. it contains the number of
+ * durations less than or equal to "bucket_le_ms"; "bucket_le_ms" is
+ * NULL for the final bucket, which contains all recorded durations.
+ */
+Datum
+get_failover_phase_histogram(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	repmgrdFailoverPhaseTiming *phases;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "return type must be a row type");
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		phases = palloc(sizeof(repmgrdFailoverPhaseTiming) * FAILOVER_PHASE_SLOTS);
+
+		funcctx->user_fctx = phases;
+		funcctx->max_calls = copy_failover_phase_timings(phases) * FAILOVER_PHASE_HISTOGRAM_BUCKETS;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	phases = (repmgrdFailoverPhaseTiming *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		repmgrdFailoverPhaseTiming *timing = &phases[funcctx->call_cntr / FAILOVER_PHASE_HISTOGRAM_BUCKETS];
+		int			bucket = funcctx->call_cntr % FAILOVER_PHASE_HISTOGRAM_BUCKETS;
+		int64		cumulative_count = 0;
+		Datum		values[3];
+		bool		nulls[3];
+		int			i;
+
+		memset(nulls, 0, sizeof(nulls));
+
+		for (i = 0; i <= bucket; i++)
+			cumulative_count += timing->histogram[i];
+
+		values[0] = CStringGetTextDatum(timing->phase);
+
+		if (bucket < FAILOVER_PHASE_HISTOGRAM_BUCKETS - 1)
+			values[1] = Int64GetDatum(failover_phase_histogram_bounds_ms[bucket]);
+		else
+			nulls[1] = true;
+
+		values[2] = Int64GetDatum(cumulative_count);
+
+		SRF_RETURN_NEXT(funcctx,
+						HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+
+#if (PG_VERSION_NUM < 90400)
+static XLogRecPtr
+text_to_lsn(text *lsn_text)
+{
+	char	   *lsn_str = text_to_cstring(lsn_text);
+	uint32		xlogid;
+	uint32		xrecoff;
+
+	if (sscanf(lsn_str, "%X/%X", &xlogid, &xrecoff) != 2)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+				 errmsg("invalid LSN: \"%s\"", lsn_str)));
+
+	pfree(lsn_str);
+
+	return ((uint64) xlogid << 32) | xrecoff;
+}
+
+
+static Datum
+lsn_to_text_datum(XLogRecPtr lsn)
+{
+	/* two 32-bit hex values and a separator */
+	char		lsn_str[8 + 1 + 8 + 1];
+
+	snprintf(lsn_str, sizeof(lsn_str), "%X/%X", (uint32) (lsn >> 32), (uint32) lsn);
+
+	return CStringGetTextDatum(lsn_str);
+}
+#endif
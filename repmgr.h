@@ -69,6 +69,7 @@
 #include "repmgr_version.h"
 #include "errcode.h"
 #include "strutil.h"
+#include "memarena.h"
 #include "configfile.h"
 #include "dbutils.h"
 #include "log.h"
@@ -123,13 +124,27 @@
 #define	DEFAULT_REPLICATION_LAG_WARNING      300 /* seconds */
 #define DEFAULT_REPLICATION_LAG_CRITICAL     600 /* seconds */
 #define DEFAULT_WITNESS_SYNC_INTERVAL        15  /* seconds */
+#define DEFAULT_PARALLEL_JOBS                8
+#define DEFAULT_REMOTE_COMMAND_TIMEOUT       60  /* seconds */
+#define DEFAULT_BARMAN_RESTORE_JOBS          1
+#define DEFAULT_SSH_MULTIPLEXING             true
+#define SSH_CONTROL_PERSIST                  60  /* seconds */
 #define DEFAULT_WAL_RECEIVE_CHECK_TIMEOUT    30  /* seconds */
 #define DEFAULT_LOCATION                     "default"
 #define DEFAULT_PRIORITY		             100
 #define DEFAULT_MONITORING_INTERVAL          2	 /* seconds */
+#define DEFAULT_MONITORING_INTERVAL_MS       0	 /* milliseconds; 0 = use DEFAULT_MONITORING_INTERVAL */
 #define DEFAULT_RECONNECTION_ATTEMPTS        6	 /* seconds */
 #define DEFAULT_RECONNECTION_INTERVAL        10  /* seconds */
+#define DEFAULT_RECONNECT_BACKOFF            false
+#define DEFAULT_RECONNECT_INITIAL_INTERVAL_MS 250 /* milliseconds */
+#define RECONNECT_PROBE_TIMEOUT_MS           1000 /* milliseconds */
 #define DEFAULT_MONITORING_HISTORY           false
+#define DEFAULT_MONITORING_HISTORY_FLUSH_INTERVAL 0 /* seconds */
+#define DEFAULT_MONITORING_HISTORY_MAX_RECORDS 1000
+#define MONITORING_HISTORY_PARTITIONS_AHEAD  2	 /* days */
+#define MONITORING_HISTORY_PARTITIONS_CHECK_INTERVAL 3600 /* seconds */
+#define NODE_CONNECTION_CACHE_MAX_IDLE       300 /* seconds */
 #define DEFAULT_DEGRADED_MONITORING_TIMEOUT  -1  /* seconds */
 #define DEFAULT_ASYNC_QUERY_TIMEOUT          60  /* seconds */
 #define DEFAULT_PRIMARY_NOTIFICATION_TIMEOUT 60  /* seconds */
@@ -139,12 +154,27 @@
 #define DEFAULT_CONNECTION_CHECK_TYPE        CHECK_PING
 #define DEFAULT_PRIMARY_VISIBILITY_CONSENSUS false
 #define DEFAULT_ELECTION_RERUN_INTERVAL      15  /* seconds */
+#define DEFAULT_ELECTION_PREVOTE_TIMEOUT     5   /* seconds */
+#define DEFAULT_PROMOTION_CANDIDATE_SCORING  false
+#define DEFAULT_PROMOTION_SCORE_PRIORITY_WEIGHT 1
+#define DEFAULT_PROMOTION_SCORE_REPLAY_WEIGHT 10  /* per MB pending replay */
+#define DEFAULT_PROMOTION_SCORE_LAG_WEIGHT   1   /* per second of replication lag */
+#define DEFAULT_PROMOTION_SCORE_LOCATION_WEIGHT 50
+#define DEFAULT_UPSTREAM_FAILOVER_STRATEGY   UPSTREAM_FAILOVER_PRIMARY
 #define DEFAULT_CHILD_NODES_CHECK_INTERVAL   5   /* seconds */
 #define DEFAULT_CHILD_NODES_DISCONNECT_MIN_COUNT -1
 #define DEFAULT_CHILD_NODES_CONNECTED_MIN_COUNT -1
 #define DEFAULT_CHILD_NODES_CONNECTED_INCLUDE_WITNESS false
 #define DEFAULT_CHILD_NODES_DISCONNECT_TIMEOUT 30 /* seconds */
+#define DEFAULT_REPLICATION_SLOT_CHECK_INTERVAL 60 /* seconds */
+#define DEFAULT_REPLICATION_SLOT_RETAINED_WAL_THRESHOLD 0 /* MB; disabled */
+#define DEFAULT_REPLICATION_SLOT_RETAINED_WAL_GROWTH_RATE 0 /* MB per minute; disabled */
+#define DEFAULT_REPLICATION_SLOT_INACTIVE_DROP_TIMEOUT 0 /* seconds; disabled */
 #define DEFAULT_SSH_OPTIONS                  "-q -o ConnectTimeout=10"
+#define DEFAULT_EVENT_NOTIFICATION_WORKERS   1
+#define DEFAULT_EVENT_NOTIFICATION_QUEUE_SIZE 100
+#define DEFAULT_EVENT_NOTIFICATION_TIMEOUT   60  /* seconds */
+#define DEFAULT_METRICS_PORT                 0	 /* disabled */
 
 
 #ifndef RECOVERY_COMMAND_FILE
@@ -0,0 +1,712 @@
+/*
+ * repmgrd-metrics.c - HTTP endpoint providing repmgrd metrics
+ *
+ * Copyright (c) 2ndQuadrant, 2010-2020
+ *
+ * Provides repmgrd's internal state in the Prometheus text exposition format,
+ * so it can be monitored without querying PostgreSQL. Requests are handled
+ * from within the monitoring loop's wait for the next monitoring event.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "repmgr.h"
+#include "repmgrd.h"
+#include "repmgrd-metrics.h"
+
+#define METRICS_REQUEST_BUF_SIZE	4096
+#define METRICS_CLIENT_TIMEOUT		1	/* seconds, for the whole request */
+
+typedef struct
+{
+	bool		upstream_seen;
+	instr_time	upstream_last_seen;
+	bool		lag_recorded;
+	long long unsigned int replication_lag_bytes;
+	long long unsigned int apply_lag_bytes;
+	int			electoral_term;
+	bool		failover_phase_recorded[FAILOVER_PHASE_COUNT];
+	double		failover_phase_duration[FAILOVER_PHASE_COUNT];
+	/* phases executed during the current (or most recent) failover */
+	bool		failover_trace_recorded[FAILOVER_PHASE_COUNT];
+	int64		failover_trace_us[FAILOVER_PHASE_COUNT];
+	long long unsigned int failovers;
+	long long unsigned int reconnect_attempts_succeeded;
+	long long unsigned int reconnect_attempts_failed;
+} t_repmgrd_metrics;
+
+typedef struct
+{
+	char		slot_name[MAXLEN];
+	long long unsigned int retained_wal_bytes;
+	bool		growth_rate_recorded;
+	double		growth_rate;
+} t_replication_slot_metrics;
+
+static t_repmgrd_metrics metrics;
+
+/* per-slot WAL retention, as of the last replication slot check */
+static t_replication_slot_metrics *slot_metrics = NULL;
+static int	slot_metrics_count = 0;
+static int	slot_metrics_size = 0;
+
+static int	metrics_socket = -1;
+static char metrics_listen_address[MAXLEN] = "";
+static int	metrics_port = 0;
+
+static void handle_metrics_request(int client_socket);
+static void format_metrics(PQExpBufferData *body);
+static void append_label_value(PQExpBufferData *buf, const char *value);
+static bool send_all(int client_socket, const char *data, size_t len, instr_time request_start);
+static bool wait_for_client_socket(int client_socket, short events, instr_time request_start);
+
+
+/*
+ * init_metrics_server()
+ *
+ * Start listening on "metrics_port" (if set), or stop listening if it has
+ * been unset. This is called at startup and after a configuration
+ * reload; the listening socket is only recreated if the listen address
+ * or port has changed.
+ */
+void
+init_metrics_server(void)
+{
+	struct addrinfo hints;
+	struct addrinfo *addrs = NULL;
+	struct addrinfo *addr = NULL;
+	char		port_str[MAXLEN];
+	int			ret;
+
+	if (metrics_socket != -1
+		&& metrics_port == config_file_options.metrics_port
+		&& strncmp(metrics_listen_address, config_file_options.metrics_listen_address, MAXLEN) == 0)
+		return;
+
+	shutdown_metrics_server();
+
+	metrics_port = config_file_options.metrics_port;
+	strncpy(metrics_listen_address, config_file_options.metrics_listen_address, MAXLEN);
+
+	if (metrics_port == 0)
+		return;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+
+	maxlen_snprintf(port_str, "%i", metrics_port);
+
+	ret = getaddrinfo(metrics_listen_address[0] == '\0' ? NULL : metrics_listen_address,
+					  port_str, &hints, &addrs);
+
+	if (ret != 0)
+	{
+		log_error(_("unable to resolve \"metrics_listen_address\" \"%s\""), metrics_listen_address);
+		log_detail("%s", gai_strerror(ret));
+		return;
+	}
+
+	for (addr = addrs; addr != NULL; addr = addr->ai_next)
+	{
+		int			one = 1;
+
+		metrics_socket = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+
+		if (metrics_socket < 0)
+			continue;
+
+		(void) setsockopt(metrics_socket, SOL_SOCKET, SO_REUSEADDR, (char *) &one, sizeof(one));
+
+		if (bind(metrics_socket, addr->ai_addr, addr->ai_addrlen) == 0
+			&& listen(metrics_socket, 16) == 0)
+			break;
+
+		close(metrics_socket);
+		metrics_socket = -1;
+	}
+
+	freeaddrinfo(addrs);
+
+	if (metrics_socket == -1)
+	{
+		log_error(_("unable to listen for metrics requests on port %i"), metrics_port);
+		log_detail("%s", strerror(errno));
+		return;
+	}
+
+	fcntl(metrics_socket, F_SETFL, fcntl(metrics_socket, F_GETFL) | O_NONBLOCK);
+	fcntl(metrics_socket, F_SETFD, FD_CLOEXEC);
+
+	log_notice(_("listening for metrics requests on port %i"), metrics_port);
+}
+
+
+void
+shutdown_metrics_server(void)
+{
+	if (metrics_socket == -1)
+		return;
+
+	close(metrics_socket);
+	metrics_socket = -1;
+}
+
+
+/*
+ * Returns the listening socket, or -1 if metrics are not enabled.
+ */
+int
+get_metrics_socket(void)
+{
+	return metrics_socket;
+}
+
+
+/*
+ * handle_metrics_requests()
+ *
+ * Accept and respond to any pending connections; does not block waiting
+ * for new connections.
+ */
+void
+handle_metrics_requests(void)
+{
+	if (metrics_socket == -1)
+		return;
+
+	for (;;)
+	{
+		int			client_socket = accept(metrics_socket, NULL, NULL);
+
+		if (client_socket < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+			{
+				log_warning(_("unable to accept metrics request"));
+				log_detail("%s", strerror(errno));
+			}
+
+			return;
+		}
+
+		handle_metrics_request(client_socket);
+
+		close(client_socket);
+	}
+}
+
+
+static void
+handle_metrics_request(int client_socket)
+{
+	char		request[METRICS_REQUEST_BUF_SIZE];
+	size_t		request_len = 0;
+	instr_time	request_start;
+	PQExpBufferData response;
+	PQExpBufferData body;
+
+	/*
+	 * Don't let a slow or stalled client hold up monitoring: the socket is
+	 * non-blocking, and the whole request must be completed within
+	 * METRICS_CLIENT_TIMEOUT.
+	 */
+	fcntl(client_socket, F_SETFL, fcntl(client_socket, F_GETFL) | O_NONBLOCK);
+	INSTR_TIME_SET_CURRENT(request_start);
+
+	/* read the request headers; the request body, if any, is ignored */
+	while (request_len < sizeof(request) - 1)
+	{
+		ssize_t		bytes_read = recv(client_socket, request + request_len, sizeof(request) - 1 - request_len, 0);
+
+		if (bytes_read < 0 && errno == EINTR)
+			continue;
+
+		if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			if (wait_for_client_socket(client_socket, POLLIN, request_start) == false)
+				break;
+
+			continue;
+		}
+
+		if (bytes_read <= 0)
+			break;
+
+		request_len += bytes_read;
+		request[request_len] = '\0';
+
+		if (strstr(request, "\r\n\r\n") != NULL || strstr(request, "\n\n") != NULL)
+			break;
+	}
+
+	request[request_len] = '\0';
+
+	initPQExpBuffer(&response);
+	initPQExpBuffer(&body);
+
+	if (strncmp(request, "GET /metrics ", strlen("GET /metrics ")) == 0
+		|| strncmp(request, "GET / ", strlen("GET / ")) == 0)
+	{
+		format_metrics(&body);
+
+		appendPQExpBuffer(&response,
+						  "HTTP/1.0 200 OK\r\n"
+						  "Content-Type: text/plain; version=0.0.4\r\n"
+						  "Content-Length: %lu\r\n"
+						  "Connection: close\r\n"
+						  "\r\n",
+						  (unsigned long) body.len);
+	}
+	else
+	{
+		log_verbose(LOG_DEBUG, "handle_metrics_request(): unrecognised request:\n%s", request);
+
+		appendPQExpBufferStr(&body, "not found\n");
+
+		appendPQExpBuffer(&response,
+						  "HTTP/1.0 404 Not Found\r\n"
+						  "Content-Type: text/plain\r\n"
+						  "Content-Length: %lu\r\n"
+						  "Connection: close\r\n"
+						  "\r\n",
+						  (unsigned long) body.len);
+	}
+
+	if (send_all(client_socket, response.data, response.len, request_start) == true)
+		(void) send_all(client_socket, body.data, body.len, request_start);
+
+	termPQExpBuffer(&body);
+	termPQExpBuffer(&response);
+}
+
+
+static bool
+send_all(int client_socket, const char *data, size_t len, instr_time request_start)
+{
+	while (len > 0)
+	{
+		ssize_t		bytes_sent = send(client_socket, data, len, MSG_NOSIGNAL);
+
+		if (bytes_sent < 0 && errno == EINTR)
+			continue;
+
+		if (bytes_sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			if (wait_for_client_socket(client_socket, POLLOUT, request_start) == false)
+				return false;
+
+			continue;
+		}
+
+		if (bytes_sent <= 0)
+			return false;
+
+		data += bytes_sent;
+		len -= bytes_sent;
+	}
+
+	return true;
+}
+
+
+/*
+ * Wait until the client socket is ready for "events", or until the request
+ * has taken longer than METRICS_CLIENT_TIMEOUT; returns false on timeout
+ * or error.
+ */
+static bool
+wait_for_client_socket(int client_socket, short events, instr_time request_start)
+{
+	for (;;)
+	{
+		struct pollfd pfd;
+		instr_time	elapsed;
+		long		remaining_ms;
+		int			ret;
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, request_start);
+
+		remaining_ms = (METRICS_CLIENT_TIMEOUT * 1000L) - (long) INSTR_TIME_GET_MILLISEC(elapsed);
+
+		if (remaining_ms <= 0)
+		{
+			log_verbose(LOG_DEBUG, "wait_for_client_socket(): metrics request timed out");
+			return false;
+		}
+
+		pfd.fd = client_socket;
+		pfd.events = events;
+		pfd.revents = 0;
+
+		ret = poll(&pfd, 1, (int) remaining_ms);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		return ret > 0;
+	}
+}
+
+
+static void
+format_metrics(PQExpBufferData *body)
+{
+	int			i;
+
+	appendPQExpBufferStr(body,
+						 "# HELP repmgrd_info repmgrd node information.\n"
+						 "# TYPE repmgrd_info gauge\n");
+	appendPQExpBuffer(body,
+					  "repmgrd_info{node_id=\"%i\",node_name=\"",
+					  local_node_info.node_id);
+	append_label_value(body, local_node_info.node_name);
+	appendPQExpBuffer(body,
+					  "\",node_type=\"%s\",version=\"%s\"} 1\n",
+					  get_node_type_string(local_node_info.type),
+					  REPMGR_VERSION);
+
+	appendPQExpBufferStr(body,
+						 "# HELP repmgrd_monitoring_state Current monitoring state.\n"
+						 "# TYPE repmgrd_monitoring_state gauge\n");
+	appendPQExpBuffer(body,
+					  "repmgrd_monitoring_state{state=\"normal\"} %i\n"
+					  "repmgrd_monitoring_state{state=\"degraded\"} %i\n",
+					  monitoring_state == MS_NORMAL ? 1 : 0,
+					  monitoring_state == MS_DEGRADED ? 1 : 0);
+
+	appendPQExpBufferStr(body,
+						 "# HELP repmgrd_upstream_node_id ID of the local node's upstream node.\n"
+						 "# TYPE repmgrd_upstream_node_id gauge\n");
+	appendPQExpBuffer(body,
+					  "repmgrd_upstream_node_id %i\n",
+					  local_node_info.upstream_node_id);
+
+	if (metrics.upstream_seen == true)
+	{
+		instr_time	elapsed;
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, metrics.upstream_last_seen);
+
+		appendPQExpBufferStr(body,
+							 "# HELP repmgrd_upstream_last_seen_seconds Seconds since the upstream node was last seen.\n"
+							 "# TYPE repmgrd_upstream_last_seen_seconds gauge\n");
+		appendPQExpBuffer(body,
+						  "repmgrd_upstream_last_seen_seconds %.3f\n",
+						  INSTR_TIME_GET_DOUBLE(elapsed));
+	}
+
+	if (metrics.lag_recorded == true)
+	{
+		appendPQExpBufferStr(body,
+							 "# HELP repmgrd_replication_lag_bytes Replication lag in bytes, as of the last monitoring sample.\n"
+							 "# TYPE repmgrd_replication_lag_bytes gauge\n");
+		appendPQExpBuffer(body,
+						  "repmgrd_replication_lag_bytes %llu\n",
+						  metrics.replication_lag_bytes);
+
+		appendPQExpBufferStr(body,
+							 "# HELP repmgrd_apply_lag_bytes Apply lag in bytes, as of the last monitoring sample.\n"
+							 "# TYPE repmgrd_apply_lag_bytes gauge\n");
+		appendPQExpBuffer(body,
+						  "repmgrd_apply_lag_bytes %llu\n",
+						  metrics.apply_lag_bytes);
+	}
+
+	appendPQExpBufferStr(body,
+						 "# HELP repmgrd_electoral_term Electoral term as of the last election.\n"
+						 "# TYPE repmgrd_electoral_term gauge\n");
+	appendPQExpBuffer(body,
+					  "repmgrd_electoral_term %i\n",
+					  metrics.electoral_term);
+
+	appendPQExpBufferStr(body,
+						 "# HELP repmgrd_failover_phase_duration_seconds Duration of the most recent execution of each failover phase.\n"
+						 "# TYPE repmgrd_failover_phase_duration_seconds gauge\n");
+
+	for (i = 0; i < FAILOVER_PHASE_COUNT; i++)
+	{
+		if (metrics.failover_phase_recorded[i] == false)
+			continue;
+
+		appendPQExpBuffer(body,
+						  "repmgrd_failover_phase_duration_seconds{phase=\"%s\"} %.3f\n",
+						  format_failover_phase((FailoverPhase) i),
+						  metrics.failover_phase_duration[i]);
+	}
+
+	appendPQExpBufferStr(body,
+						 "# HELP repmgrd_failovers_total Number of failover processes started.\n"
+						 "# TYPE repmgrd_failovers_total counter\n");
+	appendPQExpBuffer(body,
+					  "repmgrd_failovers_total %llu\n",
+					  metrics.failovers);
+
+	appendPQExpBufferStr(body,
+						 "# HELP repmgrd_reconnect_attempts_total Number of attempts to reconnect to a node.\n"
+						 "# TYPE repmgrd_reconnect_attempts_total counter\n");
+	appendPQExpBuffer(body,
+					  "repmgrd_reconnect_attempts_total{result=\"success\"} %llu\n"
+					  "repmgrd_reconnect_attempts_total{result=\"failure\"} %llu\n",
+					  metrics.reconnect_attempts_succeeded,
+					  metrics.reconnect_attempts_failed);
+
+	if (slot_metrics_count > 0)
+	{
+		appendPQExpBufferStr(body,
+							 "# HELP repmgrd_replication_slot_retained_wal_bytes WAL retained by each physical replication slot.\n"
+							 "# TYPE repmgrd_replication_slot_retained_wal_bytes gauge\n");
+
+		for (i = 0; i < slot_metrics_count; i++)
+		{
+			appendPQExpBufferStr(body, "repmgrd_replication_slot_retained_wal_bytes{slot_name=\"");
+			append_label_value(body, slot_metrics[i].slot_name);
+			appendPQExpBuffer(body, "\"} %llu\n", slot_metrics[i].retained_wal_bytes);
+		}
+
+		appendPQExpBufferStr(body,
+							 "# HELP repmgrd_replication_slot_retained_wal_growth_bytes_per_second Growth rate of the WAL retained by each physical replication slot.\n"
+							 "# TYPE repmgrd_replication_slot_retained_wal_growth_bytes_per_second gauge\n");
+
+		for (i = 0; i < slot_metrics_count; i++)
+		{
+			if (slot_metrics[i].growth_rate_recorded == false)
+				continue;
+
+			appendPQExpBufferStr(body, "repmgrd_replication_slot_retained_wal_growth_bytes_per_second{slot_name=\"");
+			append_label_value(body, slot_metrics[i].slot_name);
+			appendPQExpBuffer(body, "\"} %.3f\n", slot_metrics[i].growth_rate);
+		}
+	}
+}
+
+
+/*
+ * Append a string to a label value, escaping as required by the
+ * text exposition format.
+ */
+static void
+append_label_value(PQExpBufferData *buf, const char *value)
+{
+	const char *ptr;
+
+	for (ptr = value; *ptr; ptr++)
+	{
+		if (*ptr == '\\' || *ptr == '"')
+			appendPQExpBufferChar(buf, '\\');
+
+		if (*ptr == '\n')
+			appendPQExpBufferStr(buf, "\\n");
+		else
+			appendPQExpBufferChar(buf, *ptr);
+	}
+}
+
+
+void
+metrics_record_upstream_seen(void)
+{
+	metrics.upstream_seen = true;
+	INSTR_TIME_SET_CURRENT(metrics.upstream_last_seen);
+}
+
+
+/*
+ * Retrieve the time the upstream node was last seen, if it has been
+ * seen since repmgrd started.
+ */
+bool
+metrics_get_upstream_last_seen(instr_time *last_seen)
+{
+	if (metrics.upstream_seen == false)
+		return false;
+
+	*last_seen = metrics.upstream_last_seen;
+
+	return true;
+}
+
+
+void
+metrics_record_lag(long long unsigned int replication_lag_bytes, long long unsigned int apply_lag_bytes)
+{
+	metrics.lag_recorded = true;
+	metrics.replication_lag_bytes = replication_lag_bytes;
+	metrics.apply_lag_bytes = apply_lag_bytes;
+}
+
+
+void
+metrics_record_electoral_term(int electoral_term)
+{
+	metrics.electoral_term = electoral_term;
+}
+
+
+/*
+ * Record the duration of a failover phase which began at "start_time",
+ * and return the duration in microseconds.
+ */
+int64
+metrics_record_failover_phase(FailoverPhase phase, instr_time start_time)
+{
+	instr_time	elapsed;
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+	metrics.failover_phase_recorded[phase] = true;
+	metrics.failover_phase_duration[phase] = INSTR_TIME_GET_DOUBLE(elapsed);
+
+	/* a phase may be executed more than once during a failover */
+	metrics.failover_trace_recorded[phase] = true;
+	metrics.failover_trace_us[phase] += (int64) INSTR_TIME_GET_MICROSEC(elapsed);
+
+	logger_set_phase_timing(format_failover_phase(phase),
+							metrics.failover_phase_duration[phase] * 1000);
+
+	log_info(_("failover phase \"%s\" completed in %.3f ms"),
+			 format_failover_phase(phase),
+			 metrics.failover_phase_duration[phase] * 1000);
+
+	return (int64) INSTR_TIME_GET_MICROSEC(elapsed);
+}
+
+
+/*
+ * Discard the phase timings of any previous failover; called when
+ * failure of the upstream node is first detected.
+ */
+void
+metrics_start_failover_trace(void)
+{
+	memset(metrics.failover_trace_recorded, 0, sizeof(metrics.failover_trace_recorded));
+	memset(metrics.failover_trace_us, 0, sizeof(metrics.failover_trace_us));
+}
+
+
+/*
+ * Append the durations of the phases executed so far during the current
+ * failover, in a form suitable for event details, e.g.:
+ *
+ *   "; phase timings (ms): detection=1203.512, reconnect=60014.236, election=12.004"
+ */
+void
+metrics_append_failover_trace(PQExpBufferData *out)
+{
+	bool		first = true;
+	int			i;
+
+	for (i = 0; i < FAILOVER_PHASE_COUNT; i++)
+	{
+		if (metrics.failover_trace_recorded[i] == false)
+			continue;
+
+		appendPQExpBuffer(out, "%s%s=%.3f",
+						  first ? _("; phase timings (ms): ") : ", ",
+						  format_failover_phase((FailoverPhase) i),
+						  (double) metrics.failover_trace_us[i] / 1000.0);
+		first = false;
+	}
+}
+
+
+/*
+ * Discard the per-slot WAL retention figures; called before each
+ * replication slot check, and when the local node is not a primary.
+ */
+void
+metrics_reset_replication_slots(void)
+{
+	slot_metrics_count = 0;
+}
+
+
+/*
+ * Record the WAL retained by a replication slot, and its growth rate in
+ * bytes per second if "growth_rate_recorded" is true.
+ */
+void
+metrics_record_replication_slot(const char *slot_name, long long unsigned int retained_wal_bytes, bool growth_rate_recorded, double growth_rate)
+{
+	t_replication_slot_metrics *slot = NULL;
+
+	if (slot_metrics_count == slot_metrics_size)
+	{
+		slot_metrics_size = slot_metrics_size == 0 ? 8 : slot_metrics_size * 2;
+		slot_metrics = pg_realloc(slot_metrics, sizeof(t_replication_slot_metrics) * slot_metrics_size);
+	}
+
+	slot = &slot_metrics[slot_metrics_count++];
+
+	strncpy(slot->slot_name, slot_name, MAXLEN);
+	slot->slot_name[MAXLEN - 1] = '\0';
+	slot->retained_wal_bytes = retained_wal_bytes;
+	slot->growth_rate_recorded = growth_rate_recorded;
+	slot->growth_rate = growth_rate;
+}
+
+
+void
+metrics_record_failover(void)
+{
+	metrics.failovers++;
+}
+
+
+void
+metrics_record_reconnect_attempt(bool success)
+{
+	if (success == true)
+		metrics.reconnect_attempts_succeeded++;
+	else
+		metrics.reconnect_attempts_failed++;
+}
+
+
+const char *
+format_failover_phase(FailoverPhase phase)
+{
+	switch (phase)
+	{
+		case FAILOVER_PHASE_DETECTION:
+			return "detection";
+		case FAILOVER_PHASE_RECONNECT:
+			return "reconnect";
+		case FAILOVER_PHASE_ELECTION:
+			return "election";
+		case FAILOVER_PHASE_VALIDATION:
+			return "validation";
+		case FAILOVER_PHASE_PROMOTE:
+			return "promote";
+		case FAILOVER_PHASE_NOTIFY:
+			return "notify";
+		case FAILOVER_PHASE_FOLLOW:
+			return "follow";
+	}
+
+	/* should never reach here */
+	return "unknown";
+}
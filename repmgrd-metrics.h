@@ -0,0 +1,56 @@
+/*
+ * repmgrd-metrics.h
+ * Copyright (c) 2ndQuadrant, 2010-2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _REPMGRD_METRICS_H_
+#define _REPMGRD_METRICS_H_
+
+#include "portability/instr_time.h"
+
+typedef enum
+{
+	FAILOVER_PHASE_DETECTION = 0,
+	FAILOVER_PHASE_RECONNECT,
+	FAILOVER_PHASE_ELECTION,
+	FAILOVER_PHASE_VALIDATION,
+	FAILOVER_PHASE_PROMOTE,
+	FAILOVER_PHASE_NOTIFY,
+	FAILOVER_PHASE_FOLLOW
+} FailoverPhase;
+
+#define FAILOVER_PHASE_COUNT (FAILOVER_PHASE_FOLLOW + 1)
+
+void		init_metrics_server(void);
+void		shutdown_metrics_server(void);
+int			get_metrics_socket(void);
+void		handle_metrics_requests(void);
+
+void		metrics_record_upstream_seen(void);
+bool		metrics_get_upstream_last_seen(instr_time *last_seen);
+void		metrics_record_lag(long long unsigned int replication_lag_bytes, long long unsigned int apply_lag_bytes);
+void		metrics_record_electoral_term(int electoral_term);
+int64		metrics_record_failover_phase(FailoverPhase phase, instr_time start_time);
+void		metrics_start_failover_trace(void);
+void		metrics_append_failover_trace(PQExpBufferData *out);
+void		metrics_record_failover(void);
+void		metrics_record_reconnect_attempt(bool success);
+void		metrics_reset_replication_slots(void);
+void		metrics_record_replication_slot(const char *slot_name, long long unsigned int retained_wal_bytes, bool growth_rate_recorded, double growth_rate);
+
+const char *format_failover_phase(FailoverPhase phase);
+
+#endif							/* _REPMGRD_METRICS_H_ */
@@ -22,6 +22,8 @@
 #include "repmgr.h"
 #include "repmgrd.h"
 #include "repmgrd-physical.h"
+#include "repmgrd-metrics.h"
+#include "repmgrd-topology.h"
 
 typedef enum
 {
@@ -61,21 +63,45 @@ typedef struct t_child_node_info
 	NodeAttached attached;
 	instr_time detached_time;
 	struct t_child_node_info *next;
+	struct t_child_node_info *prev;
+	/* next record in the same node_id hash bucket */
+	struct t_child_node_info *hash_next;
+	/* neighbours in the list of detached nodes, ordered by detached_time */
+	struct t_child_node_info *detached_next;
+	struct t_child_node_info *detached_prev;
 } t_child_node_info;
 
+/*
+ * List of child nodes, with a node_id-keyed hash index so records can be
+ * looked up without scanning the list, and a secondary list of currently
+ * detached nodes in order of detachment (most recently detached node at
+ * the tail).
+ */
 typedef struct t_child_node_info_list
 {
 	t_child_node_info *head;
 	t_child_node_info *tail;
 	int			node_count;
+	t_child_node_info **buckets;
+	int			bucket_count;
+	t_child_node_info *detached_head;
+	t_child_node_info *detached_tail;
 } t_child_node_info_list;
 
 #define T_CHILD_NODE_INFO_LIST_INITIALIZER { \
 	NULL, \
 	NULL, \
-	0 \
+	0, \
+	NULL, \
+	0, \
+	NULL, \
+	NULL \
 }
 
+#define CHILD_NODE_INFO_LIST_MIN_BUCKETS 16
+
+#define ELECTION_PREVOTE_POLL_INTERVAL_MS 100
+
 static PGconn *upstream_conn = NULL;
 static PGconn *primary_conn = NULL;
 
@@ -86,9 +112,46 @@ static t_node_info upstream_node_info = T_NODE_INFO_INITIALIZER;
 
 static instr_time last_monitoring_update;
 
+/* monitoring history samples not yet written to the primary */
+static t_monitoring_record *monitoring_records = NULL;
+static int	monitoring_record_count = 0;
+static int	monitoring_records_allocated = 0;
+static instr_time last_monitoring_flush;
+
 static bool child_nodes_disconnect_command_executed = false;
 
+/*
+ * WAL retained by each physical replication slot on the primary, as of the
+ * previous replication slot check, so growth can be tracked between checks.
+ */
+typedef struct t_replication_slot_state
+{
+	char		slot_name[MAXLEN];
+	uint64		retained_wal_bytes;
+	instr_time	sample_time;
+	/* retention threshold or growth rate exceeded, and reported */
+	bool		alerted;
+	/* when the slot was first seen unused by an inactive node, if applicable */
+	instr_time	unused_since;
+} t_replication_slot_state;
+
+static t_replication_slot_state *replication_slot_states = NULL;
+static int	replication_slot_state_count = 0;
+
+/*
+ * Short-lived allocations made via arena_alloc0() (list cells, scratch
+ * arrays used by the parallel query helpers etc.) come from one of these;
+ * see begin_monitoring_cycle() and run_failover_attempt().
+ */
+static MemoryArena *monitoring_cycle_arena = NULL;
+static MemoryArena *failover_arena = NULL;
+
 static ElectionResult do_election(NodeInfoList *sibling_nodes, int *new_primary_id);
+static bool sibling_prevote_pending(t_node_info *node_info, int electoral_term);
+static int64 calculate_candidate_score(t_node_info *node_info, XLogRecPtr replay_lsn, int lag_time);
+static void publish_prevote_abstention(int electoral_term);
+static void wait_for_sibling_prevotes(NodeInfoList *sibling_nodes, int electoral_term);
+static bool election_will_be_cancelled(NodeInfoList *sibling_nodes, bool primary_location_seen, int total_nodes);
 static const char *_print_election_result(ElectionResult result);
 
 static FailoverState promote_self(void);
@@ -107,9 +170,18 @@ static void reset_node_voting_status(void);
 
 static bool do_primary_failover(void);
 static bool do_upstream_standby_failover(void);
+static void select_upstream_failover_target(t_node_info *primary_node_info, int failed_upstream_node_id, t_node_info *follow_target_node_info);
+static t_node_info *assign_orphan_nodes(NodeInfoList *all_nodes, NodeInfoList *candidate_nodes, int failed_upstream_node_id, int *assigned);
+static bool node_is_downstream_of(NodeInfoList *node_list, t_node_info *node_info, int ancestor_node_id);
 static bool do_witness_failover(void);
+static bool run_failover_attempt(bool (*failover_function) (void));
+
+static void begin_monitoring_cycle(void);
 
 static bool update_monitoring_history(void);
+static bool add_local_monitoring_sample(void);
+static void buffer_monitoring_record(t_monitoring_record *record);
+static bool flush_monitoring_records(void);
 
 static void handle_sighup(PGconn **conn, t_server_type server_type);
 
@@ -120,12 +192,17 @@ static bool check_node_can_follow(PGconn *local_conn, XLogRecPtr local_xlogpos,
 static void check_witness_attached(t_node_info *node_info, bool startup);
 
 static t_child_node_info *append_child_node_record(t_child_node_info_list *nodes, int node_id, const char *node_name, t_server_type type, NodeAttached attached);
+static t_child_node_info *find_child_node_record(t_child_node_info_list *nodes, int node_id);
+static void set_child_node_attached(t_child_node_info_list *nodes, t_child_node_info *child_node, NodeAttached attached);
 static void remove_child_node_record(t_child_node_info_list *nodes, int node_id);
 static void clear_child_node_info_list(t_child_node_info_list *nodes);
 static void parse_child_nodes_disconnect_command(char *parsed_command, char *template, int reporting_node_id);
 static void execute_child_nodes_disconnect_command(NodeInfoList *db_child_node_records, t_child_node_info_list *local_child_nodes);
+static void check_replication_slot_retention(void);
+static void reset_replication_slot_states(void);
 
 static int try_primary_reconnect(PGconn **conn, PGconn *local_conn, t_node_info *node_info);
+static void record_failover_phase(FailoverPhase phase, instr_time start_time);
 
 void
 handle_sigint_physical(SIGNAL_ARGS)
@@ -262,6 +339,8 @@ monitor_streaming_primary(void)
 {
 	instr_time	log_status_interval_start;
 	instr_time	child_nodes_check_interval_start;
+	instr_time	monitoring_history_partitions_check_start;
+	instr_time	replication_slot_check_start;
 	t_child_node_info_list local_child_nodes = T_CHILD_NODE_INFO_LIST_INITIALIZER;
 
 	reset_node_voting_status();
@@ -305,15 +384,21 @@ monitor_streaming_primary(void)
 
 	INSTR_TIME_SET_CURRENT(log_status_interval_start);
 	INSTR_TIME_SET_CURRENT(child_nodes_check_interval_start);
+	INSTR_TIME_SET_ZERO(monitoring_history_partitions_check_start);
+	INSTR_TIME_SET_ZERO(replication_slot_check_start);
 	local_node_info.node_status = NODE_STATUS_UP;
 
+	/* discard any state from a previous period of primary monitoring */
+	reset_replication_slot_states();
+	metrics_reset_replication_slots();
+
 	/*
 	 * get list of expected and attached nodes
 	 */
 
 	{
 		NodeInfoList db_child_node_records = T_NODE_INFO_LIST_INITIALIZER;
-		bool success = get_child_nodes(local_conn, config_file_options.node_id, &db_child_node_records);
+		bool success = get_cached_child_nodes(local_conn, config_file_options.node_id, &db_child_node_records);
 
 		if (!success)
 		{
@@ -364,6 +449,8 @@ monitor_streaming_primary(void)
 
 	while (true)
 	{
+		begin_monitoring_cycle();
+
 		/*
 		 * TODO: cache node list here, refresh at `node_list_refresh_interval`
 		 * also return reason for inavailability so we can log it
@@ -534,6 +621,35 @@ monitor_streaming_primary(void)
 					check_primary_child_nodes(&local_child_nodes);
 				}
 			}
+
+			/*
+			 * If the monitoring history table is partitioned, ensure partitions
+			 * exist in advance for the monitoring data written by standbys;
+			 * standbys may have "monitoring_history" enabled even if the primary
+			 * does not.
+			 */
+			if (INSTR_TIME_IS_ZERO(monitoring_history_partitions_check_start)
+				|| calculate_elapsed(monitoring_history_partitions_check_start) >= MONITORING_HISTORY_PARTITIONS_CHECK_INTERVAL)
+			{
+				INSTR_TIME_SET_CURRENT(monitoring_history_partitions_check_start);
+
+				if (is_monitoring_history_partitioned(local_conn) == true)
+				{
+					int			partitions_created = create_monitoring_history_partitions(local_conn,
+																						  MONITORING_HISTORY_PARTITIONS_AHEAD);
+
+					if (partitions_created > 0)
+						log_info(_("%i monitoring history partition(s) created"), partitions_created);
+				}
+			}
+
+			if (config_file_options.replication_slot_check_interval > 0
+				&& (INSTR_TIME_IS_ZERO(replication_slot_check_start)
+					|| calculate_elapsed(replication_slot_check_start) >= config_file_options.replication_slot_check_interval))
+			{
+				INSTR_TIME_SET_CURRENT(replication_slot_check_start);
+				check_replication_slot_retention();
+			}
 		}
 
 loop:
@@ -568,10 +684,10 @@ loop:
 			handle_sighup(&local_conn, PRIMARY);
 		}
 
-		log_verbose(LOG_DEBUG, "sleeping %i seconds (parameter \"monitor_interval_secs\")",
-					config_file_options.monitor_interval_secs);
+		log_verbose(LOG_DEBUG, "waiting %i milliseconds until next monitoring cycle",
+					get_monitor_interval_ms());
 
-		sleep(config_file_options.monitor_interval_secs);
+		(void) wait_for_monitoring_event(get_monitor_interval_ms(), local_conn, NULL);
 	}
 }
 
@@ -793,7 +909,7 @@ check_primary_child_nodes(t_child_node_info_list *local_child_nodes)
 	t_child_node_info_list reconnected_child_nodes = T_CHILD_NODE_INFO_LIST_INITIALIZER;
 	t_child_node_info_list new_child_nodes = T_CHILD_NODE_INFO_LIST_INITIALIZER;
 
-	bool success = get_child_nodes(local_conn, config_file_options.node_id, &db_child_node_records);
+	bool success = get_cached_child_nodes(local_conn, config_file_options.node_id, &db_child_node_records);
 
 	if (!success)
 	{
@@ -820,7 +936,6 @@ check_primary_child_nodes(t_child_node_info_list *local_child_nodes)
 	for (cell = db_child_node_records.head; cell; cell = cell->next)
 	{
 		t_child_node_info *local_child_node_rec;
-		bool local_child_node_rec_found = false;
 
 
 		/*
@@ -835,24 +950,16 @@ check_primary_child_nodes(t_child_node_info_list *local_child_nodes)
 				  cell->node_info->node_id,
 				  cell->node_info->attached == NODE_ATTACHED ? "yes" : "no");
 
-		for (local_child_node_rec = local_child_nodes->head; local_child_node_rec; local_child_node_rec = local_child_node_rec->next)
-		{
-			if (local_child_node_rec->node_id == cell->node_info->node_id)
-			{
-				local_child_node_rec_found = true;
-				break;
-			}
-		}
+		local_child_node_rec = find_child_node_record(local_child_nodes, cell->node_info->node_id);
 
-		if (local_child_node_rec_found == true)
+		if (local_child_node_rec != NULL)
 		{
 			/* our node record shows node attached, DB record indicates detached */
 			if (local_child_node_rec->attached == NODE_ATTACHED && cell->node_info->attached == NODE_DETACHED)
 			{
 				t_child_node_info *detached_child_node;
 
-				local_child_node_rec->attached = NODE_DETACHED;
-				INSTR_TIME_SET_CURRENT(local_child_node_rec->detached_time);
+				set_child_node_attached(local_child_nodes, local_child_node_rec, NODE_DETACHED);
 
 				detached_child_node = append_child_node_record(&disconnected_child_nodes,
 															   local_child_node_rec->node_id,
@@ -866,19 +973,18 @@ check_primary_child_nodes(t_child_node_info_list *local_child_nodes)
 			{
 				t_child_node_info *attached_child_node;
 
-				local_child_node_rec->attached = NODE_ATTACHED;
-
 				attached_child_node = append_child_node_record(&reconnected_child_nodes,
 															   local_child_node_rec->node_id,
 															   local_child_node_rec->node_name,
 															   local_child_node_rec->type,
 															   NODE_ATTACHED);
 				attached_child_node->detached_time = local_child_node_rec->detached_time;
-				INSTR_TIME_SET_ZERO(local_child_node_rec->detached_time);
+
+				set_child_node_attached(local_child_nodes, local_child_node_rec, NODE_ATTACHED);
 			}
 			else if (local_child_node_rec->attached == NODE_ATTACHED_UNKNOWN  && cell->node_info->attached == NODE_ATTACHED)
 			{
-				local_child_node_rec->attached = NODE_ATTACHED;
+				set_child_node_attached(local_child_nodes, local_child_node_rec, NODE_ATTACHED);
 
 				append_child_node_record(&new_child_nodes,
 										 local_child_node_rec->node_id,
@@ -919,20 +1025,14 @@ check_primary_child_nodes(t_child_node_info_list *local_child_nodes)
 	 */
 	{
 		t_child_node_info *local_child_node_rec;
-		bool db_node_rec_found = false;
+		t_child_node_info *next_child_node_rec;
 
-		for (local_child_node_rec = local_child_nodes->head; local_child_node_rec; local_child_node_rec = local_child_node_rec->next)
+		for (local_child_node_rec = local_child_nodes->head; local_child_node_rec; local_child_node_rec = next_child_node_rec)
 		{
-			for (cell = db_child_node_records.head; cell; cell = cell->next)
-			{
-				if (cell->node_info->node_id == local_child_node_rec->node_id)
-				{
-					db_node_rec_found = true;
-					break;
-				}
-			}
+			/* the record may be removed below */
+			next_child_node_rec = local_child_node_rec->next;
 
-			if (db_node_rec_found == false)
+			if (find_node_in_list(&db_child_node_records, local_child_node_rec->node_id) == NULL)
 			{
 				log_notice(_("%s node \"%s\" (ID: %i) is no longer connected or registered"),
 						   get_node_type_string(local_child_node_rec->type),
@@ -1121,37 +1221,32 @@ execute_child_nodes_disconnect_command(NodeInfoList *db_child_node_records, t_ch
 
 			INSTR_TIME_SET_CURRENT(current_time_base);
 
-			for (child_node_rec = local_child_nodes->head; child_node_rec; child_node_rec = child_node_rec->next)
+			/*
+			 * The detached list is ordered by detachment time, so the first
+			 * eligible node from the tail is the most recently detached one;
+			 * if that node has not yet exceeded the timeout, no other node
+			 * can have either.
+			 */
+			for (child_node_rec = local_child_nodes->detached_tail; child_node_rec; child_node_rec = child_node_rec->detached_prev)
 			{
 				instr_time  current_time = current_time_base;
-				int seconds_since_detached;
 
-				/* exclude witness server from calculatin if neccessary */
+				/* exclude witness server from calculation if necessary */
 				if (config_file_options.child_nodes_connected_include_witness == false &&
 					child_node_rec->type == WITNESS)
 					continue;
 
-				if (child_node_rec->attached != NODE_DETACHED)
-					continue;
-
 				INSTR_TIME_SUBTRACT(current_time, child_node_rec->detached_time);
-				seconds_since_detached = (int) INSTR_TIME_GET_DOUBLE(current_time);
 
-				if (seconds_since_detached < config_file_options.child_nodes_disconnect_timeout)
+				most_recently_disconnected_node_id = child_node_rec->node_id;
+				most_recently_disconnected_elapsed = (int) INSTR_TIME_GET_DOUBLE(current_time);
+
+				if (most_recently_disconnected_elapsed < config_file_options.child_nodes_disconnect_timeout)
 				{
 					most_recent_disconnect_below_threshold = true;
 				}
 
-				if (most_recently_disconnected_node_id == UNKNOWN_NODE_ID)
-				{
-					most_recently_disconnected_node_id = child_node_rec->node_id;
-					most_recently_disconnected_elapsed = seconds_since_detached;
-				}
-				else if (seconds_since_detached < most_recently_disconnected_elapsed)
-				{
-					most_recently_disconnected_node_id = child_node_rec->node_id;
-					most_recently_disconnected_elapsed = seconds_since_detached;
-				}
+				break;
 			}
 
 
@@ -1242,6 +1337,228 @@ execute_child_nodes_disconnect_command(NodeInfoList *db_child_node_records, t_ch
 }
 
 
+/*
+ * check_replication_slot_retention()
+ *
+ * Sample the WAL retained by each physical replication slot on the primary,
+ * and warn (once per excursion) if it exceeds
+ * "replication_slot_retained_wal_threshold", or has grown faster than
+ * "replication_slot_retained_wal_growth_rate" since the previous check.
+ *
+ * If "replication_slot_inactive_drop_timeout" is set, a slot which has been
+ * unused for that long, and which belongs to a node whose record is marked
+ * inactive, is dropped; slots not referenced by any node record are never
+ * dropped.
+ */
+static void
+check_replication_slot_retention(void)
+{
+	t_replication_slot_retention *slots = NULL;
+	t_replication_slot_state *slot_states = NULL;
+	int			slot_count;
+	int			i;
+	uint64		threshold_bytes = (uint64) config_file_options.replication_slot_retained_wal_threshold * 1024 * 1024;
+	double		growth_rate_limit = (double) config_file_options.replication_slot_retained_wal_growth_rate * 1024 * 1024 / 60;
+	instr_time	sample_time;
+
+	slot_count = get_replication_slot_retention(local_conn, &slots);
+
+	if (slot_count < 0)
+		return;
+
+	INSTR_TIME_SET_CURRENT(sample_time);
+	metrics_reset_replication_slots();
+
+	if (slot_count > 0)
+		slot_states = pg_malloc0(sizeof(t_replication_slot_state) * slot_count);
+
+	for (i = 0; i < slot_count; i++)
+	{
+		t_replication_slot_retention *slot = &slots[i];
+		t_replication_slot_state *slot_state = &slot_states[i];
+		t_replication_slot_state *previous_state = NULL;
+		bool		growth_rate_recorded = false;
+		double		growth_rate = 0.0;
+		int			j;
+
+		for (j = 0; j < replication_slot_state_count; j++)
+		{
+			if (strncmp(replication_slot_states[j].slot_name, slot->slot_name, MAXLEN) == 0)
+			{
+				previous_state = &replication_slot_states[j];
+				break;
+			}
+		}
+
+		strncpy(slot_state->slot_name, slot->slot_name, MAXLEN);
+		slot_state->retained_wal_bytes = slot->retained_wal_bytes;
+		slot_state->sample_time = sample_time;
+		INSTR_TIME_SET_ZERO(slot_state->unused_since);
+
+		if (previous_state != NULL)
+		{
+			instr_time	elapsed = sample_time;
+
+			INSTR_TIME_SUBTRACT(elapsed, previous_state->sample_time);
+
+			if (INSTR_TIME_GET_DOUBLE(elapsed) > 0)
+			{
+				growth_rate_recorded = true;
+				growth_rate = ((double) slot->retained_wal_bytes - (double) previous_state->retained_wal_bytes)
+					/ INSTR_TIME_GET_DOUBLE(elapsed);
+			}
+
+			slot_state->alerted = previous_state->alerted;
+			slot_state->unused_since = previous_state->unused_since;
+		}
+
+		metrics_record_replication_slot(slot->slot_name,
+										(long long unsigned int) slot->retained_wal_bytes,
+										growth_rate_recorded,
+										growth_rate);
+
+		log_verbose(LOG_DEBUG, "replication slot \"%s\" retains %llu bytes of WAL",
+					slot->slot_name,
+					(long long unsigned int) slot->retained_wal_bytes);
+
+		/* retention threshold and growth rate */
+		{
+			PQExpBufferData event_details;
+
+			initPQExpBuffer(&event_details);
+
+			if (threshold_bytes > 0 && slot->retained_wal_bytes > threshold_bytes)
+			{
+				appendPQExpBuffer(&event_details,
+								  _("replication slot \"%s\" retains %llu MB of WAL, exceeding \"replication_slot_retained_wal_threshold\" (%i MB)"),
+								  slot->slot_name,
+								  (long long unsigned int) (slot->retained_wal_bytes / (1024 * 1024)),
+								  config_file_options.replication_slot_retained_wal_threshold);
+			}
+			else if (growth_rate_limit > 0 && growth_rate_recorded == true && growth_rate > growth_rate_limit)
+			{
+				appendPQExpBuffer(&event_details,
+								  _("WAL retained by replication slot \"%s\" grew by %.1f MB per minute, exceeding \"replication_slot_retained_wal_growth_rate\" (%i MB per minute)"),
+								  slot->slot_name,
+								  growth_rate * 60 / (1024 * 1024),
+								  config_file_options.replication_slot_retained_wal_growth_rate);
+			}
+
+			if (event_details.len > 0)
+			{
+				if (slot_state->alerted == false)
+				{
+					log_warning("%s", event_details.data);
+
+					if (slot->node_id != UNKNOWN_NODE_ID)
+						log_detail(_("replication slot is used by node \"%s\" (ID: %i), which is currently %s"),
+								   slot->node_name,
+								   slot->node_id,
+								   slot->active == true ? _("connected") : _("not connected"));
+
+					create_event_notification(local_conn,
+											  &config_file_options,
+											  config_file_options.node_id,
+											  "replication_slot_wal_retention",
+											  false,
+											  event_details.data);
+
+					slot_state->alerted = true;
+				}
+			}
+			else if (slot_state->alerted == true)
+			{
+				log_notice(_("WAL retained by replication slot \"%s\" is within configured limits"),
+						   slot->slot_name);
+				slot_state->alerted = false;
+			}
+
+			termPQExpBuffer(&event_details);
+		}
+
+		/* slots left behind by inactive nodes */
+		if (slot->active == false && slot->node_id != UNKNOWN_NODE_ID && slot->node_active == false)
+		{
+			if (INSTR_TIME_IS_ZERO(slot_state->unused_since))
+				slot_state->unused_since = sample_time;
+
+			if (config_file_options.replication_slot_inactive_drop_timeout > 0
+				&& calculate_elapsed(slot_state->unused_since) >= config_file_options.replication_slot_inactive_drop_timeout)
+			{
+				PQExpBufferData event_details;
+				bool		success = drop_replication_slot_sql(local_conn, slot->slot_name);
+
+				initPQExpBuffer(&event_details);
+
+				if (success == true)
+				{
+					appendPQExpBuffer(&event_details,
+									  _("dropped replication slot \"%s\" of inactive node \"%s\" (ID: %i), unused for at least %i seconds"),
+									  slot->slot_name,
+									  slot->node_name,
+									  slot->node_id,
+									  config_file_options.replication_slot_inactive_drop_timeout);
+					log_notice("%s", event_details.data);
+
+					/* no longer retaining WAL */
+					slot_state->alerted = false;
+					INSTR_TIME_SET_ZERO(slot_state->unused_since);
+				}
+				else
+				{
+					appendPQExpBuffer(&event_details,
+									  _("unable to drop replication slot \"%s\" of inactive node \"%s\" (ID: %i)"),
+									  slot->slot_name,
+									  slot->node_name,
+									  slot->node_id);
+					log_warning("%s", event_details.data);
+
+					/* retry after a further timeout period */
+					slot_state->unused_since = sample_time;
+				}
+
+				create_event_notification(local_conn,
+										  &config_file_options,
+										  config_file_options.node_id,
+										  "replication_slot_drop",
+										  success,
+										  event_details.data);
+
+				termPQExpBuffer(&event_details);
+			}
+		}
+		else
+		{
+			/*
+			 * The slot is in use, or no longer eligible to be dropped; any
+			 * subsequent grace period must start afresh.
+			 */
+			INSTR_TIME_SET_ZERO(slot_state->unused_since);
+		}
+	}
+
+	if (replication_slot_states != NULL)
+		pfree(replication_slot_states);
+
+	replication_slot_states = slot_states;
+	replication_slot_state_count = slot_count;
+
+	if (slots != NULL)
+		pfree(slots);
+}
+
+
+static void
+reset_replication_slot_states(void)
+{
+	if (replication_slot_states != NULL)
+		pfree(replication_slot_states);
+
+	replication_slot_states = NULL;
+	replication_slot_state_count = 0;
+}
+
+
 /*
  * repmgrd running on a standby server
  */
@@ -1259,6 +1576,7 @@ monitor_streaming_standby(void)
 	log_debug("monitor_streaming_standby()");
 
 	reset_node_voting_status();
+	metrics_reset_replication_slots();
 
 	INSTR_TIME_SET_ZERO(last_monitoring_update);
 
@@ -1444,6 +1762,8 @@ monitor_streaming_standby(void)
 	{
 		bool upstream_check_result;
 
+		begin_monitoring_cycle();
+
 		log_verbose(LOG_DEBUG, "checking %s", upstream_node_info.conninfo);
 
 		if (upstream_node_info.type == PRIMARY)
@@ -1458,6 +1778,7 @@ monitor_streaming_standby(void)
 		if (upstream_check_result == true)
 		{
 			set_upstream_last_seen(local_conn, upstream_node_info.node_id);
+			metrics_record_upstream_seen();
 		}
 		else
 		{
@@ -1468,6 +1789,15 @@ monitor_streaming_standby(void)
 
 				INSTR_TIME_SET_CURRENT(upstream_node_unreachable_start);
 
+				/* start tracing the phases of a potential failover */
+				{
+					instr_time	upstream_last_seen;
+
+					metrics_start_failover_trace();
+
+					if (metrics_get_upstream_last_seen(&upstream_last_seen) == true)
+						record_failover_phase(FAILOVER_PHASE_DETECTION, upstream_last_seen);
+				}
 
 				upstream_node_info.node_status = NODE_STATUS_UNKNOWN;
 
@@ -1518,6 +1848,7 @@ monitor_streaming_standby(void)
 				if (upstream_node_info.type == PRIMARY)
 				{
 					primary_node_id = try_primary_reconnect(&upstream_conn, local_conn, &upstream_node_info);
+					record_failover_phase(FAILOVER_PHASE_RECONNECT, upstream_node_unreachable_start);
 
 					/*
 					 * We were notified by the the primary during our own reconnection
@@ -1526,7 +1857,7 @@ monitor_streaming_standby(void)
 					 */
 					if (primary_node_id == ELECTION_RERUN_NOTIFICATION)
 					{
-						if (do_primary_failover() == true)
+						if (run_failover_attempt(do_primary_failover) == true)
 						{
 							primary_node_id = get_primary_node_id(local_conn);
 							return;
@@ -1541,6 +1872,7 @@ monitor_streaming_standby(void)
 				else
 				{
 					try_reconnect(&upstream_conn, &upstream_node_info);
+					record_failover_phase(FAILOVER_PHASE_RECONNECT, upstream_node_unreachable_start);
 				}
 
 				/* Upstream node has recovered - log and continue */
@@ -1635,12 +1967,12 @@ monitor_streaming_standby(void)
 					{
 						if (upstream_node_info.type == PRIMARY)
 						{
-							failover_done = do_primary_failover();
+							failover_done = run_failover_attempt(do_primary_failover);
 						}
 						else if (upstream_node_info.type == STANDBY)
 						{
 
-							failover_done = do_upstream_standby_failover();
+							failover_done = run_failover_attempt(do_upstream_standby_failover);
 
 							if (failover_done == false)
 							{
@@ -1818,6 +2150,7 @@ monitor_streaming_standby(void)
 														&sibling_nodes);
 						notify_followers(&sibling_nodes, local_node_info.node_id);
 
+						release_node_list_connections(&sibling_nodes);
 						clear_node_info_list(&sibling_nodes);
 
 						/* this will restart monitoring in primary mode */
@@ -1882,11 +2215,10 @@ monitor_streaming_standby(void)
 								continue;
 							}
 
-							cell->node_info->conn = establish_db_connection(cell->node_info->conninfo, false);
+							cell->node_info->conn = get_node_connection(cell->node_info);
 
 							if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
 							{
-								close_connection(&cell->node_info->conn);
 								log_debug("unable to connect to %i ... ", cell->node_info->node_id);
 								close_connection(&cell->node_info->conn);
 								continue;
@@ -1895,10 +2227,10 @@ monitor_streaming_standby(void)
 							if (get_recovery_type(cell->node_info->conn) == RECTYPE_PRIMARY)
 							{
 								follow_node_info = cell->node_info;
-								close_connection(&cell->node_info->conn);
+								release_node_connection(cell->node_info, &cell->node_info->conn);
 								break;
 							}
-							close_connection(&cell->node_info->conn);
+							release_node_connection(cell->node_info, &cell->node_info->conn);
 						}
 
 						if (follow_node_info != NULL)
@@ -2004,10 +2336,13 @@ loop:
 			}
 
 			/*
-			 * if monitoring not in use, we'll need to ensure the local connection
-			 * handle isn't stale
+			 * Even if monitoring history is not in use, record a sample of
+			 * the local node's replication state in its shared memory; this
+			 * does not require the primary. If this fails, we'll need to
+			 * ensure the local connection handle isn't stale.
 			 */
-			(void) connection_ping(local_conn);
+			if (add_local_monitoring_sample() == false)
+				(void) connection_ping(local_conn);
 		}
 
 		/*
@@ -2204,11 +2539,10 @@ loop:
 			}
 		}
 
-		log_verbose(LOG_DEBUG, "sleeping %i seconds (parameter \"monitor_interval_secs\")",
-					config_file_options.monitor_interval_secs);
+		log_verbose(LOG_DEBUG, "waiting %i milliseconds until next monitoring cycle",
+					get_monitor_interval_ms());
 
-
-		sleep(config_file_options.monitor_interval_secs);
+		(void) wait_for_monitoring_event(get_monitor_interval_ms(), upstream_conn, local_conn);
 	}
 }
 
@@ -2333,9 +2667,12 @@ monitor_streaming_witness(void)
 
 	while (true)
 	{
+		begin_monitoring_cycle();
+
 		if (check_upstream_connection(&primary_conn, upstream_node_info.conninfo, NULL) == true)
 		{
 			set_upstream_last_seen(local_conn, upstream_node_info.node_id);
+			metrics_record_upstream_seen();
 		}
 		else
 		{
@@ -2409,7 +2746,7 @@ monitor_streaming_witness(void)
 					bool		failover_done = false;
 
 
-					failover_done = do_witness_failover();
+					failover_done = run_failover_attempt(do_witness_failover);
 
 					/*
 					 * XXX it's possible it will make sense to return in all
@@ -2513,11 +2850,10 @@ monitor_streaming_witness(void)
 							continue;
 						}
 
-						cell->node_info->conn = establish_db_connection(cell->node_info->conninfo, false);
+						cell->node_info->conn = get_node_connection(cell->node_info);
 
 						if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
 						{
-							close_connection(&cell->node_info->conn);
 							log_debug("unable to connect to %i ... ", cell->node_info->node_id);
 							close_connection(&cell->node_info->conn);
 							continue;
@@ -2526,10 +2862,10 @@ monitor_streaming_witness(void)
 						if (get_recovery_type(cell->node_info->conn) == RECTYPE_PRIMARY)
 						{
 							follow_node_info = cell->node_info;
-							close_connection(&cell->node_info->conn);
+							release_node_connection(cell->node_info, &cell->node_info->conn);
 							break;
 						}
-						close_connection(&cell->node_info->conn);
+						release_node_connection(cell->node_info, &cell->node_info->conn);
 					}
 
 					if (follow_node_info != NULL)
@@ -2711,10 +3047,10 @@ loop:
 			handle_sighup(&local_conn, WITNESS);
 		}
 
-		log_verbose(LOG_DEBUG, "sleeping %i seconds (parameter \"monitor_interval_secs\")",
-					config_file_options.monitor_interval_secs);
+		log_verbose(LOG_DEBUG, "waiting %i milliseconds until next monitoring cycle",
+					get_monitor_interval_ms());
 
-		sleep(config_file_options.monitor_interval_secs);
+		(void) wait_for_monitoring_event(get_monitor_interval_ms(), primary_conn, local_conn);
 	}
 
 	return;
@@ -2728,6 +3064,12 @@ do_primary_failover(void)
 	bool final_result = false;
 	NodeInfoList sibling_nodes = T_NODE_INFO_LIST_INITIALIZER;
 	int new_primary_id = UNKNOWN_NODE_ID;
+	instr_time	phase_start;
+
+	metrics_record_failover();
+
+	/* node timelines may have changed since the last failover */
+	clear_follow_check_cache();
 
 	/*
 	 * Double-check status of the local connection
@@ -2774,7 +3116,7 @@ do_primary_failover(void)
 				for (cell = check_sibling_nodes.head; cell; cell = cell->next)
 				{
 					if (cell->node_info->conn == NULL)
-						cell->node_info->conn = establish_db_connection(cell->node_info->conninfo, false);
+						cell->node_info->conn = get_node_connection(cell->node_info);
 
 					if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
 					{
@@ -2824,12 +3166,15 @@ do_primary_failover(void)
 						 check_sibling_nodes.node_count);
 			}
 
+			release_node_list_connections(&check_sibling_nodes);
 			clear_node_info_list(&check_sibling_nodes);
 		}
 	}
 
 	/* attempt to initiate voting process */
+	INSTR_TIME_SET_CURRENT(phase_start);
 	election_result = do_election(&sibling_nodes, &new_primary_id);
+	record_failover_phase(FAILOVER_PHASE_ELECTION, phase_start);
 
 	/* TODO add pre-event notification here */
 	failover_state = FAILOVER_STATE_UNKNOWN;
@@ -2849,6 +3194,7 @@ do_primary_failover(void)
 		if (new_primary_id == UNKNOWN_NODE_ID)
 		{
 			log_notice(_("election cancelled"));
+			release_node_list_connections(&sibling_nodes);
 			clear_node_info_list(&sibling_nodes);
 			return false;
 		}
@@ -2861,7 +3207,9 @@ do_primary_failover(void)
 	{
 		log_notice(_("promotion candidate election will be rerun"));
 		/* notify siblings that they should rerun the election too */
+		INSTR_TIME_SET_CURRENT(phase_start);
 		notify_followers(&sibling_nodes, ELECTION_RERUN_NOTIFICATION);
+		record_failover_phase(FAILOVER_PHASE_NOTIFY, phase_start);
 
 		failover_state = FAILOVER_STATE_ELECTION_RERUN;
 	}
@@ -2876,7 +3224,9 @@ do_primary_failover(void)
 			log_notice("this node is the only available candidate and will now promote itself");
 		}
 
+		INSTR_TIME_SET_CURRENT(phase_start);
 		failover_state = promote_self();
+		record_failover_phase(FAILOVER_PHASE_PROMOTE, phase_start);
 	}
 	else if (election_result == ELECTION_LOST || election_result == ELECTION_NOT_CANDIDATE)
 	{
@@ -2901,7 +3251,9 @@ do_primary_failover(void)
 	 */
 	if (failover_state == FAILOVER_STATE_FOLLOW_NEW_PRIMARY)
 	{
+		INSTR_TIME_SET_CURRENT(phase_start);
 		failover_state = follow_new_primary(new_primary_id);
+		record_failover_phase(FAILOVER_PHASE_FOLLOW, phase_start);
 	}
 
 	/*
@@ -2925,7 +3277,9 @@ do_primary_failover(void)
 			{
 				log_notice(_("this node is promotion candidate, promoting"));
 
+				INSTR_TIME_SET_CURRENT(phase_start);
 				failover_state = promote_self();
+				record_failover_phase(FAILOVER_PHASE_PROMOTE, phase_start);
 
 				get_active_sibling_node_records(local_conn,
 												local_node_info.node_id,
@@ -2983,7 +3337,9 @@ do_primary_failover(void)
 			}
 			else
 			{
+				INSTR_TIME_SET_CURRENT(phase_start);
 				failover_state = follow_new_primary(new_primary_id);
+				record_failover_phase(FAILOVER_PHASE_FOLLOW, phase_start);
 			}
 		}
 		else
@@ -2999,7 +3355,9 @@ do_primary_failover(void)
 	{
 		case FAILOVER_STATE_PROMOTED:
 			/* notify former siblings that they should now follow this node */
+			INSTR_TIME_SET_CURRENT(phase_start);
 			notify_followers(&sibling_nodes, local_node_info.node_id);
+			record_failover_phase(FAILOVER_PHASE_NOTIFY, phase_start);
 
 			/* pass control back down to start_monitoring() */
 			log_info(_("switching to primary monitoring mode"));
@@ -3013,6 +3371,7 @@ do_primary_failover(void)
 		case FAILOVER_STATE_ELECTION_RERUN:
 
 			/* we no longer care about our former siblings */
+			release_node_list_connections(&sibling_nodes);
 			clear_node_info_list(&sibling_nodes);
 
 			log_notice(_("rerunning election after %i seconds (\"election_rerun_interval\")"),
@@ -3036,7 +3395,9 @@ do_primary_failover(void)
 			 * notify siblings that they should resume following the original
 			 * primary
 			 */
+			INSTR_TIME_SET_CURRENT(phase_start);
 			notify_followers(&sibling_nodes, upstream_node_info.node_id);
+			record_failover_phase(FAILOVER_PHASE_NOTIFY, phase_start);
 
 			/* pass control back down to start_monitoring() */
 
@@ -3115,17 +3476,62 @@ do_primary_failover(void)
 	}
 
 	/* we no longer care about our former siblings */
+	release_node_list_connections(&sibling_nodes);
 	clear_node_info_list(&sibling_nodes);
 
 	return final_result;
 }
 
 
+/*
+ * Execute a failover function with short-lived allocations made from the
+ * failover arena, so they don't accumulate in the (still live) monitoring
+ * cycle's arena; the failover arena is reset once the attempt is complete.
+ */
+static bool
+run_failover_attempt(bool (*failover_function) (void))
+{
+	MemoryArena *old_arena = NULL;
+	bool		result = false;
+
+	if (failover_arena == NULL)
+		failover_arena = memory_arena_create("failover attempt", MEMORY_ARENA_DEFAULT_BLOCK_SIZE);
+
+	old_arena = memory_arena_switch_to(failover_arena);
+
+	result = failover_function();
+
+	(void) memory_arena_switch_to(old_arena);
+	memory_arena_reset(failover_arena);
+
+	return result;
+}
+
+
+/*
+ * Called at the start of each iteration of a monitoring loop; releases all
+ * short-lived allocations made during the previous iteration (logging
+ * allocation statistics at debug level) and directs subsequent ones to the
+ * monitoring cycle arena.
+ */
+static void
+begin_monitoring_cycle(void)
+{
+	if (monitoring_cycle_arena == NULL)
+		monitoring_cycle_arena = memory_arena_create("monitoring cycle", MEMORY_ARENA_DEFAULT_BLOCK_SIZE);
+	else
+		memory_arena_reset(monitoring_cycle_arena);
+
+	(void) memory_arena_switch_to(monitoring_cycle_arena);
+}
+
+
 static bool
 update_monitoring_history(void)
 {
 	ReplInfo	replication_info;
 	XLogRecPtr	primary_last_wal_location = InvalidXLogRecPtr;
+	t_monitoring_record record;
 
 	long long unsigned int apply_lag_bytes = 0;
 	long long unsigned int replication_lag_bytes = 0;
@@ -3199,85 +3605,239 @@ update_monitoring_history(void)
 		replication_lag_bytes = 0;
 	}
 
-	add_monitoring_record(primary_conn,
-						  local_conn,
-						  primary_node_id,
-						  local_node_info.node_id,
-						  replication_info.current_timestamp,
-						  primary_last_wal_location,
-						  replication_info.last_wal_receive_lsn,
-						  replication_info.last_xact_replay_timestamp,
-						  replication_lag_bytes,
-						  apply_lag_bytes);
+	record.primary_node_id = primary_node_id;
+	record.standby_node_id = local_node_info.node_id;
+	snprintf(record.monitor_timestamp, sizeof(record.monitor_timestamp),
+			 "%s", replication_info.current_timestamp);
+	snprintf(record.last_xact_replay_timestamp, sizeof(record.last_xact_replay_timestamp),
+			 "%s", replication_info.last_xact_replay_timestamp);
+	record.primary_last_wal_location = primary_last_wal_location;
+	record.last_wal_receive_lsn = replication_info.last_wal_receive_lsn;
+	record.replication_lag_bytes = replication_lag_bytes;
+	record.apply_lag_bytes = apply_lag_bytes;
 
-	INSTR_TIME_SET_CURRENT(last_monitoring_update);
+	add_monitoring_sample(local_conn, &record);
+	metrics_record_lag(replication_lag_bytes, apply_lag_bytes);
+
+	buffer_monitoring_record(&record);
+
+	set_standby_last_updated(local_conn);
 
-	log_verbose(LOG_DEBUG, "update_monitoring_history(): monitoring history update sent");
+	/*
+	 * Write buffered samples if the flush interval has expired (or samples
+	 * are not being buffered), or the buffer is full.
+	 */
+	if (config_file_options.monitoring_history_flush_interval == 0
+		|| monitoring_record_count >= config_file_options.monitoring_history_max_records
+		|| calculate_elapsed(last_monitoring_flush) >= config_file_options.monitoring_history_flush_interval)
+	{
+		return flush_monitoring_records();
+	}
+
+	log_verbose(LOG_DEBUG, "update_monitoring_history(): %i monitoring history sample(s) buffered",
+				monitoring_record_count);
 
 	return true;
 }
 
 
 /*
- * do_upstream_standby_failover()
- *
- * Attach cascaded standby to another node, currently the primary.
- *
- * Note that in contrast to a primary failover, where one of the downstrean
- * standby nodes will become a primary, a cascaded standby failover (where the
- * upstream standby has gone away) is "just" a case of attaching the standby to
- * another node.
- *
- * Currently we will try to attach the node to the cluster primary.
- *
- * TODO: As of repmgr 4.3, "repmgr standby follow" supports attaching a standby to another
- * standby node. We need to provide a selection of reconnection strategies as different
- * behaviour might be desirable in different situations.
+ * Store a sample of the local node's replication state in its shared
+ * memory, without contacting the primary; used when monitoring history
+ * is not being written. As the primary's current LSN is not known,
+ * replication lag is not recorded.
  */
-
 static bool
-do_upstream_standby_failover(void)
+add_local_monitoring_sample(void)
 {
-	t_node_info primary_node_info = T_NODE_INFO_INITIALIZER;
-	RecordStatus record_status = RECORD_NOT_FOUND;
-	RecoveryType primary_type = RECTYPE_UNKNOWN;
-	int			i, standby_follow_result;
-	char		parsed_follow_command[MAXPGPATH] = "";
-
-	close_connection(&upstream_conn);
+	ReplInfo	replication_info;
+	t_monitoring_record record;
 
-	/*
-	 *
-	 */
-	if (config_file_options.failover == FAILOVER_MANUAL)
-	{
-		log_notice(_("this node is not configured for automatic failover"));
-		log_detail(_("parameter \"failover\" is set to \"manual\""));
+	if (PQstatus(local_conn) != CONNECTION_OK)
 		return false;
-	}
 
-	if (get_primary_node_record(local_conn, &primary_node_info) == false)
-	{
-		log_error(_("unable to retrieve primary node record"));
+	init_replication_info(&replication_info);
+
+	if (get_replication_info(local_conn, STANDBY, &replication_info) == false)
 		return false;
-	}
 
-	/*
-	 * Verify that we can still talk to the cluster primary, even though the
-	 * node's upstream is not available
-	 */
+	record.primary_node_id = primary_node_id;
+	record.standby_node_id = local_node_info.node_id;
+	snprintf(record.monitor_timestamp, sizeof(record.monitor_timestamp),
+			 "%s", replication_info.current_timestamp);
+	snprintf(record.last_xact_replay_timestamp, sizeof(record.last_xact_replay_timestamp),
+			 "%s", replication_info.last_xact_replay_timestamp);
+	record.primary_last_wal_location = InvalidXLogRecPtr;
+	record.last_wal_receive_lsn = replication_info.last_wal_receive_lsn;
+	record.replication_lag_bytes = 0;
 
-	check_connection(&primary_node_info, &primary_conn);
+	if (replication_info.last_wal_receive_lsn >= replication_info.last_wal_replay_lsn)
+		record.apply_lag_bytes = (long long unsigned int) (replication_info.last_wal_receive_lsn - replication_info.last_wal_replay_lsn);
+	else
+		record.apply_lag_bytes = 0;
 
-	if (PQstatus(primary_conn) != CONNECTION_OK)
-	{
-		log_error(_("unable to connect to last known primary \"%s\" (ID: %i)"),
-				  primary_node_info.node_name,
-				  primary_node_info.node_id);
+	add_monitoring_sample(local_conn, &record);
 
-		close_connection(&primary_conn);
-		monitoring_state = MS_DEGRADED;
-		INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
+	return true;
+}
+
+
+/*
+ * Add a sample to the monitoring history buffer, discarding the oldest
+ * sample if the buffer is full (i.e. the primary has not been reachable
+ * for some time).
+ */
+static void
+buffer_monitoring_record(t_monitoring_record *record)
+{
+	int			max_records = config_file_options.monitoring_history_max_records;
+
+	/* (re)allocate buffer, e.g. on first use or after a configuration reload */
+	if (monitoring_records_allocated != max_records)
+	{
+		if (monitoring_record_count > max_records)
+		{
+			memmove(monitoring_records,
+					monitoring_records + (monitoring_record_count - max_records),
+					sizeof(t_monitoring_record) * max_records);
+			monitoring_record_count = max_records;
+		}
+
+		monitoring_records = pg_realloc(monitoring_records, sizeof(t_monitoring_record) * max_records);
+		monitoring_records_allocated = max_records;
+	}
+
+	if (monitoring_record_count == 0 && config_file_options.monitoring_history_flush_interval > 0)
+		INSTR_TIME_SET_CURRENT(last_monitoring_flush);
+
+	if (monitoring_record_count == max_records)
+	{
+		log_warning(_("monitoring history buffer is full, discarding oldest sample"));
+		memmove(monitoring_records,
+				monitoring_records + 1,
+				sizeof(t_monitoring_record) * (max_records - 1));
+		monitoring_record_count--;
+	}
+
+	monitoring_records[monitoring_record_count++] = *record;
+}
+
+
+/*
+ * Write any buffered monitoring history samples to the primary.
+ */
+static bool
+flush_monitoring_records(void)
+{
+	if (monitoring_record_count == 0)
+		return true;
+
+	if (add_monitoring_records(primary_conn, monitoring_records, monitoring_record_count) == false)
+		return false;
+
+	log_verbose(LOG_DEBUG, "flush_monitoring_records(): %i monitoring history sample(s) sent",
+				monitoring_record_count);
+
+	monitoring_record_count = 0;
+
+	INSTR_TIME_SET_CURRENT(last_monitoring_flush);
+	INSTR_TIME_SET_CURRENT(last_monitoring_update);
+
+	return true;
+}
+
+
+/*
+ * Write any buffered monitoring history samples before repmgrd stops
+ * monitoring the node as a standby (e.g. following a failover, or on
+ * shutdown); otherwise they would only be written on a subsequent
+ * monitoring update, which may never happen.
+ *
+ * If "reconnect" is true and the primary connection is no longer usable,
+ * attempt to connect to the (possibly new) primary first.
+ */
+void
+flush_monitoring_history(bool reconnect)
+{
+	if (monitoring_record_count == 0)
+		return;
+
+	if (reconnect == true
+		&& PQstatus(primary_conn) != CONNECTION_OK
+		&& PQstatus(local_conn) == CONNECTION_OK)
+	{
+		primary_conn = establish_primary_db_connection(local_conn, false);
+	}
+
+	if (PQstatus(primary_conn) == CONNECTION_OK && flush_monitoring_records() == true)
+		return;
+
+	log_warning(_("unable to write %i buffered monitoring history sample(s) to the primary"),
+				monitoring_record_count);
+}
+
+
+/*
+ * do_upstream_standby_failover()
+ *
+ * Attach cascaded standby to another node, currently the primary.
+ *
+ * Note that in contrast to a primary failover, where one of the downstrean
+ * standby nodes will become a primary, a cascaded standby failover (where the
+ * upstream standby has gone away) is "just" a case of attaching the standby to
+ * another node.
+ *
+ * With "upstream_failover_strategy=primary" (the default) we will try to attach
+ * the node to the cluster primary; with "upstream_failover_strategy=balanced",
+ * to the primary or another standby with spare capacity, so that the failed
+ * upstream's downstream nodes do not all attach to the primary at once
+ * (see select_upstream_failover_target()).
+ */
+
+static bool
+do_upstream_standby_failover(void)
+{
+	t_node_info primary_node_info = T_NODE_INFO_INITIALIZER;
+	RecordStatus record_status = RECORD_NOT_FOUND;
+	t_node_info follow_target_node_info = T_NODE_INFO_INITIALIZER;
+	RecoveryType primary_type = RECTYPE_UNKNOWN;
+	int			i, standby_follow_result;
+	char		parsed_follow_command[MAXPGPATH] = "";
+
+	close_connection(&upstream_conn);
+
+	/*
+	 *
+	 */
+	if (config_file_options.failover == FAILOVER_MANUAL)
+	{
+		log_notice(_("this node is not configured for automatic failover"));
+		log_detail(_("parameter \"failover\" is set to \"manual\""));
+		return false;
+	}
+
+	if (get_primary_node_record(local_conn, &primary_node_info) == false)
+	{
+		log_error(_("unable to retrieve primary node record"));
+		return false;
+	}
+
+	/*
+	 * Verify that we can still talk to the cluster primary, even though the
+	 * node's upstream is not available
+	 */
+
+	check_connection(&primary_node_info, &primary_conn);
+
+	if (PQstatus(primary_conn) != CONNECTION_OK)
+	{
+		log_error(_("unable to connect to last known primary \"%s\" (ID: %i)"),
+				  primary_node_info.node_name,
+				  primary_node_info.node_id);
+
+		close_connection(&primary_conn);
+		monitoring_state = MS_DEGRADED;
+		INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
 		return false;
 	}
 
@@ -3304,6 +3864,17 @@ do_upstream_standby_failover(void)
 		return false;
 	}
 
+	if (config_file_options.upstream_failover_strategy == UPSTREAM_FAILOVER_BALANCED)
+	{
+		select_upstream_failover_target(&primary_node_info,
+										upstream_node_info.node_id,
+										&follow_target_node_info);
+	}
+	else
+	{
+		follow_target_node_info = primary_node_info;
+	}
+
 	/* Close the connection to this server */
 	close_connection(&local_conn);
 
@@ -3311,13 +3882,30 @@ do_upstream_standby_failover(void)
 			  config_file_options.follow_command);
 
 	/*
-	 * replace %n in "config_file_options.follow_command" with ID of primary
+	 * replace %n in "config_file_options.follow_command" with ID of the node
 	 * to follow.
 	 */
-	parse_follow_command(parsed_follow_command, config_file_options.follow_command, primary_node_info.node_id);
+	parse_follow_command(parsed_follow_command, config_file_options.follow_command, follow_target_node_info.node_id);
 
 	standby_follow_result = system(parsed_follow_command);
 
+	/*
+	 * If a standby was selected as follow target but can't be followed,
+	 * fall back to the primary, before any node record is updated.
+	 */
+	if (standby_follow_result != 0 && follow_target_node_info.node_id != primary_node_info.node_id)
+	{
+		log_warning(_("unable to follow standby \"%s\" (ID: %i), attempting to follow the primary"),
+					follow_target_node_info.node_name,
+					follow_target_node_info.node_id);
+
+		follow_target_node_info = primary_node_info;
+
+		parse_follow_command(parsed_follow_command, config_file_options.follow_command, follow_target_node_info.node_id);
+
+		standby_follow_result = system(parsed_follow_command);
+	}
+
 	if (standby_follow_result != 0)
 	{
 		PQExpBufferData event_details;
@@ -3393,14 +3981,14 @@ do_upstream_standby_failover(void)
 	}
 
 	/*
-	 * update upstream_node_id to primary node (but only if follow command
+	 * update upstream_node_id to the follow target (but only if follow command
 	 * was successful)
 	 */
 
 	{
 		if (update_node_record_set_upstream(primary_conn,
 											local_node_info.node_id,
-											primary_node_info.node_id) == false)
+											follow_target_node_info.node_id) == false)
 		{
 			PQExpBufferData event_details;
 
@@ -3409,7 +3997,7 @@ do_upstream_standby_failover(void)
 							  _("unable to set node \"%s\" (ID: %i)'s new upstream ID to %i"),
 							  local_node_info.node_name,
 							  local_node_info.node_id,
-							  primary_node_info.node_id);
+							  follow_target_node_info.node_id);
 
 			log_error("%s", event_details.data);
 
@@ -3436,7 +4024,7 @@ do_upstream_standby_failover(void)
 	 */
 	if (record_status != RECORD_FOUND)
 	{
-		local_node_info.upstream_node_id = primary_node_info.node_id;
+		local_node_info.upstream_node_id = follow_target_node_info.node_id;
 	}
 
 	{
@@ -3445,14 +4033,17 @@ do_upstream_standby_failover(void)
 		initPQExpBuffer(&event_details);
 
 		appendPQExpBuffer(&event_details,
-						  _("node \"%s\" (ID: %i) is now following primary node \"%s\" (ID: %i)"),
+						  _("node \"%s\" (ID: %i) is now following %s node \"%s\" (ID: %i)"),
 						  local_node_info.node_name,
 						  local_node_info.node_id,
-						  primary_node_info.node_name,
-						  primary_node_info.node_id);
+						  follow_target_node_info.node_id == primary_node_info.node_id ? "primary" : "standby",
+						  follow_target_node_info.node_name,
+						  follow_target_node_info.node_id);
 
 		log_notice("%s", event_details.data);
 
+		metrics_append_failover_trace(&event_details);
+
 		create_event_notification(primary_conn,
 								  &config_file_options,
 								  local_node_info.node_id,
@@ -3469,6 +4060,312 @@ do_upstream_standby_failover(void)
 }
 
 
+/*
+ * select_upstream_failover_target()
+ *
+ * For "upstream_failover_strategy=balanced": choose the node this cascaded
+ * standby should attach to after its upstream has failed, and copy its
+ * record into "follow_target_node_info".
+ *
+ * Candidates are the primary and all active standbys which are not the
+ * failed upstream or downstream of it, and which have a free WAL
+ * sender (and, if "use_replication_slots" is set, a free replication slot),
+ * as reported by get_node_replication_stats().
+ *
+ * All the failed upstream's downstream standbys ("orphans") make this
+ * decision at about the same time, and would all pick the same least-loaded
+ * node if each only considered itself. Instead each orphan simulates the
+ * assignment of all orphans in node ID order, each to the candidate with
+ * the lowest WAL sender utilisation (including orphans already assigned to
+ * it), preferring candidates in the orphan's location, then standbys over
+ * the primary, then the lowest node ID; and then follows the candidate
+ * assigned to itself. As each orphan sees (more or less) the same state,
+ * orphans are spread across the candidates.
+ *
+ * If the standby assigned to this node is one it cannot attach to (e.g.
+ * because it is behind this node), it is excluded and the assignment
+ * repeated. If no suitable candidate can be found, the primary is chosen.
+ */
+static void
+select_upstream_failover_target(t_node_info *primary_node_info, int failed_upstream_node_id, t_node_info *follow_target_node_info)
+{
+	NodeInfoList all_nodes = T_NODE_INFO_LIST_INITIALIZER;
+	NodeInfoList candidate_nodes = T_NODE_INFO_LIST_INITIALIZER;
+	NodeInfoListCell *candidate_cells = NULL;
+	NodeInfoListCell *cell = NULL;
+	int		   *assigned = NULL;
+	t_node_info *target = NULL;
+	XLogRecPtr	local_xlogpos = InvalidXLogRecPtr;
+	int			i;
+
+	*follow_target_node_info = *primary_node_info;
+
+	if (get_all_node_records(primary_conn, &all_nodes) == false || all_nodes.node_count == 0)
+	{
+		log_warning(_("unable to retrieve node records, attaching to the primary"));
+		clear_node_info_list(&all_nodes);
+		return;
+	}
+
+	candidate_cells = pg_malloc0(sizeof(NodeInfoListCell) * all_nodes.node_count);
+
+	for (cell = all_nodes.head; cell; cell = cell->next)
+	{
+		t_node_info *node_info = cell->node_info;
+
+		if (node_info->active == false)
+			continue;
+
+		if (node_info->type != PRIMARY && node_info->type != STANDBY)
+			continue;
+
+		if (node_info->node_id == failed_upstream_node_id)
+			continue;
+
+		if (node_is_downstream_of(&all_nodes, node_info, failed_upstream_node_id) == true)
+			continue;
+
+		/* reuse the existing primary connection */
+		if (node_info->node_id == primary_node_info->node_id)
+			node_info->conn = primary_conn;
+
+		candidate_cells[candidate_nodes.node_count].node_info = node_info;
+
+		if (candidate_nodes.tail == NULL)
+			candidate_nodes.head = &candidate_cells[candidate_nodes.node_count];
+		else
+			candidate_nodes.tail->next = &candidate_cells[candidate_nodes.node_count];
+
+		candidate_nodes.tail = &candidate_cells[candidate_nodes.node_count];
+		candidate_nodes.node_count++;
+	}
+
+	(void) establish_node_connections_parallel(&candidate_nodes, candidate_nodes.node_count);
+
+	assigned = pg_malloc0(sizeof(int) * all_nodes.node_count);
+
+	/* retrieve capacity; nodes without spare capacity are not candidates */
+	for (cell = candidate_nodes.head; cell; cell = cell->next)
+	{
+		t_node_info *node_info = cell->node_info;
+		RecoveryType expected_type = node_info->type == PRIMARY ? RECTYPE_PRIMARY : RECTYPE_STANDBY;
+
+		node_info->max_wal_senders = -1;
+
+		if (PQstatus(node_info->conn) != CONNECTION_OK)
+			continue;
+
+		node_info->recovery_type = RECTYPE_UNKNOWN;
+		get_node_replication_stats(node_info->conn, node_info);
+
+		if (node_info->recovery_type != expected_type)
+		{
+			node_info->max_wal_senders = -1;
+			continue;
+		}
+
+		log_debug("select_upstream_failover_target(): node %i has %i of %i WAL senders and %i of %i replication slots in use",
+				  node_info->node_id,
+				  node_info->attached_wal_receivers,
+				  node_info->max_wal_senders,
+				  node_info->total_replication_slots,
+				  node_info->max_replication_slots);
+	}
+
+	/*
+	 * A standby which is behind this node (or on a timeline this node can't
+	 * follow) can't be attached to; exclude any such target from the
+	 * candidates, and repeat the assignment.
+	 */
+	local_xlogpos = get_node_current_lsn(local_conn);
+
+	for (;;)
+	{
+		target = assign_orphan_nodes(&all_nodes, &candidate_nodes, failed_upstream_node_id, assigned);
+
+		if (target == NULL || target->node_id == primary_node_info->node_id)
+			break;
+
+		if (check_node_can_follow(local_conn, local_xlogpos, target->conn, target) == true)
+			break;
+
+		log_notice(_("unable to attach to node \"%s\" (ID: %i), excluding it as a candidate"),
+				   target->node_name,
+				   target->node_id);
+
+		target->max_wal_senders = -1;
+	}
+
+	if (target == NULL)
+	{
+		log_notice(_("no node with spare capacity found, attaching to the primary"));
+	}
+	else
+	{
+		log_notice(_("selected node \"%s\" (ID: %i) as new upstream"),
+				   target->node_name,
+				   target->node_id);
+
+		if (target->node_id != primary_node_info->node_id)
+		{
+			*follow_target_node_info = *target;
+			follow_target_node_info->conn = NULL;
+			follow_target_node_info->replication_info = NULL;
+		}
+	}
+
+	/* don't close the primary connection */
+	for (i = 0; i < all_nodes.node_count; i++)
+	{
+		cell = &candidate_cells[i];
+
+		if (cell->node_info != NULL && cell->node_info->conn == primary_conn)
+			cell->node_info->conn = NULL;
+	}
+
+	close_node_connections(&candidate_nodes);
+
+	pfree(assigned);
+	pfree(candidate_cells);
+	clear_node_info_list(&all_nodes);
+}
+
+
+/*
+ * Simulate the assignment of the failed upstream's orphans to the nodes in
+ * "candidate_nodes"; see select_upstream_failover_target(). "assigned" must
+ * have one entry per node in "all_nodes". Returns the candidate assigned to
+ * the local node, or NULL if none.
+ */
+static t_node_info *
+assign_orphan_nodes(NodeInfoList *all_nodes, NodeInfoList *candidate_nodes, int failed_upstream_node_id, int *assigned)
+{
+	NodeInfoListCell *cell = NULL;
+	t_node_info *target = NULL;
+
+	memset(assigned, 0, sizeof(int) * all_nodes->node_count);
+
+	/* simulate the assignment of each orphan, in node ID order */
+	for (cell = all_nodes->head; cell; cell = cell->next)
+	{
+		t_node_info *orphan = cell->node_info;
+		NodeInfoListCell *candidate_cell = NULL;
+		t_node_info *best = NULL;
+		int			best_position = -1;
+
+		if (orphan->active == false || orphan->type != STANDBY || orphan->upstream_node_id != failed_upstream_node_id)
+			continue;
+
+		for (candidate_cell = candidate_nodes->head; candidate_cell; candidate_cell = candidate_cell->next)
+		{
+			t_node_info *candidate = candidate_cell->node_info;
+			int			position = get_node_list_position(all_nodes, candidate->node_id);
+
+			if (candidate->max_wal_senders <= 0 || position < 0)
+				continue;
+
+			if (candidate->attached_wal_receivers + assigned[position] >= candidate->max_wal_senders)
+				continue;
+
+			if (config_file_options.use_replication_slots == true
+				&& candidate->total_replication_slots + assigned[position] >= candidate->max_replication_slots)
+				continue;
+
+			if (best == NULL)
+			{
+				best = candidate;
+				best_position = position;
+				continue;
+			}
+
+			/* prefer the orphan's location */
+			{
+				bool		candidate_local = strncmp(candidate->location, orphan->location, MAXLEN) == 0;
+				bool		best_local = strncmp(best->location, orphan->location, MAXLEN) == 0;
+
+				if (candidate_local != best_local)
+				{
+					if (candidate_local == true)
+					{
+						best = candidate;
+						best_position = position;
+					}
+					continue;
+				}
+			}
+
+			/* then lower WAL sender utilisation, compared without division */
+			{
+				int64		candidate_load = (int64) (candidate->attached_wal_receivers + assigned[position]) * best->max_wal_senders;
+				int64		best_load = (int64) (best->attached_wal_receivers + assigned[best_position]) * candidate->max_wal_senders;
+
+				if (candidate_load != best_load)
+				{
+					if (candidate_load < best_load)
+					{
+						best = candidate;
+						best_position = position;
+					}
+					continue;
+				}
+			}
+
+			/* then standbys over the primary, then lower node ID */
+			if ((candidate->type == STANDBY && best->type == PRIMARY)
+				|| (candidate->type == best->type && candidate->node_id < best->node_id))
+			{
+				best = candidate;
+				best_position = position;
+			}
+		}
+
+		if (best == NULL)
+			continue;
+
+		assigned[best_position]++;
+
+		log_debug("select_upstream_failover_target(): node %i assigned to node %i",
+				  orphan->node_id, best->node_id);
+
+		if (orphan->node_id == local_node_info.node_id)
+			target = best;
+	}
+
+	return target;
+}
+
+
+/*
+ * Determine whether "node_info" is (directly or indirectly) downstream of
+ * the node with ID "ancestor_node_id", according to the node records in
+ * "node_list".
+ */
+static bool
+node_is_downstream_of(NodeInfoList *node_list, t_node_info *node_info, int ancestor_node_id)
+{
+	int			upstream_node_id = node_info->upstream_node_id;
+	int			hops = 0;
+
+	/* bound the walk in case the records describe a cycle */
+	while (upstream_node_id != NO_UPSTREAM_NODE && hops++ < node_list->node_count)
+	{
+		t_node_info *upstream_node_info;
+
+		if (upstream_node_id == ancestor_node_id)
+			return true;
+
+		upstream_node_info = find_node_in_list(node_list, upstream_node_id);
+
+		if (upstream_node_info == NULL)
+			break;
+
+		upstream_node_id = upstream_node_info->upstream_node_id;
+	}
+
+	return false;
+}
+
+
 static FailoverState
 promote_self(void)
 {
@@ -3506,6 +4403,8 @@ promote_self(void)
 	log_info(_("promote_command is:\n  \"%s\""),
 			  promote_command);
 
+	logger_flush();
+
 	if (log_type == REPMGR_STDERR && *config_file_options.log_file)
 	{
 		fflush(stderr);
@@ -3568,6 +4467,7 @@ promote_self(void)
 							  _("original primary \"%s\" (ID: %i) reappeared"),
 							  failed_primary.node_name,
 							  failed_primary.node_id);
+			metrics_append_failover_trace(&event_details);
 
 			create_event_notification(upstream_conn,
 									  &config_file_options,
@@ -3616,6 +4516,8 @@ promote_self(void)
 						  failed_primary.node_name,
 						  failed_primary.node_id);
 
+		metrics_append_failover_trace(&event_details);
+
 		/* local_conn is now the primary connection */
 		create_event_notification(local_conn,
 								  &config_file_options,
@@ -3643,31 +4545,45 @@ static void
 notify_followers(NodeInfoList *standby_nodes, int follow_node_id)
 {
 	NodeInfoListCell *cell;
+	int			notified_count = 0;
 
 	log_info(_("%i followers to notify"),
 			 standby_nodes->node_count);
 
+	/*
+	 * Reconnect to any followers whose connection is not usable (reusing any
+	 * cached connections); connection attempts are made concurrently, so an
+	 * unreachable follower does not delay notification of the others by
+	 * more than one connection timeout in total.
+	 */
 	for (cell = standby_nodes->head; cell; cell = cell->next)
 	{
-		log_verbose(LOG_DEBUG, "intending to notify node %i...", cell->node_info->node_id);
+		if (PQstatus(cell->node_info->conn) == CONNECTION_OK)
+			continue;
 
-		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
-		{
-			log_info(_("reconnecting to node \"%s\" (ID: %i)..."),
-					 cell->node_info->node_name,
-					 cell->node_info->node_id);
+		log_info(_("reconnecting to node \"%s\" (ID: %i)..."),
+				 cell->node_info->node_name,
+				 cell->node_info->node_id);
 
-			close_connection(&cell->node_info->conn);
+		close_connection(&cell->node_info->conn);
 
-			cell->node_info->conn = establish_db_connection(cell->node_info->conninfo, false);
-		}
+		cell->node_info->conn = get_cached_node_connection(cell->node_info);
+	}
+
+	(void) establish_node_connections_parallel(standby_nodes, standby_nodes->node_count);
+
+	for (cell = standby_nodes->head; cell; cell = cell->next)
+	{
+		log_verbose(LOG_DEBUG, "intending to notify node %i...", cell->node_info->node_id);
 
 		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
 		{
 			log_warning(_("unable to reconnect to \"%s\" (ID: %i)"),
 						cell->node_info->node_name,
 						cell->node_info->node_id);
-			log_detail("\n%s", PQerrorMessage(cell->node_info->conn));
+
+			if (cell->node_info->conn != NULL)
+				log_detail("\n%s", PQerrorMessage(cell->node_info->conn));
 
 			close_connection(&cell->node_info->conn);
 			continue;
@@ -3686,8 +4602,14 @@ notify_followers(NodeInfoList *standby_nodes, int follow_node_id)
 					   cell->node_info->node_id,
 					   follow_node_id);
 		}
-		notify_follow_primary(cell->node_info->conn, follow_node_id);
 	}
+
+	/* dispatch the notification to all reachable followers at once */
+	notified_count = notify_follow_primary_parallel(standby_nodes, follow_node_id, config_file_options.async_query_timeout);
+
+	log_verbose(LOG_DEBUG, "%i of %i followers notified",
+				notified_count,
+				standby_nodes->node_count);
 }
 
 
@@ -3759,6 +4681,8 @@ follow_new_primary(int new_primary_id)
 
 	/* XXX check if new_primary_id == failed_primary.node_id? */
 
+	logger_flush();
+
 	if (log_type == REPMGR_STDERR && *config_file_options.log_file)
 	{
 		fflush(stderr);
@@ -3838,6 +4762,8 @@ follow_new_primary(int new_primary_id)
 
 				log_notice("%s", event_details.data);
 
+				metrics_append_failover_trace(&event_details);
+
 				create_event_notification(old_primary_conn,
 										  &config_file_options,
 										  local_node_info.node_id,
@@ -3927,6 +4853,8 @@ follow_new_primary(int new_primary_id)
 
 		log_notice("%s", event_details.data);
 
+		metrics_append_failover_trace(&event_details);
+
 		create_event_notification(upstream_conn,
 								  &config_file_options,
 								  local_node_info.node_id,
@@ -3959,6 +4887,8 @@ witness_follow_new_primary(int new_primary_id)
 
 	/* TODO: check if new_primary_id == failed_primary.node_id? */
 
+	logger_flush();
+
 	if (log_type == REPMGR_STDERR && *config_file_options.log_file)
 	{
 		fflush(stderr);
@@ -4035,6 +4965,8 @@ witness_follow_new_primary(int new_primary_id)
 
 		log_notice("%s", event_details.data);
 
+		metrics_append_failover_trace(&event_details);
+
 		create_event_notification(upstream_conn,
 								  &config_file_options,
 								  local_node_info.node_id,
@@ -4093,6 +5025,7 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 	NodeInfoListCell *cell = NULL;
 
 	t_node_info *candidate_node = NULL;
+	int64		candidate_score = 0;
 
 	ReplInfo	local_replication_info;
 
@@ -4124,12 +5057,17 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 
 	log_debug("do_election(): electoral term is %i", electoral_term);
 
+	metrics_record_electoral_term(electoral_term);
+	current_electoral_term = electoral_term;
+
 	if (config_file_options.failover == FAILOVER_MANUAL)
 	{
 		log_notice(_("this node is not configured for automatic failover so will not be considered as promotion candidate, and will not follow the new primary"));
 		log_detail(_("\"failover\" is set to \"manual\" in repmgr.conf"));
 		log_hint(_("manually execute \"repmgr standby follow\" to have this node follow the new primary"));
 
+		publish_prevote_abstention(electoral_term);
+
 		return ELECTION_NOT_CANDIDATE;
 	}
 
@@ -4139,6 +5077,8 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 		log_notice(_("this node's priority is %i so will not be considered as an automatic promotion candidate"),
 				   local_node_info.priority);
 
+		publish_prevote_abstention(electoral_term);
+
 		return ELECTION_LOST;
 	}
 
@@ -4246,14 +5186,58 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 
 	log_info(_("local node's last receive lsn: %X/%X"), format_lsn(local_node_info.last_wal_receive_lsn));
 
+	/*
+	 * Publish the LSNs and replication lag this node is standing with (the
+	 * "pre-vote"), so sibling candidates compare and score themselves against
+	 * the same values this node uses, and all candidates reach the same
+	 * decision in a single pass.
+	 */
+	(void) set_prevote(local_conn,
+					   electoral_term,
+					   local_node_info.last_wal_receive_lsn,
+					   local_replication_info.last_wal_replay_lsn,
+					   local_replication_info.replication_lag_time);
+
 	/* pointer to "winning" node, initially self */
 	candidate_node = &local_node_info;
 
+	if (config_file_options.promotion_candidate_scoring == true)
+	{
+		candidate_score = calculate_candidate_score(&local_node_info,
+													local_replication_info.last_wal_replay_lsn,
+													local_replication_info.replication_lag_time);
+		log_info(_("local node's promotion candidate score is %lli"), (long long int) candidate_score);
+	}
+
 	initPQExpBuffer(&nodes_with_primary_visible);
 
+	/*
+	 * Connect to all siblings concurrently (reusing any cached connections),
+	 * and retrieve each sibling's replication and repmgrd state with a single
+	 * query, so the survey takes one round trip in total rather than several
+	 * per node.
+	 */
+	for (cell = sibling_nodes->head; cell; cell = cell->next)
+	{
+		if (cell->node_info->conn == NULL)
+			cell->node_info->conn = get_cached_node_connection(cell->node_info);
+	}
+
+	(void) establish_node_connections_parallel(sibling_nodes, sibling_nodes->node_count);
+	(void) get_replication_info_parallel(sibling_nodes, config_file_options.async_query_timeout);
+
+	/*
+	 * Only wait for siblings' pre-votes if the result of the initial survey
+	 * does not already mean the election will be cancelled.
+	 */
+	if (election_will_be_cancelled(sibling_nodes, primary_location_seen, total_nodes) == false)
+		wait_for_sibling_prevotes(sibling_nodes, electoral_term);
+
 	for (cell = sibling_nodes->head; cell; cell = cell->next)
 	{
 		ReplInfo	sibling_replication_info;
+		XLogRecPtr	sibling_replay_lsn = InvalidXLogRecPtr;
+		int			sibling_lag_time = 0;
 
 		log_info(_("checking state of sibling node \"%s\" (ID: %i)"),
 				 cell->node_info->node_name,
@@ -4262,8 +5246,6 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 		/* assume the worst case */
 		cell->node_info->node_status = NODE_STATUS_UNKNOWN;
 
-		cell->node_info->conn = establish_db_connection(cell->node_info->conninfo, false);
-
 		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
 		{
 			close_connection(&cell->node_info->conn);
@@ -4290,15 +5272,23 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 			}
 		}
 
+		if (cell->node_info->replication_info == NULL)
+		{
+			log_warning(_("unable to retrieve replication information for node \"%s\" (ID: %i), skipping"),
+						cell->node_info->node_name,
+						cell->node_info->node_id);
+			continue;
+		}
+
+		sibling_replication_info = *cell->node_info->replication_info;
+
 		/*
 		 * check if repmgrd running - skip if not
 		 *
-		 * TODO: include pid query in replication info query?
-		 *
 		 * NOTE: from Pg12 we could execute "pg_promote()" from a running repmgrd;
 		 * here we'll need to find a way of ensuring only one repmgrd does this
 		 */
-		if (repmgrd_get_pid(cell->node_info->conn) == UNKNOWN_PID)
+		if (sibling_replication_info.repmgrd_pid == UNKNOWN_PID)
 		{
 			log_warning(_("repmgrd not running on node \"%s\" (ID: %i), skipping"),
 						cell->node_info->node_name,
@@ -4306,14 +5296,6 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 			continue;
 		}
 
-		if (get_replication_info(cell->node_info->conn, cell->node_info->type, &sibling_replication_info) == false)
-		{
-			log_warning(_("unable to retrieve replication information for node \"%s\" (ID: %i), skipping"),
-						cell->node_info->node_name,
-						cell->node_info->node_id);
-			continue;
-		}
-
 		/*
 		 * Check if node is not in recovery - it may have been promoted
 		 * outside of the failover mechanism, in which case we may be able
@@ -4447,13 +5429,42 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 		}
 
 
-		/* get node's last receive LSN - if "higher" than current winner, current node is candidate */
-		cell->node_info->last_wal_receive_lsn = sibling_replication_info.last_wal_receive_lsn;
+		/* node has published a pre-vote stating it is not standing */
+		if (sibling_replication_info.prevote_term == electoral_term
+			&& sibling_replication_info.prevote_lsn == InvalidXLogRecPtr)
+		{
+			log_info(_("node \"%s\" (ID: %i) is not standing as a promotion candidate, skipping"),
+					 cell->node_info->node_name,
+					 cell->node_info->node_id);
+			continue;
+		}
 
-		log_info(_("last receive LSN for sibling node \"%s\" (ID: %i) is: %X/%X"),
-				 cell->node_info->node_name,
-				 cell->node_info->node_id,
-				 format_lsn(cell->node_info->last_wal_receive_lsn));
+		/*
+		 * get node's last receive LSN - if "higher" than current winner, current node is candidate;
+		 * if the node has published a pre-vote, use the LSN it is standing with
+		 */
+		if (sibling_replication_info.prevote_term == electoral_term)
+		{
+			cell->node_info->last_wal_receive_lsn = sibling_replication_info.prevote_lsn;
+			sibling_replay_lsn = sibling_replication_info.prevote_replay_lsn;
+			sibling_lag_time = sibling_replication_info.prevote_lag_time;
+
+			log_info(_("sibling node \"%s\" (ID: %i) is standing with LSN %X/%X"),
+					 cell->node_info->node_name,
+					 cell->node_info->node_id,
+					 format_lsn(cell->node_info->last_wal_receive_lsn));
+		}
+		else
+		{
+			cell->node_info->last_wal_receive_lsn = sibling_replication_info.last_wal_receive_lsn;
+			sibling_replay_lsn = sibling_replication_info.last_wal_replay_lsn;
+			sibling_lag_time = sibling_replication_info.replication_lag_time;
+
+			log_info(_("last receive LSN for sibling node \"%s\" (ID: %i) is: %X/%X"),
+					 cell->node_info->node_name,
+					 cell->node_info->node_id,
+					 format_lsn(cell->node_info->last_wal_receive_lsn));
+		}
 
 		/* compare LSN */
 		if (cell->node_info->last_wal_receive_lsn > candidate_node->last_wal_receive_lsn)
@@ -4466,6 +5477,46 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 					 candidate_node->node_id);
 
 			candidate_node = cell->node_info;
+
+			if (config_file_options.promotion_candidate_scoring == true)
+				candidate_score = calculate_candidate_score(cell->node_info, sibling_replay_lsn, sibling_lag_time);
+		}
+		/* LSN is same - tiebreak on score, if enabled */
+		else if (cell->node_info->last_wal_receive_lsn == candidate_node->last_wal_receive_lsn
+				 && config_file_options.promotion_candidate_scoring == true)
+		{
+			int64		sibling_score = calculate_candidate_score(cell->node_info, sibling_replay_lsn, sibling_lag_time);
+
+			log_info(_("node \"%s\" (ID: %i) has same LSN as current candidate \"%s\" (ID: %i)"),
+					 cell->node_info->node_name,
+					 cell->node_info->node_id,
+					 candidate_node->node_name,
+					 candidate_node->node_id);
+
+			if (sibling_score > candidate_score
+				|| (sibling_score == candidate_score && cell->node_info->node_id < candidate_node->node_id))
+			{
+				log_info(_("node \"%s\" (ID: %i) has a better score (%lli) than current candidate \"%s\" (ID: %i) (%lli)"),
+						 cell->node_info->node_name,
+						 cell->node_info->node_id,
+						 (long long int) sibling_score,
+						 candidate_node->node_name,
+						 candidate_node->node_id,
+						 (long long int) candidate_score);
+
+				candidate_node = cell->node_info;
+				candidate_score = sibling_score;
+			}
+			else
+			{
+				log_info(_("node \"%s\" (ID: %i) does not have a better score (%lli) than current candidate \"%s\" (ID: %i) (%lli)"),
+						 cell->node_info->node_name,
+						 cell->node_info->node_id,
+						 (long long int) sibling_score,
+						 candidate_node->node_name,
+						 candidate_node->node_id,
+						 (long long int) candidate_score);
+			}
 		}
 		/* LSN is same - tiebreak on priority, then node_id */
 		else if (cell->node_info->last_wal_receive_lsn == candidate_node->last_wal_receive_lsn)
@@ -4523,77 +5574,272 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 		monitoring_state = MS_DEGRADED;
 		INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
 
-		reset_node_voting_status();
+		reset_node_voting_status();
+
+		termPQExpBuffer(&nodes_with_primary_visible);
+
+		return ELECTION_CANCELLED;
+	}
+
+	if (nodes_with_primary_still_visible > 0)
+	{
+		log_info(_("%i nodes can see the primary"),
+				   nodes_with_primary_still_visible);
+
+		log_detail(_("following nodes can see the primary:\n%s"),
+				   nodes_with_primary_visible.data);
+
+		if (config_file_options.primary_visibility_consensus == true)
+		{
+			log_notice(_("cancelling failover as some nodes can still see the primary"));
+			monitoring_state = MS_DEGRADED;
+			INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
+
+			reset_node_voting_status();
+
+			termPQExpBuffer(&nodes_with_primary_visible);
+
+			return ELECTION_CANCELLED;
+		}
+	}
+
+	termPQExpBuffer(&nodes_with_primary_visible);
+
+	log_info(_("visible nodes: %i; total nodes: %i; no nodes have seen the primary within the last %i seconds"),
+			  visible_nodes,
+			 total_nodes,
+			 (config_file_options.monitor_interval_secs * 2));
+
+	if (visible_nodes <= (total_nodes / 2.0))
+	{
+		log_notice(_("unable to reach a qualified majority of nodes"));
+		log_detail(_("node will enter degraded monitoring state waiting for reconnect"));
+
+		monitoring_state = MS_DEGRADED;
+		INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
+
+		reset_node_voting_status();
+
+		return ELECTION_CANCELLED;
+	}
+
+	log_notice(_("promotion candidate is \"%s\" (ID: %i)"),
+			   candidate_node->node_name,
+			   candidate_node->node_id);
+
+	if (candidate_node->node_id == local_node_info.node_id)
+	{
+		/*
+		 * If "failover_validation_command" is set, execute that command
+		 * and decide the result based on the command's output
+		 */
+
+		if (config_file_options.failover_validation_command[0] != '\0')
+		{
+			return execute_failover_validation_command(candidate_node);
+		}
+
+		return ELECTION_WON;
+	}
+
+	return ELECTION_LOST;
+}
+
+/*
+ * Calculate a promotion candidate's score, used to choose between candidates
+ * which have received the same amount of WAL if "promotion_candidate_scoring"
+ * is enabled; a higher score is better. The score favours the candidate
+ * which will be able to accept writes soonest, i.e. with the least WAL
+ * pending replay and the lowest replication lag.
+ *
+ * Candidates are never chosen over ones which have received more WAL, as
+ * nodes which are ahead of the new primary would be unable to follow it.
+ *
+ * As all candidates evaluate each other's scores, "node_info->last_wal_receive_lsn",
+ * "replay_lsn" and "lag_time" must be the values the candidate published with
+ * its pre-vote, so every candidate scores it identically; only a candidate
+ * which has not published a pre-vote is scored from the values sampled
+ * during the survey. For the same reason, the weights must be the same on
+ * all nodes.
+ */
+static int64
+calculate_candidate_score(t_node_info *node_info, XLogRecPtr replay_lsn, int lag_time)
+{
+	int64		score = 0;
+	int64		replay_pending_mb = 0;
+
+	if (node_info->last_wal_receive_lsn > replay_lsn)
+		replay_pending_mb = (int64) ((node_info->last_wal_receive_lsn - replay_lsn) / (1024 * 1024));
+
+	if (lag_time < 0)
+		lag_time = 0;
+
+	score += (int64) node_info->priority * config_file_options.promotion_score_priority_weight;
+	score -= replay_pending_mb * config_file_options.promotion_score_replay_weight;
+	score -= (int64) lag_time * config_file_options.promotion_score_lag_weight;
+
+	if (strncmp(node_info->location, upstream_node_info.location, MAXLEN) == 0)
+		score += config_file_options.promotion_score_location_weight;
+
+	log_verbose(LOG_DEBUG, "calculate_candidate_score(): node %i: priority %i; MB pending replay %lli; lag %i seconds; location \"%s\"; score %lli",
+				node_info->node_id,
+				node_info->priority,
+				(long long int) replay_pending_mb,
+				lag_time,
+				node_info->location,
+				(long long int) score);
+
+	return score;
+}
+
+
+/*
+ * Publish a pre-vote with an invalid LSN, stating this node is not standing
+ * in the election for this electoral term, so sibling candidates need not
+ * wait for its pre-vote.
+ */
+static void
+publish_prevote_abstention(int electoral_term)
+{
+	(void) set_prevote(local_conn,
+					   electoral_term,
+					   InvalidXLogRecPtr,
+					   InvalidXLogRecPtr,
+					   0);
+}
+
+
+/*
+ * Determine whether the sibling is a potential promotion candidate which
+ * has not yet published its pre-vote for the current electoral term.
+ *
+ * Siblings whose repmgr extension does not provide pre-votes are not
+ * waited for, nor are siblings whose repmgrd is paused or which can still
+ * see the primary, as neither will start an election.
+ */
+static bool
+sibling_prevote_pending(t_node_info *node_info, int electoral_term)
+{
+	ReplInfo   *replication_info = node_info->replication_info;
+
+	if (PQstatus(node_info->conn) != CONNECTION_OK || replication_info == NULL)
+		return false;
+
+	if (node_info->type == WITNESS || node_info->priority <= 0)
+		return false;
+
+	if (replication_info->in_recovery == false || replication_info->repmgrd_pid == UNKNOWN_PID)
+		return false;
+
+	if (replication_info->repmgrd_paused == true)
+		return false;
+
+	if (replication_info->upstream_last_seen >= 0
+		&& replication_info->upstream_last_seen < (config_file_options.monitor_interval_secs * 2)
+		&& replication_info->upstream_node_id == upstream_node_info.node_id)
+		return false;
+
+	if (replication_info->prevote_term < 0)
+		return false;
+
+	return replication_info->prevote_term != electoral_term;
+}
 
-		termPQExpBuffer(&nodes_with_primary_visible);
 
-		return ELECTION_CANCELLED;
-	}
+/*
+ * Determine from the initial survey of the siblings whether the outcome of
+ * the election does not depend on the siblings' pre-votes, i.e. if a sibling
+ * is not in recovery (and may have been promoted), if "primary_visibility_consensus"
+ * is set and a sibling can still see the primary, if no node in the primary's
+ * location is visible, or if a majority of nodes is not visible. These
+ * are the same criteria do_election() applies once the survey is complete.
+ */
+static bool
+election_will_be_cancelled(NodeInfoList *sibling_nodes, bool primary_location_seen, int total_nodes)
+{
+	NodeInfoListCell *cell = NULL;
+	int			visible_nodes = 1;
 
-	if (nodes_with_primary_still_visible > 0)
+	for (cell = sibling_nodes->head; cell; cell = cell->next)
 	{
-		log_info(_("%i nodes can see the primary"),
-				   nodes_with_primary_still_visible);
+		ReplInfo   *replication_info = cell->node_info->replication_info;
 
-		log_detail(_("following nodes can see the primary:\n%s"),
-				   nodes_with_primary_visible.data);
+		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
+			continue;
 
-		if (config_file_options.primary_visibility_consensus == true)
-		{
-			log_notice(_("cancelling failover as some nodes can still see the primary"));
-			monitoring_state = MS_DEGRADED;
-			INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
+		visible_nodes++;
 
-			reset_node_voting_status();
+		if (strncmp(cell->node_info->location, upstream_node_info.location, MAXLEN) == 0)
+			primary_location_seen = true;
 
-			termPQExpBuffer(&nodes_with_primary_visible);
+		if (replication_info == NULL || replication_info->repmgrd_pid == UNKNOWN_PID)
+			continue;
 
-			return ELECTION_CANCELLED;
-		}
-	}
+		if (replication_info->in_recovery == false && cell->node_info->type != WITNESS)
+			return true;
 
-	termPQExpBuffer(&nodes_with_primary_visible);
+		if (config_file_options.primary_visibility_consensus == true
+			&& replication_info->upstream_last_seen >= 0
+			&& replication_info->upstream_last_seen < (config_file_options.monitor_interval_secs * 2)
+			&& replication_info->upstream_node_id == upstream_node_info.node_id)
+			return true;
+	}
 
-	log_info(_("visible nodes: %i; total nodes: %i; no nodes have seen the primary within the last %i seconds"),
-			  visible_nodes,
-			 total_nodes,
-			 (config_file_options.monitor_interval_secs * 2));
+	if (primary_location_seen == false)
+		return true;
 
 	if (visible_nodes <= (total_nodes / 2.0))
-	{
-		log_notice(_("unable to reach a qualified majority of nodes"));
-		log_detail(_("node will enter degraded monitoring state waiting for reconnect"));
+		return true;
 
-		monitoring_state = MS_DEGRADED;
-		INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
+	return false;
+}
 
-		reset_node_voting_status();
 
-		return ELECTION_CANCELLED;
-	}
+/*
+ * Siblings detect the primary's failure at slightly different times, so
+ * some may not yet have published their pre-vote when this node surveys
+ * them. Re-survey, for up to "election_prevote_timeout" seconds, until each
+ * sibling candidate has published one; any still outstanding will be
+ * compared using their current LSN.
+ */
+static void
+wait_for_sibling_prevotes(NodeInfoList *sibling_nodes, int electoral_term)
+{
+	instr_time	wait_start;
+	NodeInfoListCell *cell = NULL;
 
-	log_notice(_("promotion candidate is \"%s\" (ID: %i)"),
-			   candidate_node->node_name,
-			   candidate_node->node_id);
+	INSTR_TIME_SET_CURRENT(wait_start);
 
-	if (candidate_node->node_id == local_node_info.node_id)
+	for (;;)
 	{
-		/*
-		 * If "failover_validation_command" is set, execute that command
-		 * and decide the result based on the command's output
-		 */
+		int			pending_count = 0;
 
-		if (config_file_options.failover_validation_command[0] != '\0')
+		for (cell = sibling_nodes->head; cell; cell = cell->next)
 		{
-			return execute_failover_validation_command(candidate_node);
+			if (sibling_prevote_pending(cell->node_info, electoral_term) == true)
+				pending_count++;
 		}
 
-		return ELECTION_WON;
-	}
+		if (pending_count == 0)
+			return;
 
-	return ELECTION_LOST;
+		if (calculate_elapsed(wait_start) >= config_file_options.election_prevote_timeout)
+		{
+			log_notice(_("%i sibling node(s) did not publish a pre-vote within %i seconds (\"election_prevote_timeout\")"),
+					   pending_count,
+					   config_file_options.election_prevote_timeout);
+			return;
+		}
+
+		log_debug("wait_for_sibling_prevotes(): waiting for %i sibling node(s)", pending_count);
+
+		pg_usleep(ELECTION_PREVOTE_POLL_INTERVAL_MS * 1000L);
+
+		(void) get_replication_info_parallel(sibling_nodes, config_file_options.async_query_timeout);
+	}
 }
 
+
 /*
  * "failover" for the witness node; the witness has no part in the election
  * other than being reachable, so just needs to await notification from the
@@ -4795,6 +6041,16 @@ handle_sighup(PGconn **conn, t_server_type server_type)
 		close_connection(conn);
 
 		*conn = establish_db_connection(config_file_options.conninfo, true);
+
+		init_background_commands(config_file_options.event_notification_workers,
+								 config_file_options.event_notification_queue_size,
+								 config_file_options.event_notification_timeout);
+
+		logger_set_buffer_size(config_file_options.log_buffer_size);
+		logger_set_format(config_file_options.log_format);
+
+		/* only re-binds if "metrics_port" or "metrics_listen_address" changed */
+		init_metrics_server();
 	}
 
 	if (*config_file_options.log_file)
@@ -4803,6 +6059,9 @@ handle_sighup(PGconn **conn, t_server_type server_type)
 
 		log_debug("reopening %s", config_file_options.log_file);
 
+		/* ensure buffered records are written to the current file */
+		logger_flush();
+
 		fd = freopen(config_file_options.log_file, "a", stderr);
 		if (fd == NULL)
 		{
@@ -4820,6 +6079,7 @@ execute_failover_validation_command(t_node_info *node_info)
 	PQExpBufferData failover_validation_command;
 	PQExpBufferData command_output;
 	int return_value = -1;
+	instr_time	validation_start;
 
 	initPQExpBuffer(&failover_validation_command);
 	initPQExpBuffer(&command_output);
@@ -4832,9 +6092,11 @@ execute_failover_validation_command(t_node_info *node_info)
 	log_detail("%s", failover_validation_command.data);
 
 	/* we determine success of the command by the value placed into return_value */
+	INSTR_TIME_SET_CURRENT(validation_start);
 	(void) local_command_return_value(failover_validation_command.data,
 									  &command_output,
 									  &return_value);
+	record_failover_phase(FAILOVER_PHASE_VALIDATION, validation_start);
 
 	termPQExpBuffer(&failover_validation_command);
 
@@ -4914,11 +6176,14 @@ parse_failover_validation_command(const char *template, t_node_info *node_info,
  * repmgr-client.c, however the later is very focussed on client-side
  * functionality (including log output related to --dry-run, pg_rewind etc.)
  * which we don't want here.
+ *
+ * System identifications and timeline history are cached for the duration
+ * of a failover (see clear_follow_check_cache()), so replication
+ * connections are only established the first time a node is checked.
  */
 static bool
 check_node_can_follow(PGconn *local_conn, XLogRecPtr local_xlogpos, PGconn *follow_target_conn, t_node_info *follow_target_node_info)
 {
-	PGconn	   *local_repl_conn = NULL;
 	t_system_identification local_identification = T_SYSTEM_IDENTIFICATION_INITIALIZER;
 
 	PGconn	   *follow_target_repl_conn = NULL;
@@ -4926,46 +6191,56 @@ check_node_can_follow(PGconn *local_conn, XLogRecPtr local_xlogpos, PGconn *foll
 	TimeLineHistoryEntry *follow_target_history = NULL;
 
 	bool can_follow = true;
-	bool success;
 
-	local_repl_conn = establish_replication_connection_from_conn(local_conn, local_node_info.repluser);
-
-	if (PQstatus(local_repl_conn) != CONNECTION_OK)
+	if (get_cached_system_identification(local_node_info.node_id, &local_identification) == false)
 	{
-		log_error(_("unable to establish a replication connection to the local node"));
-		PQfinish(local_repl_conn);
+		PGconn	   *local_repl_conn = establish_replication_connection_from_conn(local_conn, local_node_info.repluser);
+		bool		success;
 
-		return false;
-	}
+		if (PQstatus(local_repl_conn) != CONNECTION_OK)
+		{
+			log_error(_("unable to establish a replication connection to the local node"));
+			PQfinish(local_repl_conn);
 
-	success = identify_system(local_repl_conn, &local_identification);
-	PQfinish(local_repl_conn);
+			return false;
+		}
 
-	if (success == false)
-	{
-		log_error(_("unable to query the local node's system identification"));
+		success = identify_system(local_repl_conn, &local_identification);
+		PQfinish(local_repl_conn);
 
-		return false;
-	}
+		if (success == false)
+		{
+			log_error(_("unable to query the local node's system identification"));
 
-	/* check replication connection */
-	follow_target_repl_conn = establish_replication_connection_from_conn(follow_target_conn,
-																		 follow_target_node_info->repluser);
-	if (PQstatus(follow_target_repl_conn) != CONNECTION_OK)
-	{
-		log_error(_("unable to establish a replication connection to the follow target node"));
+			return false;
+		}
 
-		PQfinish(follow_target_repl_conn);
-		return false;
+		cache_system_identification(local_node_info.node_id, &local_identification);
 	}
 
-	/* check system_identifiers match */
-	if (identify_system(follow_target_repl_conn, &follow_target_identification) == false)
+	if (get_cached_system_identification(follow_target_node_info->node_id, &follow_target_identification) == false)
 	{
-		log_error(_("unable to query the follow target node's system identification"));
+		/* check replication connection */
+		follow_target_repl_conn = establish_replication_connection_from_conn(follow_target_conn,
+																			 follow_target_node_info->repluser);
+		if (PQstatus(follow_target_repl_conn) != CONNECTION_OK)
+		{
+			log_error(_("unable to establish a replication connection to the follow target node"));
 
-		PQfinish(follow_target_repl_conn);
-		return false;
+			PQfinish(follow_target_repl_conn);
+			return false;
+		}
+
+		/* check system_identifiers match */
+		if (identify_system(follow_target_repl_conn, &follow_target_identification) == false)
+		{
+			log_error(_("unable to query the follow target node's system identification"));
+
+			PQfinish(follow_target_repl_conn);
+			return false;
+		}
+
+		cache_system_identification(follow_target_node_info->node_id, &follow_target_identification);
 	}
 
 	/*
@@ -5032,14 +6307,37 @@ check_node_can_follow(PGconn *local_conn, XLogRecPtr local_xlogpos, PGconn *foll
 		/*
 		 * upstream has higher timeline - check where it forked off from this node's timeline
 		 */
-		follow_target_history = get_timeline_history(follow_target_repl_conn,
-													 local_identification.timeline + 1);
+		follow_target_history = get_cached_timeline_history(follow_target_identification.system_identifier,
+															local_identification.timeline + 1);
 
 		if (follow_target_history == NULL)
 		{
-			/* get_timeline_history() will emit relevant error messages */
-			PQfinish(follow_target_repl_conn);
-			return false;
+			if (follow_target_repl_conn == NULL)
+			{
+				follow_target_repl_conn = establish_replication_connection_from_conn(follow_target_conn,
+																					 follow_target_node_info->repluser);
+				if (PQstatus(follow_target_repl_conn) != CONNECTION_OK)
+				{
+					log_error(_("unable to establish a replication connection to the follow target node"));
+
+					PQfinish(follow_target_repl_conn);
+					return false;
+				}
+			}
+
+			follow_target_history = get_timeline_history(follow_target_repl_conn,
+														 local_identification.timeline + 1);
+
+			if (follow_target_history == NULL)
+			{
+				/* get_timeline_history() will emit relevant error messages */
+				PQfinish(follow_target_repl_conn);
+				return false;
+			}
+
+			cache_timeline_history(follow_target_identification.system_identifier,
+								   local_identification.timeline + 1,
+								   follow_target_history);
 		}
 
 		log_debug("local tli: %i; local_xlogpos: %X/%X; follow_target_history->tli: %i; follow_target_history->end: %X/%X",
@@ -5098,7 +6396,7 @@ check_witness_attached(t_node_info *node_info, bool startup)
 	 * connect and check upstream node id; at this point we don't care if it's
 	 * not reachable, only whether we can mark it as attached or not.
 	 */
-	PGconn *witness_conn = establish_db_connection_quiet(node_info->conninfo);
+	PGconn *witness_conn = get_node_connection(node_info);
 
 	if (PQstatus(witness_conn) == CONNECTION_OK)
 	{
@@ -5122,7 +6420,39 @@ check_witness_attached(t_node_info *node_info, bool startup)
 		node_info->attached = startup == true ? NODE_ATTACHED_UNKNOWN : NODE_DETACHED;
 	}
 
-	PQfinish(witness_conn);
+	release_node_connection(node_info, &witness_conn);
+}
+
+
+static inline unsigned int
+child_node_hash_bucket(t_child_node_info_list *nodes, int node_id)
+{
+	return ((unsigned int) node_id * 2654435761U) & (unsigned int) (nodes->bucket_count - 1);
+}
+
+
+/*
+ * (Re)build the node_id hash index with the provided number of buckets,
+ * which must be a power of two.
+ */
+static void
+resize_child_node_index(t_child_node_info_list *nodes, int bucket_count)
+{
+	t_child_node_info *node;
+
+	if (nodes->buckets != NULL)
+		pfree(nodes->buckets);
+
+	nodes->buckets = pg_malloc0(sizeof(t_child_node_info *) * bucket_count);
+	nodes->bucket_count = bucket_count;
+
+	for (node = nodes->head; node; node = node->next)
+	{
+		unsigned int bucket = child_node_hash_bucket(nodes, node->node_id);
+
+		node->hash_next = nodes->buckets[bucket];
+		nodes->buckets[bucket] = node;
+	}
 }
 
 
@@ -5130,6 +6460,7 @@ static t_child_node_info *
 append_child_node_record(t_child_node_info_list *nodes, int node_id, const char *node_name, t_server_type type, NodeAttached attached)
 {
 	t_child_node_info *child_node = pg_malloc0(sizeof(t_child_node_info));
+	unsigned int bucket;
 
 	child_node->node_id = node_id;
 	snprintf(child_node->node_name, sizeof(child_node->node_name), "%s", node_name);
@@ -5137,6 +6468,8 @@ append_child_node_record(t_child_node_info_list *nodes, int node_id, const char
 	child_node->type = type;
 	child_node->attached = attached;
 
+	child_node->prev = nodes->tail;
+
 	if (nodes->tail)
 		nodes->tail->next = child_node;
 	else
@@ -5145,51 +6478,139 @@ append_child_node_record(t_child_node_info_list *nodes, int node_id, const char
 	nodes->tail = child_node;
 	nodes->node_count++;
 
+	/* keep the load factor at or below one */
+	if (nodes->node_count > nodes->bucket_count)
+	{
+		int			bucket_count = nodes->bucket_count > 0
+			? nodes->bucket_count * 2
+			: CHILD_NODE_INFO_LIST_MIN_BUCKETS;
+
+		/* rebuilding the index also adds the new record */
+		resize_child_node_index(nodes, bucket_count);
+	}
+	else
+	{
+		bucket = child_node_hash_bucket(nodes, node_id);
+		child_node->hash_next = nodes->buckets[bucket];
+		nodes->buckets[bucket] = child_node;
+	}
+
 	return child_node;
 }
 
 
-static void
-remove_child_node_record(t_child_node_info_list *nodes, int node_id)
+static t_child_node_info *
+find_child_node_record(t_child_node_info_list *nodes, int node_id)
 {
 	t_child_node_info *node;
-	t_child_node_info *prev_node = NULL;
-	t_child_node_info *next_node = NULL;
 
-	node = nodes->head;
+	if (nodes->bucket_count == 0)
+		return NULL;
 
-	while (node != NULL)
+	for (node = nodes->buckets[child_node_hash_bucket(nodes, node_id)]; node; node = node->hash_next)
 	{
-		next_node = node->next;
-
 		if (node->node_id == node_id)
-		{
-			/* first node */
-			if (node == nodes->head)
-			{
-				nodes->head = next_node;
-			}
-			/* last node */
-			else if (next_node == NULL)
-			{
-				prev_node->next = NULL;
-			}
-			else
-			{
-				prev_node->next = next_node;
-			}
-			pfree(node);
-			nodes->node_count--;
-			return;
-		}
+			return node;
+	}
+
+	return NULL;
+}
+
+
+static void
+unlink_detached_child_node(t_child_node_info_list *nodes, t_child_node_info *child_node)
+{
+	if (child_node->detached_prev)
+		child_node->detached_prev->detached_next = child_node->detached_next;
+	else if (nodes->detached_head == child_node)
+		nodes->detached_head = child_node->detached_next;
+	else
+		return;					/* not in detached list */
+
+	if (child_node->detached_next)
+		child_node->detached_next->detached_prev = child_node->detached_prev;
+	else
+		nodes->detached_tail = child_node->detached_prev;
+
+	child_node->detached_prev = NULL;
+	child_node->detached_next = NULL;
+}
+
+
+/*
+ * Record a change in a child node's attachment state. A node which becomes
+ * detached is stamped with the current time and appended to the list's
+ * detached list; a node which leaves the detached state is removed from
+ * that list and its detached_time reset.
+ */
+static void
+set_child_node_attached(t_child_node_info_list *nodes, t_child_node_info *child_node, NodeAttached attached)
+{
+	if (child_node->attached == attached)
+		return;
+
+	if (child_node->attached == NODE_DETACHED)
+	{
+		unlink_detached_child_node(nodes, child_node);
+		INSTR_TIME_SET_ZERO(child_node->detached_time);
+	}
+
+	child_node->attached = attached;
+
+	if (attached == NODE_DETACHED)
+	{
+		INSTR_TIME_SET_CURRENT(child_node->detached_time);
+
+		child_node->detached_prev = nodes->detached_tail;
+		child_node->detached_next = NULL;
+
+		if (nodes->detached_tail)
+			nodes->detached_tail->detached_next = child_node;
 		else
-		{
-			prev_node = node;
-		}
-		node = next_node;
+			nodes->detached_head = child_node;
+
+		nodes->detached_tail = child_node;
 	}
 }
 
+
+static void
+remove_child_node_record(t_child_node_info_list *nodes, int node_id)
+{
+	t_child_node_info *node;
+	t_child_node_info **bucket_ptr;
+
+	if (nodes->bucket_count == 0)
+		return;
+
+	bucket_ptr = &nodes->buckets[child_node_hash_bucket(nodes, node_id)];
+
+	while (*bucket_ptr != NULL && (*bucket_ptr)->node_id != node_id)
+		bucket_ptr = &(*bucket_ptr)->hash_next;
+
+	node = *bucket_ptr;
+
+	if (node == NULL)
+		return;
+
+	*bucket_ptr = node->hash_next;
+
+	unlink_detached_child_node(nodes, node);
+
+	if (node->prev)
+		node->prev->next = node->next;
+	else
+		nodes->head = node->next;
+
+	if (node->next)
+		node->next->prev = node->prev;
+	else
+		nodes->tail = node->prev;
+
+	pfree(node);
+	nodes->node_count--;
+}
+
 static void
 clear_child_node_info_list(t_child_node_info_list *nodes)
 {
@@ -5205,9 +6626,16 @@ clear_child_node_info_list(t_child_node_info_list *nodes)
 		node = next_node;
 	}
 
+	if (nodes->buckets != NULL)
+		pfree(nodes->buckets);
+
 	nodes->head = NULL;
 	nodes->tail = NULL;
 	nodes->node_count = 0;
+	nodes->buckets = NULL;
+	nodes->bucket_count = 0;
+	nodes->detached_head = NULL;
+	nodes->detached_tail = NULL;
 }
 
 
@@ -5261,8 +6689,11 @@ int
 try_primary_reconnect(PGconn **conn, PGconn *local_conn, t_node_info *node_info)
 {
 	t_conninfo_param_list conninfo_params = T_CONNINFO_PARAM_LIST_INITIALIZER;
-	int			i;
+	int			attempt = 0;
 	int			max_attempts = config_file_options.reconnect_attempts;
+	int			delay_ms = (max_attempts > 0) ? 0 : -1;
+	int			interval_ms = 0;
+	instr_time	reconnect_start;
 
 	initialize_conninfo_params(&conninfo_params, false);
 
@@ -5273,14 +6704,28 @@ try_primary_reconnect(PGconn **conn, PGconn *local_conn, t_node_info *node_info)
 	param_set_ine(&conninfo_params, "connect_timeout", "2");
 	param_set_ine(&conninfo_params, "fallback_application_name", "repmgr");
 
-	for (i = 0; i < max_attempts; i++)
+	INSTR_TIME_SET_CURRENT(reconnect_start);
+
+	while (delay_ms >= 0)
 	{
-		log_info(_("checking state of node \"%s\" (ID: %i), %i of %i attempts"),
-				 node_info->node_name,
-				 node_info->node_id,
-				 i + 1, max_attempts);
+		attempt++;
+
+		if (config_file_options.reconnect_backoff == true)
+		{
+			log_info(_("checking state of node \"%s\" (ID: %i), attempt %i"),
+					 node_info->node_name,
+					 node_info->node_id,
+					 attempt);
+		}
+		else
+		{
+			log_info(_("checking state of node \"%s\" (ID: %i), %i of %i attempts"),
+					 node_info->node_name,
+					 node_info->node_id,
+					 attempt, max_attempts);
+		}
 
-		if (is_server_available_params(&conninfo_params) == true)
+		if (probe_reconnect_target(&conninfo_params) == true)
 		{
 			PGconn	   *our_conn;
 
@@ -5299,6 +6744,8 @@ try_primary_reconnect(PGconn **conn, PGconn *local_conn, t_node_info *node_info)
 			{
 				free_conninfo_params(&conninfo_params);
 
+				metrics_record_reconnect_attempt(true);
+
 				log_info(_("connection to node \"%s\" (ID: %i) succeeded"),
 						 node_info->node_name,
 						 node_info->node_id);
@@ -5340,14 +6787,31 @@ try_primary_reconnect(PGconn **conn, PGconn *local_conn, t_node_info *node_info)
 					   node_info->node_id);
 		}
 
-		if (i + 1 < max_attempts)
+		metrics_record_reconnect_attempt(false);
+
+		delay_ms = get_reconnect_delay_ms(attempt, reconnect_start, &interval_ms);
+
+		if (delay_ms >= 0)
 		{
-			int j;
-			log_info(_("sleeping %i seconds until next reconnection attempt"),
-					 config_file_options.reconnect_interval);
-			for (j = 0; j < config_file_options.reconnect_interval; j++)
+			int			slept_ms = 0;
+
+			if (config_file_options.reconnect_backoff == true)
+			{
+				log_info(_("sleeping %i milliseconds until next reconnection attempt"),
+						 delay_ms);
+			}
+			else
+			{
+				log_info(_("sleeping %i seconds until next reconnection attempt"),
+						 config_file_options.reconnect_interval);
+			}
+
+			/* check for a notification from a new primary at least once a second */
+			while (slept_ms < delay_ms)
 			{
 				int new_primary_node_id;
+				int			sleep_ms = Min(delay_ms - slept_ms, 1000);
+
 				if (get_new_primary(local_conn, &new_primary_node_id) == true && new_primary_node_id != UNKNOWN_NODE_ID)
 				{
 					if (new_primary_node_id == ELECTION_RERUN_NOTIFICATION)
@@ -5362,7 +6826,8 @@ try_primary_reconnect(PGconn **conn, PGconn *local_conn, t_node_info *node_info)
 					free_conninfo_params(&conninfo_params);
 					return new_primary_node_id;
 				}
-				sleep(1);
+				pg_usleep((long) sleep_ms * 1000L);
+				slept_ms += sleep_ms;
 			}
 		}
 	}
@@ -5370,7 +6835,7 @@ try_primary_reconnect(PGconn **conn, PGconn *local_conn, t_node_info *node_info)
 	log_warning(_("unable to reconnect to node \"%s\" (ID: %i) after %i attempts"),
 				node_info->node_name,
 				node_info->node_id,
-				max_attempts);
+				attempt);
 
 	node_info->node_status = NODE_STATUS_DOWN;
 
@@ -5378,3 +6843,17 @@ try_primary_reconnect(PGconn **conn, PGconn *local_conn, t_node_info *node_info)
 
 	return UNKNOWN_NODE_ID;
 }
+
+
+/*
+ * Record the duration of a failover phase which began at "start_time",
+ * both for the metrics endpoint and in the local node's shared memory.
+ */
+static void
+record_failover_phase(FailoverPhase phase, instr_time start_time)
+{
+	int64		duration_us = metrics_record_failover_phase(phase, start_time);
+
+	if (PQstatus(local_conn) == CONNECTION_OK)
+		set_failover_phase_timing(local_conn, format_failover_phase(phase), duration_us);
+}
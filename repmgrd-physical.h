@@ -25,6 +25,8 @@ void		monitor_streaming_primary(void);
 void		monitor_streaming_standby(void);
 void		monitor_streaming_witness(void);
 
+void		flush_monitoring_history(bool reconnect);
+
 void		handle_sigint_physical(SIGNAL_ARGS);
 
 #endif							/* _REPMGRD_PHYSICAL_H_ */
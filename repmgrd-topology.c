@@ -0,0 +1,297 @@
+/*
+ * repmgrd-topology.c - cache of node records used by repmgrd
+ *
+ * Copyright (c) 2ndQuadrant, 2010-2020
+ *
+ * repmgrd checks the status of a primary's child nodes on every
+ * "child_nodes_check_interval". Rather than reading "repmgr.nodes" each
+ * time, the child node records are cached, and updated when the trigger
+ * on "repmgr.nodes" notifies the "repmgr_nodes_changed" channel. Each
+ * notification's payload is the ID of the changed node, so only that
+ * record needs to be reread; an empty payload (TRUNCATE) causes the whole
+ * cache to be reread.
+ *
+ * Notifications are only delivered while the connection is LISTENing, and
+ * LISTEN is not possible on a server in recovery, so the cache is only used
+ * for a connection on which LISTEN succeeded; otherwise the records are
+ * read from the database every time, as before.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "repmgr.h"
+#include "repmgrd.h"
+#include "repmgrd-topology.h"
+
+/* if more nodes than this change between checks, reread all records */
+#define TOPOLOGY_MAX_PENDING_NODES 32
+
+typedef struct
+{
+	/* connection and backend PID on which LISTEN was executed */
+	PGconn	   *conn;
+	int			backend_pid;
+	/* node whose child node records are cached */
+	int			node_id;
+	bool		valid;
+	t_node_info *child_nodes;
+	int			child_node_count;
+	int			child_node_capacity;
+	/* nodes changed since the cache was last refreshed */
+	int			pending_node_ids[TOPOLOGY_MAX_PENDING_NODES];
+	int			pending_node_count;
+	bool		refresh_all;
+} t_topology_cache;
+
+static t_topology_cache topology_cache = {
+	NULL, 0, UNKNOWN_NODE_ID, false, NULL, 0, 0, {0}, 0, false
+};
+
+static bool topology_cache_listen(PGconn *conn);
+static bool topology_cache_refresh(PGconn *conn);
+static void topology_cache_store(NodeInfoList *node_list);
+static void topology_cache_remove_node(int node_id);
+static void topology_cache_add_node(t_node_info *node_info);
+
+
+/*
+ * get_cached_child_nodes()
+ *
+ * Equivalent to get_child_nodes(), but uses the cached node records if
+ * possible; only the nodes' "attached" status is always retrieved from
+ * the database.
+ */
+bool
+get_cached_child_nodes(PGconn *conn, int node_id, NodeInfoList *node_list)
+{
+	if (topology_cache_listen(conn) == false)
+	{
+		topology_cache_invalidate();
+		return get_child_nodes(conn, node_id, node_list);
+	}
+
+	/* process any notifications received since the last check */
+	if (PQconsumeInput(conn) == 1)
+	{
+		PGnotify   *notify = NULL;
+
+		while ((notify = PQnotifies(conn)) != NULL)
+		{
+			topology_cache_process_notify(conn, notify);
+			PQfreemem(notify);
+		}
+	}
+
+	if (topology_cache.node_id != node_id)
+	{
+		topology_cache.node_id = node_id;
+		topology_cache.valid = false;
+	}
+
+	if (topology_cache.valid == false || topology_cache.refresh_all == true)
+	{
+		bool		success = get_child_nodes(conn, node_id, node_list);
+
+		if (success == true)
+			topology_cache_store(node_list);
+
+		return success;
+	}
+
+	if (topology_cache.pending_node_count > 0 && topology_cache_refresh(conn) == false)
+	{
+		topology_cache_invalidate();
+		return get_child_nodes(conn, node_id, node_list);
+	}
+
+	log_verbose(LOG_DEBUG, "get_cached_child_nodes(): using %i cached child node record(s)",
+				topology_cache.child_node_count);
+
+	set_node_info_list(node_list, topology_cache.child_nodes, topology_cache.child_node_count);
+
+	return update_node_list_attached(conn, node_list);
+}
+
+
+/*
+ * Handle a notification received on any connection; notifications
+ * not relevant to the cache are ignored.
+ */
+void
+topology_cache_process_notify(PGconn *conn, PGnotify *notify)
+{
+	int			node_id;
+
+	if (conn != topology_cache.conn || strcmp(notify->relname, NODES_CHANGED_CHANNEL) != 0)
+		return;
+
+	log_verbose(LOG_DEBUG, "topology_cache_process_notify(): received notification with payload \"%s\"",
+				notify->extra);
+
+	node_id = atoi(notify->extra);
+
+	if (node_id <= 0 || topology_cache.pending_node_count >= TOPOLOGY_MAX_PENDING_NODES)
+	{
+		topology_cache.refresh_all = true;
+		return;
+	}
+
+	topology_cache.pending_node_ids[topology_cache.pending_node_count++] = node_id;
+}
+
+
+void
+topology_cache_invalidate(void)
+{
+	topology_cache.valid = false;
+	topology_cache.refresh_all = false;
+	topology_cache.pending_node_count = 0;
+}
+
+
+/*
+ * Ensure LISTEN has been executed on the provided connection. Any changes
+ * made before LISTEN was executed will not have been notified, so the
+ * cache is invalidated whenever the connection changes.
+ */
+static bool
+topology_cache_listen(PGconn *conn)
+{
+	PGresult   *res = NULL;
+	int			backend_pid;
+
+	if (PQstatus(conn) != CONNECTION_OK)
+		return false;
+
+	backend_pid = PQbackendPID(conn);
+
+	if (topology_cache.conn == conn && topology_cache.backend_pid == backend_pid)
+		return true;
+
+	topology_cache.conn = NULL;
+	topology_cache.backend_pid = 0;
+	topology_cache_invalidate();
+
+	res = PQexec(conn, "LISTEN " NODES_CHANGED_CHANNEL);
+
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+	{
+		log_verbose(LOG_DEBUG, "topology_cache_listen(): unable to execute LISTEN:\n  %s",
+					PQerrorMessage(conn));
+		PQclear(res);
+		return false;
+	}
+
+	PQclear(res);
+
+	log_debug("listening for changes to node records");
+
+	topology_cache.conn = conn;
+	topology_cache.backend_pid = backend_pid;
+
+	return true;
+}
+
+
+/*
+ * Reread the records of the nodes notified as changed.
+ */
+static bool
+topology_cache_refresh(PGconn *conn)
+{
+	int			i;
+
+	for (i = 0; i < topology_cache.pending_node_count; i++)
+	{
+		t_node_info node_info = T_NODE_INFO_INITIALIZER;
+		int			node_id = topology_cache.pending_node_ids[i];
+		RecordStatus record_status = get_node_record(conn, node_id, &node_info);
+
+		log_verbose(LOG_DEBUG, "topology_cache_refresh(): refreshing record for node %i", node_id);
+
+		if (record_status == RECORD_ERROR)
+			return false;
+
+		topology_cache_remove_node(node_id);
+
+		if (record_status == RECORD_FOUND && node_info.upstream_node_id == topology_cache.node_id)
+			topology_cache_add_node(&node_info);
+	}
+
+	topology_cache.pending_node_count = 0;
+
+	return true;
+}
+
+
+static void
+topology_cache_store(NodeInfoList *node_list)
+{
+	NodeInfoListCell *cell = NULL;
+
+	topology_cache.child_node_count = 0;
+
+	for (cell = node_list->head; cell; cell = cell->next)
+		topology_cache_add_node(cell->node_info);
+
+	topology_cache.valid = true;
+	topology_cache.refresh_all = false;
+	topology_cache.pending_node_count = 0;
+}
+
+
+static void
+topology_cache_remove_node(int node_id)
+{
+	int			i;
+
+	for (i = 0; i < topology_cache.child_node_count; i++)
+	{
+		if (topology_cache.child_nodes[i].node_id != node_id)
+			continue;
+
+		topology_cache.child_node_count--;
+
+		/* order is not significant */
+		if (i < topology_cache.child_node_count)
+			topology_cache.child_nodes[i] = topology_cache.child_nodes[topology_cache.child_node_count];
+
+		return;
+	}
+}
+
+
+static void
+topology_cache_add_node(t_node_info *node_info)
+{
+	t_node_info *cached_node = NULL;
+
+	if (topology_cache.child_node_count == topology_cache.child_node_capacity)
+	{
+		int			capacity = topology_cache.child_node_capacity == 0
+			? 8
+			: topology_cache.child_node_capacity * 2;
+
+		topology_cache.child_nodes = (t_node_info *) pg_realloc(topology_cache.child_nodes,
+																sizeof(t_node_info) * capacity);
+		topology_cache.child_node_capacity = capacity;
+	}
+
+	cached_node = &topology_cache.child_nodes[topology_cache.child_node_count++];
+
+	*cached_node = *node_info;
+	cached_node->conn = NULL;
+	cached_node->replication_info = NULL;
+	cached_node->attached = NODE_ATTACHED_UNKNOWN;
+}
@@ -0,0 +1,29 @@
+/*
+ * repmgrd-topology.h
+ * Copyright (c) 2ndQuadrant, 2010-2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _REPMGRD_TOPOLOGY_H_
+#define _REPMGRD_TOPOLOGY_H_
+
+/* channel notified by the trigger on "repmgr.nodes" */
+#define NODES_CHANGED_CHANNEL "repmgr_nodes_changed"
+
+bool		get_cached_child_nodes(PGconn *conn, int node_id, NodeInfoList *node_list);
+void		topology_cache_process_notify(PGconn *conn, PGnotify *notify);
+void		topology_cache_invalidate(void);
+
+#endif							/* _REPMGRD_TOPOLOGY_H_ */
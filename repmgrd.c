@@ -20,12 +20,16 @@
 #include <stdio.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <sys/stat.h>
 
 
 #include "repmgr.h"
 #include "repmgrd.h"
 #include "repmgrd-physical.h"
+#include "repmgrd-metrics.h"
+#include "repmgrd-topology.h"
 #include "configfile.h"
 #include "voting.h"
 
@@ -50,23 +54,57 @@ bool		startup_event_logged = false;
 MonitoringState monitoring_state = MS_NORMAL;
 instr_time	degraded_monitoring_start;
 
+/* most recently seen electoral term, for logging purposes */
+int			current_electoral_term = -1;
+
 /*
  * Record receipt of SIGHUP; will cause configuration file to be reread
  * at the appropriate point in the main loop.
  */
 volatile sig_atomic_t got_SIGHUP = false;
 
+/*
+ * Self-pipe written to by signal handlers, so wait_for_monitoring_event()
+ * can be woken immediately when a signal is received.
+ */
+static int	signal_pipe[2] = {-1, -1};
+
+/*
+ * Cache of idle connections to other nodes, so repeated probes of sibling
+ * and child nodes (e.g. during degraded monitoring or failover) can reuse
+ * an existing connection rather than establishing a new one each time.
+ */
+typedef struct NodeConnectionCacheEntry
+{
+	int			node_id;
+	char		conninfo[MAXCONNINFO];
+	PGconn	   *conn;
+	instr_time	last_used;
+	struct NodeConnectionCacheEntry *next;
+} NodeConnectionCacheEntry;
+
+static NodeConnectionCacheEntry *node_connection_cache = NULL;
+
+/* maximum time to wait for background commands on shutdown */
+#define BACKGROUND_COMMANDS_SHUTDOWN_WAIT	5	/* seconds */
+
 static void show_help(void);
 static void show_usage(void);
 static void daemonize_process(void);
 static void check_and_create_pid_file(const char *pid_file);
 
 static void start_monitoring(void);
+static void get_log_context(t_log_context *context);
 
 
 #ifndef WIN32
 static void setup_event_handlers(void);
+static void setup_signal_pipe(void);
 static void handle_sighup(SIGNAL_ARGS);
+
+static NodeConnectionCacheEntry *find_cached_node_connection(int node_id);
+static void remove_cached_node_connection(NodeConnectionCacheEntry *entry);
+static bool wal_receiver_is_receiving(void);
 #endif
 
 int			calculate_elapsed(instr_time start_time);
@@ -344,6 +382,7 @@ main(int argc, char **argv)
 	}
 
 	logger_init(&config_file_options, progname());
+	logger_set_context_hook(get_log_context);
 
 	log_notice(_("repmgrd (%s %s) starting up"), progname(), REPMGR_VERSION);
 
@@ -387,6 +426,12 @@ main(int argc, char **argv)
 		log_detail(_("available from PostgreSQL 9.5, this PostgreSQL version is %i"), PQserverVersion(local_conn));
 	}
 
+	if (config_file_options.connection_check_type == CHECK_WAL_RECEIVER && PQserverVersion(local_conn) < 90600)
+	{
+		log_warning(_("\"connection_check_type\" set to \"wal_receiver\", but WAL receiver status is not available for this PostgreSQL version"));
+		log_detail(_("available from PostgreSQL 9.6, this PostgreSQL version is %i; \"ping\" will be used"), PQserverVersion(local_conn));
+	}
+
 	/* Check "repmgr" the extension is installed */
 	extension_status = get_repmgr_extension_status(local_conn, &extversions);
 
@@ -525,6 +570,27 @@ main(int argc, char **argv)
 
 	repmgrd_set_pid(local_conn, getpid(), pid_file);
 
+	/*
+	 * Execute event notification commands in the background, so repmgrd
+	 * does not have to wait for them to complete.
+	 */
+	init_background_commands(config_file_options.event_notification_workers,
+							 config_file_options.event_notification_queue_size,
+							 config_file_options.event_notification_timeout);
+
+	init_metrics_server();
+
+	/*
+	 * The queries executed on each monitoring cycle are prepared on first
+	 * use on each connection, rather than parsed and planned every time.
+	 */
+	enable_prepared_monitoring_queries(true);
+
+	/*
+	 * Log buffering is only enabled once start-up is complete, so any
+	 * problems during start-up are reported immediately.
+	 */
+	logger_set_buffer_size(config_file_options.log_buffer_size);
 
 #ifndef WIN32
 	setup_event_handlers();
@@ -557,6 +623,7 @@ start_monitoring(void)
 				break;
 			case STANDBY:
 				monitor_streaming_standby();
+				flush_monitoring_history(true);
 				break;
 			case WITNESS:
 				monitor_streaming_witness();
@@ -738,12 +805,44 @@ check_and_create_pid_file(const char *pid_file)
 static void
 handle_sighup(SIGNAL_ARGS)
 {
+	int			save_errno = errno;
+
 	got_SIGHUP = true;
+
+	/* wake up wait_for_monitoring_event() */
+	if (signal_pipe[1] != -1)
+		(void) write(signal_pipe[1], "", 1);
+
+	errno = save_errno;
+}
+
+
+static void
+setup_signal_pipe(void)
+{
+	int			i;
+
+	if (pipe(signal_pipe) != 0)
+	{
+		log_warning(_("unable to create signal pipe"));
+		log_detail("%s", strerror(errno));
+		signal_pipe[0] = signal_pipe[1] = -1;
+		return;
+	}
+
+	for (i = 0; i < 2; i++)
+	{
+		(void) fcntl(signal_pipe[i], F_SETFL, fcntl(signal_pipe[i], F_GETFL) | O_NONBLOCK);
+		(void) fcntl(signal_pipe[i], F_SETFD, FD_CLOEXEC);
+	}
 }
 
+
 static void
 setup_event_handlers(void)
 {
+	setup_signal_pipe();
+
 	pqsignal(SIGHUP, handle_sighup);
 
 	/*
@@ -807,6 +906,40 @@ show_help(void)
 }
 
 
+/*
+ * Determine whether the local WAL receiver has recently received a message
+ * from the upstream node.
+ *
+ * A message is only considered recent if received within the last
+ * "monitor_interval_secs", so an upstream which fails without closing the
+ * connection (host crash, network partition) is detected no later than
+ * with "ping". On an idle system, where the upstream may only send a
+ * keepalive every half "wal_receiver_timeout", this means falling back to
+ * pinging the upstream, rather than delaying detection by up to that long.
+ */
+static bool
+wal_receiver_is_receiving(void)
+{
+	int			receiver_timeout = 0;
+	int			last_msg_age;
+
+	if (local_conn == NULL || PQstatus(local_conn) != CONNECTION_OK)
+		return false;
+
+	last_msg_age = get_wal_receiver_last_msg_age(local_conn, &receiver_timeout);
+
+	if (last_msg_age < 0)
+	{
+		log_debug("wal_receiver_is_receiving(): WAL receiver status not available");
+		return false;
+	}
+
+	log_debug("wal_receiver_is_receiving(): last message received %i seconds ago", last_msg_age);
+
+	return last_msg_age <= config_file_options.monitor_interval_secs;
+}
+
+
 bool
 check_upstream_connection(PGconn **conn, const char *conninfo, PGconn **paired_conn)
 {
@@ -824,8 +957,22 @@ check_upstream_connection(PGconn **conn, const char *conninfo, PGconn **paired_c
 	if (config_file_options.connection_check_type != CHECK_QUERY)
 	{
 		bool success = true;
+		ConnectionCheckType check_type = config_file_options.connection_check_type;
+
+		/*
+		 * If the local WAL receiver is receiving messages from the upstream,
+		 * no need to contact the upstream at all; otherwise fall back to
+		 * pinging it.
+		 */
+		if (check_type == CHECK_WAL_RECEIVER)
+		{
+			check_type = CHECK_PING;
 
-		if (config_file_options.connection_check_type == CHECK_PING)
+			if (wal_receiver_is_receiving() == true)
+				check_type = CHECK_WAL_RECEIVER;
+		}
+
+		if (check_type == CHECK_PING)
 		{
 			success = is_server_available(conninfo);
 		}
@@ -947,9 +1094,11 @@ try_reconnect(PGconn **conn, t_node_info *node_info)
 	PGconn	   *our_conn;
 	t_conninfo_param_list conninfo_params = T_CONNINFO_PARAM_LIST_INITIALIZER;
 
-	int			i;
-
+	int			attempt = 0;
 	int			max_attempts = config_file_options.reconnect_attempts;
+	int			delay_ms = (max_attempts > 0) ? 0 : -1;
+	int			interval_ms = 0;
+	instr_time	reconnect_start;
 
 	initialize_conninfo_params(&conninfo_params, false);
 
@@ -960,12 +1109,42 @@ try_reconnect(PGconn **conn, t_node_info *node_info)
 	param_set_ine(&conninfo_params, "connect_timeout", "2");
 	param_set_ine(&conninfo_params, "fallback_application_name", "repmgr");
 
-	for (i = 0; i < max_attempts; i++)
+	INSTR_TIME_SET_CURRENT(reconnect_start);
+
+	while (delay_ms >= 0)
 	{
-		log_info(_("checking state of node %i, %i of %i attempts"),
-				 node_info->node_id, i + 1, max_attempts);
-		if (is_server_available_params(&conninfo_params) == true)
+		attempt++;
+
+		if (config_file_options.reconnect_backoff == true)
+		{
+			log_info(_("checking state of node %i, attempt %i"),
+					 node_info->node_id, attempt);
+		}
+		else
+		{
+			log_info(_("checking state of node %i, %i of %i attempts"),
+					 node_info->node_id, attempt, max_attempts);
+		}
+
+		if (probe_reconnect_target(&conninfo_params) == true)
 		{
+			/*
+			 * If the original connection is still usable, there's no need to
+			 * establish a new one.
+			 */
+			if (PQstatus(*conn) == CONNECTION_OK && connection_ping(*conn) == PGRES_TUPLES_OK)
+			{
+				free_conninfo_params(&conninfo_params);
+
+				metrics_record_reconnect_attempt(true);
+
+				log_info(_("original connection is still available"));
+
+				node_info->node_status = NODE_STATUS_UP;
+
+				return;
+			}
+
 			log_notice(_("node %i has recovered, reconnecting"), node_info->node_id);
 
 			/*
@@ -979,34 +1158,22 @@ try_reconnect(PGconn **conn, t_node_info *node_info)
 			{
 				free_conninfo_params(&conninfo_params);
 
+				metrics_record_reconnect_attempt(true);
+
 				log_info(_("connection to node %i succeeded"), node_info->node_id);
 
 				if (PQstatus(*conn) == CONNECTION_BAD)
 				{
 					log_verbose(LOG_INFO, _("original connection handle returned CONNECTION_BAD, using new connection"));
-					close_connection(conn);
-					*conn = our_conn;
 				}
 				else
 				{
-					ExecStatusType ping_result;
-
-					ping_result = connection_ping(*conn);
-
-					if (ping_result != PGRES_TUPLES_OK)
-					{
-						log_info(_("original connection no longer available, using new connection"));
-						close_connection(conn);
-						*conn = our_conn;
-					}
-					else
-					{
-						log_info(_("original connection is still available"));
-
-						PQfinish(our_conn);
-					}
+					log_info(_("original connection no longer available, using new connection"));
 				}
 
+				close_connection(conn);
+				*conn = our_conn;
+
 				node_info->node_status = NODE_STATUS_UP;
 
 				return;
@@ -1018,17 +1185,29 @@ try_reconnect(PGconn **conn, t_node_info *node_info)
 					   node_info->node_id);
 		}
 
-		if (i + 1 < max_attempts)
+		metrics_record_reconnect_attempt(false);
+
+		delay_ms = get_reconnect_delay_ms(attempt, reconnect_start, &interval_ms);
+
+		if (delay_ms >= 0)
 		{
-			log_info(_("sleeping %i seconds until next reconnection attempt"),
-					 config_file_options.reconnect_interval);
-			sleep(config_file_options.reconnect_interval);
+			if (config_file_options.reconnect_backoff == true)
+			{
+				log_info(_("sleeping %i milliseconds until next reconnection attempt"),
+						 delay_ms);
+			}
+			else
+			{
+				log_info(_("sleeping %i seconds until next reconnection attempt"),
+						 config_file_options.reconnect_interval);
+			}
+			pg_usleep((long) delay_ms * 1000L);
 		}
 	}
 
 	log_warning(_("unable to reconnect to node %i after %i attempts"),
 				node_info->node_id,
-				max_attempts);
+				attempt);
 
 	node_info->node_status = NODE_STATUS_DOWN;
 
@@ -1038,6 +1217,467 @@ try_reconnect(PGconn **conn, t_node_info *node_info)
 }
 
 
+/*
+ * get_reconnect_delay_ms()
+ *
+ * Return the delay (in milliseconds) before the next attempt to reconnect
+ * to an unreachable node, or -1 if no further attempt should be made.
+ * "attempt" is the number of attempts made so far, and "start_time" the
+ * time the first attempt was made.
+ *
+ * By default, "reconnect_attempts" attempts are made "reconnect_interval"
+ * seconds apart. If "reconnect_backoff" is set, the interval starts at
+ * "reconnect_initial_interval_ms" and is doubled after each attempt (up to
+ * "reconnect_interval" seconds), with random jitter of up to 25% so nodes
+ * which lost the same upstream do not probe it in lockstep. Attempts are
+ * made until the same total period ("reconnect_attempts" *
+ * "reconnect_interval" seconds) has elapsed, so a node which has recovered
+ * is detected promptly without reducing tolerance of transient outages.
+ * "interval_ms" holds the current interval and should be initialised to 0.
+ */
+int
+get_reconnect_delay_ms(int attempt, instr_time start_time, int *interval_ms)
+{
+	static bool seeded = false;
+	int			max_interval_ms = config_file_options.reconnect_interval * 1000;
+	int			remaining_ms;
+	int			delay_ms;
+
+	if (config_file_options.reconnect_backoff == false)
+	{
+		if (attempt >= config_file_options.reconnect_attempts)
+			return -1;
+
+		return max_interval_ms;
+	}
+
+	remaining_ms = config_file_options.reconnect_attempts * max_interval_ms - elapsed_ms(start_time);
+
+	if (remaining_ms <= 0)
+		return -1;
+
+	if (seeded == false)
+	{
+		srandom((unsigned int) getpid() ^ (unsigned int) time(NULL));
+		seeded = true;
+	}
+
+	if (*interval_ms <= 0)
+		*interval_ms = config_file_options.reconnect_initial_interval_ms;
+
+	if (max_interval_ms < *interval_ms)
+		max_interval_ms = *interval_ms;
+
+	delay_ms = *interval_ms - *interval_ms / 4 + (int) (random() % (*interval_ms / 2 + 1));
+
+	*interval_ms = Min(*interval_ms * 2, max_interval_ms);
+
+	return Min(delay_ms, remaining_ms);
+}
+
+
+/*
+ * probe_reconnect_target()
+ *
+ * Check whether a node being reconnected to is available; with
+ * "reconnect_backoff", a failed TCP-level check fails the probe without
+ * waiting for "connect_timeout" to expire.
+ */
+bool
+probe_reconnect_target(t_conninfo_param_list *conninfo_params)
+{
+	if (config_file_options.reconnect_backoff == true)
+		return probe_server_available_params(conninfo_params, RECONNECT_PROBE_TIMEOUT_MS);
+
+	return is_server_available_params(conninfo_params);
+}
+
+
+/*
+ * get_node_connection()
+ *
+ * Return a connection to the specified node, reusing an idle cached
+ * connection if one is available and still usable; otherwise establish
+ * a new connection. Keepalive settings are applied to new connections
+ * (unless explicitly set in the node's conninfo string) so a connection
+ * to a node which has vanished is detected within roughly the same
+ * timeframe as repmgrd's own reconnection attempts.
+ *
+ * The caller should return the connection with release_node_connection().
+ */
+PGconn *
+get_node_connection(t_node_info *node_info)
+{
+	PGconn	   *conn = get_cached_node_connection(node_info);
+	t_conninfo_param_list conninfo_params = T_CONNINFO_PARAM_LIST_INITIALIZER;
+	char		buf[MAXLEN];
+
+	if (conn != NULL)
+		return conn;
+
+	initialize_conninfo_params(&conninfo_params, false);
+
+	if (parse_conninfo_string(node_info->conninfo, &conninfo_params, NULL, false) == false)
+	{
+		free_conninfo_params(&conninfo_params);
+		return establish_db_connection_quiet(node_info->conninfo);
+	}
+
+	param_set_ine(&conninfo_params, "connect_timeout", "2");
+	param_set_ine(&conninfo_params, "fallback_application_name", "repmgr");
+	param_set_ine(&conninfo_params, "keepalives", "1");
+
+	maxlen_snprintf(buf, "%i", config_file_options.monitor_interval_secs);
+	param_set_ine(&conninfo_params, "keepalives_idle", buf);
+
+	maxlen_snprintf(buf, "%i", config_file_options.reconnect_interval);
+	param_set_ine(&conninfo_params, "keepalives_interval", buf);
+
+	maxlen_snprintf(buf, "%i", config_file_options.reconnect_attempts);
+	param_set_ine(&conninfo_params, "keepalives_count", buf);
+
+	log_verbose(LOG_DEBUG, "get_node_connection(): establishing new connection to node %i",
+				node_info->node_id);
+
+	conn = establish_db_connection_by_params(&conninfo_params, false);
+
+	free_conninfo_params(&conninfo_params);
+
+	return conn;
+}
+
+
+/*
+ * get_cached_node_connection()
+ *
+ * Return an idle cached connection to the specified node, or NULL if none
+ * is available. A cached connection is only returned if it is still usable
+ * and was established with the node's current conninfo string.
+ *
+ * The connection is removed from the cache; the caller should return
+ * it with release_node_connection().
+ */
+PGconn *
+get_cached_node_connection(t_node_info *node_info)
+{
+	NodeConnectionCacheEntry *entry = find_cached_node_connection(node_info->node_id);
+	PGconn	   *conn = NULL;
+
+	if (entry == NULL)
+		return NULL;
+
+	conn = entry->conn;
+	entry->conn = NULL;
+
+	if (strncmp(entry->conninfo, node_info->conninfo, MAXCONNINFO) != 0)
+	{
+		log_verbose(LOG_DEBUG, "get_cached_node_connection(): conninfo for node %i has changed",
+					node_info->node_id);
+		close_connection(&conn);
+	}
+	else if (PQstatus(conn) != CONNECTION_OK
+			 || PQconsumeInput(conn) == 0
+			 || connection_ping(conn) != PGRES_TUPLES_OK)
+	{
+		log_verbose(LOG_DEBUG, "get_cached_node_connection(): cached connection to node %i no longer usable",
+					node_info->node_id);
+		close_connection(&conn);
+	}
+	else
+	{
+		log_verbose(LOG_DEBUG, "get_cached_node_connection(): reusing connection to node %i",
+					node_info->node_id);
+	}
+
+	remove_cached_node_connection(entry);
+
+	return conn;
+}
+
+
+/*
+ * release_node_connection()
+ *
+ * Return a connection obtained with get_node_connection() (or any other
+ * connection to the specified node) to the cache, provided it is usable
+ * and idle; otherwise close it. "*conn" is set to NULL in either case.
+ *
+ * Cached connections which have not been used for some time are also
+ * closed here.
+ */
+void
+release_node_connection(t_node_info *node_info, PGconn **conn)
+{
+	NodeConnectionCacheEntry *entry = NULL;
+	NodeConnectionCacheEntry *next_entry = NULL;
+
+	/* close connections which have not been used recently */
+	for (entry = node_connection_cache; entry != NULL; entry = next_entry)
+	{
+		next_entry = entry->next;
+
+		if (calculate_elapsed(entry->last_used) >= NODE_CONNECTION_CACHE_MAX_IDLE)
+		{
+			log_verbose(LOG_DEBUG, "release_node_connection(): closing idle connection to node %i",
+						entry->node_id);
+			remove_cached_node_connection(entry);
+		}
+	}
+
+	if (*conn == NULL)
+		return;
+
+	if (PQstatus(*conn) != CONNECTION_OK || PQtransactionStatus(*conn) != PQTRANS_IDLE)
+	{
+		close_connection(conn);
+		return;
+	}
+
+	/* only cache one connection per node */
+	entry = find_cached_node_connection(node_info->node_id);
+
+	if (entry != NULL)
+		remove_cached_node_connection(entry);
+
+	entry = pg_malloc0(sizeof(NodeConnectionCacheEntry));
+
+	entry->node_id = node_info->node_id;
+	strncpy(entry->conninfo, node_info->conninfo, MAXCONNINFO);
+	entry->conn = *conn;
+	INSTR_TIME_SET_CURRENT(entry->last_used);
+
+	entry->next = node_connection_cache;
+	node_connection_cache = entry;
+
+	*conn = NULL;
+}
+
+
+/*
+ * Return all open connections in the provided list to the connection cache.
+ */
+void
+release_node_list_connections(NodeInfoList *node_list)
+{
+	NodeInfoListCell *cell = NULL;
+
+	for (cell = node_list->head; cell; cell = cell->next)
+	{
+		release_node_connection(cell->node_info, &cell->node_info->conn);
+	}
+}
+
+
+/*
+ * Close all cached connections, e.g. on shutdown.
+ */
+void
+clear_node_connection_cache(void)
+{
+	while (node_connection_cache != NULL)
+		remove_cached_node_connection(node_connection_cache);
+}
+
+
+static NodeConnectionCacheEntry *
+find_cached_node_connection(int node_id)
+{
+	NodeConnectionCacheEntry *entry = NULL;
+
+	for (entry = node_connection_cache; entry != NULL; entry = entry->next)
+	{
+		if (entry->node_id == node_id)
+			return entry;
+	}
+
+	return NULL;
+}
+
+
+static void
+remove_cached_node_connection(NodeConnectionCacheEntry *entry)
+{
+	NodeConnectionCacheEntry **prev = &node_connection_cache;
+
+	while (*prev != NULL && *prev != entry)
+		prev = &(*prev)->next;
+
+	if (*prev == NULL)
+		return;
+
+	*prev = entry->next;
+
+	close_connection(&entry->conn);
+	pfree(entry);
+}
+
+
+
+/*
+ * Return the effective monitoring interval in milliseconds; "monitor_interval_ms",
+ * if set, overrides "monitor_interval_secs".
+ */
+int
+get_monitor_interval_ms(void)
+{
+	if (config_file_options.monitor_interval_ms > 0)
+		return config_file_options.monitor_interval_ms;
+
+	return config_file_options.monitor_interval_secs * 1000;
+}
+
+
+/*
+ * wait_for_monitoring_event()
+ *
+ * Wait for up to "timeout_ms" milliseconds, returning early if a signal
+ * is received, or if either of the provided connections (which may be NULL)
+ * is found to have been closed by the server. This enables the monitoring
+ * loops to react to a lost connection straight away, rather than at the
+ * end of the current monitoring interval.
+ *
+ * Returns true if woken early.
+ */
+bool
+wait_for_monitoring_event(int timeout_ms, PGconn *conn1, PGconn *conn2)
+{
+	PGconn	   *conns[2];
+	instr_time	start_time;
+	bool		woken = false;
+	int			i;
+
+	conns[0] = conn1;
+	conns[1] = (conn2 != conn1) ? conn2 : NULL;
+
+	/* reap any completed event notification commands and start queued ones */
+	(void) process_background_commands();
+
+	/* idle point - write out any buffered log output before blocking */
+	logger_flush();
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	while (woken == false)
+	{
+		struct pollfd pollfds[4];
+		PGconn	   *polled_conns[4];
+		int			nfds = 0;
+		int			metrics_fd_index = -1;
+		int			remaining_ms;
+		int			ret;
+		instr_time	elapsed;
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, start_time);
+		remaining_ms = timeout_ms - (int) INSTR_TIME_GET_MILLISEC(elapsed);
+
+		if (remaining_ms <= 0)
+			break;
+
+		if (signal_pipe[0] != -1)
+		{
+			pollfds[nfds].fd = signal_pipe[0];
+			pollfds[nfds].events = POLLIN;
+			pollfds[nfds].revents = 0;
+			polled_conns[nfds] = NULL;
+			nfds++;
+		}
+
+		/* handle any metrics requests while waiting */
+		if (get_metrics_socket() != -1)
+		{
+			pollfds[nfds].fd = get_metrics_socket();
+			pollfds[nfds].events = POLLIN;
+			pollfds[nfds].revents = 0;
+			polled_conns[nfds] = NULL;
+			metrics_fd_index = nfds;
+			nfds++;
+		}
+
+		for (i = 0; i < 2; i++)
+		{
+			if (conns[i] == NULL || PQstatus(conns[i]) != CONNECTION_OK || PQsocket(conns[i]) < 0)
+				continue;
+
+			pollfds[nfds].fd = PQsocket(conns[i]);
+			pollfds[nfds].events = POLLIN;
+			pollfds[nfds].revents = 0;
+			polled_conns[nfds] = conns[i];
+			nfds++;
+		}
+
+		ret = poll(pollfds, nfds, remaining_ms);
+
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+			{
+				if (got_SIGHUP)
+					woken = true;
+				continue;
+			}
+
+			log_warning(_("wait_for_monitoring_event(): poll() returned with error"));
+			log_detail("%s", strerror(errno));
+
+			/* ensure we don't end up busy-looping */
+			pg_usleep((long) remaining_ms * 1000);
+			break;
+		}
+
+		if (ret == 0)
+			break;
+
+		for (i = 0; i < nfds; i++)
+		{
+			if (pollfds[i].revents == 0)
+				continue;
+
+			if (i == metrics_fd_index)
+			{
+				handle_metrics_requests();
+				continue;
+			}
+
+			if (polled_conns[i] == NULL)
+			{
+				char		buf[16];
+
+				/* drain the signal pipe */
+				while (read(signal_pipe[0], buf, sizeof(buf)) > 0)
+					;
+
+				woken = true;
+				continue;
+			}
+
+			/*
+			 * The connection is idle, so the server will only send us
+			 * something if it's closing the connection (or has sent a
+			 * notice or notification; the only notifications of interest
+			 * are for the topology cache).
+			 */
+			if (PQconsumeInput(polled_conns[i]) == 0 || PQstatus(polled_conns[i]) != CONNECTION_OK)
+			{
+				log_debug("wait_for_monitoring_event(): connection lost");
+				woken = true;
+			}
+			else
+			{
+				PGnotify   *notify = NULL;
+
+				while ((notify = PQnotifies(polled_conns[i])) != NULL)
+				{
+					topology_cache_process_notify(polled_conns[i], notify);
+					PQfreemem(notify);
+				}
+			}
+		}
+	}
+
+	return woken;
+}
+
 
 int
 calculate_elapsed(instr_time start_time)
@@ -1069,9 +1709,33 @@ print_monitoring_state(MonitoringState monitoring_state)
 }
 
 
+/*
+ * Provide repmgrd's current state for inclusion in JSON log records.
+ */
+static void
+get_log_context(t_log_context *context)
+{
+	if (local_node_info.node_id != UNKNOWN_NODE_ID)
+		context->node_id = local_node_info.node_id;
+
+	context->monitoring_state = print_monitoring_state(monitoring_state);
+	context->electoral_term = current_electoral_term;
+}
+
+
 void
 terminate(int retval)
 {
+	clear_node_connection_cache();
+
+	/* don't lose any monitoring history samples not yet written */
+	flush_monitoring_history(false);
+
+	/* give any outstanding event notification commands a chance to complete */
+	wait_background_commands(BACKGROUND_COMMANDS_SHUTDOWN_WAIT);
+
+	shutdown_metrics_server();
+
 	if (PQstatus(local_conn)  == CONNECTION_OK)
 		repmgrd_set_pid(local_conn, UNKNOWN_PID, NULL);
 
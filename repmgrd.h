@@ -16,6 +16,7 @@
 extern volatile sig_atomic_t got_SIGHUP;
 extern MonitoringState monitoring_state;
 extern instr_time degraded_monitoring_start;
+extern int	current_electoral_term;
 
 extern t_node_info local_node_info;
 extern PGconn *local_conn;
@@ -24,6 +25,17 @@ extern char pid_file[MAXPGPATH];
 
 bool		check_upstream_connection(PGconn **conn, const char *conninfo, PGconn **paired_conn);
 void		try_reconnect(PGconn **conn, t_node_info *node_info);
+int			get_reconnect_delay_ms(int attempt, instr_time start_time, int *interval_ms);
+bool		probe_reconnect_target(t_conninfo_param_list *conninfo_params);
+
+PGconn	   *get_node_connection(t_node_info *node_info);
+PGconn	   *get_cached_node_connection(t_node_info *node_info);
+void		release_node_connection(t_node_info *node_info, PGconn **conn);
+void		release_node_list_connections(NodeInfoList *node_list);
+void		clear_node_connection_cache(void);
+
+int			get_monitor_interval_ms(void);
+bool		wait_for_monitoring_event(int timeout_ms, PGconn *conn1, PGconn *conn2);
 
 int			calculate_elapsed(instr_time start_time);
 const char *print_monitoring_state(MonitoringState monitoring_state);
@@ -18,6 +18,7 @@ SELECT * FROM repmgr.show_nodes;
 
 -- functions
 SELECT repmgr.get_new_primary();
+SELECT * FROM repmgr.get_election_status();
 SELECT repmgr.notify_follow_primary(-1);
 SELECT repmgr.notify_follow_primary(NULL);
 SELECT repmgr.reset_voting_status();
@@ -25,3 +26,4 @@ SELECT repmgr.set_local_node_id(-1);
 SELECT repmgr.set_local_node_id(NULL);
 SELECT repmgr.standby_get_last_updated();
 SELECT repmgr.standby_set_last_updated();
+SELECT repmgr.drop_monitoring_history_partitions(0);
@@ -0,0 +1,37 @@
+-- tests for functions which store data in the local node's shared memory;
+-- this is only available if "repmgr" is included in "shared_preload_libraries",
+-- otherwise no data is retained (see "repmgr_shmem_1.out")
+--
+-- as shared memory is retained until the server is restarted, results
+-- are compared against the state before each test where necessary
+
+SELECT current_setting('shared_preload_libraries') LIKE '%repmgr%' AS shmem_available;
+
+-- monitoring samples
+SELECT repmgr.add_monitoring_sample(1, '0/3000060', '0/3000000', NULL, 96, 0);
+SELECT repmgr.add_monitoring_sample(1, NULL, '0/3000100', '2020-01-01 00:00:00+00', NULL, 16);
+SELECT primary_node_id, last_wal_primary_location, last_wal_standby_location,
+       last_apply_time = '2020-01-01 00:00:00+00' AS last_apply_time_matches,
+       replication_lag, apply_lag, apply_time_lag > 0 AS apply_time_lag_positive
+  FROM repmgr.get_recent_monitoring()
+ ORDER BY sample_time DESC
+ LIMIT 2;
+
+-- failover phase timings
+SELECT COALESCE(SUM(count), 0) AS count_before, COALESCE(SUM(total_us), 0) AS total_us_before
+  FROM repmgr.get_failover_phase_timings() WHERE phase = 'regress' \gset
+SELECT COALESCE(array_agg(count ORDER BY bucket_le_ms NULLS LAST), '{}') AS histogram_before
+  FROM repmgr.get_failover_phase_histogram() WHERE phase = 'regress' \gset
+SELECT repmgr.set_failover_phase_timing('regress', 1000);
+SELECT repmgr.set_failover_phase_timing('regress', 2500000);
+-- negative durations are ignored
+SELECT repmgr.set_failover_phase_timing('regress', -1);
+SELECT phase, last_duration_us, count - :count_before AS new_count,
+       total_us - :total_us_before AS new_total_us, max_us >= 2500000 AS max_us_ok
+  FROM repmgr.get_failover_phase_timings()
+ WHERE phase = 'regress';
+SELECT bucket_le_ms, count - COALESCE((:'histogram_before'::BIGINT[])[bucket], 0) AS new_count
+  FROM (SELECT bucket_le_ms, count, row_number() OVER (ORDER BY bucket_le_ms NULLS LAST) AS bucket
+          FROM repmgr.get_failover_phase_histogram()
+         WHERE phase = 'regress') h
+ ORDER BY bucket;
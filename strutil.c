@@ -121,7 +121,7 @@ item_list_append_format(ItemList *item_list, const char *format,...)
 	if (item_list == NULL)
 		return;
 
-	cell = (ItemListCell *) pg_malloc0(sizeof(ItemListCell));
+	cell = (ItemListCell *) arena_alloc0(sizeof(ItemListCell));
 
 	if (cell == NULL)
 	{
@@ -129,7 +129,7 @@ item_list_append_format(ItemList *item_list, const char *format,...)
 		exit(ERR_OUT_OF_MEMORY);
 	}
 
-	cell->string = pg_malloc0(MAXLEN);
+	cell->string = arena_alloc0(MAXLEN);
 
 	va_start(arglist, format);
 
@@ -157,8 +157,8 @@ item_list_free(ItemList *item_list)
 	while (cell != NULL)
 	{
 		next_cell = cell->next;
-		pfree(cell->string);
-		pfree(cell);
+		arena_free(cell->string);
+		arena_free(cell);
 		cell = next_cell;
 	}
 }
@@ -225,9 +225,9 @@ _key_value_list_set(KeyValueList *item_list, bool replace, const char *key, cons
 					item_list->tail = NULL;
 				}
 
-				pfree(cell->key);
-				pfree(cell->value);
-				pfree(cell);
+				arena_free(cell->key);
+				arena_free(cell->value);
+				arena_free(cell);
 			}
 			else
 			{
@@ -236,7 +236,7 @@ _key_value_list_set(KeyValueList *item_list, bool replace, const char *key, cons
 		}
 	}
 
-	cell = (KeyValueListCell *) pg_malloc0(sizeof(KeyValueListCell));
+	cell = (KeyValueListCell *) arena_alloc0(sizeof(KeyValueListCell));
 
 	if (cell == NULL)
 	{
@@ -247,8 +247,8 @@ _key_value_list_set(KeyValueList *item_list, bool replace, const char *key, cons
 	keylen = strlen(key);
 	vallen = strlen(value);
 
-	cell->key = pg_malloc0(keylen + 1);
-	cell->value = pg_malloc0(vallen + 1);
+	cell->key = arena_alloc0(keylen + 1);
+	cell->value = arena_alloc0(vallen + 1);
 	cell->output_mode = OM_NOT_SET;
 
 	strncpy(cell->key, key, keylen);
@@ -295,9 +295,9 @@ key_value_list_free(KeyValueList *item_list)
 	while (cell != NULL)
 	{
 		next_cell = cell->next;
-		pfree(cell->key);
-		pfree(cell->value);
-		pfree(cell);
+		arena_free(cell->key);
+		arena_free(cell->value);
+		arena_free(cell);
 		cell = next_cell;
 	}
 }
@@ -317,7 +317,7 @@ check_status_list_set_format(CheckStatusList *list, const char *item, CheckStatu
 	va_list		arglist;
 	int			itemlen;
 
-	cell = (CheckStatusListCell *) pg_malloc0(sizeof(CheckStatusListCell));
+	cell = (CheckStatusListCell *) arena_alloc0(sizeof(CheckStatusListCell));
 
 	if (cell == NULL)
 	{
@@ -327,8 +327,8 @@ check_status_list_set_format(CheckStatusList *list, const char *item, CheckStatu
 
 	itemlen = strlen(item);
 
-	cell->item = pg_malloc0(itemlen + 1);
-	cell->details = pg_malloc0(MAXLEN);
+	cell->item = arena_alloc0(itemlen + 1);
+	cell->details = arena_alloc0(MAXLEN);
 	cell->status = status;
 
 	strncpy(cell->item, item, itemlen);
@@ -361,9 +361,9 @@ check_status_list_free(CheckStatusList *list)
 	while (cell != NULL)
 	{
 		next_cell = cell->next;
-		pfree(cell->item);
-		pfree(cell->details);
-		pfree(cell);
+		arena_free(cell->item);
+		arena_free(cell->details);
+		arena_free(cell);
 		cell = next_cell;
 	}
 }
@@ -455,6 +455,53 @@ escape_double_quotes(char *string, PQExpBufferData *out)
 }
 
 
+/*
+ * Append "string" to "out" as a double-quoted JSON string literal.
+ */
+void
+append_json_string(PQExpBufferData *out, const char *string)
+{
+	const unsigned char *ptr;
+
+	appendPQExpBufferChar(out, '"');
+
+	for (ptr = (const unsigned char *) string; *ptr; ptr++)
+	{
+		switch (*ptr)
+		{
+			case '"':
+				appendPQExpBufferStr(out, "\\\"");
+				break;
+			case '\\':
+				appendPQExpBufferStr(out, "\\\\");
+				break;
+			case '\b':
+				appendPQExpBufferStr(out, "\\b");
+				break;
+			case '\f':
+				appendPQExpBufferStr(out, "\\f");
+				break;
+			case '\n':
+				appendPQExpBufferStr(out, "\\n");
+				break;
+			case '\r':
+				appendPQExpBufferStr(out, "\\r");
+				break;
+			case '\t':
+				appendPQExpBufferStr(out, "\\t");
+				break;
+			default:
+				if (*ptr < 0x20)
+					appendPQExpBuffer(out, "\\u%04x", (int) *ptr);
+				else
+					appendPQExpBufferChar(out, *ptr);
+		}
+	}
+
+	appendPQExpBufferChar(out, '"');
+}
+
+
 char *
 string_skip_prefix(const char *prefix, char *string)
 {
@@ -483,6 +530,55 @@ string_remove_trailing_newlines(char *string)
 }
 
 
+/*
+ * Parse "value_count" comma-separated integers from the line starting at
+ * "*line" (e.g. a line of "repmgr cluster show --csv" output) into "values",
+ * and advance "*line" to the start of the following line.
+ *
+ * Returns false if the line does not start with "value_count" integers.
+ */
+bool
+parse_csv_int_line(char **line, int *values, int value_count)
+{
+	char	   *p = *line;
+	char	   *line_end = strchr(p, '\n');
+	bool		success = true;
+	int			i;
+
+	if (line_end == NULL)
+		line_end = p + strlen(p);
+
+	for (i = 0; i < value_count; i++)
+	{
+		char	   *endptr = NULL;
+
+		if (i > 0)
+		{
+			if (*p != ',')
+			{
+				success = false;
+				break;
+			}
+			p++;
+		}
+
+		values[i] = (int) strtol(p, &endptr, 10);
+
+		if (endptr == p || endptr > line_end)
+		{
+			success = false;
+			break;
+		}
+
+		p = endptr;
+	}
+
+	*line = (*line_end == '\n') ? line_end + 1 : line_end;
+
+	return success;
+}
+
+
 char *
 trim(char *s)
 {
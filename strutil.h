@@ -152,6 +152,8 @@ extern char *escape_string(PGconn *conn, const char *string);
 
 extern void escape_double_quotes(char *string, PQExpBufferData *out);
 
+extern void append_json_string(PQExpBufferData *out, const char *string);
+
 extern void
 append_where_clause(PQExpBufferData *where_clause, const char *clause,...)
 __attribute__((format(PG_PRINTF_ATTRIBUTE, 2, 3)));
@@ -163,6 +165,8 @@ extern char
 
 extern char *trim(char *s);
 
+extern bool parse_csv_int_line(char **line, int *values, int value_count);
+
 extern void
 			parse_follow_command(char *parsed_command, char *template, int node_id);
 
@@ -20,11 +20,54 @@
  */
 
 #include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <dirent.h>
 
 #include "repmgr.h"
 
 static bool _local_command(const char *command, PQExpBufferData *outputbuf, bool simple, int *return_value);
 
+static bool _start_parallel_command(t_parallel_command *parallel_command);
+static bool _read_parallel_command_output(t_parallel_command *parallel_command);
+static void _finish_parallel_command(t_parallel_command *parallel_command);
+static int	_parallel_command_remaining_ms(t_parallel_command *parallel_command, instr_time current_time, int timeout);
+
+/*
+ * State for commands executed in the background by queue_background_command();
+ * see init_background_commands().
+ */
+typedef struct s_background_command
+{
+	char		command[MAXPGPATH];
+	pid_t		pid;
+	instr_time	start_time;
+	bool		terminated;
+} t_background_command;
+
+static int	background_max_workers = 0;
+static int	background_queue_size = 0;
+static int	background_timeout = 0;
+
+static t_background_command *background_running = NULL;
+static int	background_running_count = 0;
+static int	background_running_allocated = 0;
+
+static t_background_command *background_queue = NULL;
+static int	background_queue_count = 0;
+static int	background_queue_allocated = 0;
+
+static bool _start_background_command(t_background_command *background_command);
+
+/*
+ * State for SSH connection multiplexing; see init_ssh_multiplexing().
+ */
+static bool ssh_multiplexing_enabled = false;
+static char ssh_control_directory[MAXPGPATH] = "";
+
+static bool _get_ssh_control_directory(void);
+static void _close_ssh_control_connections(void);
+
 
 /*
  * Execute a command locally. "outputbuf" should either be an
@@ -108,6 +151,95 @@ _local_command(const char *command, PQExpBufferData *outputbuf, bool simple, int
 }
 
 
+/*
+ * init_ssh_multiplexing()
+ *
+ * If enabled, ssh commands generated by make_remote_command() will share
+ * one master connection per host (OpenSSH's "ControlMaster" feature), so
+ * only the first command executed on a host incurs the overhead of
+ * establishing the connection and authenticating.
+ *
+ * The control sockets are created on demand in a private temporary
+ * directory; the master connections are closed, and the directory removed,
+ * when the process exits.
+ */
+void
+init_ssh_multiplexing(bool enabled)
+{
+	ssh_multiplexing_enabled = enabled;
+}
+
+
+static bool
+_get_ssh_control_directory(void)
+{
+	if (ssh_control_directory[0] != '\0')
+		return true;
+
+	snprintf(ssh_control_directory, sizeof(ssh_control_directory),
+			 "/tmp/repmgr-ssh-XXXXXX");
+
+	if (mkdtemp(ssh_control_directory) == NULL)
+	{
+		log_warning(_("unable to create directory for SSH control sockets, not using SSH multiplexing"));
+		log_detail("%s", strerror(errno));
+
+		ssh_control_directory[0] = '\0';
+		ssh_multiplexing_enabled = false;
+
+		return false;
+	}
+
+	log_verbose(LOG_DEBUG, "using SSH control socket directory \"%s\"", ssh_control_directory);
+
+	atexit(_close_ssh_control_connections);
+
+	return true;
+}
+
+
+/*
+ * Ask each master connection to exit and remove the control socket
+ * directory. Registered with atexit() when the directory is created.
+ */
+static void
+_close_ssh_control_connections(void)
+{
+	DIR		   *control_dir;
+	struct dirent *control_file;
+
+	if (ssh_control_directory[0] == '\0')
+		return;
+
+	control_dir = opendir(ssh_control_directory);
+
+	if (control_dir != NULL)
+	{
+		while ((control_file = readdir(control_dir)) != NULL)
+		{
+			char		exit_command[MAXLEN] = "";
+
+			if (control_file->d_name[0] == '.')
+				continue;
+
+			/* the host name is irrelevant if the control path is specified */
+			maxlen_snprintf(exit_command,
+							"ssh -q -o ControlPath=%s/%s -O exit localhost >/dev/null 2>&1",
+							ssh_control_directory,
+							control_file->d_name);
+
+			if (system(exit_command) != 0)
+				log_verbose(LOG_DEBUG, "unable to close SSH master connection \"%s\"", control_file->d_name);
+		}
+
+		closedir(control_dir);
+	}
+
+	rmtree(ssh_control_directory, true);
+	ssh_control_directory[0] = '\0';
+}
+
+
 /*
  * Execute a command via ssh on the remote host.
  *
@@ -188,8 +320,23 @@ make_remote_command(const char *host, const char *user, const char *command, con
 
 
 	appendPQExpBuffer(ssh_command,
-					  "ssh -o Batchmode=yes %s %s %s",
-					  ssh_options,
+					  "ssh -o Batchmode=yes %s ",
+					  ssh_options);
+
+	/*
+	 * ssh uses the first value obtained for each option, so any
+	 * ControlMaster settings in "ssh_options" take precedence.
+	 */
+	if (ssh_multiplexing_enabled == true && _get_ssh_control_directory() == true)
+	{
+		appendPQExpBuffer(ssh_command,
+						  "-o ControlMaster=auto -o ControlPersist=%i -o ControlPath=%s/%%C ",
+						  SSH_CONTROL_PERSIST,
+						  ssh_control_directory);
+	}
+
+	appendPQExpBuffer(ssh_command,
+					  "%s %s",
 					  ssh_host.data,
 					  command);
 
@@ -198,6 +345,669 @@ make_remote_command(const char *host, const char *user, const char *command, con
 }
 
 
+void
+init_parallel_command(t_parallel_command *parallel_command)
+{
+	initPQExpBuffer(&parallel_command->command);
+	initPQExpBuffer(&parallel_command->output);
+	parallel_command->return_value = -1;
+	parallel_command->timed_out = false;
+	parallel_command->pid = UNKNOWN_PID;
+	parallel_command->fd = -1;
+	INSTR_TIME_SET_ZERO(parallel_command->start_time);
+}
+
+
+void
+term_parallel_command(t_parallel_command *parallel_command)
+{
+	termPQExpBuffer(&parallel_command->command);
+	termPQExpBuffer(&parallel_command->output);
+}
+
+
+/*
+ * Execute the provided shell commands (typically generated with
+ * make_remote_command()), running at most "max_parallel" of them at
+ * the same time, and collect their output.
+ *
+ * If "timeout" is greater than zero, any command which has not completed
+ * after that number of seconds will be terminated and marked as timed out.
+ *
+ * On return each command's "output" buffer contains whatever was written
+ * to stdout, and "return_value" its exit code (-1 if the command could not
+ * be executed, or was terminated).
+ */
+void
+execute_commands_parallel(t_parallel_command *commands, int command_count, int max_parallel, int timeout)
+{
+	execute_commands_parallel_callback(commands, command_count, max_parallel, timeout, NULL, NULL);
+}
+
+
+/*
+ * As execute_commands_parallel(), but additionally calls "callback" (if
+ * not NULL) as soon as each command has completed, e.g. to report progress
+ * while the remaining commands are still running.
+ */
+void
+execute_commands_parallel_callback(t_parallel_command *commands, int command_count, int max_parallel, int timeout,
+								   parallel_command_callback callback, void *callback_arg)
+{
+	struct pollfd *pollfds = NULL;
+	int		   *running = NULL;
+	int			running_count = 0;
+	int			next_command = 0;
+	int			i;
+
+	if (command_count <= 0)
+		return;
+
+	if (max_parallel < 1)
+		max_parallel = 1;
+
+	if (max_parallel > command_count)
+		max_parallel = command_count;
+
+	log_verbose(LOG_DEBUG, "execute_commands_parallel(): executing %i commands; max parallel: %i; timeout: %i",
+				command_count, max_parallel, timeout);
+
+	pollfds = pg_malloc0(sizeof(struct pollfd) * max_parallel);
+	running = pg_malloc0(sizeof(int) * max_parallel);
+
+	while (next_command < command_count || running_count > 0)
+	{
+		int			poll_timeout = -1;
+		instr_time	current_time;
+
+		/* start as many commands as permitted */
+		while (next_command < command_count && running_count < max_parallel)
+		{
+			if (_start_parallel_command(&commands[next_command]) == true)
+			{
+				running[running_count] = next_command;
+				running_count++;
+			}
+			else if (callback != NULL)
+			{
+				callback(next_command, &commands[next_command], callback_arg);
+			}
+
+			next_command++;
+		}
+
+		if (running_count == 0)
+			continue;
+
+		INSTR_TIME_SET_CURRENT(current_time);
+
+		for (i = 0; i < running_count; i++)
+		{
+			t_parallel_command *parallel_command = &commands[running[i]];
+
+			pollfds[i].fd = parallel_command->fd;
+			pollfds[i].events = POLLIN;
+			pollfds[i].revents = 0;
+
+			if (timeout > 0)
+			{
+				int			remaining_ms = _parallel_command_remaining_ms(parallel_command, current_time, timeout);
+
+				if (poll_timeout == -1 || remaining_ms < poll_timeout)
+					poll_timeout = remaining_ms;
+			}
+		}
+
+		if (poll(pollfds, running_count, poll_timeout) < 0 && errno != EINTR)
+		{
+			log_error(_("execute_commands_parallel(): poll() returned with error"));
+			log_detail("%s", strerror(errno));
+
+			/* no way of usefully proceeding - terminate anything still running */
+			for (i = 0; i < running_count; i++)
+			{
+				kill(-commands[running[i]].pid, SIGKILL);
+				_finish_parallel_command(&commands[running[i]]);
+
+				if (callback != NULL)
+					callback(running[i], &commands[running[i]], callback_arg);
+			}
+
+			break;
+		}
+
+		INSTR_TIME_SET_CURRENT(current_time);
+
+		/*
+		 * Work backwards through the list of running commands, so any
+		 * completed command can be replaced with the last entry (which
+		 * will already have been processed).
+		 */
+		for (i = running_count - 1; i >= 0; i--)
+		{
+			t_parallel_command *parallel_command = &commands[running[i]];
+			bool		finished = false;
+
+			if (pollfds[i].revents != 0)
+				finished = _read_parallel_command_output(parallel_command);
+
+			if (finished == false && timeout > 0
+				&& _parallel_command_remaining_ms(parallel_command, current_time, timeout) == 0)
+			{
+				log_warning(_("command did not complete within %i seconds, terminating"), timeout);
+				log_detail(_("command was:\n  %s"), parallel_command->command.data);
+
+				/* the command is run in its own process group, so terminate the whole group */
+				kill(-parallel_command->pid, SIGKILL);
+				parallel_command->timed_out = true;
+				finished = true;
+			}
+
+			if (finished == true)
+			{
+				_finish_parallel_command(parallel_command);
+
+				if (callback != NULL)
+					callback(running[i], parallel_command, callback_arg);
+
+				running[i] = running[running_count - 1];
+				running_count--;
+			}
+		}
+	}
+
+	pfree(pollfds);
+	pfree(running);
+}
+
+
+static bool
+_start_parallel_command(t_parallel_command *parallel_command)
+{
+	int			pipefd[2];
+
+	log_debug("execute_commands_parallel(): starting command:\n  %s", parallel_command->command.data);
+
+	if (pipe(pipefd) != 0)
+	{
+		log_error(_("unable to create pipe for command:\n  %s"), parallel_command->command.data);
+		log_detail("%s", strerror(errno));
+		return false;
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+
+	parallel_command->pid = fork();
+
+	if (parallel_command->pid < 0)
+	{
+		log_error(_("unable to fork process for command:\n  %s"), parallel_command->command.data);
+		log_detail("%s", strerror(errno));
+		close(pipefd[0]);
+		close(pipefd[1]);
+		parallel_command->pid = UNKNOWN_PID;
+		return false;
+	}
+
+	if (parallel_command->pid == 0)
+	{
+		int			devnull;
+
+		/* own process group, so the command and any children can be terminated together */
+		setpgid(0, 0);
+
+		/* ensure concurrently executed commands don't compete for stdin */
+		devnull = open("/dev/null", O_RDONLY);
+		if (devnull >= 0)
+		{
+			dup2(devnull, STDIN_FILENO);
+			close(devnull);
+		}
+
+		close(pipefd[0]);
+		dup2(pipefd[1], STDOUT_FILENO);
+		close(pipefd[1]);
+
+		execl("/bin/sh", "sh", "-c", parallel_command->command.data, (char *) NULL);
+		_exit(127);
+	}
+
+	/* set here too, in case the child has not yet done so */
+	setpgid(parallel_command->pid, parallel_command->pid);
+
+	close(pipefd[1]);
+	parallel_command->fd = pipefd[0];
+	fcntl(parallel_command->fd, F_SETFL, fcntl(parallel_command->fd, F_GETFL) | O_NONBLOCK);
+
+	INSTR_TIME_SET_CURRENT(parallel_command->start_time);
+
+	return true;
+}
+
+
+/*
+ * Read any available output; returns true if the command has closed
+ * its output (i.e. has finished), otherwise false.
+ */
+static bool
+_read_parallel_command_output(t_parallel_command *parallel_command)
+{
+	char		output[MAXLEN];
+
+	for (;;)
+	{
+		ssize_t		bytes_read = read(parallel_command->fd, output, sizeof(output));
+
+		if (bytes_read > 0)
+		{
+			appendBinaryPQExpBuffer(&parallel_command->output, output, bytes_read);
+			continue;
+		}
+
+		if (bytes_read == 0)
+			return true;
+
+		if (errno == EINTR)
+			continue;
+
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return false;
+
+		log_warning(_("unable to read output of command:\n  %s"), parallel_command->command.data);
+		log_detail("%s", strerror(errno));
+
+		return true;
+	}
+}
+
+
+static void
+_finish_parallel_command(t_parallel_command *parallel_command)
+{
+	int			status = 0;
+
+	close(parallel_command->fd);
+	parallel_command->fd = -1;
+
+	while (waitpid(parallel_command->pid, &status, 0) < 0)
+	{
+		if (errno != EINTR)
+		{
+			status = -1;
+			break;
+		}
+	}
+
+	if (parallel_command->timed_out == false && status != -1 && WIFEXITED(status))
+		parallel_command->return_value = WEXITSTATUS(status);
+	else
+		parallel_command->return_value = -1;
+
+	log_verbose(LOG_DEBUG, "execute_commands_parallel(): result of command was %i:\n  %s",
+				parallel_command->return_value,
+				parallel_command->command.data);
+
+	if (parallel_command->output.data[0] != '\0')
+		log_verbose(LOG_DEBUG, "execute_commands_parallel(): output returned was:\n%s", parallel_command->output.data);
+	else
+		log_verbose(LOG_DEBUG, "execute_commands_parallel(): no output returned");
+}
+
+
+static int
+_parallel_command_remaining_ms(t_parallel_command *parallel_command, instr_time current_time, int timeout)
+{
+	int			remaining_ms;
+
+	INSTR_TIME_SUBTRACT(current_time, parallel_command->start_time);
+
+	remaining_ms = (timeout * 1000) - (int) INSTR_TIME_GET_MILLISEC(current_time);
+
+	return remaining_ms > 0 ? remaining_ms : 0;
+}
+
+
+/*
+ * init_background_commands()
+ *
+ * Enable execution of commands passed to queue_background_command() in the
+ * background, with up to "max_workers" commands executing concurrently and
+ * up to "queue_size" commands waiting for execution. Commands which do not
+ * complete within "timeout" seconds (if greater than 0) will be terminated.
+ *
+ * This may be called again to change the settings; any commands already
+ * queued or executing are retained. If "max_workers" is 0, background
+ * execution is disabled (see background_commands_enabled()).
+ */
+void
+init_background_commands(int max_workers, int queue_size, int timeout)
+{
+	int			running_allocated;
+
+	if (queue_size < 1)
+		queue_size = 1;
+
+	background_max_workers = max_workers;
+	background_queue_size = queue_size;
+	background_timeout = timeout;
+
+	running_allocated = max_workers > background_running_count ? max_workers : background_running_count;
+
+	if (running_allocated > background_running_allocated)
+	{
+		background_running = pg_realloc(background_running, sizeof(t_background_command) * running_allocated);
+		background_running_allocated = running_allocated;
+	}
+
+	/* discard the oldest queued commands if the queue has shrunk */
+	if (background_queue_count > queue_size)
+	{
+		log_warning(_("discarding %i queued background command(s)"),
+					background_queue_count - queue_size);
+
+		memmove(background_queue,
+				background_queue + (background_queue_count - queue_size),
+				sizeof(t_background_command) * queue_size);
+		background_queue_count = queue_size;
+	}
+
+	if (queue_size != background_queue_allocated)
+	{
+		background_queue = pg_realloc(background_queue, sizeof(t_background_command) * queue_size);
+		background_queue_allocated = queue_size;
+	}
+}
+
+
+bool
+background_commands_enabled(void)
+{
+	return background_max_workers > 0;
+}
+
+
+/*
+ * queue_background_command()
+ *
+ * Queue a command for execution in the background, and start it immediately
+ * if a worker slot is free. This does not wait for the command to complete;
+ * process_background_commands() must be called periodically to reap
+ * completed commands, start queued ones and enforce the timeout.
+ *
+ * If the same command is already waiting in the queue, it is not queued
+ * again. If the queue is full, the oldest queued command is discarded, so
+ * a backlog of slow commands cannot grow without limit.
+ */
+void
+queue_background_command(const char *command)
+{
+	int			i;
+
+	for (i = 0; i < background_queue_count; i++)
+	{
+		if (strncmp(background_queue[i].command, command, MAXPGPATH) == 0)
+		{
+			log_debug("queue_background_command(): command already queued:\n  %s", command);
+			return;
+		}
+	}
+
+	if (background_queue_count == background_queue_size)
+	{
+		log_warning(_("background command queue is full, discarding oldest queued command"));
+		log_detail(_("discarded command was:\n  %s"), background_queue[0].command);
+
+		memmove(background_queue,
+				background_queue + 1,
+				sizeof(t_background_command) * (background_queue_count - 1));
+		background_queue_count--;
+	}
+
+	memset(&background_queue[background_queue_count], 0, sizeof(t_background_command));
+	strncpy(background_queue[background_queue_count].command, command, MAXPGPATH - 1);
+	background_queue[background_queue_count].pid = UNKNOWN_PID;
+	background_queue_count++;
+
+	(void) process_background_commands();
+}
+
+
+/*
+ * process_background_commands()
+ *
+ * Reap any completed background commands, terminate any which have
+ * exceeded the timeout, and start queued commands if worker slots
+ * are free. Does not block.
+ *
+ * Returns the number of commands still executing or queued.
+ */
+int
+process_background_commands(void)
+{
+	int			max_workers = background_max_workers > 0 ? background_max_workers : 1;
+	int			i;
+
+	/* work backwards, so completed entries can be replaced with the last one */
+	for (i = background_running_count - 1; i >= 0; i--)
+	{
+		t_background_command *background_command = &background_running[i];
+		int			status = 0;
+		pid_t		pid = waitpid(background_command->pid, &status, WNOHANG);
+
+		if (pid == 0)
+		{
+			if (background_timeout > 0 && background_command->terminated == false)
+			{
+				instr_time	elapsed;
+
+				INSTR_TIME_SET_CURRENT(elapsed);
+				INSTR_TIME_SUBTRACT(elapsed, background_command->start_time);
+
+				if (INSTR_TIME_GET_DOUBLE(elapsed) >= background_timeout)
+				{
+					log_warning(_("command did not complete within %i seconds, terminating"), background_timeout);
+					log_detail(_("command was:\n  %s"), background_command->command);
+
+					/* the command is run in its own process group, so terminate the whole group */
+					kill(-background_command->pid, SIGKILL);
+					background_command->terminated = true;
+				}
+			}
+
+			continue;
+		}
+
+		if (pid < 0 && errno == EINTR)
+			continue;
+
+		if (pid > 0 && background_command->terminated == false)
+		{
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			{
+				log_warning(_("unable to execute command"));
+				log_detail(_("command was:\n  %s"), background_command->command);
+			}
+			else
+			{
+				log_verbose(LOG_DEBUG, "process_background_commands(): command completed:\n  %s",
+							background_command->command);
+			}
+		}
+
+		background_running[i] = background_running[background_running_count - 1];
+		background_running_count--;
+	}
+
+	while (background_queue_count > 0 && background_running_count < max_workers
+		   && background_running_count < background_running_allocated)
+	{
+		t_background_command background_command = background_queue[0];
+
+		memmove(background_queue,
+				background_queue + 1,
+				sizeof(t_background_command) * (background_queue_count - 1));
+		background_queue_count--;
+
+		if (_start_background_command(&background_command) == true)
+		{
+			background_running[background_running_count] = background_command;
+			background_running_count++;
+		}
+	}
+
+	return background_running_count + background_queue_count;
+}
+
+
+/*
+ * wait_background_commands()
+ *
+ * Wait up to "max_wait" seconds in total for all queued and executing
+ * background commands to complete, e.g. before exiting. Each command is
+ * still subject to the timeout provided to init_background_commands().
+ *
+ * Any commands still executing after "max_wait" seconds are terminated,
+ * and any still queued are discarded.
+ */
+void
+wait_background_commands(int max_wait)
+{
+	instr_time	wait_start;
+	int			i;
+
+	INSTR_TIME_SET_CURRENT(wait_start);
+
+	while (process_background_commands() > 0)
+	{
+		instr_time	elapsed;
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, wait_start);
+
+		if (INSTR_TIME_GET_DOUBLE(elapsed) >= max_wait)
+			break;
+
+		pg_usleep(100000);
+	}
+
+	if (background_queue_count > 0)
+	{
+		log_warning(_("discarding %i queued background command(s)"),
+					background_queue_count);
+		background_queue_count = 0;
+	}
+
+	if (background_running_count == 0)
+		return;
+
+	log_warning(_("terminating %i background command(s) which did not complete within %i seconds"),
+				background_running_count,
+				max_wait);
+
+	for (i = 0; i < background_running_count; i++)
+	{
+		log_detail(_("command was:\n  %s"), background_running[i].command);
+
+		/* the command is run in its own process group, so terminate the whole group */
+		kill(-background_running[i].pid, SIGKILL);
+		(void) waitpid(background_running[i].pid, NULL, 0);
+	}
+
+	background_running_count = 0;
+}
+
+
+static bool
+_start_background_command(t_background_command *background_command)
+{
+	log_debug("starting background command:\n  %s", background_command->command);
+
+	fflush(stdout);
+	fflush(stderr);
+
+	background_command->pid = fork();
+
+	if (background_command->pid < 0)
+	{
+		log_error(_("unable to fork process for command:\n  %s"), background_command->command);
+		log_detail("%s", strerror(errno));
+		background_command->pid = UNKNOWN_PID;
+		return false;
+	}
+
+	if (background_command->pid == 0)
+	{
+		int			devnull;
+
+		/* own process group, so the command and any children can be terminated together */
+		setpgid(0, 0);
+
+		devnull = open("/dev/null", O_RDONLY);
+		if (devnull >= 0)
+		{
+			dup2(devnull, STDIN_FILENO);
+			close(devnull);
+		}
+
+		execl("/bin/sh", "sh", "-c", background_command->command, (char *) NULL);
+		_exit(127);
+	}
+
+	/* set here too, in case the child has not yet done so */
+	setpgid(background_command->pid, background_command->pid);
+
+	background_command->terminated = false;
+	INSTR_TIME_SET_CURRENT(background_command->start_time);
+
+	return true;
+}
+
+
+/*
+ * Sleep for "*interval_ms" milliseconds, then double the interval for the
+ * next call, up to "max_interval_ms".
+ *
+ * Used when polling for a state change which usually happens quickly but
+ * may take a while; "*interval_ms" should be initialised to
+ * POLL_INITIAL_INTERVAL_MS (or zero, which has the same effect).
+ */
+void
+sleep_with_backoff(int *interval_ms, int max_interval_ms)
+{
+	if (*interval_ms <= 0)
+		*interval_ms = POLL_INITIAL_INTERVAL_MS;
+
+	if (max_interval_ms < POLL_INITIAL_INTERVAL_MS)
+		max_interval_ms = POLL_INITIAL_INTERVAL_MS;
+
+	if (*interval_ms > max_interval_ms)
+		*interval_ms = max_interval_ms;
+
+	pg_usleep((long) *interval_ms * 1000L);
+
+	*interval_ms *= 2;
+
+	if (*interval_ms > max_interval_ms)
+		*interval_ms = max_interval_ms;
+}
+
+
+/*
+ * Return the number of milliseconds elapsed since "start_time".
+ */
+int
+elapsed_ms(instr_time start_time)
+{
+	instr_time	current_time;
+
+	INSTR_TIME_SET_CURRENT(current_time);
+	INSTR_TIME_SUBTRACT(current_time, start_time);
+
+	return (int) INSTR_TIME_GET_MILLISEC(current_time);
+}
+
+
 pid_t
 disable_wal_receiver(PGconn *conn)
 {
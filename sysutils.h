@@ -19,13 +19,51 @@
 #ifndef _SYSUTILS_H_
 #define _SYSUTILS_H_
 
+/*
+ * Struct to track a shell command executed by execute_commands_parallel()
+ */
+typedef struct s_parallel_command
+{
+	/* command line as passed to the shell */
+	PQExpBufferData command;
+	/* populated by execute_commands_parallel() */
+	PQExpBufferData output;
+	int			return_value;
+	bool		timed_out;
+	/* internal state */
+	pid_t		pid;
+	int			fd;
+	instr_time	start_time;
+} t_parallel_command;
+
+/* initial interval used by sleep_with_backoff() */
+#define POLL_INITIAL_INTERVAL_MS	50
+
+typedef void (*parallel_command_callback) (int command_index, t_parallel_command *parallel_command, void *arg);
+
 extern bool local_command(const char *command, PQExpBufferData *outputbuf);
 extern bool local_command_return_value(const char *command, PQExpBufferData *outputbuf, int *return_value);
 extern bool local_command_simple(const char *command, PQExpBufferData *outputbuf);
 
+extern void init_ssh_multiplexing(bool enabled);
 extern bool remote_command(const char *host, const char *user, const char *command, const char *ssh_options, PQExpBufferData *outputbuf);
 extern void make_remote_command(const char *host, const char *user, const char *command, const char *ssh_options, PQExpBufferData *ssh_command);
 
+extern void init_parallel_command(t_parallel_command *parallel_command);
+extern void term_parallel_command(t_parallel_command *parallel_command);
+extern void execute_commands_parallel(t_parallel_command *commands, int command_count, int max_parallel, int timeout);
+extern void execute_commands_parallel_callback(t_parallel_command *commands, int command_count, int max_parallel, int timeout,
+											   parallel_command_callback callback, void *callback_arg);
+
+extern void init_background_commands(int max_workers, int queue_size, int timeout);
+extern bool background_commands_enabled(void);
+extern void queue_background_command(const char *command);
+extern int	process_background_commands(void);
+extern void wait_background_commands(int max_wait);
+
+extern void sleep_with_backoff(int *interval_ms, int max_interval_ms);
+extern int	elapsed_ms(instr_time start_time);
+
 extern pid_t disable_wal_receiver(PGconn *conn);
 extern pid_t enable_wal_receiver(PGconn *conn, bool wait_startup);
 